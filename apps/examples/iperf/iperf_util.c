@@ -58,6 +58,9 @@
 #include <sys/time.h>
 #include <time.h>
 #include <errno.h>
+#ifdef CONFIG_SCHED_CPULOAD
+#include <tinyara/clock.h>
+#endif
 
 #include "iperf_cjson.h"
 
@@ -221,6 +224,34 @@ void cpu_util(double pcpu[3])
 	pcpu[0] = (((ctemp - clast) * 1000000.0 / CLOCKS_PER_SEC) / timediff) * 100;
 	pcpu[1] = (userdiff / timediff) * 100;
 	pcpu[2] = (systemdiff / timediff) * 100;
+#elif defined(CONFIG_SCHED_CPULOAD)
+	/* The scheduler counts the ticks each thread ran with a decay of
+	 * CONFIG_SCHED_CPULOAD_TIMECONSTANT seconds, so this is the load of the
+	 * last few seconds of the test.  "user" is this task and "system" the
+	 * network stack and every other thread.
+	 */
+	struct cpuload_s idle;
+	struct cpuload_s self;
+
+	if (pcpu == NULL) {
+		return;
+	}
+
+	pcpu[0] = pcpu[1] = pcpu[2] = 0.0;
+	if (clock_cpuload(0, &idle) < 0 || idle.total == 0) {
+		return;
+	}
+	pcpu[0] = 100.0 * (idle.total - idle.active) / idle.total;
+	if (clock_cpuload(getpid(), &self) == 0 && self.total != 0) {
+		pcpu[1] = 100.0 * self.active / self.total;
+	}
+	if (pcpu[0] > pcpu[1]) {
+		pcpu[2] = pcpu[0] - pcpu[1];
+	}
+#else
+	if (pcpu != NULL) {
+		pcpu[0] = pcpu[1] = pcpu[2] = 0.0;
+	}
 #endif
 }
 
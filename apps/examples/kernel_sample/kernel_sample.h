@@ -204,6 +204,16 @@ void barrier_test(void);
 
 void priority_inheritance(void);
 
+/* schedqueue.c *************************************************************/
+
+void schedqueue_test(void);
+
+/* wdog.c *******************************************************************/
+
+#ifdef CONFIG_EXAMPLES_KERNEL_SAMPLE_WDOG
+void wdog_test(void);
+#endif
+
 /* vfork.c ******************************************************************/
 
 #if defined(CONFIG_ARCH_HAVE_VFORK) && defined(CONFIG_SCHED_WAITPID) && \
@@ -464,6 +464,22 @@ static int user_main(int argc, char *argv[])
 		check_test_memory_usage();
 #endif /* CONFIG_PRIORITY_INHERITANCE && !CONFIG_DISABLE_SIGNALS && !CONFIG_DISABLE_PTHREAD */
 
+#ifndef CONFIG_DISABLE_PTHREAD
+		/* Measure ready-to-run queue operations */
+
+		printf("\nuser_main: ready-to-run queue test\n");
+		schedqueue_test();
+		check_test_memory_usage();
+#endif
+
+#ifdef CONFIG_EXAMPLES_KERNEL_SAMPLE_WDOG
+		/* Verify and benchmark watchdog timers */
+
+		printf("\nuser_main: watchdog timer test\n");
+		wdog_test();
+		check_test_memory_usage();
+#endif
+
 #if defined(CONFIG_ARCH_HAVE_VFORK) && defined(CONFIG_SCHED_WAITPID) && \
 	!defined(CONFIG_DISABLE_SIGNALS)
 		printf("\nuser_main: vfork() test\n");
@@ -0,0 +1,178 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * apps/examples/kernel_sample/schedqueue.c
+ *
+ *   Measures the cost of re-queueing a ready-to-run task as the number of
+ *   higher priority ready-to-run tasks grows.  With the ordered list the
+ *   scheduler walks past every one of those tasks with interrupts disabled;
+ *   with CONFIG_SCHED_PRIORITY_BITMAP the cost should not depend on them.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "kernel_sample.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Leave most of the task table to the rest of the system */
+
+#define MAX_FILLERS    (CONFIG_MAX_TASKS / 4)
+
+/* Each measurement runs for at least this long */
+
+#define MEASURE_NSEC   (200 * 1000 * 1000L)
+#define MEASURE_BATCH  32
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile bool g_schedq_done;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Filler threads stay ready-to-run, just below the priority of the test
+ * thread, so that they are queued ahead of the target thread.  The target
+ * thread stays ready-to-run below them and never gets to run.
+ */
+
+static FAR void *schedqueue_spin(FAR void *arg)
+{
+	while (!g_schedq_done) {
+		sched_yield();
+	}
+
+	return NULL;
+}
+
+static int schedqueue_start(FAR pthread_t *thread, int priority)
+{
+	struct sched_param sparam;
+	pthread_attr_t attr;
+	int status;
+
+	pthread_attr_init(&attr);
+	sparam.sched_priority = priority;
+	pthread_attr_setschedparam(&attr, &sparam);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+
+	status = pthread_create(thread, &attr, schedqueue_spin, NULL);
+	if (status != 0) {
+		printf("schedqueue_test: ERROR pthread_create failed, status=%d\n", status);
+	}
+
+	return status;
+}
+
+/* Change the priority of the target thread back and forth between two
+ * priorities below the fillers.  Each change removes the thread from the
+ * ready-to-run list and inserts it again behind all of the fillers.
+ */
+
+static long schedqueue_measure(pthread_t target, int priority)
+{
+	struct sched_param sparam;
+	struct timespec start;
+	struct timespec now;
+	long elapsed;
+	long nops = 0;
+	int i;
+
+	clock_gettime(CLOCK_REALTIME, &start);
+	do {
+		for (i = 0; i < MEASURE_BATCH; i++) {
+			sparam.sched_priority = priority - (i & 1);
+			pthread_setschedparam(target, SCHED_FIFO, &sparam);
+		}
+
+		nops += MEASURE_BATCH;
+		clock_gettime(CLOCK_REALTIME, &now);
+		elapsed = (now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec);
+	} while (elapsed < MEASURE_NSEC);
+
+	return elapsed / nops;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: schedqueue_test
+ ****************************************************************************/
+
+void schedqueue_test(void)
+{
+	pthread_t fillers[MAX_FILLERS];
+	pthread_t target;
+	struct sched_param sparam;
+	int nfillers = 0;
+	int prio;
+	int step;
+
+	sched_getparam(0, &sparam);
+	prio = sparam.sched_priority;
+	if (prio < SCHED_PRIORITY_MIN + 3) {
+		printf("schedqueue_test: priority %d is too low\n", prio);
+		return;
+	}
+
+	g_schedq_done = false;
+	if (schedqueue_start(&target, prio - 2) != 0) {
+		return;
+	}
+
+	for (step = 0; nfillers <= MAX_FILLERS; step = step ? step * 2 : 1) {
+		while (nfillers < step && nfillers < MAX_FILLERS) {
+			if (schedqueue_start(&fillers[nfillers], prio - 1) != 0) {
+				goto errout;
+			}
+
+			nfillers++;
+		}
+
+		printf("schedqueue_test: %2d tasks ahead: %6ld ns per re-queue\n", nfillers, schedqueue_measure(target, prio - 2));
+		if (nfillers == MAX_FILLERS) {
+			break;
+		}
+	}
+
+errout:
+	g_schedq_done = true;
+	while (nfillers > 0) {
+		pthread_join(fillers[--nfillers], NULL);
+	}
+
+	pthread_join(target, NULL);
+}
@@ -0,0 +1,330 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * apps/examples/kernel_sample/wdog.c
+ *
+ *   Watchdog timer test and benchmark.  The test checks that a large number
+ *   of concurrently armed watchdogs all expire, and not early.  The
+ *   benchmark then arms an increasing number of long watchdogs and measures
+ *   the cost of arming and cancelling more watchdogs behind all of them.
+ *   wd_start() and wd_cancel() do all of their work with interrupts
+ *   disabled, so the longest single call is the longest window during
+ *   which they hold off interrupts.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <tinyara/clock.h>
+#include <tinyara/irq.h>
+#include <tinyara/wdog.h>
+
+#include "kernel_sample.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_KERNEL_SAMPLE_WDOG_NTIMERS
+#  define CONFIG_EXAMPLES_KERNEL_SAMPLE_WDOG_NTIMERS 256
+#endif
+
+#define NTIMERS        CONFIG_EXAMPLES_KERNEL_SAMPLE_WDOG_NTIMERS
+
+/* Delays used by the functional test are spread over this many ticks */
+
+#define SPREAD_TICKS   37
+
+/* Delays used by the benchmark; long enough that nothing expires while
+ * the measurement runs.
+ */
+
+#define PARK_TICKS     (100 * TICK_PER_SEC)
+
+/* Each measurement runs for at least this long */
+
+#define MEASURE_NSEC   (500 * 1000 * 1000L)
+#define MEASURE_BATCH  64
+
+/* The Cortex-R4 cycle counter (PMCCNTR) is fine enough to time a single
+ * call.  Its rate is calibrated against the system clock for this long.
+ */
+
+#ifdef CONFIG_ARCH_CORTEXR4
+#  define HAVE_CYCLE_COUNTER 1
+#  define CALIBRATE_NSEC   (100 * 1000 * 1000L)
+#endif
+
+#ifdef HAVE_CYCLE_COUNTER
+#  define WDOG_TIMED(call, max) \
+	do { \
+		irqstate_t _flags = irqsave(); \
+		uint32_t _cycles = wdog_cycles(); \
+		call; \
+		_cycles = wdog_cycles() - _cycles; \
+		irqrestore(_flags); \
+		if (_cycles > (max)) { \
+			(max) = _cycles; \
+		} \
+	} while (0)
+#else
+#  define WDOG_TIMED(call, max) call
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static WDOG_ID g_wdogs[NTIMERS + MEASURE_BATCH];
+#ifdef HAVE_CYCLE_COUNTER
+static uint32_t g_cycles_per_usec;
+#endif
+static systime_t g_wdfired[NTIMERS];
+static volatile int g_wdnfired;
+static volatile int g_wdnparked;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void wdog_expiration(int argc, uint32_t arg)
+{
+	g_wdfired[arg] = clock_systimer();
+	g_wdnfired++;
+}
+
+static void wdog_parked(int argc, uint32_t arg)
+{
+	g_wdnparked++;
+}
+
+static long wdog_elapsed(FAR const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (now.tv_sec - start->tv_sec) * 1000000000L + (now.tv_nsec - start->tv_nsec);
+}
+
+#ifdef HAVE_CYCLE_COUNTER
+static inline uint32_t wdog_cycles(void)
+{
+	uint32_t cycles;
+
+	__asm__ __volatile__("mrc p15, 0, %0, c9, c13, 0" : "=r"(cycles));
+	return cycles;
+}
+
+/****************************************************************************
+ * Name: wdog_cycles_enable
+ *
+ * Description:
+ *   Start the cycle counter and measure its rate.  The system clock is
+ *   polled rather than slept on, since the counter may stop while the CPU
+ *   waits for an interrupt.
+ *
+ ****************************************************************************/
+
+static void wdog_cycles_enable(void)
+{
+	struct timespec start;
+	uint32_t pmcr;
+	uint32_t cycles;
+	long elapsed;
+
+	/* Set PMCR.E, then enable the cycle counter in PMCNTENSET */
+
+	__asm__ __volatile__("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+	__asm__ __volatile__("mcr p15, 0, %0, c9, c12, 0" : : "r"(pmcr | 1));
+	__asm__ __volatile__("mcr p15, 0, %0, c9, c12, 1" : : "r"(1u << 31));
+
+	clock_gettime(CLOCK_REALTIME, &start);
+	cycles = wdog_cycles();
+	do {
+		elapsed = wdog_elapsed(&start);
+	} while (elapsed < CALIBRATE_NSEC);
+
+	cycles = wdog_cycles() - cycles;
+	g_cycles_per_usec = cycles / (elapsed / 1000);
+	if (g_cycles_per_usec == 0) {
+		g_cycles_per_usec = 1;
+	}
+}
+
+static long wdog_cycles_to_ns(uint32_t cycles)
+{
+	return (long)(((uint64_t)cycles * 1000) / g_cycles_per_usec);
+}
+#endif
+
+/****************************************************************************
+ * Name: wdog_verify
+ *
+ * Description:
+ *   Arm every watchdog with a short delay and check that each expires no
+ *   earlier than requested.
+ *
+ ****************************************************************************/
+
+static int wdog_verify(void)
+{
+	systime_t start;
+	int errors = 0;
+	int delay;
+	int i;
+
+	g_wdnfired = 0;
+	start = clock_systimer();
+	for (i = 0; i < NTIMERS; i++) {
+		delay = (i % SPREAD_TICKS) + 1;
+		if (wd_start(g_wdogs[i], delay, (wdentry_t)wdog_expiration, 1, (uint32_t)i) != OK) {
+			printf("wdog_test: ERROR wd_start(%d) failed\n", i);
+			return 1;
+		}
+	}
+
+	usleep(2 * SPREAD_TICKS * USEC_PER_TICK);
+
+	if (g_wdnfired != NTIMERS) {
+		printf("wdog_test: ERROR %d of %d watchdogs expired\n", g_wdnfired, NTIMERS);
+		errors++;
+	}
+
+	for (i = 0; i < NTIMERS; i++) {
+		delay = (i % SPREAD_TICKS) + 1;
+		if ((long)(g_wdfired[i] - start) < delay) {
+			printf("wdog_test: ERROR watchdog %d expired after %ld ticks, expected %d\n", i, (long)(g_wdfired[i] - start), delay);
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+/****************************************************************************
+ * Name: wdog_measure
+ *
+ * Description:
+ *   With nactive watchdogs parked, arm a batch of watchdogs that expire
+ *   after all of them and then cancel the batch, last armed first.  For an
+ *   ordered timer list each of these calls works at the worst case
+ *   position.  The averages come from the system clock.  Where the cycle
+ *   counter is available each call is also timed on its own, with
+ *   interrupts disabled around it, for the longest interrupts-off window.
+ *
+ ****************************************************************************/
+
+static void wdog_measure(int nactive)
+{
+	struct timespec start;
+	long startns = 0;
+	long cancelns = 0;
+	long ncalls = 0;
+#ifdef HAVE_CYCLE_COUNTER
+	uint32_t startmax = 0;
+	uint32_t cancelmax = 0;
+#endif
+	int i;
+
+	for (i = 0; i < nactive; i++) {
+		wd_start(g_wdogs[i], PARK_TICKS + i, (wdentry_t)wdog_parked, 1, (uint32_t)i);
+	}
+
+	do {
+		clock_gettime(CLOCK_REALTIME, &start);
+		for (i = 0; i < MEASURE_BATCH; i++) {
+			WDOG_TIMED(wd_start(g_wdogs[NTIMERS + i], 2 * PARK_TICKS + i, (wdentry_t)wdog_parked, 1, (uint32_t)(NTIMERS + i)), startmax);
+		}
+
+		startns += wdog_elapsed(&start);
+
+		clock_gettime(CLOCK_REALTIME, &start);
+		for (i = MEASURE_BATCH - 1; i >= 0; i--) {
+			WDOG_TIMED(wd_cancel(g_wdogs[NTIMERS + i]), cancelmax);
+		}
+
+		cancelns += wdog_elapsed(&start);
+		ncalls += MEASURE_BATCH;
+	} while (startns + cancelns < MEASURE_NSEC);
+
+	for (i = 0; i < nactive; i++) {
+		wd_cancel(g_wdogs[i]);
+	}
+
+	if (g_wdnparked != 0) {
+		printf("wdog_test: ERROR %d parked watchdogs expired\n", g_wdnparked);
+		g_wdnparked = 0;
+	}
+
+#ifdef HAVE_CYCLE_COUNTER
+	printf("wdog_test: %5d active  wd_start %6ld ns (max %6ld ns)  wd_cancel %6ld ns (max %6ld ns)\n",
+		   nactive, startns / ncalls, wdog_cycles_to_ns(startmax), cancelns / ncalls, wdog_cycles_to_ns(cancelmax));
+#else
+	printf("wdog_test: %5d active  wd_start %6ld ns  wd_cancel %6ld ns\n", nactive, startns / ncalls, cancelns / ncalls);
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wdog_test
+ ****************************************************************************/
+
+void wdog_test(void)
+{
+	int nactive;
+	int i;
+
+	for (i = 0; i < NTIMERS + MEASURE_BATCH; i++) {
+		g_wdogs[i] = wd_create();
+		if (g_wdogs[i] == NULL) {
+			printf("wdog_test: ERROR wd_create(%d) failed\n", i);
+			goto errout;
+		}
+	}
+
+	if (wdog_verify() == 0) {
+		printf("wdog_test: %d watchdogs expired on time\n", NTIMERS);
+	}
+
+#ifdef HAVE_CYCLE_COUNTER
+	wdog_cycles_enable();
+#endif
+
+	for (nactive = 0; nactive < NTIMERS; nactive = nactive ? nactive * 2 : 1) {
+		wdog_measure(nactive);
+	}
+
+	wdog_measure(NTIMERS);
+
+errout:
+	while (--i >= 0) {
+		wd_delete(g_wdogs[i]);
+	}
+}
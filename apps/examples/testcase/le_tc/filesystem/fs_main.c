@@ -39,6 +39,9 @@
 #include <sys/sendfile.h>
 #include <sys/statfs.h>
 #include <sys/select.h>
+#ifdef CONFIG_FS_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include <tinyara/fs/ioctl.h>
 #include <tinyara/fs/fs_utils.h>
@@ -85,6 +88,32 @@
 
 #define LONG_FILE_LOOP_COUNT 24
 
+#define SEEK_FILE_PATH MOUNT_DIR"seek"
+
+#define SEEK_FILE_SIZE (32 * 1024)
+
+#define SEEK_LOOP_COUNT 200
+
+#define STREAM_FILE_PATH MOUNT_DIR"stream"
+
+#define STREAM_FILE_SIZE (64 * 1024)
+
+#define STREAM_RECORD_SIZE 100
+
+#define MULTI_WRITER_FILE_PATH MOUNT_DIR"mw"
+
+#define MULTI_WRITER_COUNT 4
+
+#define MULTI_WRITER_FILE_SIZE (16 * 1024)
+
+#define MULTI_WRITER_RECORD_SIZE 256
+
+#define SAME_FILE_PATH MOUNT_DIR"sf"
+
+#define SAME_FILE_RECORDS 64
+
+#define SAME_FILE_TRUNCATES 8
+
 #if defined(CONFIG_PIPES) && (CONFIG_DEV_PIPE_SIZE > 0)
 #define FIFO_FILE_PATH "/dev/fifo_test"
 
@@ -815,6 +844,421 @@ static int fs_vfs_pread_tc(void)
 	return ret;
 }
 
+static int fs_vfs_seek_perf_tc(void)
+{
+	int fd, i, ret;
+	char *filename = SEEK_FILE_PATH;
+	uint32_t word;
+	uint32_t pos;
+	struct timespec start;
+	struct timespec end;
+	long msec;
+
+	printf("%d. Random seek performance Test started. \n", g_tc_count++);
+
+	/* Each word of the file holds its own offset */
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC);
+	if (fd < 0) {
+		printf("open Failed : %s\n", filename);
+		g_tc_fail_count++;
+		return fd;
+	}
+	for (pos = 0; pos < SEEK_FILE_SIZE; pos += sizeof(word)) {
+		if (write(fd, &pos, sizeof(pos)) != sizeof(pos)) {
+			printf("write Failed : %u\n", pos);
+			g_tc_fail_count++;
+			close(fd);
+			return ERROR;
+		}
+	}
+	close(fd);
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		printf("open Failed : %s\n", filename);
+		g_tc_fail_count++;
+		return fd;
+	}
+
+	/* Read words at random offsets, alternating lseek/read and pread */
+
+	ret = OK;
+	clock_gettime(CLOCK_REALTIME, &start);
+	for (i = 0; i < SEEK_LOOP_COUNT; i++) {
+		pos = (rand() % (SEEK_FILE_SIZE / sizeof(word))) * sizeof(word);
+		if (i & 1) {
+			if (pread(fd, &word, sizeof(word), pos) != sizeof(word)) {
+				ret = ERROR;
+			}
+		} else {
+			if (lseek(fd, pos, SEEK_SET) != pos || read(fd, &word, sizeof(word)) != sizeof(word)) {
+				ret = ERROR;
+			}
+		}
+		if (ret != OK || word != pos) {
+			printf("Read Failed at %u : %u\n", pos, word);
+			g_tc_fail_count++;
+			close(fd);
+			unlink(filename);
+			return ERROR;
+		}
+	}
+	clock_gettime(CLOCK_REALTIME, &end);
+	close(fd);
+	unlink(filename);
+
+	msec = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+	printf("%d random reads in %d bytes : %ld msec\n", SEEK_LOOP_COUNT, SEEK_FILE_SIZE, msec);
+	printf("PASS!\n");
+	return OK;
+}
+
+static int fs_vfs_stream_read(int fd, uint8_t *buf, size_t chunk)
+{
+	uint32_t pos;
+	ssize_t len;
+	ssize_t i;
+
+	pos = 0;
+	while ((len = read(fd, buf, chunk)) > 0) {
+		for (i = 0; i < len; i++, pos++) {
+			if (buf[i] != (uint8_t)(pos % 251)) {
+				printf("Read Failed at %u : %d\n", pos, buf[i]);
+				return ERROR;
+			}
+		}
+	}
+	if (len < 0 || pos != STREAM_FILE_SIZE) {
+		printf("Read Failed : %d, %u bytes\n", (int)len, pos);
+		return ERROR;
+	}
+	return OK;
+}
+
+static int fs_vfs_stream_tc(void)
+{
+	int fd, i, ret;
+	char *filename = STREAM_FILE_PATH;
+	const size_t chunks[] = { 37, 4096 };
+	uint8_t *buf;
+	uint32_t pos;
+	size_t len;
+	struct timespec start;
+	struct timespec end;
+	long msec;
+
+	printf("%d. Sequential write and read Test started. \n", g_tc_count++);
+
+	buf = (uint8_t *)malloc(4096);
+	if (buf == NULL) {
+		printf("malloc Failed\n");
+		g_tc_fail_count++;
+		return ERROR;
+	}
+
+	/* Log fixed size records, byte n of the file holds n % 251 */
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC);
+	if (fd < 0) {
+		printf("open Failed : %s\n", filename);
+		g_tc_fail_count++;
+		free(buf);
+		return fd;
+	}
+	clock_gettime(CLOCK_REALTIME, &start);
+	for (pos = 0; pos < STREAM_FILE_SIZE; pos += len) {
+		len = STREAM_FILE_SIZE - pos < STREAM_RECORD_SIZE ? STREAM_FILE_SIZE - pos : STREAM_RECORD_SIZE;
+		for (i = 0; i < (int)len; i++) {
+			buf[i] = (uint8_t)((pos + i) % 251);
+		}
+		ret = write(fd, buf, len);
+		if (ret < 0 || (size_t)ret != len) {
+			printf("write Failed : %u\n", pos);
+			g_tc_fail_count++;
+			close(fd);
+			unlink(filename);
+			free(buf);
+			return ERROR;
+		}
+	}
+	close(fd);
+	clock_gettime(CLOCK_REALTIME, &end);
+	msec = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+	printf("Wrote %d bytes in %d byte records : %ld msec\n", STREAM_FILE_SIZE, STREAM_RECORD_SIZE, msec);
+
+	/* Read it back in small and in large chunks */
+
+	ret = OK;
+	for (i = 0; i < (int)(sizeof(chunks) / sizeof(chunks[0])) && ret == OK; i++) {
+		len = chunks[i];
+		fd = open(filename, O_RDONLY);
+		if (fd < 0) {
+			printf("open Failed : %s\n", filename);
+			ret = ERROR;
+			break;
+		}
+		clock_gettime(CLOCK_REALTIME, &start);
+		ret = fs_vfs_stream_read(fd, buf, len);
+		clock_gettime(CLOCK_REALTIME, &end);
+		close(fd);
+		msec = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+		printf("Read %d bytes in %d byte chunks : %ld msec\n", STREAM_FILE_SIZE, (int)len, msec);
+	}
+	unlink(filename);
+	free(buf);
+	if (ret != OK) {
+		g_tc_fail_count++;
+		return ret;
+	}
+	printf("PASS!\n");
+	return OK;
+}
+
+static pthread_addr_t fs_vfs_multi_writer(pthread_addr_t arg)
+{
+	int id = (int)arg;
+	int fd, i;
+	char filename[32];
+	uint8_t buf[MULTI_WRITER_RECORD_SIZE];
+	uint32_t pos;
+
+	snprintf(filename, sizeof(filename), "%s%d", MULTI_WRITER_FILE_PATH, id);
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC);
+	if (fd < 0) {
+		printf("open Failed : %s\n", filename);
+		return (pthread_addr_t)ERROR;
+	}
+	for (pos = 0; pos < MULTI_WRITER_FILE_SIZE; pos += MULTI_WRITER_RECORD_SIZE) {
+		for (i = 0; i < MULTI_WRITER_RECORD_SIZE; i++) {
+			buf[i] = (uint8_t)((pos + i + id) % 251);
+		}
+		if (write(fd, buf, MULTI_WRITER_RECORD_SIZE) != MULTI_WRITER_RECORD_SIZE) {
+			printf("write Failed : %s %u\n", filename, pos);
+			close(fd);
+			return (pthread_addr_t)ERROR;
+		}
+	}
+	close(fd);
+	return (pthread_addr_t)OK;
+}
+
+/* Record seq of the same file test: seq, then byte n holds (seq + n) % 251 */
+
+static void fs_vfs_same_file_record(uint8_t *buf, uint32_t seq)
+{
+	int i;
+
+	memcpy(buf, &seq, sizeof(seq));
+	for (i = sizeof(seq); i < MULTI_WRITER_RECORD_SIZE; i++) {
+		buf[i] = (uint8_t)((seq + i) % 251);
+	}
+}
+
+/* The file must hold whole, intact records with consecutive numbers.
+ * While the file is written the end of the last record may not be
+ * recorded yet, so unless complete is set a short last record is
+ * ignored.  The number of the last record is returned in last, -1 if
+ * there is none.
+ */
+
+static int fs_vfs_same_file_check(bool complete, int *last)
+{
+	int fd;
+	uint8_t buf[MULTI_WRITER_RECORD_SIZE];
+	uint8_t expect[MULTI_WRITER_RECORD_SIZE];
+	uint32_t seq;
+	ssize_t len;
+
+	*last = -1;
+	fd = open(SAME_FILE_PATH, O_RDONLY);
+	if (fd < 0) {
+		printf("open Failed : %s\n", SAME_FILE_PATH);
+		return ERROR;
+	}
+	while ((len = read(fd, buf, sizeof(buf))) > 0) {
+		if (len != sizeof(buf) && !complete) {
+			len = 0;
+			break;
+		}
+		memcpy(&seq, buf, sizeof(seq));
+		fs_vfs_same_file_record(expect, seq);
+		if (len != sizeof(buf) || (*last >= 0 && seq != *last + 1) || memcmp(buf, expect, sizeof(buf)) != 0) {
+			printf("Read Failed : %s, record after %d\n", SAME_FILE_PATH, *last);
+			close(fd);
+			return ERROR;
+		}
+		*last = seq;
+	}
+	close(fd);
+	return len < 0 ? ERROR : OK;
+}
+
+/* Truncate the file now and then, checking it before each truncation */
+
+static pthread_addr_t fs_vfs_same_file_truncater(pthread_addr_t arg)
+{
+	int fd, i, last;
+
+	for (i = 0; i < SAME_FILE_TRUNCATES; i++) {
+		if (fs_vfs_same_file_check(false, &last) != OK) {
+			return (pthread_addr_t)ERROR;
+		}
+		fd = open(SAME_FILE_PATH, O_WRONLY | O_TRUNC);
+		if (fd < 0) {
+			printf("open Failed : %s\n", SAME_FILE_PATH);
+			return (pthread_addr_t)ERROR;
+		}
+		close(fd);
+	}
+	return (pthread_addr_t)OK;
+}
+
+/* Append the records to the file, which is truncated meanwhile.  Without
+ * concurrent the truncations are done by the writer between its writes,
+ * which gives the baseline.
+ */
+
+static int fs_vfs_same_file_run(bool concurrent, long *msec)
+{
+	int fd, last;
+	int ret;
+	uint8_t buf[MULTI_WRITER_RECORD_SIZE];
+	uint32_t seq;
+	pthread_t tid;
+	pthread_addr_t result;
+	struct timespec start;
+	struct timespec end;
+
+	fd = open(SAME_FILE_PATH, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND);
+	if (fd < 0) {
+		printf("open Failed : %s\n", SAME_FILE_PATH);
+		return ERROR;
+	}
+
+	ret = OK;
+	clock_gettime(CLOCK_REALTIME, &start);
+	if (concurrent && pthread_create(&tid, NULL, fs_vfs_same_file_truncater, NULL) != 0) {
+		printf("pthread_create Failed : truncater\n");
+		close(fd);
+		return ERROR;
+	}
+	for (seq = 0; seq < SAME_FILE_RECORDS && ret == OK; seq++) {
+		if (!concurrent && seq % (SAME_FILE_RECORDS / SAME_FILE_TRUNCATES) == 0) {
+			ret = (int)fs_vfs_same_file_truncater(NULL);
+		}
+		fs_vfs_same_file_record(buf, seq);
+		if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+			printf("write Failed : %s %u\n", SAME_FILE_PATH, seq);
+			ret = ERROR;
+		}
+	}
+	close(fd);
+	if (concurrent && (pthread_join(tid, &result) != 0 || (int)result != OK)) {
+		ret = ERROR;
+	}
+	clock_gettime(CLOCK_REALTIME, &end);
+	*msec = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+
+	/* Whatever survived the last truncation ends with the last record */
+
+	if (ret == OK && (fs_vfs_same_file_check(true, &last) != OK || (last >= 0 && last != SAME_FILE_RECORDS - 1))) {
+		printf("Read Failed : %s ends with record %d\n", SAME_FILE_PATH, last);
+		ret = ERROR;
+	}
+	unlink(SAME_FILE_PATH);
+	return ret;
+}
+
+static int fs_vfs_multi_writer_tc(void)
+{
+	int fd, i, id;
+	int ret;
+	char filename[32];
+	uint8_t buf[MULTI_WRITER_RECORD_SIZE];
+	uint32_t pos;
+	ssize_t len;
+	pthread_t tid[MULTI_WRITER_COUNT];
+	pthread_addr_t result;
+	struct timespec start;
+	struct timespec end;
+	long msec;
+
+	printf("%d. Multiple writer Test started. \n", g_tc_count++);
+
+	/* Each thread writes a file of its own, byte n of file id holds (n + id) % 251 */
+
+	ret = OK;
+	clock_gettime(CLOCK_REALTIME, &start);
+	for (id = 0; id < MULTI_WRITER_COUNT; id++) {
+		if (pthread_create(&tid[id], NULL, fs_vfs_multi_writer, (pthread_addr_t)id) != 0) {
+			printf("pthread_create Failed : %d\n", id);
+			ret = ERROR;
+			break;
+		}
+	}
+	while (--id >= 0) {
+		if (pthread_join(tid[id], &result) != 0 || (int)result != OK) {
+			ret = ERROR;
+		}
+	}
+	clock_gettime(CLOCK_REALTIME, &end);
+	msec = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+	printf("%d writers wrote %d bytes each : %ld msec\n", MULTI_WRITER_COUNT, MULTI_WRITER_FILE_SIZE, msec);
+
+	/* Check every file */
+
+	for (id = 0; id < MULTI_WRITER_COUNT && ret == OK; id++) {
+		snprintf(filename, sizeof(filename), "%s%d", MULTI_WRITER_FILE_PATH, id);
+		fd = open(filename, O_RDONLY);
+		if (fd < 0) {
+			printf("open Failed : %s\n", filename);
+			ret = ERROR;
+			break;
+		}
+		pos = 0;
+		while (ret == OK && (len = read(fd, buf, sizeof(buf))) > 0) {
+			for (i = 0; i < len; i++, pos++) {
+				if (buf[i] != (uint8_t)((pos + id) % 251)) {
+					printf("Read Failed : %s at %u\n", filename, pos);
+					ret = ERROR;
+					break;
+				}
+			}
+		}
+		close(fd);
+		if (ret == OK && (len < 0 || pos != MULTI_WRITER_FILE_SIZE)) {
+			printf("Read Failed : %s, %u bytes\n", filename, pos);
+			ret = ERROR;
+		}
+	}
+	for (id = 0; id < MULTI_WRITER_COUNT; id++) {
+		snprintf(filename, sizeof(filename), "%s%d", MULTI_WRITER_FILE_PATH, id);
+		unlink(filename);
+	}
+
+	/* One task appends to a file while another one checks and truncates
+	 * it, compared with doing both in one task.
+	 */
+
+	if (ret == OK) {
+		ret = fs_vfs_same_file_run(false, &msec);
+		if (ret == OK) {
+			printf("same file, one task : %ld msec\n", msec);
+			ret = fs_vfs_same_file_run(true, &msec);
+		}
+		if (ret == OK) {
+			printf("same file, writer and truncater : %ld msec\n", msec);
+		}
+	}
+	if (ret != OK) {
+		g_tc_fail_count++;
+		return ret;
+	}
+	printf("PASS!\n");
+	return OK;
+}
+
 static int fs_vfs_mkdir_tc(void)
 {
 	char filename[14];
@@ -1372,6 +1816,157 @@ static int fs_vfs_select_tc(void)
 }
 #endif
 
+#if defined(CONFIG_FS_EPOLL) && defined(CONFIG_PIPES) && (CONFIG_DEV_PIPE_SIZE > 0)
+static int fs_vfs_epoll_tc(void)
+{
+	struct epoll_event ev;
+	struct epoll_event evs[2];
+	int fd[2][2] = { { -1, -1 }, { -1, -1 } };
+	char buf[4];
+	int epfd;
+	int ret;
+	int i;
+
+	printf("%d. epoll Test started. \n", g_tc_count++);
+
+	for (i = 0; i < 2; i++) {
+		ret = pipe(fd[i]);
+		if (ret < 0) {
+			printf("pipe Failed : %d\n", errno);
+			goto errout_with_pipes;
+		}
+	}
+
+	epfd = epoll_create(2);
+	if (epfd == ERROR) {
+		printf("epoll_create Failed : %d\n", errno);
+		goto errout_with_pipes;
+	}
+
+	/* Notification is edge-triggered only, so EPOLLET is required */
+
+	ev.events = EPOLLIN;
+	ev.data.fd = fd[0][0];
+	ret = epoll_ctl(epfd, EPOLL_CTL_ADD, fd[0][0], &ev);
+	if (ret != ERROR || errno != EINVAL) {
+		printf("epoll_ctl ADD without EPOLLET did not fail : %d\n", ret);
+		goto errout_with_epoll;
+	}
+
+	for (i = 0; i < 2; i++) {
+		ev.events = EPOLLIN | EPOLLET;
+		ev.data.fd = fd[i][0];
+		ret = epoll_ctl(epfd, EPOLL_CTL_ADD, fd[i][0], &ev);
+		if (ret < 0) {
+			printf("epoll_ctl ADD Failed : %d\n", errno);
+			goto errout_with_epoll;
+		}
+	}
+
+	/* Nothing written yet */
+
+	ret = epoll_wait(epfd, evs, 2, 0);
+	if (ret != 0) {
+		printf("epoll_wait reported %d ready descriptors, expected 0\n", ret);
+		goto errout_with_epoll;
+	}
+
+	/* Only the second pipe becomes readable, it is reported once per write */
+
+	for (i = 0; i < 2; i++) {
+		if (write(fd[1][1], "ep", 2) != 2) {
+			printf("write to pipe Failed : %d\n", errno);
+			goto errout_with_epoll;
+		}
+
+		ret = epoll_wait(epfd, evs, 2, 1000);
+		if (ret != 1 || evs[0].data.fd != fd[1][0] || !(evs[0].events & EPOLLIN)) {
+			printf("epoll_wait Failed : ret %d\n", ret);
+			goto errout_with_epoll;
+		}
+
+		ret = epoll_wait(epfd, evs, 2, 100);
+		if (ret != 0) {
+			printf("epoll_wait reported %d ready descriptors again\n", ret);
+			goto errout_with_epoll;
+		}
+	}
+
+	if (read(fd[1][0], buf, sizeof(buf)) != 4) {
+		printf("read from pipe Failed : %d\n", errno);
+		goto errout_with_epoll;
+	}
+
+	ret = epoll_wait(epfd, evs, 2, 100);
+	if (ret != 0) {
+		printf("epoll_wait reported %d ready descriptors after read\n", ret);
+		goto errout_with_epoll;
+	}
+
+	/* Closing a registered descriptor removes it from the interest list:
+	 * a new pipe that reuses its descriptor number can be added, and is
+	 * reported as itself.
+	 */
+
+	close(fd[1][0]);
+	close(fd[1][1]);
+	ret = pipe(fd[1]);
+	if (ret < 0) {
+		fd[1][0] = -1;
+		fd[1][1] = -1;
+		printf("pipe Failed : %d\n", errno);
+		goto errout_with_epoll;
+	}
+
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.fd = fd[1][0];
+	ret = epoll_ctl(epfd, EPOLL_CTL_ADD, fd[1][0], &ev);
+	if (ret < 0) {
+		printf("epoll_ctl ADD after close Failed : %d\n", errno);
+		goto errout_with_epoll;
+	}
+
+	if (write(fd[1][1], "ep", 2) != 2) {
+		printf("write to pipe Failed : %d\n", errno);
+		goto errout_with_epoll;
+	}
+
+	ret = epoll_wait(epfd, evs, 2, 1000);
+	if (ret != 1 || evs[0].data.fd != fd[1][0]) {
+		printf("epoll_wait after close Failed : ret %d\n", ret);
+		goto errout_with_epoll;
+	}
+
+	for (i = 0; i < 2; i++) {
+		ret = epoll_ctl(epfd, EPOLL_CTL_DEL, fd[i][0], NULL);
+		if (ret < 0) {
+			printf("epoll_ctl DEL Failed : %d\n", errno);
+			goto errout_with_epoll;
+		}
+	}
+
+	epoll_close(epfd);
+	for (i = 0; i < 2; i++) {
+		close(fd[i][0]);
+		close(fd[i][1]);
+	}
+
+	printf("PASS!\n");
+	return OK;
+
+errout_with_epoll:
+	epoll_close(epfd);
+errout_with_pipes:
+	for (i = 0; i < 2; i++) {
+		close(fd[i][0]);
+		close(fd[i][1]);
+	}
+
+	g_tc_fail_count++;
+	return ERROR;
+}
+#endif
+
 static int fs_vfs_rename_tc(void)
 {
 	int ret;
@@ -2094,6 +2689,9 @@ static int fs_sample_launcher(int argc, char **args)
 	fs_vfs_lseek_tc();
 	fs_vfs_pwrite_tc();
 	fs_vfs_pread_tc();
+	fs_vfs_seek_perf_tc();
+	fs_vfs_stream_tc();
+	fs_vfs_multi_writer_tc();
 	fs_vfs_mkdir_tc();
 	fs_vfs_opendir_tc();
 	fs_vfs_readdir_tc();
@@ -2114,6 +2712,9 @@ static int fs_sample_launcher(int argc, char **args)
 #ifndef CONFIG_DISABLE_POLL
 	fs_vfs_poll_tc();
 	fs_vfs_select_tc();
+#endif
+#if defined(CONFIG_FS_EPOLL) && defined(CONFIG_PIPES) && (CONFIG_DEV_PIPE_SIZE > 0)
+	fs_vfs_epoll_tc();
 #endif
 	fs_vfs_rename_tc();
 	fs_vfs_ioctl_tc();
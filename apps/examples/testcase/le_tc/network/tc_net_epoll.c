@@ -0,0 +1,288 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/// @file tc_net_epoll.c
+/// @brief Test Case Example for epoll() on UDP and TCP sockets
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include "tc_internal.h"
+
+#define EPOLL_UDP_PORT    1120
+#define EPOLL_TCP_PORT    1121
+#define EPOLL_MESSAGES    3
+#define EPOLL_TIMEOUT     1000
+#define EPOLL_QUIET       100
+
+static void epoll_sockaddr(struct sockaddr_in *sa, int port)
+{
+	memset(sa, 0, sizeof(struct sockaddr_in));
+	sa->sin_family = AF_INET;
+	sa->sin_port = htons(port);
+	sa->sin_addr.s_addr = inet_addr("127.0.0.1");
+}
+
+/* Expect fd, and only fd, to be reported as readable by the next wait */
+
+static int epoll_expect_ready(int epfd, int fd)
+{
+	struct epoll_event ev;
+	int ret;
+
+	ret = epoll_wait(epfd, &ev, 1, EPOLL_TIMEOUT);
+	if (ret != 1 || ev.data.fd != fd || !(ev.events & EPOLLIN)) {
+		printf("epoll_wait: %d ready descriptors, expected fd %d\n", ret, fd);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+static int epoll_expect_quiet(int epfd)
+{
+	struct epoll_event ev;
+	int ret;
+
+	ret = epoll_wait(epfd, &ev, 1, EPOLL_QUIET);
+	if (ret != 0) {
+		printf("epoll_wait: %d ready descriptors, expected none\n", ret);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+static int epoll_add(int epfd, int fd)
+{
+	struct epoll_event ev;
+
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.fd = fd;
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		printf("epoll_ctl ADD Failed : %d\n", errno);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+/* Send EPOLL_MESSAGES messages from tx one at a time and check that each
+ * of them, not only the first one, is reported on rx.
+ */
+
+static int epoll_exchange(int epfd, int tx, int rx, FAR const struct sockaddr_in *to)
+{
+	char buf[8];
+	int i;
+
+	for (i = 0; i < EPOLL_MESSAGES; i++) {
+		ssize_t sent;
+
+		if (to != NULL) {
+			sent = sendto(tx, "epoll", 6, 0, (FAR const struct sockaddr *)to, sizeof(struct sockaddr_in));
+		} else {
+			sent = send(tx, "epoll", 6, 0);
+		}
+
+		if (sent != 6) {
+			printf("sendto Failed : %d\n", errno);
+			return ERROR;
+		}
+
+		if (epoll_expect_ready(epfd, rx) != OK) {
+			return ERROR;
+		}
+
+		if (recv(rx, buf, sizeof(buf), 0) != 6) {
+			printf("recv Failed : %d\n", errno);
+			return ERROR;
+		}
+
+		if (epoll_expect_quiet(epfd) != OK) {
+			return ERROR;
+		}
+	}
+
+	return OK;
+}
+
+static int epoll_udp(void)
+{
+	struct sockaddr_in sa;
+	char buf[8];
+	int rx;
+	int tx;
+	int epfd;
+	int ret = ERROR;
+
+	epoll_sockaddr(&sa, EPOLL_UDP_PORT);
+	rx = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	tx = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	epfd = epoll_create(1);
+	if (rx < 0 || tx < 0 || epfd < 0) {
+		printf("socket or epoll_create Failed : %d\n", errno);
+		goto errout;
+	}
+
+	if (bind(rx, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+		printf("bind Failed : %d\n", errno);
+		goto errout;
+	}
+
+	/* A datagram that arrived before the socket was added is reported,
+	 * and so are the following ones.
+	 */
+
+	sendto(tx, "epoll", 6, 0, (struct sockaddr *)&sa, sizeof(sa));
+	usleep(EPOLL_QUIET * 1000);
+	if (epoll_add(epfd, rx) != OK || epoll_expect_ready(epfd, rx) != OK) {
+		goto errout;
+	}
+
+	if (recv(rx, buf, sizeof(buf), 0) != 6 || epoll_expect_quiet(epfd) != OK) {
+		goto errout;
+	}
+
+	ret = epoll_exchange(epfd, tx, rx, &sa);
+	epoll_ctl(epfd, EPOLL_CTL_DEL, rx, NULL);
+
+errout:
+	if (epfd >= 0) {
+		epoll_close(epfd);
+	}
+	if (tx >= 0) {
+		close(tx);
+	}
+	if (rx >= 0) {
+		close(rx);
+	}
+	return ret;
+}
+
+static int epoll_tcp(void)
+{
+	struct sockaddr_in sa;
+	int listener;
+	int client;
+	int conn = -1;
+	int epfd;
+	int ret = ERROR;
+
+	epoll_sockaddr(&sa, EPOLL_TCP_PORT);
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	epfd = epoll_create(2);
+	if (listener < 0 || client < 0 || epfd < 0) {
+		printf("socket or epoll_create Failed : %d\n", errno);
+		goto errout;
+	}
+
+	if (bind(listener, (struct sockaddr *)&sa, sizeof(sa)) != 0 || listen(listener, 1) != 0) {
+		printf("bind or listen Failed : %d\n", errno);
+		goto errout;
+	}
+
+	/* An incoming connection makes the listener readable */
+
+	if (epoll_add(epfd, listener) != OK) {
+		goto errout;
+	}
+
+	if (connect(client, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+		printf("connect Failed : %d\n", errno);
+		goto errout;
+	}
+
+	if (epoll_expect_ready(epfd, listener) != OK) {
+		goto errout;
+	}
+
+	conn = accept(listener, NULL, NULL);
+	if (conn < 0) {
+		printf("accept Failed : %d\n", errno);
+		goto errout;
+	}
+
+	if (epoll_ctl(epfd, EPOLL_CTL_DEL, listener, NULL) != 0 || epoll_add(epfd, conn) != OK) {
+		goto errout;
+	}
+
+	ret = epoll_exchange(epfd, client, conn, NULL);
+	epoll_ctl(epfd, EPOLL_CTL_DEL, conn, NULL);
+
+errout:
+	if (epfd >= 0) {
+		epoll_close(epfd);
+	}
+	if (conn >= 0) {
+		close(conn);
+	}
+	if (client >= 0) {
+		close(client);
+	}
+	if (listener >= 0) {
+		close(listener);
+	}
+	return ret;
+}
+
+/**
+* @testcase		tc_net_epoll_udp_p
+* @brief		Every datagram received on a UDP socket is reported by epoll_wait()
+* @scenario		Add a socket which already holds a datagram, then receive several more one at a time
+* @apicovered		epoll_create(), epoll_ctl(), epoll_wait(), epoll_close()
+* @precondition		The loopback interface is up
+* @postcondition	none
+*/
+static void tc_net_epoll_udp_p(void)
+{
+	TC_ASSERT_EQ("epoll_udp", epoll_udp(), OK);
+	TC_SUCCESS_RESULT();
+}
+
+/**
+* @testcase		tc_net_epoll_tcp_p
+* @brief		A connection and every segment received on it are reported by epoll_wait()
+* @scenario		Wait for a connection on a listening socket, then receive several messages one at a time
+* @apicovered		epoll_create(), epoll_ctl(), epoll_wait(), epoll_close()
+* @precondition		The loopback interface is up
+* @postcondition	none
+*/
+static void tc_net_epoll_tcp_p(void)
+{
+	TC_ASSERT_EQ("epoll_tcp", epoll_tcp(), OK);
+	TC_SUCCESS_RESULT();
+}
+
+/****************************************************************************
+ * Name: epoll()
+ ****************************************************************************/
+
+int net_epoll_main(void)
+{
+	tc_net_epoll_udp_p();
+	tc_net_epoll_tcp_p();
+	return 0;
+}
@@ -0,0 +1,204 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/// @file tc_net_mbox.c
+/// @brief Test Case Example for the lwIP mailbox of the OS abstraction
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <net/lwip/opt.h>
+#include <net/lwip/sys.h>
+
+#include "tc_internal.h"
+
+#define MBOX_SIZE         16
+#define MBOX_PRODUCERS    4
+#define MBOX_MESSAGES     10000
+#define MBOX_BATCH        8
+
+/* Message posted by a producer: producer number and sequence number.
+ * Sequence numbers start at 1 so that no message is a NULL pointer.
+ */
+
+#define MBOX_MSG(p, seq) ((void *)(((unsigned long)(p) << 24) | (seq)))
+#define MBOX_MSG_PRODUCER(m) ((unsigned long)(m) >> 24)
+#define MBOX_MSG_SEQ(m) ((unsigned long)(m) & 0xffffff)
+
+static sys_mbox_t mbox;
+
+static void *mbox_producer(void *arg)
+{
+	unsigned long p = (unsigned long)arg;
+	unsigned long seq;
+
+	for (seq = 1; seq <= MBOX_MESSAGES; seq++) {
+		sys_mbox_post(&mbox, MBOX_MSG(p, seq));
+	}
+
+	return NULL;
+}
+
+/* Receive nproducers * MBOX_MESSAGES messages, checking that the messages
+ * of each producer arrive in order, and report the throughput.
+ */
+
+static int mbox_consume(int nproducers, u32_t batch)
+{
+	unsigned long last[MBOX_PRODUCERS];
+	pthread_t producer[MBOX_PRODUCERS];
+	void *msgs[MBOX_BATCH + 1];
+	unsigned long total = (unsigned long)nproducers * MBOX_MESSAGES;
+	unsigned long n = 0;
+	u32_t start;
+	u32_t elapsed;
+	u32_t count;
+	u32_t i;
+	int ret = OK;
+	int p;
+
+	for (p = 0; p < nproducers; p++) {
+		last[p] = 0;
+	}
+
+	start = sys_now();
+	for (p = 0; p < nproducers; p++) {
+		if (pthread_create(&producer[p], NULL, mbox_producer, (void *)(unsigned long)p) != 0) {
+			printf("pthread_create Failed : %d\n", p);
+			nproducers = p;
+			total = (unsigned long)p * MBOX_MESSAGES;
+			ret = ERROR;
+			break;
+		}
+	}
+
+	/* Keep draining on an error so that no producer stays blocked */
+
+	while (n < total) {
+		(void)sys_arch_mbox_fetch(&mbox, &msgs[0], 0);
+		count = 1;
+		if (batch > 0) {
+			count += sys_arch_mbox_tryfetch_n(&mbox, &msgs[1], batch);
+		}
+
+		for (i = 0; i < count; i++) {
+			p = MBOX_MSG_PRODUCER(msgs[i]);
+			if (p >= nproducers || MBOX_MSG_SEQ(msgs[i]) != last[p] + 1) {
+				ret = ERROR;
+				continue;
+			}
+
+			last[p] = MBOX_MSG_SEQ(msgs[i]);
+		}
+
+		n += count;
+	}
+
+	elapsed = sys_now() - start;
+	for (p = 0; p < nproducers; p++) {
+		pthread_join(producer[p], NULL);
+	}
+
+	if (sys_arch_mbox_tryfetch(&mbox, NULL) != SYS_MBOX_EMPTY) {
+		ret = ERROR;
+	}
+
+	printf("mbox: %d producer(s), batch %u: %lu msgs in %u ms", nproducers, batch, n, elapsed);
+	if (elapsed > 0) {
+		printf(", %lu msgs/s", (unsigned long)(n * 1000ULL / elapsed));
+	}
+	printf("\n");
+
+	return ret;
+}
+
+/**
+* @testcase		tc_net_mbox_fifo_p
+* @brief		Fill and drain the mailbox without blocking
+* @scenario		Post until the mailbox is full, then fetch one, several and the rest
+* @apicovered		sys_mbox_trypost(), sys_arch_mbox_tryfetch(), sys_arch_mbox_tryfetch_n(), sys_arch_mbox_fetch()
+* @precondition		The mailbox has been created
+* @postcondition	The mailbox is empty
+*/
+static void tc_net_mbox_fifo_p(void)
+{
+	void *msgs[MBOX_SIZE];
+	void *msg;
+	unsigned long i;
+
+	TC_ASSERT_EQ("sys_arch_mbox_tryfetch", sys_arch_mbox_tryfetch(&mbox, &msg), SYS_MBOX_EMPTY);
+	TC_ASSERT_EQ("sys_arch_mbox_tryfetch_n", sys_arch_mbox_tryfetch_n(&mbox, msgs, MBOX_SIZE), 0);
+
+	for (i = 1; i <= MBOX_SIZE; i++) {
+		TC_ASSERT_EQ("sys_mbox_trypost", sys_mbox_trypost(&mbox, MBOX_MSG(0, i)), ERR_OK);
+	}
+	TC_ASSERT_EQ("sys_mbox_trypost", sys_mbox_trypost(&mbox, MBOX_MSG(0, i)), ERR_MEM);
+
+	TC_ASSERT_NEQ("sys_arch_mbox_tryfetch", sys_arch_mbox_tryfetch(&mbox, &msg), SYS_MBOX_EMPTY);
+	TC_ASSERT("sys_arch_mbox_tryfetch", msg == MBOX_MSG(0, 1));
+
+	TC_ASSERT_EQ("sys_arch_mbox_tryfetch_n", sys_arch_mbox_tryfetch_n(&mbox, msgs, 4), 4);
+	for (i = 0; i < 4; i++) {
+		TC_ASSERT("sys_arch_mbox_tryfetch_n", msgs[i] == MBOX_MSG(0, i + 2));
+	}
+
+	TC_ASSERT_EQ("sys_arch_mbox_tryfetch_n", sys_arch_mbox_tryfetch_n(&mbox, msgs, MBOX_SIZE), MBOX_SIZE - 5);
+	TC_ASSERT("sys_arch_mbox_tryfetch_n", msgs[0] == MBOX_MSG(0, 6));
+	TC_ASSERT_EQ("sys_arch_mbox_fetch", sys_arch_mbox_fetch(&mbox, &msg, 10), SYS_ARCH_TIMEOUT);
+	TC_SUCCESS_RESULT();
+}
+
+/**
+* @testcase		tc_net_mbox_throughput_p
+* @brief		Message throughput of one consumer, with and without batch fetch
+* @scenario		One and MBOX_PRODUCERS producers post MBOX_MESSAGES messages each
+* @apicovered		sys_mbox_post(), sys_arch_mbox_fetch(), sys_arch_mbox_tryfetch_n()
+* @precondition		The mailbox has been created
+* @postcondition	The mailbox is empty
+*/
+static void tc_net_mbox_throughput_p(void)
+{
+	TC_ASSERT_EQ("mbox_consume", mbox_consume(1, 0), OK);
+	TC_ASSERT_EQ("mbox_consume", mbox_consume(1, MBOX_BATCH), OK);
+	TC_ASSERT_EQ("mbox_consume", mbox_consume(MBOX_PRODUCERS, 0), OK);
+	TC_ASSERT_EQ("mbox_consume", mbox_consume(MBOX_PRODUCERS, MBOX_BATCH), OK);
+	TC_SUCCESS_RESULT();
+}
+
+/****************************************************************************
+ * Name: mbox()
+ ****************************************************************************/
+
+int net_mbox_main(void)
+{
+	if (sys_mbox_new(&mbox, MBOX_SIZE) != ERR_OK) {
+		printf("sys_mbox_new Failed\n");
+		total_fail++;
+		return ERROR;
+	}
+
+	tc_net_mbox_fifo_p();
+
+	/* Start from an empty mailbox even if the previous test failed */
+
+	while (sys_arch_mbox_tryfetch(&mbox, NULL) != SYS_MBOX_EMPTY) ;
+	tc_net_mbox_throughput_p();
+
+	sys_mbox_free(&mbox);
+	return 0;
+}
@@ -0,0 +1,285 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <arastorage/arastorage.h>
+#include <apps/shell/tash.h>
+#include <tinyara/fs/fs_utils.h>
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+#define RELATION_NAME "perf"
+#define QUERY_LENGTH 128
+
+#ifndef CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF_ROWS
+#define CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF_ROWS 500
+#endif
+
+#ifndef CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF_LOOPS
+#define CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF_LOOPS 10
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+static char g_query[QUERY_LENGTH];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+static unsigned long perf_elapsed_msec(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_usec - start->tv_usec) / 1000;
+}
+
+static void perf_report(const char *name, unsigned long rows, unsigned long msec)
+{
+	if (msec == 0) {
+		msec = 1;
+	}
+	printf("%-24s %6lu rows %8lu msec %8lu rows/sec\n", name, rows, msec, rows * 1000 / msec);
+}
+
+static int perf_arastorage_setup(int nrows)
+{
+	struct timeval start;
+	db_stmt_t *stmt;
+	char name[16];
+	int i;
+
+	if (db_init() != DB_OK) {
+		printf("db_init failed\n");
+		return ERROR;
+	}
+
+	snprintf(g_query, QUERY_LENGTH, "REMOVE RELATION %s;", RELATION_NAME);
+	db_exec(g_query);
+
+	snprintf(g_query, QUERY_LENGTH, "CREATE RELATION %s;", RELATION_NAME);
+	if (db_exec(g_query) != DB_OK) {
+		goto errout;
+	}
+	snprintf(g_query, QUERY_LENGTH, "CREATE ATTRIBUTE id DOMAIN int IN %s;", RELATION_NAME);
+	if (db_exec(g_query) != DB_OK) {
+		goto errout;
+	}
+	snprintf(g_query, QUERY_LENGTH, "CREATE ATTRIBUTE value DOMAIN long IN %s;", RELATION_NAME);
+	if (db_exec(g_query) != DB_OK) {
+		goto errout;
+	}
+	snprintf(g_query, QUERY_LENGTH, "CREATE ATTRIBUTE name DOMAIN string(16) IN %s;", RELATION_NAME);
+	if (db_exec(g_query) != DB_OK) {
+		goto errout;
+	}
+
+	/* Insert the first third of the rows with queries built for each row,
+	   the second with a prepared statement and the rest in one batch. */
+	gettimeofday(&start, NULL);
+	for (i = 0; i < nrows / 3; i++) {
+		snprintf(g_query, QUERY_LENGTH, "INSERT (%d, %d, 'name%d') INTO %s;", i, i % 100, i, RELATION_NAME);
+		if (db_exec(g_query) != DB_OK) {
+			printf("Failed to insert row %d\n", i);
+			goto errout;
+		}
+	}
+	perf_report("INSERT", nrows / 3, perf_elapsed_msec(&start));
+
+	snprintf(g_query, QUERY_LENGTH, "INSERT (?, ?, ?) INTO %s;", RELATION_NAME);
+	stmt = db_prepare(g_query);
+	if (stmt == NULL) {
+		goto errout;
+	}
+
+	gettimeofday(&start, NULL);
+	for (; i < nrows * 2 / 3; i++) {
+		snprintf(name, sizeof(name), "name%d", i);
+		db_bind_int(stmt, 0, i);
+		db_bind_long(stmt, 1, i % 100);
+		db_bind_string(stmt, 2, name);
+		if (db_stmt_exec(stmt) != DB_OK) {
+			printf("Failed to insert row %d\n", i);
+			db_stmt_free(stmt);
+			goto errout;
+		}
+	}
+	perf_report("INSERT prepared", nrows * 2 / 3 - nrows / 3, perf_elapsed_msec(&start));
+
+	gettimeofday(&start, NULL);
+	for (; i < nrows; i++) {
+		snprintf(name, sizeof(name), "name%d", i);
+		db_bind_int(stmt, 0, i);
+		db_bind_long(stmt, 1, i % 100);
+		db_bind_string(stmt, 2, name);
+		if (db_stmt_add_batch(stmt) != DB_OK) {
+			printf("Failed to add row %d\n", i);
+			db_stmt_free(stmt);
+			goto errout;
+		}
+	}
+	if (db_stmt_exec_batch(stmt) != DB_OK) {
+		printf("Failed to insert the batch\n");
+		db_stmt_free(stmt);
+		goto errout;
+	}
+	perf_report("INSERT batch", nrows - nrows * 2 / 3, perf_elapsed_msec(&start));
+	db_stmt_free(stmt);
+
+	return OK;
+
+errout:
+	printf("Failed to create relation %s\n", RELATION_NAME);
+	db_deinit();
+	return ERROR;
+}
+
+static int perf_arastorage_query(const char *name, const char *query, int nrows, int loops)
+{
+	struct timeval start;
+	db_cursor_t *cursor;
+	int i;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < loops; i++) {
+		cursor = db_query((char *)query);
+		if (cursor == NULL) {
+			printf("%s failed : %s\n", name, query);
+			return ERROR;
+		}
+		db_cursor_free(cursor);
+	}
+	perf_report(name, (unsigned long)nrows * loops, perf_elapsed_msec(&start));
+
+	return OK;
+}
+
+static int perf_arastorage_prepared_query(const char *name, const char *query, int nrows, int loops)
+{
+	struct timeval start;
+	db_stmt_t *stmt;
+	db_cursor_t *cursor;
+	int i;
+
+	stmt = db_prepare((char *)query);
+	if (stmt == NULL) {
+		printf("%s failed : %s\n", name, query);
+		return ERROR;
+	}
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < loops; i++) {
+		db_bind_long(stmt, 0, i % 100);
+		cursor = db_stmt_query(stmt);
+		if (cursor == NULL) {
+			printf("%s failed : %s\n", name, query);
+			db_stmt_free(stmt);
+			return ERROR;
+		}
+		db_cursor_free(cursor);
+	}
+	perf_report(name, (unsigned long)nrows * loops, perf_elapsed_msec(&start));
+	db_stmt_free(stmt);
+
+	return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+int perf_arastorage_launcher(int argc, FAR char *argv[])
+{
+	int nrows;
+	int loops;
+
+	nrows = CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF_ROWS;
+	loops = CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF_LOOPS;
+	if (argc > 1) {
+		nrows = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		loops = atoi(argv[2]);
+	}
+	if (nrows <= 0 || loops <= 0) {
+		printf("Usage : %s [rows] [loops]\n", argv[0]);
+		return ERROR;
+	}
+
+#ifdef CONFIG_FS_SMARTFS
+	if (fs_erase("/dev/smart1") != OK) {
+		printf("Error erasing file system, STOP TEST!!\n");
+		return ERROR;
+	}
+
+	if (fs_initiate("/dev/smart1", "smartfs") != OK) {
+		printf("Error initiating file system, STOP TEST!!\n");
+		return ERROR;
+	}
+#endif
+
+	printf("\n#########################################\n");
+	printf("    Arastorage Performance : %d rows\n", nrows);
+	printf("#########################################\n");
+
+	if (perf_arastorage_setup(nrows) != OK) {
+		return ERROR;
+	}
+
+	/* Full scans, the first without a predicate */
+	snprintf(g_query, QUERY_LENGTH, "SELECT id, value, name FROM %s;", RELATION_NAME);
+	perf_arastorage_query("SELECT scan", g_query, nrows, loops);
+	snprintf(g_query, QUERY_LENGTH, "SELECT id, value FROM %s WHERE value > 49;", RELATION_NAME);
+	perf_arastorage_query("SELECT scan with WHERE", g_query, nrows, loops);
+
+	/* Predicates with several comparisons and arithmetic */
+	snprintf(g_query, QUERY_LENGTH, "SELECT id, value FROM %s WHERE value > 9 AND value < 90 AND id > 7;", RELATION_NAME);
+	perf_arastorage_query("SELECT with AND", g_query, nrows, loops);
+	snprintf(g_query, QUERY_LENGTH, "SELECT id, value FROM %s WHERE value * 2 + 1 > 99 OR value < 10;", RELATION_NAME);
+	perf_arastorage_query("SELECT with arithmetic", g_query, nrows, loops);
+
+	/* The same predicate with a parameter bound for each execution */
+	snprintf(g_query, QUERY_LENGTH, "SELECT id, value FROM %s WHERE value > ?;", RELATION_NAME);
+	perf_arastorage_prepared_query("SELECT prepared", g_query, nrows, loops);
+
+	db_deinit();
+
+	return OK;
+}
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int perf_arastorage_main(int argc, char *argv[])
+#endif
+{
+#ifdef CONFIG_TASH
+	tash_cmd_install("arastorage_perf", perf_arastorage_launcher, TASH_EXECMD_SYNC);
+#else
+	perf_arastorage_launcher(argc, argv);
+#endif
+	return 0;
+}
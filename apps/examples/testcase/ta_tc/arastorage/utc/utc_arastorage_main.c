@@ -45,6 +45,8 @@
 
 static db_cursor_t *g_cursor;
 
+static db_stmt_t *g_stmt;
+
 static int g_arastorage_tc_count;
 
 static int g_arastorage_tc_fail_count;
@@ -620,6 +622,456 @@ void utc_arastorage_db_cursor_free_tc_n(void)
 	printf("PASS\n");
 }
 
+void utc_arastorage_db_prepare_tc_p(void)
+{
+	char query[QUERY_LENGTH];
+	printf("%d. db_prepare Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+#ifdef CONFIG_ARCH_FLOAT_H
+	snprintf(query, QUERY_LENGTH, "INSERT (?, ?, ?, %f) INTO %s;", 11.0011, RELATION_NAME);
+#else
+	snprintf(query, QUERY_LENGTH, "INSERT (?, ?, ?) INTO %s;", RELATION_NAME);
+#endif
+	g_stmt = db_prepare(query);
+	if (g_stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_prepare_tc_n(void)
+{
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	printf("%d. db_prepare Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	snprintf(query, QUERY_LENGTH, "INSERT (?, ? INTO %s;", RELATION_NAME);
+	stmt = db_prepare(query);
+	if (stmt != NULL) {
+		printf("db_prepare Failed with wrong query\n");
+		db_stmt_free(stmt);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	stmt = db_prepare(NULL);
+	if (stmt != NULL) {
+		printf("db_prepare Failed with NULL value\n");
+		db_stmt_free(stmt);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_bind_int_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_bind_int Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_bind_int(g_stmt, 0, DATA_SET_NUM + 1);
+	if (DB_ERROR(res)) {
+		printf("db_bind_int Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_bind_int_tc_n(void)
+{
+	db_result_t res;
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	printf("%d. db_bind_int Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	res = db_bind_int(NULL, 0, 1);
+	if (DB_SUCCESS(res)) {
+		printf("db_bind_int Failed with NULL statement\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Try to bind a parameter which is not in the query */
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s > ?;", g_attribute_set[0],
+			 RELATION_NAME, g_attribute_set[0]);
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	res = db_bind_int(stmt, 1, 1);
+	db_stmt_free(stmt);
+	if (DB_SUCCESS(res)) {
+		printf("db_bind_int Failed with wrong index\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_bind_long_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_bind_long Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_bind_long(g_stmt, 1, 20160111);
+	if (DB_ERROR(res)) {
+		printf("db_bind_long Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_bind_long_tc_n(void)
+{
+	db_result_t res;
+	printf("%d. db_bind_long Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	res = db_bind_long(NULL, 0, 1);
+	if (DB_SUCCESS(res)) {
+		printf("db_bind_long Failed with NULL statement\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_bind_string_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_bind_string Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_bind_string(g_stmt, 2, "grape");
+	if (DB_ERROR(res)) {
+		printf("db_bind_string Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_bind_string_tc_n(void)
+{
+	db_result_t res;
+	printf("%d. db_bind_string Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	res = db_bind_string(NULL, 0, "grape");
+	if (DB_SUCCESS(res)) {
+		printf("db_bind_string Failed with NULL statement\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_exec_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_stmt_exec Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_stmt_exec(g_stmt);
+	if (DB_ERROR(res)) {
+		printf("db_stmt_exec Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_exec_tc_n(void)
+{
+	db_result_t res;
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	printf("%d. db_stmt_exec Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	res = db_stmt_exec(NULL);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_exec Failed with NULL statement\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Try to execute a statement without binding its parameters */
+	snprintf(query, QUERY_LENGTH, "INSERT (?, ?, ?) INTO %s;", RELATION_NAME);
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	res = db_stmt_exec(stmt);
+	db_stmt_free(stmt);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_exec Failed with unbound parameters\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_query_tc_p(void)
+{
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	db_cursor_t *cursor;
+	tuple_id_t count;
+	printf("%d. db_stmt_query Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	snprintf(query, QUERY_LENGTH, "SELECT %s, %s, %s FROM %s WHERE %s > ?;", g_attribute_set[0],
+			 g_attribute_set[1], g_attribute_set[2], RELATION_NAME, g_attribute_set[0]);
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	db_bind_int(stmt, 0, DATA_SET_NUM);
+	cursor = db_stmt_query(stmt);
+	db_stmt_free(stmt);
+	if (cursor == NULL) {
+		printf("db_stmt_query Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Only the row inserted by db_stmt_exec matches */
+	count = cursor_get_count(cursor);
+	db_cursor_free(cursor);
+	if (count != 1) {
+		printf("db_stmt_query Failed : count %d\n", count);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_query_tc_n(void)
+{
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	db_cursor_t *cursor;
+	printf("%d. db_stmt_query Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	cursor = db_stmt_query(NULL);
+	if (cursor != NULL) {
+		printf("db_stmt_query Failed with NULL statement\n");
+		db_cursor_free(cursor);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Try to query with a string compared as a number */
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s > ?;", g_attribute_set[0],
+			 RELATION_NAME, g_attribute_set[0]);
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	db_bind_string(stmt, 0, "grape");
+	cursor = db_stmt_query(stmt);
+	db_stmt_free(stmt);
+	if (cursor != NULL) {
+		printf("db_stmt_query Failed with string parameter\n");
+		db_cursor_free(cursor);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_add_batch_tc_p(void)
+{
+	db_result_t res;
+	int i;
+	printf("%d. db_stmt_add_batch Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	for (i = DATA_SET_NUM + 2; i <= DATA_SET_NUM + 4; i++) {
+		db_bind_int(g_stmt, 0, i);
+		res = db_stmt_add_batch(g_stmt);
+		if (DB_ERROR(res)) {
+			printf("db_stmt_add_batch Failed : %d\n", res);
+			g_arastorage_tc_fail_count++;
+			return;
+		}
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_add_batch_tc_n(void)
+{
+	db_result_t res;
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	printf("%d. db_stmt_add_batch Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	res = db_stmt_add_batch(NULL);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_add_batch Failed with NULL statement\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Try to add a tuple without binding its parameters */
+	snprintf(query, QUERY_LENGTH, "INSERT (?, ?, ?) INTO %s;", RELATION_NAME);
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	res = db_stmt_add_batch(stmt);
+	db_stmt_free(stmt);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_add_batch Failed with unbound parameters\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_exec_batch_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_stmt_exec_batch Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_stmt_exec_batch(g_stmt);
+	if (DB_ERROR(res)) {
+		printf("db_stmt_exec_batch Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_exec_batch_tc_n(void)
+{
+	db_result_t res;
+	char query[QUERY_LENGTH];
+	db_stmt_t *stmt;
+	printf("%d. db_stmt_exec_batch Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	res = db_stmt_exec_batch(NULL);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_exec_batch Failed with NULL statement\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Try to insert a batch with a tuple in the wrong domain */
+	snprintf(query, QUERY_LENGTH, "INSERT (?, ?, ?) INTO %s;", RELATION_NAME);
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	db_bind_string(stmt, 0, "grape");
+	db_bind_long(stmt, 1, 20160111);
+	db_bind_string(stmt, 2, "grape");
+	db_stmt_add_batch(stmt);
+	res = db_stmt_exec_batch(stmt);
+	db_stmt_free(stmt);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_exec_batch Failed with wrong domain\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_free_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_stmt_free Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_stmt_free(g_stmt);
+	if (DB_ERROR(res)) {
+		printf("db_stmt_free Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	g_stmt = NULL;
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_stmt_free_tc_n(void)
+{
+	db_result_t res;
+	printf("%d. db_stmt_free Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_stmt_free(NULL);
+	if (DB_SUCCESS(res)) {
+		printf("db_stmt_free Failed with NULL value\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_set_default_index_cache_size_tc_p(void)
+{
+	db_result_t res;
+	printf("%d. db_set_default_index_cache_size Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_set_default_index_cache_size(16, 8);
+	if (DB_ERROR(res)) {
+		printf("db_set_default_index_cache_size Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_set_default_index_cache_size_tc_n(void)
+{
+	db_result_t res;
+	printf("%d. db_set_default_index_cache_size Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_set_default_index_cache_size(0, 8);
+	if (DB_SUCCESS(res)) {
+		printf("db_set_default_index_cache_size Failed with zero nodes\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	res = db_set_default_index_cache_size(16, 256);
+	if (DB_SUCCESS(res)) {
+		printf("db_set_default_index_cache_size Failed with too many buckets\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_get_index_cache_stats_tc_p(void)
+{
+	db_result_t res;
+	db_index_cache_stats_t stats;
+	printf("%d. db_get_index_cache_stats Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_get_index_cache_stats(&stats);
+	if (DB_ERROR(res)) {
+		printf("db_get_index_cache_stats Failed : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	/* The index was used by the inserts and queries above */
+	if (stats.node_hits + stats.node_misses == 0) {
+		printf("db_get_index_cache_stats Failed : no node access counted\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
+void utc_arastorage_db_get_index_cache_stats_tc_n(void)
+{
+	db_result_t res;
+	printf("%d. db_get_index_cache_stats Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	res = db_get_index_cache_stats(NULL);
+	if (DB_SUCCESS(res)) {
+		printf("db_get_index_cache_stats Failed with NULL value\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS!\n");
+}
+
 void utc_arastorage_cursor_get_count_tc_p(void)
 {
 	tuple_id_t count;
@@ -1463,6 +1915,17 @@ int arastorage_sample_launcher(int argc, FAR char *argv[])
 #endif
 	utc_arastorage_cursor_get_string_value_tc_p();
 	utc_arastorage_db_cursor_free_tc_p();
+	utc_arastorage_db_prepare_tc_p();
+	utc_arastorage_db_bind_int_tc_p();
+	utc_arastorage_db_bind_long_tc_p();
+	utc_arastorage_db_bind_string_tc_p();
+	utc_arastorage_db_stmt_exec_tc_p();
+	utc_arastorage_db_stmt_query_tc_p();
+	utc_arastorage_db_stmt_add_batch_tc_p();
+	utc_arastorage_db_stmt_exec_batch_tc_p();
+	utc_arastorage_db_stmt_free_tc_p();
+	utc_arastorage_db_set_default_index_cache_size_tc_p();
+	utc_arastorage_db_get_index_cache_stats_tc_p();
 	utc_arastorage_db_deinit_tc_p();
 
 	printf("#########################################\n");
@@ -1501,6 +1964,17 @@ int arastorage_sample_launcher(int argc, FAR char *argv[])
 #endif
 	utc_arastorage_cursor_get_string_value_tc_n();
 	utc_arastorage_db_cursor_free_tc_n();
+	utc_arastorage_db_prepare_tc_n();
+	utc_arastorage_db_bind_int_tc_n();
+	utc_arastorage_db_bind_long_tc_n();
+	utc_arastorage_db_bind_string_tc_n();
+	utc_arastorage_db_stmt_exec_tc_n();
+	utc_arastorage_db_stmt_query_tc_n();
+	utc_arastorage_db_stmt_add_batch_tc_n();
+	utc_arastorage_db_stmt_exec_batch_tc_n();
+	utc_arastorage_db_stmt_free_tc_n();
+	utc_arastorage_db_set_default_index_cache_size_tc_n();
+	utc_arastorage_db_get_index_cache_stats_tc_n();
 	db_deinit();
 
 
@@ -26,7 +26,7 @@
 #include <sys/types.h>
 #include <semaphore.h>
 
-#if defined(CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_UTC) || defined(CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_ITC)
+#if defined(CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_UTC) || defined(CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_ITC) || defined(CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF)
 #define TC_ARASTORAGE_STACK       4096
 #endif
 #ifdef CONFIG_EXAMPLES_TESTCASE_FILESYSTEM
@@ -59,6 +59,7 @@ extern int network_tc_main(int argc, char *argv[]);
 /* TinyAra Public API Test Case as ta_tc */
 extern int utc_arastorage_main(int argc, char *argv[]);
 extern int itc_arastorage_main(int argc, char *argv[]);
+extern int perf_arastorage_main(int argc, char *argv[]);
 extern int utc_sysio_main(int argc, char *argv[]);
 extern int itc_sysio_main(int argc, char *argv[]);
 extern int utc_dm_main(int argc, char *argv[]);
@@ -90,6 +91,13 @@ int tc_main(int argc, char *argv[])
 		printf("Arastorage itc is not started, err = %d\n", pid);
 	}
 #endif
+
+#ifdef CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_PERF
+	pid = task_create("arastorageperf", SCHED_PRIORITY_DEFAULT, TC_ARASTORAGE_STACK, perf_arastorage_main, argv);
+	if (pid < 0) {
+		printf("Arastorage perf is not started, err = %d\n", pid);
+	}
+#endif
 #ifdef CONFIG_EXAMPLES_TESTCASE_FILESYSTEM
 	pid = task_create("fstc", SCHED_PRIORITY_DEFAULT, TC_FS_STACK, fs_main, argv);
 	if (pid < 0) {
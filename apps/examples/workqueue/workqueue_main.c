@@ -21,6 +21,7 @@
 
 #include <tinyara/config.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <tinyara/clock.h>
 #include <tinyara/wqueue.h>
 
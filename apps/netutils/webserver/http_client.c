@@ -17,6 +17,10 @@
  ****************************************************************************/
 
 #include <fcntl.h>
+#include <sys/stat.h>
+#ifdef CONFIG_NET_SENDFILE
+#include <sys/sendfile.h>
+#endif
 #include <apps/netutils/webserver/http_err.h>
 #include <apps/netutils/webserver/http_keyvalue_list.h>
 #include <apps/netutils/webclient.h>
@@ -450,19 +454,102 @@ int http_recv_and_handle_request(struct http_client_t *client, struct http_keyva
 	return HTTP_ERROR;
 }
 
+static int http_send_data(struct http_client_t *client, const char *buf, int sndlen)
+{
+	int buflen = 0;
+	int ret;
+
+	while (sndlen > 0) {
+#ifdef CONFIG_NET_SECURITY_TLS
+		if (client->server->tls_init) {
+			ret = mbedtls_ssl_write(&(client->tls_ssl), (unsigned char *)buf + buflen, sndlen);
+		} else
+#endif
+		{
+			ret = send(client->client_fd, buf + buflen, sndlen, 0);
+		}
+
+		if (ret < 1) {
+			return HTTP_ERROR;
+		} else {
+			sndlen -= ret;
+			buflen += ret;
+		}
+	}
+
+	return HTTP_OK;
+}
+
+/* Send the whole file as the body of a 200 response.  Plain connections use
+ * sendfile() so the file data is not copied again by the stack.
+ */
+static int http_send_file(struct http_client_t *client, int fd, off_t size)
+{
+	char *buf;
+	ssize_t len;
+	int ret = HTTP_OK;
+
+	buf = HTTP_MALLOC(HTTP_CONF_MAX_ENTITY_LENGTH);
+	if (buf == NULL) {
+		HTTP_LOGE("Error: Fail to malloc buffer\n");
+		return HTTP_ERROR;
+	}
+
+	len = snprintf(buf, HTTP_CONF_MAX_ENTITY_LENGTH, "HTTP/1.1 200 OK\r\n" "Content-type: text/html\r\n" "Connection: close\r\n" "Content-Length: %ld\r\n" "\r\n", (long)size);
+	if (http_send_data(client, buf, len) == HTTP_ERROR) {
+		HTTP_FREE(buf);
+		return HTTP_ERROR;
+	}
+
+#ifdef CONFIG_NET_SENDFILE
+#ifdef CONFIG_NET_SECURITY_TLS
+	if (!client->server->tls_init)
+#endif
+	{
+		HTTP_FREE(buf);
+		while (size > 0) {
+			len = sendfile(client->client_fd, fd, NULL, size);
+			if (len <= 0) {
+				return HTTP_ERROR;
+			}
+			size -= len;
+		}
+		return HTTP_OK;
+	}
+#endif
+
+	while (size > 0) {
+		len = read(fd, buf, HTTP_CONF_MAX_ENTITY_LENGTH);
+		if (len <= 0 || http_send_data(client, buf, len) == HTTP_ERROR) {
+			ret = HTTP_ERROR;
+			break;
+		}
+		size -= len;
+	}
+	HTTP_FREE(buf);
+
+	return ret;
+}
+
 void http_handle_file(struct http_client_t *client, int method, const char *url, char *entity)
 {
 	FILE *f;
+	int fd;
+	struct stat st;
 	char path[HTTP_CONF_MAX_REQUEST_HEADER_URL_LENGTH + 1] = ".";
 
 	switch (method) {
 	case HTTP_METHOD_GET:
-		if ((f = fopen(url, "r")) != NULL) {
-			fgets(entity, HTTP_CONF_MAX_ENTITY_LENGTH, f);
-			if (http_send_response(client, 200, entity, NULL) == HTTP_ERROR) {
+		if ((fd = open(url, O_RDONLY)) >= 0) {
+			if (fstat(fd, &st) < 0) {
+				HTTP_LOGE("fail to stat %s\n", url);
+				if (http_send_response(client, 500, HTTP_ERROR_500, NULL) == HTTP_ERROR) {
+					HTTP_LOGE("Error: Fail to send response\n");
+				}
+			} else if (http_send_file(client, fd, st.st_size) == HTTP_ERROR) {
 				HTTP_LOGE("Error: Fail to send response\n");
 			}
-			fclose(f);
+			close(fd);
 		} else {
 			if (http_send_response(client, 404, HTTP_ERROR_404, NULL) == HTTP_ERROR) {
 				HTTP_LOGE("Error: Fail to send response\n");
@@ -521,7 +608,6 @@ int http_send_response(struct http_client_t *client, int status, const char *bod
 	char *buf;
 	int buflen = 0;
 	int ret;
-	int sndlen;
 	struct http_keyvalue_t *cur = NULL;
 
 	buf = HTTP_MALLOC(HTTP_CONF_MAX_REQUEST_LENGTH);
@@ -560,27 +646,8 @@ int http_send_response(struct http_client_t *client, int status, const char *bod
 		}
 	}
 
-	sndlen = strlen(buf);
-	buflen = 0;
-	while (sndlen > 0) {
-#ifdef CONFIG_NET_SECURITY_TLS
-		if (client->server->tls_init) {
-			ret = mbedtls_ssl_write(&(client->tls_ssl), (unsigned char *)buf + buflen, sndlen);
-		} else
-#endif
-		{
-			ret = send(client->client_fd, buf + buflen, sndlen, 0);
-		}
-
-		if (ret < 1) {
-			HTTP_FREE(buf);
-			return HTTP_ERROR;
-		} else {
-			sndlen -= ret;
-			buflen += ret;
-		}
-	}
+	ret = http_send_data(client, buf, strlen(buf));
 	HTTP_FREE(buf);
 
-	return HTTP_OK;
+	return ret;
 }
@@ -162,6 +162,9 @@ typedef struct _db_handle_s db_handle_t;
 struct _db_cursor_s;
 typedef struct _db_cursor_s db_cursor_t;
 
+struct _db_stmt_s;
+typedef struct _db_stmt_s db_stmt_t;
+
 typedef int db_storage_id_t;
 
 typedef uint32_t cursor_row_t;
@@ -170,6 +173,14 @@ typedef uint32_t tuple_id_t;
 
 typedef uint8_t attribute_id_t;
 
+struct db_index_cache_stats_s {
+	uint32_t node_hits;
+	uint32_t node_misses;
+	uint32_t bucket_hits;
+	uint32_t bucket_misses;
+};
+typedef struct db_index_cache_stats_s db_index_cache_stats_t;
+
 /****************************************************************************
 * Public Variables
 ****************************************************************************/
@@ -219,6 +230,119 @@ db_result_t db_exec(char *format);
 */
 db_cursor_t *db_query(char *format);
 
+/**
+* @brief Prepare a query sentence for repeated execution. Each '?' in place of a value
+*        in INSERT or of a number in the WHERE condition is a parameter to be bound.
+*
+* @param[in] query sentence
+* @return On success, pointer of db_stmt_t is returned. On failure, a NULL is returned.
+* @since Tizen RT v1.1
+*/
+db_stmt_t *db_prepare(char *format);
+
+/**
+* @brief Bind an int value to a parameter of a prepared statement.
+*
+* @param[in] prepared statement
+* @param[in] index of the parameter, starting from 0 in the order of the '?'s
+* @param[in] value of the parameter
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_bind_int(db_stmt_t *stmt, int param_index, int value);
+
+/**
+* @brief Bind a long value to a parameter of a prepared statement.
+*
+* @param[in] prepared statement
+* @param[in] index of the parameter, starting from 0 in the order of the '?'s
+* @param[in] value of the parameter
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_bind_long(db_stmt_t *stmt, int param_index, long value);
+
+/**
+* @brief Bind a string value to a parameter of a prepared statement. The string is copied.
+*
+* @param[in] prepared statement
+* @param[in] index of the parameter, starting from 0 in the order of the '?'s
+* @param[in] value of the parameter
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_bind_string(db_stmt_t *stmt, int param_index, const char *value);
+
+/**
+* @brief Execute a prepared statement like db_exec() with the values bound to its parameters.
+*
+* @param[in] prepared statement
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_stmt_exec(db_stmt_t *stmt);
+
+/**
+* @brief Execute a prepared statement like db_query() with the values bound to its parameters.
+*
+* @param[in] prepared statement
+* @return On success, pointer of db_cursor_t is returned. On failure, a NULL is returned.
+* @since Tizen RT v1.1
+*/
+db_cursor_t *db_stmt_query(db_stmt_t *stmt);
+
+/**
+* @brief Add a tuple with the values bound to the parameters of a prepared INSERT
+*        to the batch of the statement. The bound values may be changed afterwards.
+*
+* @param[in] prepared statement
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_stmt_add_batch(db_stmt_t *stmt);
+
+/**
+* @brief Insert the batch of a prepared INSERT with a single write. If a tuple of the batch
+*        does not fit the relation, none of them is inserted. Once written the tuples stay
+*        inserted; an index that fails to take their keys is rebuilt from the relation.
+*        The batch is emptied.
+*
+* @param[in] prepared statement
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_stmt_exec_batch(db_stmt_t *stmt);
+
+/**
+* @brief Free a prepared statement.
+*
+* @param[in] prepared statement
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_stmt_free(db_stmt_t *stmt);
+
+/**
+* @brief Set the default number of nodes and buckets cached for each bplustree
+*        index. The sizes apply to the indexes created or loaded after the call,
+*        the indexes already loaded keep the size of their caches.
+*
+* @param[in] number of cached nodes, from 4 to 255
+* @param[in] number of cached buckets, from 4 to 255
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_set_default_index_cache_size(int node_count, int bucket_count);
+
+/**
+* @brief Get the hits and misses of the node and bucket caches of all bplustree indexes.
+*
+* @param[out] cache statistics
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.1
+*/
+db_result_t db_get_index_cache_stats(db_index_cache_stats_t *stats);
+
 
 /**
 * @brief free allocated cursor data. This should be called before application terminated.
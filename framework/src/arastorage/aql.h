@@ -126,6 +126,8 @@
 #define AQL_SET_CONDITION(adt, cond)    ((adt)->lvm_instance = (cond))
 #define AQL_ADD_VALUE(adt, domain, value)                               \
 	aql_add_value((adt), (domain), (value))
+#define AQL_ADD_PARAMETER_VALUE(adt)    aql_add_parameter_value(adt)
+#define AQL_PARAMETER_COUNT(adt)        ((adt)->parameter_count)
 
 /****************************************************************************
 * Public Type Definitions
@@ -193,6 +195,7 @@ enum token_e {
 
 	ATTRIBUTE,
 	BPLUSTREE,					/* 48 */
+	PLACEHOLDER,
 
 	INTEGER_VALUE = 251,
 	FLOAT_VALUE = 252,
@@ -242,12 +245,25 @@ struct aql_adt_s {
 	uint8_t relation_count;
 	uint8_t attribute_count;
 	uint8_t value_count;
+	uint8_t parameter_count;
 	uint32_t optype;
 	uint8_t flags;
 	void *lvm_instance;
 };
 typedef struct aql_adt_s aql_adt_t;
 
+/* A prepared statement. Values which are placeholders in the parse result
+   are taken from the parameters when the statement is executed. The values
+   of the tuples added to the batch of an INSERT statement are kept in
+   batch, value_count of them per tuple. */
+struct _db_stmt_s {
+	aql_adt_t adt;
+	attribute_value_t parameters[AQL_PARAMETER_LIMIT];
+	attribute_value_t *batch;
+	tuple_id_t batch_count;
+	tuple_id_t batch_size;
+};
+
 /****************************************************************************
 * Global Function Prototypes
 ****************************************************************************/
@@ -260,5 +276,17 @@ void aql_add_relation(aql_adt_t *adt, char *rel);
 aql_status_t aql_parse(aql_adt_t *adt, char *query_string);
 db_result_t aql_add_attribute(aql_adt_t *adt, char *name, domain_t domain, unsigned element_size, int processed_only);
 db_result_t aql_add_value(aql_adt_t *adt, domain_t domain, void *value);
+db_result_t aql_add_parameter_value(aql_adt_t *adt);
+void aql_free_values(aql_adt_t *adt);
+db_result_t aql_copy(aql_adt_t *dst, aql_adt_t *src);
+
+db_result_t aql_get_parse_result(char *format, aql_adt_t *adt);
+relation_t *aql_get_relation(aql_adt_t *adt);
+db_result_t aql_exec(aql_adt_t *adt);
+db_cursor_t *aql_query(aql_adt_t *adt);
+
+db_result_t aql_stmt_get(char *query, aql_adt_t *adt);
+db_result_t aql_stmt_bind(aql_adt_t *adt, aql_adt_t *stmt_adt, attribute_value_t *parameters);
+void aql_stmt_cache_clear(void);
 
 #endif							/* !AQL_H */
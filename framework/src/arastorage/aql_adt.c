@@ -61,6 +61,7 @@
 #include <string.h>
 #include "aql.h"
 #include "db_debug.h"
+#include "lvm.h"
 
 
 /****************************************************************************
@@ -84,6 +85,7 @@ void aql_clear(aql_adt_t *adt)
 	adt->relation_count = 0;
 	adt->attribute_count = 0;
 	adt->value_count = 0;
+	adt->parameter_count = 0;
 	adt->flags = 0;
 	memset(adt->aggregators, 0, sizeof(adt->aggregators));
 }
@@ -160,3 +162,69 @@ db_result_t aql_add_value(aql_adt_t *adt, domain_t domain, void *value_ptr)
 
 	return DB_OK;
 }
+
+/* A placeholder value takes the domain and value of the parameter which
+   is bound to it, the index of which is kept in the value until then. */
+db_result_t aql_add_parameter_value(aql_adt_t *adt)
+{
+	attribute_value_t *value;
+
+	if (adt->value_count == AQL_ATTRIBUTE_LIMIT || adt->parameter_count == AQL_PARAMETER_LIMIT) {
+		return DB_LIMIT_ERROR;
+	}
+
+	value = &adt->values[adt->value_count++];
+	value->domain = DOMAIN_UNSPECIFIED;
+	VALUE_LONG(value) = adt->parameter_count++;
+
+	return DB_OK;
+}
+
+void aql_free_values(aql_adt_t *adt)
+{
+	int i;
+
+	for (i = 0; i < adt->value_count; i++) {
+		if (adt->values[i].domain == DOMAIN_STRING && VALUE_STRING(&adt->values[i]) != NULL) {
+			free(VALUE_STRING(&adt->values[i]));
+			VALUE_STRING(&adt->values[i]) = NULL;
+		}
+	}
+	adt->value_count = 0;
+}
+
+/* Make a copy of a parse result which owns its string values and condition. */
+db_result_t aql_copy(aql_adt_t *dst, aql_adt_t *src)
+{
+	unsigned char *str;
+	int i;
+
+	memcpy(dst, src, sizeof(*dst));
+	dst->lvm_instance = NULL;
+	dst->value_count = 0;
+
+	for (i = 0; i < src->value_count; i++) {
+		if (src->values[i].domain == DOMAIN_STRING) {
+			str = (unsigned char *)strdup((const char *)VALUE_STRING(&src->values[i]));
+			if (str == NULL) {
+				goto errout;
+			}
+			VALUE_STRING(&dst->values[i]) = str;
+		}
+		dst->value_count++;
+	}
+
+	if (src->lvm_instance != NULL) {
+		dst->lvm_instance = malloc(sizeof(lvm_instance_t));
+		if (dst->lvm_instance == NULL) {
+			goto errout;
+		}
+		lvm_clone((lvm_instance_t *)dst->lvm_instance, (lvm_instance_t *)src->lvm_instance);
+	}
+
+	return DB_OK;
+
+errout:
+	aql_free_values(dst);
+	return DB_ALLOCATION_ERROR;
+}
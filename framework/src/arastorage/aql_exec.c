@@ -107,6 +107,10 @@ db_result_t aql_deinit_handle(db_handle_t **handle)
 		free((*handle)->tuple);
 		(*handle)->tuple = NULL;
 	}
+	if ((*handle)->scan_buf != NULL) {
+		free((*handle)->scan_buf);
+		(*handle)->scan_buf = NULL;
+	}
 	if ((*handle)->lvm_instance != NULL) {
 		free((*handle)->lvm_instance);
 		(*handle)->lvm_instance = NULL;
@@ -146,30 +150,23 @@ relation_t *aql_get_relation(aql_adt_t *adt)
 	return relation_load(adt->relations[first_rel_arg]);
 }
 
-db_result_t db_exec(char *format)
+db_result_t aql_exec(aql_adt_t *adt)
 {
 	db_result_t res;
-	aql_adt_t adt;
 	relation_t *rel = NULL;
 	aql_attribute_t *attr;
 	attribute_t *relattr = NULL;
 	uint32_t optype;
-	res = aql_get_parse_result(format, &adt);
 
-	if (DB_ERROR(res)) {
-		DB_LOG_E("DB : Parsing Error in db_create : %d\n", res);
-		return DB_PARSING_ERROR;
-	}
-
-	optype = AQL_GET_OP_TYPE(AQL_GET_TYPE(&adt));
+	optype = AQL_GET_OP_TYPE(AQL_GET_TYPE(adt));
 	if (optype == AQL_OP_TYPE_QUERY) {
 		DB_LOG_E("DB : AQL OP TYPE Error \n");
 		return DB_ARGUMENT_ERROR;
 	}
 
-	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&adt));
+	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(adt));
 	if (optype != AQL_TYPE_CREATE_RELATION) {
-		rel = aql_get_relation(&adt);
+		rel = aql_get_relation(adt);
 		if (rel == NULL) {
 			DB_LOG_E("DB : get relation Failed\n");
 			return DB_RELATIONAL_ERROR;
@@ -180,27 +177,27 @@ db_result_t db_exec(char *format)
 
 	switch (optype) {
 	case AQL_TYPE_CREATE_ATTRIBUTE:
-		attr = &(adt.attributes[0]);
+		attr = &(adt->attributes[0]);
 		if (relation_attribute_add(rel, DB_STORAGE, attr->name, attr->domain, attr->element_size) != NULL) {
 			res = DB_OK;
 		}
 		break;
 	case AQL_TYPE_CREATE_INDEX:
-		relattr = relation_attribute_get(rel, adt.attributes[0].name);
+		relattr = relation_attribute_get(rel, adt->attributes[0].name);
 		if (relattr == NULL) {
 			res = DB_NAME_ERROR;
 			break;
 		}
-		res = index_create(AQL_GET_INDEX_TYPE(&adt), rel, relattr);
+		res = index_create(AQL_GET_INDEX_TYPE(adt), rel, relattr);
 		break;
 	case AQL_TYPE_CREATE_RELATION:
-		if (relation_create(adt.relations[0], DB_STORAGE) != NULL) {
+		if (relation_create(adt->relations[0], DB_STORAGE) != NULL) {
 			res = DB_OK;
 		}
 		break;
 	case AQL_TYPE_INSERT:
 		if (relation_cardinality(rel) < DB_TUPLE_LIMIT) {
-			res = relation_insert(rel, adt.values);
+			res = relation_insert(rel, adt->values);
 			if (DB_SUCCESS(res)) {
 				res = DB_OK;
 			}
@@ -209,10 +206,10 @@ db_result_t db_exec(char *format)
 		}
 		break;
 	case AQL_TYPE_REMOVE_ATTRIBUTE:
-		res = relation_attribute_remove(rel, adt.attributes[0].name);
+		res = relation_attribute_remove(rel, adt->attributes[0].name);
 		break;
 	case AQL_TYPE_REMOVE_INDEX:
-		relattr = relation_attribute_get(rel, adt.attributes[0].name);
+		relattr = relation_attribute_get(rel, adt->attributes[0].name);
 		if (relattr != NULL) {
 			index_load(rel, relattr);
 			if (relattr->index != NULL) {
@@ -225,7 +222,7 @@ db_result_t db_exec(char *format)
 		}
 		break;
 	case AQL_TYPE_REMOVE_RELATION:
-		res = relation_remove(adt.relations[0], 1);
+		res = relation_remove(adt->relations[0], 1);
 		break;
 	default:
 		break;
@@ -236,9 +233,27 @@ db_result_t db_exec(char *format)
 	return res;
 }
 
-db_cursor_t *db_query(char *format)
+db_result_t db_exec(char *format)
 {
+	db_result_t res;
 	aql_adt_t adt;
+
+	res = aql_stmt_get(format, &adt);
+	if (DB_ERROR(res)) {
+		DB_LOG_E("DB : Parsing Error in db_exec : %d\n", res);
+		return res == DB_ARGUMENT_ERROR ? res : DB_PARSING_ERROR;
+	}
+
+	res = aql_exec(&adt);
+	if (adt.lvm_instance != NULL) {
+		free(adt.lvm_instance);
+	}
+	return res;
+}
+
+/* The condition of the query is released along with the query. */
+db_cursor_t *aql_query(aql_adt_t *adt)
+{
 	relation_t *rel;
 	uint32_t optype;
 	db_handle_t *handler;
@@ -247,15 +262,12 @@ db_cursor_t *db_query(char *format)
 
 	handler = NULL;
 	cursor = NULL;
+	rel = NULL;
 
-	if (DB_ERROR(aql_get_parse_result(format, &adt))) {
-		DB_LOG_E("DB : Parsing Error in db_create : %d\n");
-		return NULL;
-	}
-	optype = AQL_GET_OP_TYPE(AQL_GET_TYPE(&adt));
+	optype = AQL_GET_OP_TYPE(AQL_GET_TYPE(adt));
 	if (optype != AQL_OP_TYPE_QUERY) {
 		DB_LOG_E("DB : AQL OP TYPE Error \n");
-		return NULL;
+		goto errout;
 	}
 #ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
 	if (DB_SUCCESS(storage_flush_insert_buffer())) {
@@ -263,19 +275,19 @@ db_cursor_t *db_query(char *format)
 	}
 #endif
 
-	rel = aql_get_relation(&adt);
+	rel = aql_get_relation(adt);
 	if (rel == NULL) {
-		return NULL;
+		goto errout;
 	}
 
-	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&adt));
+	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(adt));
 	switch (optype) {
 	case AQL_TYPE_REMOVE_TUPLES:
 		/* Overwrite the attribute array with a full copy of the original
 		   relation's attributes. */
-		adt.attribute_count = 0;
+		adt->attribute_count = 0;
 		for (attr_ptr = list_head(rel->attributes); attr_ptr != NULL; attr_ptr = attr_ptr->next) {
-			AQL_ADD_ATTRIBUTE(&adt, attr_ptr->name, DOMAIN_UNSPECIFIED, 0);
+			AQL_ADD_ATTRIBUTE(adt, attr_ptr->name, DOMAIN_UNSPECIFIED, 0);
 		}
 	/* FALLTHROUGH */
 	case AQL_TYPE_SELECT:
@@ -283,7 +295,7 @@ db_cursor_t *db_query(char *format)
 			DB_LOG_E("DB: Init handle failed\n");
 			goto errout;
 		}
-		if (DB_ERROR(relation_select(&handler, rel, &adt))) {
+		if (DB_ERROR(relation_select(&handler, rel, adt))) {
 			DB_LOG_E("DB: Failed relation_select\n");
 			goto errout;
 		}
@@ -304,6 +316,10 @@ db_cursor_t *db_query(char *format)
 			relation_release(rel);
 		}
 	}
+	if (handler == NULL && adt->lvm_instance != NULL) {
+		free(adt->lvm_instance);
+		adt->lvm_instance = NULL;
+	}
 	aql_deinit_handle(&handler);
 
 	return cursor;
@@ -317,7 +333,25 @@ errout:
 		cursor_deinit(cursor);
 	}
 
+	if (handler == NULL && adt->lvm_instance != NULL) {
+		/* The condition has not been handed over to a handle yet. */
+		free(adt->lvm_instance);
+		adt->lvm_instance = NULL;
+	}
+
 	aql_deinit_handle(&handler);
 
 	return NULL;
 }
+
+db_cursor_t *db_query(char *format)
+{
+	aql_adt_t adt;
+
+	if (DB_ERROR(aql_stmt_get(format, &adt))) {
+		DB_LOG_E("DB : Parsing Error in db_query\n");
+		return NULL;
+	}
+
+	return aql_query(&adt);
+}
@@ -260,6 +260,11 @@ PARSER(values)
 	case INTEGER_VALUE:
 		AQL_ADD_VALUE(adt, DOMAIN_INT, VALUE);
 		break;
+	case PLACEHOLDER:
+		if (DB_ERROR(AQL_ADD_PARAMETER_VALUE(adt))) {
+			RETURN(SYNTAX_ERROR);
+		}
+		break;
 	default:
 		RETURN(SYNTAX_ERROR);
 	}
@@ -294,6 +299,12 @@ PARSER(operand)
 	case INTEGER_VALUE:
 		lvm_set_long(p, *(long *)lexer->value);
 		break;
+	case PLACEHOLDER:
+		if (AQL_PARAMETER_COUNT(adt) == AQL_PARAMETER_LIMIT) {
+			RETURN(SYNTAX_ERROR);
+		}
+		lvm_set_parameter(p, AQL_PARAMETER_COUNT(adt)++);
+		break;
 	default:
 		RETURN(SYNTAX_ERROR);
 	}
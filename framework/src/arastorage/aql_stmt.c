@@ -0,0 +1,443 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "db_debug.h"
+#include "aql.h"
+#include "lvm.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+/* A parse result kept for queries with the same text. */
+struct aql_stmt_cache_s {
+	char *query;
+	uint32_t hash;
+	uint32_t last_used;			/* 0 if the entry is free */
+	aql_adt_t adt;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+static struct aql_stmt_cache_s g_stmt_cache[AQL_STMT_CACHE_SIZE];
+static uint32_t g_stmt_clock;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+static uint32_t stmt_hash(const char *query)
+{
+	uint32_t hash;
+
+	hash = 5381;
+	while (*query != '\0') {
+		hash = hash * 33 + (unsigned char)*query++;
+	}
+	return hash;
+}
+
+static void stmt_cache_evict(struct aql_stmt_cache_s *entry)
+{
+	if (entry->query != NULL) {
+		free(entry->query);
+		entry->query = NULL;
+	}
+	aql_free_values(&entry->adt);
+	if (entry->adt.lvm_instance != NULL) {
+		free(entry->adt.lvm_instance);
+		entry->adt.lvm_instance = NULL;
+	}
+	entry->last_used = 0;
+}
+
+/* Look up the parse result of a query. A query which is not in the cache
+   is parsed into the least recently used entry. */
+static aql_adt_t *stmt_cache_get(char *query)
+{
+	struct aql_stmt_cache_s *entry;
+	struct aql_stmt_cache_s *victim;
+	uint32_t hash;
+	int i;
+
+	hash = stmt_hash(query);
+	victim = &g_stmt_cache[0];
+	for (i = 0; i < AQL_STMT_CACHE_SIZE; i++) {
+		entry = &g_stmt_cache[i];
+		if (entry->query != NULL && entry->hash == hash && strcmp(entry->query, query) == 0) {
+			entry->last_used = ++g_stmt_clock;
+			return &entry->adt;
+		}
+		if (entry->last_used < victim->last_used) {
+			victim = entry;
+		}
+	}
+
+	stmt_cache_evict(victim);
+	if (DB_ERROR(aql_get_parse_result(query, &victim->adt))) {
+		/* Release what the parser allocated before it failed. */
+		stmt_cache_evict(victim);
+		return NULL;
+	}
+
+	/* Without the text the entry is just not found again. */
+	victim->query = strdup(query);
+	victim->hash = hash;
+	victim->last_used = ++g_stmt_clock;
+
+	return &victim->adt;
+}
+
+static attribute_value_t *stmt_get_parameter(db_stmt_t *stmt, int param_index)
+{
+	attribute_value_t *param;
+
+	if (stmt == NULL || param_index < 0 || param_index >= AQL_PARAMETER_COUNT(&stmt->adt)) {
+		return NULL;
+	}
+
+	param = &stmt->parameters[param_index];
+	if (param->domain == DOMAIN_STRING && VALUE_STRING(param) != NULL) {
+		free(VALUE_STRING(param));
+		VALUE_STRING(param) = NULL;
+	}
+	param->domain = DOMAIN_UNSPECIFIED;
+
+	return param;
+}
+
+/* Release the tuples added to the batch of a statement. The batch owns
+   copies of its strings. */
+static void stmt_clear_batch(db_stmt_t *stmt)
+{
+	tuple_id_t i;
+
+	for (i = 0; i < stmt->batch_count * stmt->adt.value_count; i++) {
+		if (stmt->batch[i].domain == DOMAIN_STRING && VALUE_STRING(&stmt->batch[i]) != NULL) {
+			free(VALUE_STRING(&stmt->batch[i]));
+		}
+	}
+	stmt->batch_count = 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+/* Make an executable copy of a parse result with the placeholders replaced
+   by the parameters. The copy shares the string values of the parse result
+   and has its own condition, which the caller has to release. */
+db_result_t aql_stmt_bind(aql_adt_t *adt, aql_adt_t *stmt_adt, attribute_value_t *parameters)
+{
+	lvm_instance_t *lvm;
+	attribute_value_t *value;
+	int i;
+
+	memcpy(adt, stmt_adt, sizeof(*adt));
+	adt->lvm_instance = NULL;
+
+	for (i = 0; i < AQL_PARAMETER_COUNT(adt); i++) {
+		if (parameters == NULL || parameters[i].domain == DOMAIN_UNSPECIFIED) {
+			DB_LOG_E("DB: Parameter %d is not bound\n", i);
+			return DB_ARGUMENT_ERROR;
+		}
+	}
+
+	for (i = 0; i < adt->value_count; i++) {
+		value = &adt->values[i];
+		if (value->domain == DOMAIN_UNSPECIFIED) {
+			*value = parameters[VALUE_LONG(value)];
+		}
+	}
+
+	if (stmt_adt->lvm_instance != NULL) {
+		lvm = (lvm_instance_t *)malloc(sizeof(lvm_instance_t));
+		if (lvm == NULL) {
+			DB_LOG_E("DB: Failed to malloc lvm instance\n");
+			return DB_ALLOCATION_ERROR;
+		}
+		lvm_clone(lvm, (lvm_instance_t *)stmt_adt->lvm_instance);
+
+		/* The parameters of a condition are all compared as numbers. */
+		for (i = 0; i < AQL_PARAMETER_COUNT(adt); i++) {
+			if (parameters[i].domain != DOMAIN_INT && parameters[i].domain != DOMAIN_LONG) {
+				DB_LOG_E("DB: Parameter %d is not a number\n", i);
+				free(lvm);
+				return DB_TYPE_ERROR;
+			}
+			lvm_bind_parameter(lvm, i, VALUE_LONG(&parameters[i]));
+		}
+		adt->lvm_instance = lvm;
+	}
+
+	return DB_OK;
+}
+
+db_result_t aql_stmt_get(char *query, aql_adt_t *adt)
+{
+	aql_adt_t *stmt_adt;
+
+	if (query == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	stmt_adt = stmt_cache_get(query);
+	if (stmt_adt == NULL) {
+		return DB_PARSING_ERROR;
+	}
+
+	return aql_stmt_bind(adt, stmt_adt, NULL);
+}
+
+void aql_stmt_cache_clear(void)
+{
+	int i;
+
+	for (i = 0; i < AQL_STMT_CACHE_SIZE; i++) {
+		stmt_cache_evict(&g_stmt_cache[i]);
+	}
+	g_stmt_clock = 0;
+}
+
+db_stmt_t *db_prepare(char *format)
+{
+	aql_adt_t *stmt_adt;
+	db_stmt_t *stmt;
+
+	if (format == NULL) {
+		return NULL;
+	}
+
+	stmt_adt = stmt_cache_get(format);
+	if (stmt_adt == NULL) {
+		DB_LOG_E("DB : Parsing Error in db_prepare\n");
+		return NULL;
+	}
+
+	stmt = (db_stmt_t *)malloc(sizeof(db_stmt_t));
+	if (stmt == NULL) {
+		DB_LOG_E("DB: Failed to malloc statement\n");
+		return NULL;
+	}
+	memset(stmt->parameters, 0, sizeof(stmt->parameters));
+	stmt->batch = NULL;
+	stmt->batch_count = 0;
+	stmt->batch_size = 0;
+
+	if (DB_ERROR(aql_copy(&stmt->adt, stmt_adt))) {
+		free(stmt);
+		return NULL;
+	}
+
+	return stmt;
+}
+
+db_result_t db_bind_int(db_stmt_t *stmt, int param_index, int value)
+{
+	return db_bind_long(stmt, param_index, value);
+}
+
+db_result_t db_bind_long(db_stmt_t *stmt, int param_index, long value)
+{
+	attribute_value_t *param;
+
+	param = stmt_get_parameter(stmt, param_index);
+	if (param == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	/* Integers in a query are in the INT domain, which may be promoted
+	   to LONG, so do the same for parameters. */
+	param->domain = DOMAIN_INT;
+	VALUE_LONG(param) = value;
+
+	return DB_OK;
+}
+
+db_result_t db_bind_string(db_stmt_t *stmt, int param_index, const char *value)
+{
+	attribute_value_t *param;
+	unsigned char *str;
+
+	if (value == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	param = stmt_get_parameter(stmt, param_index);
+	if (param == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	str = (unsigned char *)strdup(value);
+	if (str == NULL) {
+		return DB_ALLOCATION_ERROR;
+	}
+	param->domain = DOMAIN_STRING;
+	VALUE_STRING(param) = str;
+
+	return DB_OK;
+}
+
+db_result_t db_stmt_exec(db_stmt_t *stmt)
+{
+	db_result_t res;
+	aql_adt_t adt;
+
+	if (stmt == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	res = aql_stmt_bind(&adt, &stmt->adt, stmt->parameters);
+	if (DB_ERROR(res)) {
+		return res;
+	}
+
+	res = aql_exec(&adt);
+	if (adt.lvm_instance != NULL) {
+		free(adt.lvm_instance);
+	}
+	return res;
+}
+
+db_cursor_t *db_stmt_query(db_stmt_t *stmt)
+{
+	aql_adt_t adt;
+
+	if (stmt == NULL) {
+		return NULL;
+	}
+
+	if (DB_ERROR(aql_stmt_bind(&adt, &stmt->adt, stmt->parameters))) {
+		return NULL;
+	}
+
+	return aql_query(&adt);
+}
+
+db_result_t db_stmt_add_batch(db_stmt_t *stmt)
+{
+	attribute_value_t *batch;
+	attribute_value_t *value;
+	tuple_id_t size;
+	db_result_t res;
+	aql_adt_t adt;
+	int i;
+
+	if (stmt == NULL || AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&stmt->adt)) != AQL_TYPE_INSERT) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	res = aql_stmt_bind(&adt, &stmt->adt, stmt->parameters);
+	if (DB_ERROR(res)) {
+		return res;
+	}
+
+	if (stmt->batch_count == stmt->batch_size) {
+		if (stmt->batch_size >= DB_TUPLE_LIMIT) {
+			return DB_LIMIT_ERROR;
+		}
+		size = stmt->batch_size + AQL_BATCH_INCREMENT;
+		batch = (attribute_value_t *)realloc(stmt->batch, size * adt.value_count * sizeof(attribute_value_t));
+		if (batch == NULL) {
+			DB_LOG_E("DB: Failed to grow the batch to %d tuples\n", size);
+			return DB_ALLOCATION_ERROR;
+		}
+		stmt->batch = batch;
+		stmt->batch_size = size;
+	}
+
+	value = &stmt->batch[stmt->batch_count * adt.value_count];
+	for (i = 0; i < adt.value_count; i++) {
+		value[i] = adt.values[i];
+		if (adt.values[i].domain == DOMAIN_STRING) {
+			VALUE_STRING(&value[i]) = (unsigned char *)strdup((char *)VALUE_STRING(&adt.values[i]));
+			if (VALUE_STRING(&value[i]) == NULL) {
+				/* Drop the values copied so far. */
+				while (i-- > 0) {
+					if (value[i].domain == DOMAIN_STRING) {
+						free(VALUE_STRING(&value[i]));
+					}
+				}
+				return DB_ALLOCATION_ERROR;
+			}
+		}
+	}
+	stmt->batch_count++;
+
+	return DB_OK;
+}
+
+db_result_t db_stmt_exec_batch(db_stmt_t *stmt)
+{
+	relation_t *rel;
+	db_result_t res;
+
+	if (stmt == NULL || AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&stmt->adt)) != AQL_TYPE_INSERT) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	if (stmt->batch_count == 0) {
+		return DB_OK;
+	}
+
+	rel = aql_get_relation(&stmt->adt);
+	if (rel == NULL) {
+		DB_LOG_E("DB : get relation Failed\n");
+		stmt_clear_batch(stmt);
+		return DB_RELATIONAL_ERROR;
+	}
+
+	if (relation_cardinality(rel) + stmt->batch_count > DB_TUPLE_LIMIT) {
+		res = DB_LIMIT_ERROR;
+	} else {
+		res = relation_insert_rows(rel, stmt->batch, stmt->adt.value_count, stmt->batch_count);
+	}
+	relation_release(rel);
+	stmt_clear_batch(stmt);
+
+	return res;
+}
+
+db_result_t db_stmt_free(db_stmt_t *stmt)
+{
+	int i;
+
+	if (stmt == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	for (i = 0; i < AQL_PARAMETER_COUNT(&stmt->adt); i++) {
+		stmt_get_parameter(stmt, i);
+	}
+	if (stmt->batch != NULL) {
+		stmt_clear_batch(stmt);
+		free(stmt->batch);
+	}
+	aql_free_values(&stmt->adt);
+	if (stmt->adt.lvm_instance != NULL) {
+		free(stmt->adt.lvm_instance);
+	}
+	free(stmt);
+
+	return DB_OK;
+}
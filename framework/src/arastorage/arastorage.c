@@ -96,11 +96,26 @@ db_result_t db_deinit()
 #ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
 	storage_write_buffer_deinit();
 #endif
+	aql_stmt_cache_clear();
 	relation_deinit();
 	index_deinit();
 	return DB_OK;
 }
 
+db_result_t db_set_default_index_cache_size(int node_count, int bucket_count)
+{
+	return index_bplustree_set_default_cache_size(node_count, bucket_count);
+}
+
+db_result_t db_get_index_cache_stats(db_index_cache_stats_t *stats)
+{
+	if (stats == NULL) {
+		return DB_ARGUMENT_ERROR;
+	}
+	index_bplustree_get_cache_stats(stats);
+	return DB_OK;
+}
+
 void db_set_output_function(db_output_function_t f)
 {
 	output = f;
@@ -99,9 +99,10 @@
 #endif							/* DB_MAX_ELEMENT_SIZE */
 
 /* The maximum size of the LVM bytecode compiled from a
-   single database query. */
+   single database query. A comparison between two operands
+   takes 48 bytes and a logical connective 8 bytes. */
 #ifndef DB_VM_BYTECODE_SIZE
-#define DB_VM_BYTECODE_SIZE             32
+#define DB_VM_BYTECODE_SIZE             160
 #endif							/* DB_VM_BYTECODE_SIZE */
 
 /*----------------------------------------------------------------------------*/
@@ -127,6 +128,26 @@
 #define AQL_ATTRIBUTE_LIMIT             6
 #endif							/* AQL_ATTRIBUTE_LIMIT */
 
+/* The maximum number of '?' placeholders in a single query. */
+#ifndef AQL_PARAMETER_LIMIT
+#define AQL_PARAMETER_LIMIT             AQL_ATTRIBUTE_LIMIT
+#endif							/* AQL_PARAMETER_LIMIT */
+
+/* The number of parsed queries kept for reuse when the same query
+   text is executed again. */
+#ifndef AQL_STMT_CACHE_SIZE
+#ifdef CONFIG_ARASTORAGE_STMT_CACHE_SIZE
+#define AQL_STMT_CACHE_SIZE             CONFIG_ARASTORAGE_STMT_CACHE_SIZE
+#else
+#define AQL_STMT_CACHE_SIZE             4
+#endif
+#endif							/* AQL_STMT_CACHE_SIZE */
+
+/* The number of tuples by which the batch of a prepared INSERT grows. */
+#ifndef AQL_BATCH_INCREMENT
+#define AQL_BATCH_INCREMENT             16
+#endif							/* AQL_BATCH_INCREMENT */
+
 /*----------------------------------------------------------------------------*/
 
 /*
@@ -178,6 +199,15 @@
 #define DB_CURSOR_RESULT_ENTRY          ((DB_CURSOR_LIMIT) * (sizeof(uint32_t)*8))
 #endif							/* DB_CURSOR_RESULT_ENTRY */
 
+/* The number of rows read at once by a sequential scan. */
+#ifndef DB_SCAN_BLOCK_ROWS
+#ifdef CONFIG_ARASTORAGE_SCAN_BLOCK_ROWS
+#define DB_SCAN_BLOCK_ROWS              CONFIG_ARASTORAGE_SCAN_BLOCK_ROWS
+#else
+#define DB_SCAN_BLOCK_ROWS              16
+#endif
+#endif							/* DB_SCAN_BLOCK_ROWS */
+
 /* The name of the intermediate "result" relation file, which is used
    for presenting the result of a query to a user. */
 #ifndef RESULT_RELATION
@@ -197,6 +227,10 @@
 
 #define TUPLE_NAME_LENGTH 14
 
+/* Suffix of the tuple file written by a batch insert before it replaces
+   the tuple file. Kept short so the path fits DB_MAX_FILENAME_LENGTH. */
+#define TUPLE_TEMP_SUFFIX ".t"
+
 #define HEAP_FILE_NAME "heap"
 
 #define HEAP_FILE_LENGTH 15
@@ -246,6 +280,17 @@
 #define LVM_MAX_VARIABLE_ID             AQL_ATTRIBUTE_LIMIT - 1
 #endif							/* LVM_MAX_VARIABLE_ID */
 
+/* The maximum number of instructions of a predicate compiled
+   for evaluation on rows. Longer predicates are interpreted. */
+#ifndef LVM_MAX_INSNS
+#define LVM_MAX_INSNS                   24
+#endif							/* LVM_MAX_INSNS */
+
+/* The evaluation stack depth of a compiled predicate. */
+#ifndef LVM_STACK_SIZE
+#define LVM_STACK_SIZE                  8
+#endif							/* LVM_STACK_SIZE */
+
 /* Specify whether floats should be used or not inside the LVM. */
 #ifndef LVM_USE_FLOATS
 #define LVM_USE_FLOATS                  DB_FEATURE_FLOATS
@@ -109,6 +109,13 @@ struct index_iterator_s {
 };
 typedef struct index_iterator_s index_iterator_t;
 
+/* A key with its tuple, as given to the index for a batch of rows. */
+struct index_entry_s {
+	long key;
+	tuple_id_t tuple_id;
+};
+typedef struct index_entry_s index_entry_t;
+
 struct index_api_s {
 	index_type_t type;
 	uint8_t flags;
@@ -119,6 +126,7 @@ struct index_api_s {
 	db_result_t(*insert)(index_t *, attribute_value_t *, tuple_id_t);
 	db_result_t(*delete)(index_t *, attribute_value_t *);
 	tuple_id_t(*get_next)(index_iterator_t *, uint8_t);
+	db_result_t(*insert_batch)(index_t *, index_entry_t *, tuple_id_t);
 };
 
 typedef struct index_api_s index_api_t;
@@ -138,9 +146,13 @@ db_result_t index_destroy(index_t *);
 db_result_t index_load(relation_t *, attribute_t *);
 db_result_t index_release(index_t *);
 db_result_t index_insert(index_t *, attribute_value_t *, tuple_id_t);
+db_result_t index_insert_batch(index_t *, index_entry_t *, tuple_id_t);
+db_result_t index_rebuild(index_t *);
 db_result_t index_delete(index_t *, attribute_value_t *);
 db_result_t index_get_iterator(index_iterator_t *, index_t *, attribute_value_t *, attribute_value_t *);
 tuple_id_t index_get_next(index_iterator_t *, uint8_t);
 int index_exists(attribute_t *);
 db_result_t index_deinit(void);
+db_result_t index_bplustree_set_default_cache_size(int, int);
+void index_bplustree_get_cache_stats(db_index_cache_stats_t *);
 #endif							/* !INDEX_H */
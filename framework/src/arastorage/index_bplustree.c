@@ -123,6 +123,9 @@
 		cache_type->in_cache.tail->prev = node; \
 	} while (0)
 
+#define CACHE_ITEM(cache, entry) \
+	((cache)->items + (entry)->pos * (cache)->item_size)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -149,7 +152,8 @@ typedef struct bucket_s bucket_t;
 struct qnode_s {
 	struct qnode_s *next;
 	struct qnode_s *prev;
-	uint8_t id;
+	struct qnode_s *hash_next;	/* The next entry in the same hash chain */
+	int id;
 	uint8_t pos;
 	uint8_t node_state;
 };
@@ -161,35 +165,31 @@ struct queue_s {
 };
 typedef struct queue_s queue_t;
 
-/* A Bucket Cache Entry */
-struct bucket_cache_s {
-	bucket_t bucket;
-};
-
-/* A Tree Cache Entry */
-struct tree_cache_s {
-	tree_node_t node;
-};
-
-/* Bucket Cache Structure */
-typedef struct {
-	struct bucket_cache_s cache_t[DB_HEAP_CACHE_LIMIT];
-	queue_t in_cache;
-	uint8_t num;
-} bucket_cache_t;
-
-/* Tree Cache Structure */
-typedef struct {
-	struct tree_cache_s cache_t[DB_TREE_CACHE_LIMIT];
-	queue_t in_cache;
-	uint8_t num;
-} tree_cache_t;
-
 typedef enum {
 	NODE = 0,
 	BUCKET = 1
 } cache_type_t;
 
+/* A cache of tree nodes or buckets. The valid entries are found by id
+ * through the hash chains. All entries are kept in the in_cache queue in
+ * LRU order, the least recently used one after the head, and the free
+ * and invalidated ones are placed at the head to be reused first.
+ */
+typedef struct index_cache_s {
+	qnode_t *entries;			/* capacity entries, entry i caching item i */
+	qnode_t **hash;				/* hash_mask + 1 chains of valid entries */
+	unsigned char *items;		/* capacity nodes or buckets */
+	queue_t in_cache;
+	qnode_t ends[2];			/* The head and tail of in_cache */
+	size_t item_size;
+	uint8_t capacity;
+	uint8_t hash_mask;
+	cache_type_t type;
+	uint32_t hits;				/* Counted under the lock of the cache */
+	uint32_t misses;
+	struct index_cache_s *next;	/* The next cache in g_caches */
+} index_cache_t;
+
 typedef enum {
 	INVALIDATE = 0,
 	UNLOCK = 1,
@@ -239,8 +239,8 @@ struct tree_s {
 	uint16_t inserted;			/*  Count of total number of tuples inserted  */
 	uint16_t deleted;			/*    Count of total number of tuples deleted  */
 	uint8_t levels;				/*  The depth of the bplus-tree including the buckets  */
-	tree_cache_t *node_cache;	/*  Structure to maintain node cache  */
-	bucket_cache_t *buck_cache;	/*   Structure to maintain bucket cache  */
+	index_cache_t *node_cache;	/*  Structure to maintain node cache  */
+	index_cache_t *buck_cache;	/*   Structure to maintain bucket cache  */
 	pthread_mutex_t node_cache_lock;	/*  Maintains concurrency control over Node Cache  */
 	pthread_mutex_t buck_cache_lock;	/*  Maintains concurrency control over Bucket Cache  */
 	pthread_mutex_t bucket_lock;	/*  Maintains serialisability over in RAM Tree Structure  */
@@ -253,6 +253,18 @@ typedef struct tree_s tree_t;
  ****************************************************************************/
 static int base_offset = 0;
 
+/* The number of entries in the caches of the trees created or loaded
+   from now on. */
+static uint8_t g_node_cache_size = DB_TREE_CACHE_LIMIT;
+static uint8_t g_bucket_cache_size = DB_HEAP_CACHE_LIMIT;
+
+/* The caches of the loaded trees, and the hits and misses of the caches
+   already freed. Each cache counts its own hits and misses under its
+   lock, so lookups in different trees do not share a counter. */
+static index_cache_t *g_caches;
+static db_index_cache_stats_t g_cache_stats;
+static pthread_mutex_t g_cache_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -269,6 +281,12 @@ static bsplit_status_t bucket_split(tree_t *, int, int, pair_t *);
 static cache_result_t cache_bucket_append(tree_t *, int, pair_t *);
 static cache_result_t cache_write_bucket(tree_t *, int, bucket_t *);
 
+static index_cache_t *cache_init(cache_type_t, int, size_t);
+static void cache_deinit(index_cache_t *);
+static qnode_t *cache_find(index_cache_t *, int);
+static qnode_t *cache_insert(tree_t *, index_cache_t *, int);
+static void cache_remove(index_cache_t *, qnode_t *);
+static void cache_flush(tree_t *, index_cache_t *);
 static cache_result_t modify_cache(tree_t *, int, cache_type_t, op_type_t);
 static cache_result_t cache_write_node(tree_t *, int, tree_node_t *);
 static cache_result_t cache_replace_node(tree_t *, int, tree_node_t *);
@@ -280,6 +298,9 @@ static db_result_t release(index_t *);
 static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
 static db_result_t delete(index_t *, attribute_value_t *);
 static tuple_id_t get_next(index_iterator_t *, uint8_t);
+static db_result_t insert_batch(index_t *, index_entry_t *, tuple_id_t);
+static db_result_t insert_key(index_t *, long, tuple_id_t);
+static void flush_cache(tree_t *);
 static db_result_t vacuum(tree_t *, relation_t *);
 
 /****************************************************************************
@@ -298,9 +319,54 @@ index_api_t index_bplustree = {
 	release,
 	insert,
 	delete,
-	get_next
+	get_next,
+	insert_batch
 };
 
+/****************************************************************************
+ * Name: index_bplustree_set_default_cache_size
+ *
+ * Description: Sets the number of nodes and buckets cached for the trees
+ *              created or loaded afterwards. The caches of the trees
+ *              already loaded keep their size.
+ *
+ ****************************************************************************/
+db_result_t index_bplustree_set_default_cache_size(int node_count, int bucket_count)
+{
+	/* Splits keep several nodes and buckets locked in the caches at once */
+	if (node_count < 4 || node_count > UCHAR_MAX || bucket_count < 4 || bucket_count > UCHAR_MAX) {
+		return DB_ARGUMENT_ERROR;
+	}
+	g_node_cache_size = node_count;
+	g_bucket_cache_size = bucket_count;
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: index_bplustree_get_cache_stats
+ *
+ * Description: Sums the hits and misses of the caches of all the trees.
+ *              Lookups in progress may not be counted yet.
+ *
+ ****************************************************************************/
+void index_bplustree_get_cache_stats(db_index_cache_stats_t *stats)
+{
+	index_cache_t *cache;
+
+	pthread_mutex_lock(&g_cache_stats_lock);
+	memcpy(stats, &g_cache_stats, sizeof(db_index_cache_stats_t));
+	for (cache = g_caches; cache != NULL; cache = cache->next) {
+		if (cache->type == NODE) {
+			stats->node_hits += cache->hits;
+			stats->node_misses += cache->misses;
+		} else {
+			stats->bucket_hits += cache->hits;
+			stats->bucket_misses += cache->misses;
+		}
+	}
+	pthread_mutex_unlock(&g_cache_stats_lock);
+}
+
 /****************************************************************************
  * Name: compare
  *
@@ -335,7 +401,6 @@ static db_result_t create(index_t *index)
 	bucket_t buck;
 	int offset = 0;
 	db_result_t result;
-	uint8_t success = 0;
 
 	tree_t *tree = malloc(sizeof(tree_t));
 	if (tree == NULL) {
@@ -408,78 +473,19 @@ static db_result_t create(index_t *index)
 	/* Initialize the tree metadata. */
 	memset(&tree->lock_buckets, 0, sizeof(tree->lock_buckets));
 
-	/* Allocating node cache and initialising it */
-	tree->node_cache = malloc(sizeof(tree_cache_t));
-	if (tree->node_cache != NULL) {
-		success |= 1;
-		qnode_t *head = (qnode_t *) malloc(sizeof(qnode_t));
-		if (head != NULL) {
-			success |= 2;
-			tree->node_cache->in_cache.head = head;
-			qnode_t *end = (qnode_t *) malloc(sizeof(qnode_t));
-			if (end != NULL) {
-				success |= 4;
-				head->prev = NULL;
-				end->next = NULL;
-				head->next = end;
-				end->prev = head;
-				tree->node_cache->in_cache.tail = end;
-				tree->node_cache->num = 0;
-			}
-		}
-	}
-	if (success != 7) {
-		DB_LOG_E("FAILED TO ALLOCATE NODE CACHE\n");
-		result = DB_ALLOCATION_ERROR;
-		storage_remove(tree_filename);
-		storage_remove(bucket_filename);
-		if (success & 1) {
-			if (success & 2) {
-				free(tree->node_cache->in_cache.head);
-			}
-			free(tree->node_cache);
-		}
-		free(tree);
-		return result;
-	}
-
-	/* Allocating bucket cache and initialising it */
-	tree->buck_cache = malloc(sizeof(bucket_cache_t));
-	success = 0;
-	if (tree->buck_cache != NULL) {
-		success |= 1;
-		qnode_t *head = (qnode_t *) malloc(sizeof(qnode_t));
-		if (head != NULL) {
-			success |= 2;
-			tree->buck_cache->in_cache.head = head;
-			qnode_t *end = (qnode_t *) malloc(sizeof(qnode_t));
-			if (end != NULL) {
-				success |= 4;
-				head->prev = NULL;
-				end->next = NULL;
-				head->next = end;
-				end->prev = head;
-				tree->buck_cache->in_cache.tail = end;
-				tree->buck_cache->num = 0;
-			}
-		}
-	}
-	if (success != 7) {
-		DB_LOG_E("FAILED TO ALLOCATE BUCKET CACHE\n");
-		result = DB_ALLOCATION_ERROR;
-		free(tree->node_cache->in_cache.tail);
-		free(tree->node_cache->in_cache.head);
-		free(tree->node_cache);
+	/* Allocating node and bucket caches and initialising them */
+	tree->node_cache = cache_init(NODE, g_node_cache_size, sizeof(tree_node_t));
+	tree->buck_cache = cache_init(BUCKET, g_bucket_cache_size, sizeof(bucket_t));
+	if (tree->node_cache == NULL || tree->buck_cache == NULL) {
+		DB_LOG_E("FAILED TO ALLOCATE CACHE\n");
+		cache_deinit(tree->node_cache);
+		cache_deinit(tree->buck_cache);
+		storage_close(tree->tree_storage);
+		storage_close(tree->bucket_storage);
 		storage_remove(tree_filename);
 		storage_remove(bucket_filename);
-		if (success & 1) {
-			if (success & 2) {
-				free(tree->buck_cache->in_cache.head);
-			}
-			free(tree->buck_cache);
-		}
 		free(tree);
-		return result;
+		return DB_ALLOCATION_ERROR;
 	}
 
 	tree->inserted = 0;
@@ -532,8 +538,6 @@ static db_result_t load(index_t *index)
 	tree_t *tree;
 	db_storage_id_t fd;
 	char bucket_file[DB_MAX_FILENAME_LENGTH];
-	db_result_t result;
-	uint8_t success = 0;
 
 	index->opaque_data = tree = malloc(sizeof(tree_t));
 	if (tree == NULL) {
@@ -559,73 +563,14 @@ static db_result_t load(index_t *index)
 	}
 	storage_close(fd);
 
-	tree->node_cache = malloc(sizeof(tree_cache_t));
-	if (tree->node_cache != NULL) {
-		success |= 1;
-		qnode_t *head = (qnode_t *) malloc(sizeof(qnode_t));
-		if (head != NULL) {
-			success |= 2;
-			tree->node_cache->in_cache.head = head;
-			qnode_t *end = (qnode_t *) malloc(sizeof(qnode_t));
-			if (end != NULL) {
-				success |= 4;
-				head->prev = NULL;
-				end->next = NULL;
-				head->next = end;
-				end->prev = head;
-				tree->node_cache->in_cache.tail = end;
-				tree->node_cache->num = 0;
-			}
-		}
-	}
-	if (success != 7) {
-		DB_LOG_E("FAILED TO ALLOCATE NODE CACHE\n");
-		result = DB_ALLOCATION_ERROR;
-		if (success & 1) {
-			if (success & 2) {
-				free(tree->node_cache->in_cache.head);
-			}
-			free(tree->node_cache);
-		}
-		free(tree);
-		return result;
-	}
-
-	/* Allocating bucket cache and initialising it  */
-	tree->buck_cache = malloc(sizeof(bucket_cache_t));
-	success = 0;
-	if (tree->buck_cache != NULL) {
-		success |= 1;
-		qnode_t *head = (qnode_t *) malloc(sizeof(qnode_t));
-		if (head != NULL) {
-			success |= 2;
-			tree->buck_cache->in_cache.head = head;
-			qnode_t *end = (qnode_t *) malloc(sizeof(qnode_t));
-			if (end != NULL) {
-				success |= 4;
-				head->prev = NULL;
-				end->next = NULL;
-				head->next = end;
-				end->prev = head;
-				tree->buck_cache->in_cache.tail = end;
-				tree->buck_cache->num = 0;
-			}
-		}
-	}
-	if (success != 7) {
-		DB_LOG_E("FAILED TO ALLOCATE BUCKET CACHE\n");
-		result = DB_ALLOCATION_ERROR;
-		free(tree->node_cache->in_cache.tail);
-		free(tree->node_cache->in_cache.head);
-		free(tree->node_cache);
-		if (success & 1) {
-			if (success & 2) {
-				free(tree->buck_cache->in_cache.head);
-			}
-			free(tree->buck_cache);
-		}
+	tree->node_cache = cache_init(NODE, g_node_cache_size, sizeof(tree_node_t));
+	tree->buck_cache = cache_init(BUCKET, g_bucket_cache_size, sizeof(bucket_t));
+	if (tree->node_cache == NULL || tree->buck_cache == NULL) {
+		DB_LOG_E("FAILED TO ALLOCATE CACHE\n");
+		cache_deinit(tree->node_cache);
+		cache_deinit(tree->buck_cache);
 		free(tree);
-		return result;
+		return DB_ALLOCATION_ERROR;
 	}
 
 	base_offset = sizeof(tree_t) + sizeof(bucket_file);
@@ -638,12 +583,6 @@ static db_result_t load(index_t *index)
 
 storage_error:
 	DB_LOG_E("DB: Storage error while loading index\n");
-	free(tree->node_cache->in_cache.head);
-	free(tree->node_cache->in_cache.tail);
-	free(tree->buck_cache->in_cache.head);
-	free(tree->buck_cache->in_cache.tail);
-	free(tree->buck_cache);
-	free(tree->node_cache);
 	free(tree);
 	return DB_STORAGE_ERROR;
 
@@ -652,7 +591,6 @@ storage_error:
 static db_result_t release(index_t *index)
 {
 	tree_t *tree;
-	qnode_t *tmp_node;
 
 	tree = index->opaque_data;
 	if (tree == NULL) {
@@ -661,64 +599,28 @@ static db_result_t release(index_t *index)
 	if (tree->node_cache == NULL || tree->buck_cache == NULL) {
 		return DB_ALLOCATION_ERROR;
 	}
-	if ((tree->node_cache->in_cache.tail == NULL) || (tree->node_cache->in_cache.head == NULL)) {
-		return DB_ALLOCATION_ERROR;
-	}
-	if ((tree->buck_cache->in_cache.tail == NULL) || (tree->buck_cache->in_cache.head == NULL)) {
-		return DB_ALLOCATION_ERROR;
-	}
-	storage_write_to(tree->tree_storage, tree, 0, sizeof(tree_t));
-
-	/* Bucket Cache being flushed */
-	tmp_node = tree->buck_cache->in_cache.head->next;
-	free(tmp_node->prev);
-	while (tmp_node != tree->buck_cache->in_cache.tail) {
-		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
-			bucket_write(tree, tmp_node->id, &(tree->buck_cache->cache_t[tmp_node->pos].bucket));
-		}
-		tmp_node = tmp_node->next;
-		if (tmp_node->prev) {
-			free(tmp_node->prev);
-		}
-	}
-	free(tree->buck_cache->in_cache.tail);
-	tmp_node = tree->node_cache->in_cache.head->next;
-	free(tmp_node->prev);
-	while (tmp_node != tree->node_cache->in_cache.tail) {
-		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
-			tree_write(tree, tmp_node->id, &(tree->node_cache->cache_t[tmp_node->pos].node));
-		}
-		tmp_node = tmp_node->next;
-		if (tmp_node->prev) {
-			free(tmp_node->prev);
-		}
-	}
-	free(tree->node_cache->in_cache.tail);
+	flush_cache(tree);
 	storage_close(tree->bucket_storage);
 	storage_close(tree->tree_storage);
 
-	free(tree->node_cache);
-	free(tree->buck_cache);
+	cache_deinit(tree->node_cache);
+	cache_deinit(tree->buck_cache);
 	free(tree);
 	return DB_OK;
 }
 
 /****************************************************************************
- * Name: insert
+ * Name: insert_key
  *
- * Description: This routine is called by the antelope engine for insertion
- *              which in turns calls index insert routines to insert index
- *              entries.
+ * Description: Inserts a key into the tree. The changed nodes and buckets
+ *              are left dirty in the cache until flush_cache is called.
  *
  ****************************************************************************/
-static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t value)
+static db_result_t insert_key(index_t *index, long key, tuple_id_t value)
 {
 	tree_t *tree;
-	long long_key;
-	qnode_t *tmp_node;
 
 	tree = (tree_t *) index->opaque_data;
-	long_key = db_value_to_long(key);
 
 #ifdef CONFIG_ARASTORAGE_ENABLE_FLUSHING
 	if ((tree->inserted) >= DB_TUPLES_LIMIT) {
@@ -726,31 +628,79 @@ static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t val
 		value = value - DB_TUPLES_LIMIT / 2;
 	}
 #endif
-	if (insert_item_btree(tree, (int)long_key, (int)value) == TREE_INSERT_FAIL) {
-		DB_LOG_E("DB: Failed to insert key %ld into a bplus-tree index\n", long_key);
+	if (insert_item_btree(tree, (int)key, (int)value) == TREE_INSERT_FAIL) {
+		DB_LOG_E("DB: Failed to insert key %ld into a bplus-tree index\n", key);
 		return DB_INDEX_ERROR;
 	}
+
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: flush_cache
+ *
+ * Description: Writes the tree metadata and every dirty bucket and node
+ *              in the caches to storage.
+ *
+ ****************************************************************************/
+static void flush_cache(tree_t *tree)
+{
 	storage_write_to(tree->tree_storage, tree, 0, sizeof(tree_t));
 
-	/* Bucket Cache being flushed */
-	tmp_node = tree->buck_cache->in_cache.head->next;
-	while (tmp_node != tree->buck_cache->in_cache.tail) {
-		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
-			bucket_write(tree, tmp_node->id, &(tree->buck_cache->cache_t[tmp_node->pos].bucket));
-			UNSET_NODE_STATE(tmp_node, NODE_STATE_DIRTY);
-		}
-		tmp_node = tmp_node->next;
+	cache_flush(tree, tree->buck_cache);
+	cache_flush(tree, tree->node_cache);
+}
+
+/****************************************************************************
+ * Name: insert
+ *
+ * Description: This routine is called by the antelope engine for insertion
+ *              which in turns calls index insert routines to insert index
+ *              entries.
+ *
+ ****************************************************************************/
+static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t value)
+{
+	tree_t *tree;
+	long long_key;
+
+	tree = (tree_t *) index->opaque_data;
+	long_key = db_value_to_long(key);
+
+	if (DB_ERROR(insert_key(index, long_key, value))) {
+		return DB_INDEX_ERROR;
 	}
-	tmp_node = tree->node_cache->in_cache.head->next;
-	while (tmp_node != tree->node_cache->in_cache.tail) {
-		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
-			tree_write(tree, tmp_node->id, &(tree->node_cache->cache_t[tmp_node->pos].node));
-			UNSET_NODE_STATE(tmp_node, NODE_STATE_DIRTY);
+	flush_cache(tree);
+
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: insert_batch
+ *
+ * Description: Inserts the keys of a batch of rows. The tree metadata and
+ *              the dirty nodes and buckets are written once for the whole
+ *              batch instead of once per key.
+ *
+ ****************************************************************************/
+static db_result_t insert_batch(index_t *index, index_entry_t *entries, tuple_id_t count)
+{
+	tree_t *tree;
+	db_result_t result;
+	tuple_id_t i;
+
+	tree = (tree_t *) index->opaque_data;
+	result = DB_OK;
+
+	for (i = 0; i < count; i++) {
+		result = insert_key(index, entries[i].key, entries[i].tuple_id);
+		if (DB_ERROR(result)) {
+			break;
 		}
-		tmp_node = tmp_node->next;
 	}
+	flush_cache(tree);
 
-	return DB_OK;
+	return result;
 }
 
 static db_result_t delete(index_t *index, attribute_value_t *value)
@@ -999,6 +949,213 @@ static db_result_t vacuum(tree_t *tree, relation_t *rel)
 	return DB_OK;
 }
 
+/****************************************************************************
+ * Name: cache_init
+ *
+ * Description: Allocates a cache of capacity nodes or buckets with all of
+ *              its entries free, and adds it to g_caches
+ *
+ ****************************************************************************/
+static index_cache_t *cache_init(cache_type_t type, int capacity, size_t item_size)
+{
+	index_cache_t *cache;
+	qnode_t *entry;
+	int hash_size;
+	int i;
+
+	cache = (index_cache_t *)malloc(sizeof(index_cache_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+	cache->type = type;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->next = NULL;
+
+	hash_size = 1;
+	while (hash_size < capacity) {
+		hash_size <<= 1;
+	}
+
+	cache->entries = (qnode_t *)malloc(capacity * sizeof(qnode_t));
+	cache->hash = (qnode_t **)malloc(hash_size * sizeof(qnode_t *));
+	cache->items = (unsigned char *)malloc(capacity * item_size);
+	if (cache->entries == NULL || cache->hash == NULL || cache->items == NULL) {
+		cache_deinit(cache);
+		return NULL;
+	}
+	memset(cache->hash, 0, hash_size * sizeof(qnode_t *));
+	cache->item_size = item_size;
+	cache->capacity = capacity;
+	cache->hash_mask = hash_size - 1;
+
+	cache->in_cache.head = &cache->ends[0];
+	cache->in_cache.tail = &cache->ends[1];
+	cache->in_cache.head->prev = NULL;
+	cache->in_cache.head->next = cache->in_cache.tail;
+	cache->in_cache.tail->prev = cache->in_cache.head;
+	cache->in_cache.tail->next = NULL;
+
+	for (i = 0; i < capacity; i++) {
+		entry = &cache->entries[i];
+		entry->hash_next = NULL;
+		entry->id = 0;
+		entry->pos = i;
+		entry->node_state = 0;
+		PLACE_AT_TAIL(entry, cache);
+	}
+
+	pthread_mutex_lock(&g_cache_stats_lock);
+	cache->next = g_caches;
+	g_caches = cache;
+	pthread_mutex_unlock(&g_cache_stats_lock);
+
+	return cache;
+}
+
+/****************************************************************************
+ * Name: cache_deinit
+ *
+ * Description: Frees a cache allocated by cache_init, keeping its hits and
+ *              misses in g_cache_stats
+ *
+ ****************************************************************************/
+static void cache_deinit(index_cache_t *cache)
+{
+	index_cache_t **link;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&g_cache_stats_lock);
+	for (link = &g_caches; *link != NULL; link = &(*link)->next) {
+		if (*link == cache) {
+			*link = cache->next;
+			break;
+		}
+	}
+	if (cache->type == NODE) {
+		g_cache_stats.node_hits += cache->hits;
+		g_cache_stats.node_misses += cache->misses;
+	} else {
+		g_cache_stats.bucket_hits += cache->hits;
+		g_cache_stats.bucket_misses += cache->misses;
+	}
+	pthread_mutex_unlock(&g_cache_stats_lock);
+
+	free(cache->entries);
+	free(cache->hash);
+	free(cache->items);
+	free(cache);
+}
+
+/****************************************************************************
+ * Name: cache_find
+ *
+ * Description: Looks up the valid entry caching the node or bucket id
+ *
+ ****************************************************************************/
+static qnode_t *cache_find(index_cache_t *cache, int id)
+{
+	qnode_t *entry;
+
+	for (entry = cache->hash[id & cache->hash_mask]; entry != NULL; entry = entry->hash_next) {
+		if (entry->id == id) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/****************************************************************************
+ * Name: cache_remove
+ *
+ * Description: Invalidates an entry, dropping it from its hash chain and
+ *              placing it at the head of the queue to be reused first
+ *
+ ****************************************************************************/
+static void cache_remove(index_cache_t *cache, qnode_t *entry)
+{
+	qnode_t **link;
+
+	for (link = &cache->hash[entry->id & cache->hash_mask]; *link != NULL; link = &(*link)->hash_next) {
+		if (*link == entry) {
+			*link = entry->hash_next;
+			break;
+		}
+	}
+	entry->hash_next = NULL;
+	entry->node_state = 0;
+	REMOVE_ENTRY(entry);
+	PLACE_AT_HEAD(entry, cache);
+}
+
+/****************************************************************************
+ * Name: cache_insert
+ *
+ * Description: Takes the least recently used unlocked entry of the cache,
+ *              writing it back to flash if dirty, and makes it the most
+ *              recently used entry for id. The caller fills in the item
+ *              and its state.
+ *
+ ****************************************************************************/
+static qnode_t *cache_insert(tree_t *tree, index_cache_t *cache, int id)
+{
+	qnode_t *entry;
+
+	entry = cache->in_cache.head->next;
+	while ((entry->node_state & NODE_STATE_LOCK) && entry != cache->in_cache.tail) {
+		entry = entry->next;
+	}
+	if (entry == cache->in_cache.tail) {
+		return NULL;
+	}
+
+	if (entry->node_state & NODE_STATE_VALID) {
+		if (entry->node_state & NODE_STATE_DIRTY) {
+			if (cache == tree->node_cache) {
+				tree_write(tree, entry->id, (tree_node_t *)CACHE_ITEM(cache, entry));
+			} else {
+				bucket_write(tree, entry->id, (bucket_t *)CACHE_ITEM(cache, entry));
+			}
+		}
+		cache_remove(cache, entry);
+	}
+
+	entry->id = id;
+	entry->hash_next = cache->hash[entry->id & cache->hash_mask];
+	cache->hash[entry->id & cache->hash_mask] = entry;
+	REMOVE_ENTRY(entry);
+	PLACE_AT_TAIL(entry, cache);
+
+	return entry;
+}
+
+/****************************************************************************
+ * Name: cache_flush
+ *
+ * Description: Writes the dirty entries of a cache back to flash
+ *
+ ****************************************************************************/
+static void cache_flush(tree_t *tree, index_cache_t *cache)
+{
+	qnode_t *entry;
+	int i;
+
+	for (i = 0; i < cache->capacity; i++) {
+		entry = &cache->entries[i];
+		if ((entry->node_state & NODE_STATE_VALID) && (entry->node_state & NODE_STATE_DIRTY)) {
+			if (cache == tree->node_cache) {
+				tree_write(tree, entry->id, (tree_node_t *)CACHE_ITEM(cache, entry));
+			} else {
+				bucket_write(tree, entry->id, (bucket_t *)CACHE_ITEM(cache, entry));
+			}
+			UNSET_NODE_STATE(entry, NODE_STATE_DIRTY);
+		}
+	}
+}
+
 /****************************************************************************
  * Name: modify_cache
  *
@@ -1008,45 +1165,34 @@ static db_result_t vacuum(tree_t *tree, relation_t *rel)
  ****************************************************************************/
 static cache_result_t modify_cache(tree_t *tree, int id, cache_type_t cache, op_type_t op)
 {
+	index_cache_t *cache_type;
+	pthread_mutex_t *lock;
 	qnode_t *temp;
-	qnode_t *end;
+
 	if (cache == NODE) {
-		pthread_mutex_lock(&(tree->node_cache_lock));
-		temp = tree->node_cache->in_cache.tail->prev;
-		end = tree->node_cache->in_cache.head;
+		cache_type = tree->node_cache;
+		lock = &(tree->node_cache_lock);
 	} else {
-		pthread_mutex_lock(&(tree->buck_cache_lock));
-		temp = tree->buck_cache->in_cache.tail->prev;
-		end = tree->buck_cache->in_cache.head;
-	}
-	while (temp != end) {
-		if ((temp->id == id) && (temp->node_state & NODE_STATE_VALID)) {
-			if (op == UNLOCK) {
-				UNSET_NODE_STATE(temp, NODE_STATE_LOCK);
-			} else if (op == DIRTY) {
-				SET_NODE_STATE(temp, NODE_STATE_DIRTY);
-			} else {
-				UNSET_NODE_STATE(temp, NODE_STATE_VALID | NODE_STATE_DIRTY | NODE_STATE_LOCK);
-				REMOVE_ENTRY(temp);
-				if (cache == NODE) {
-					PLACE_AT_HEAD(temp, tree->node_cache);
-				} else {
-					PLACE_AT_HEAD(temp, tree->buck_cache);
-				}
-			}
-			break;
-		}
-		temp = temp->prev;
+		cache_type = tree->buck_cache;
+		lock = &(tree->buck_cache_lock);
 	}
-	if (temp == end) {
+	pthread_mutex_lock(lock);
+
+	temp = cache_find(cache_type, id);
+	if (temp == NULL) {
+		pthread_mutex_unlock(lock);
 		DB_LOG_E("PANIC CACHE OPERATION FOR A NON EXISTENT ENTRY\n");
 		return CACHE_NOT_EXIST;
 	}
-	if (cache == NODE) {
-		pthread_mutex_unlock(&(tree->node_cache_lock));
+	if (op == UNLOCK) {
+		UNSET_NODE_STATE(temp, NODE_STATE_LOCK);
+	} else if (op == DIRTY) {
+		SET_NODE_STATE(temp, NODE_STATE_DIRTY);
 	} else {
-		pthread_mutex_unlock(&(tree->buck_cache_lock));
+		cache_remove(cache_type, temp);
 	}
+
+	pthread_mutex_unlock(lock);
 	return CACHE_OK;
 }
 
@@ -1059,47 +1205,27 @@ static cache_result_t modify_cache(tree_t *tree, int id, cache_type_t cache, op_
  ****************************************************************************/
 static cache_result_t cache_write_node(tree_t *tree, int id, tree_node_t *node)
 {
+	qnode_t *new_node;
+
 	pthread_mutex_lock(&(tree->node_cache_lock));
 
-	qnode_t *new_node = (qnode_t *) malloc(sizeof(qnode_t));
+	new_node = cache_find(tree->node_cache, id);
 	if (new_node == NULL) {
-		DB_LOG_E("Failed allocation of node\n");
-		pthread_mutex_unlock(&(tree->node_cache_lock));
-		return CACHE_ALLOCATION_ERROR;
-	}
-
-	if (tree->node_cache->num < DB_TREE_CACHE_LIMIT) {
-		new_node->pos = tree->node_cache->num++;
-	} else {
-		qnode_t *iter_node;
-		iter_node = tree->node_cache->in_cache.head->next;
-		while ((iter_node->node_state | NODE_STATE_LOCK) && iter_node != tree->node_cache->in_cache.tail) {
-			iter_node = iter_node->next;
-		}
-		if (iter_node == tree->node_cache->in_cache.tail) {
-			free(new_node);
+		new_node = cache_insert(tree, tree->node_cache, id);
+		if (new_node == NULL) {
 			DB_LOG_E("NO SLOT AVAIABLE IN CACHE\n");
 			pthread_mutex_unlock(&(tree->node_cache_lock));
 			return CACHE_FULL;
 		}
-		if ((iter_node->node_state & NODE_STATE_DIRTY) && (iter_node->node_state & NODE_STATE_DIRTY)) {
-			tree_write(tree, iter_node->id, &(tree->node_cache->cache_t[iter_node->pos].node));
-		}
-		new_node->pos = iter_node->pos;
-		/* iter_node is the node which has to be evicted from cache.
-		 * It is removed the queue maintaining the LRU status.
-		 */
-		REMOVE_ENTRY(iter_node);
-		free(iter_node);
+	} else {
+		REMOVE_ENTRY(new_node);
+		PLACE_AT_TAIL(new_node, tree->node_cache);
 	}
-
-	PLACE_AT_TAIL(new_node, tree->node_cache);
-	new_node->id = id;
 	UNSET_NODE_STATE(new_node, NODE_STATE_LOCK);
 	SET_NODE_STATE(new_node, NODE_STATE_VALID);
 	SET_NODE_STATE(new_node, NODE_STATE_DIRTY);
 
-	memcpy(&(tree->node_cache->cache_t[new_node->pos].node), node, sizeof(tree_node_t));
+	memcpy(CACHE_ITEM(tree->node_cache, new_node), node, sizeof(tree_node_t));
 
 	pthread_mutex_unlock(&(tree->node_cache_lock));
 
@@ -1115,15 +1241,12 @@ static cache_result_t cache_write_node(tree_t *tree, int id, tree_node_t *node)
  ****************************************************************************/
 static cache_result_t cache_replace_node(tree_t *tree, int id, tree_node_t *node)
 {
-	pthread_mutex_lock(&(tree->node_cache_lock));
-
 	qnode_t *replace_node;
-	replace_node = tree->node_cache->in_cache.head->next;
 
-	while ((replace_node->id != id) && (replace_node != tree->node_cache->in_cache.tail)) {
-		replace_node = replace_node->next;
-	}
-	if (replace_node == tree->node_cache->in_cache.tail || !(replace_node->node_state & NODE_STATE_LOCK)) {
+	pthread_mutex_lock(&(tree->node_cache_lock));
+
+	replace_node = cache_find(tree->node_cache, id);
+	if (replace_node == NULL || !(replace_node->node_state & NODE_STATE_LOCK)) {
 		DB_LOG_E("PANIC REPLACE FOR NON_EXISTENT OR NON_LOCKED ENTRY\n");
 		pthread_mutex_unlock(&(tree->node_cache_lock));
 		return CACHE_NOT_EXIST;
@@ -1131,7 +1254,7 @@ static cache_result_t cache_replace_node(tree_t *tree, int id, tree_node_t *node
 	UNSET_NODE_STATE(replace_node, NODE_STATE_LOCK);
 	SET_NODE_STATE(replace_node, NODE_STATE_VALID | NODE_STATE_DIRTY);
 
-	memcpy(&(tree->node_cache->cache_t[replace_node->pos].node), node, sizeof(tree_node_t));
+	memcpy(CACHE_ITEM(tree->node_cache, replace_node), node, sizeof(tree_node_t));
 
 	pthread_mutex_unlock(&(tree->node_cache_lock));
 
@@ -1147,42 +1270,26 @@ static cache_result_t cache_replace_node(tree_t *tree, int id, tree_node_t *node
  ****************************************************************************/
 static cache_result_t cache_write_bucket(tree_t *tree, int id, bucket_t *bucket)
 {
+	qnode_t *new_node;
+
 	pthread_mutex_lock(&(tree->buck_cache_lock));
 
-	qnode_t *new_node = (qnode_t *) malloc(sizeof(qnode_t));
+	new_node = cache_find(tree->buck_cache, id);
 	if (new_node == NULL) {
-		pthread_mutex_unlock(&(tree->buck_cache_lock));
-		return CACHE_ALLOCATION_ERROR;
-	}
-
-	if (tree->buck_cache->num < DB_HEAP_CACHE_LIMIT) {
-		new_node->pos = tree->buck_cache->num++;
-	} else {
-		qnode_t *iter_node;
-		iter_node = tree->buck_cache->in_cache.head->next;
-		while ((iter_node->node_state & NODE_STATE_LOCK) && (iter_node != tree->buck_cache->in_cache.tail)) {
-			iter_node = iter_node->next;
-		}
-		if (iter_node == tree->buck_cache->in_cache.tail) {
-			free(new_node);
+		new_node = cache_insert(tree, tree->buck_cache, id);
+		if (new_node == NULL) {
 			DB_LOG_E("NO SLOT AVAILABLE IN CACHE bucket\n");
 			pthread_mutex_unlock(&(tree->buck_cache_lock));
 			return CACHE_FULL;
 		}
-
-		if ((iter_node->node_state & NODE_STATE_DIRTY) && (iter_node->node_state & NODE_STATE_VALID)) {
-			bucket_write(tree, iter_node->id, &(tree->buck_cache->cache_t[iter_node->pos].bucket));
-		}
-		new_node->pos = iter_node->pos;
-		REMOVE_ENTRY(iter_node);
-		free(iter_node);
+	} else {
+		REMOVE_ENTRY(new_node);
+		PLACE_AT_TAIL(new_node, tree->buck_cache);
 	}
-	PLACE_AT_TAIL(new_node, tree->buck_cache);
-	new_node->id = id;
 	UNSET_NODE_STATE(new_node, NODE_STATE_LOCK);
 	SET_NODE_STATE(new_node, NODE_STATE_DIRTY | NODE_STATE_VALID);
 
-	memcpy(&(tree->buck_cache->cache_t[new_node->pos].bucket), bucket, sizeof(bucket_t));
+	memcpy(CACHE_ITEM(tree->buck_cache, new_node), bucket, sizeof(bucket_t));
 
 	pthread_mutex_unlock(&(tree->buck_cache_lock));
 
@@ -1211,20 +1318,14 @@ static int transform_key(int key)
  ****************************************************************************/
 static tree_node_t *tree_read(tree_t *tree, int bucket_id)
 {
-	pthread_mutex_lock(&(tree->node_cache_lock));
+	qnode_t *iter;
 
-	bool found = false;
-	qnode_t *iter = (tree->node_cache->in_cache.tail)->prev;
+	pthread_mutex_lock(&(tree->node_cache_lock));
 
-	while (iter != (tree->node_cache->in_cache.head)) {
-		if (bucket_id == iter->id && (iter->node_state & NODE_STATE_VALID)) {
-			found = true;
-			break;
-		}
-		iter = iter->prev;
-	}
-	if (found) {
+	iter = cache_find(tree->node_cache, bucket_id);
+	if (iter != NULL) {
 		/* Case when node is found in the cache */
+		tree->node_cache->hits++;
 		if (iter->node_state & NODE_STATE_LOCK) {
 			pthread_mutex_unlock(&(tree->node_cache_lock));
 			return NULL;
@@ -1233,50 +1334,29 @@ static tree_node_t *tree_read(tree_t *tree, int bucket_id)
 		REMOVE_ENTRY(iter);
 		PLACE_AT_TAIL(iter, tree->node_cache);
 		pthread_mutex_unlock(&(tree->node_cache_lock));
-		return &(tree->node_cache->cache_t[iter->pos].node);
-	} else {
-		qnode_t *new_node = (qnode_t *) malloc(sizeof(qnode_t));
-		if (new_node == NULL) {
-			pthread_mutex_unlock(&(tree->node_cache_lock));
-			return NULL;
-		}
-		if (tree->node_cache->num < DB_TREE_CACHE_LIMIT) {
-			new_node->pos = tree->node_cache->num++;
-		} else {
-			/* Case when the least recently used node needs to be evicted to make place for new node */
-			qnode_t *replace_node = tree->node_cache->in_cache.head->next;
-			while ((replace_node->node_state & NODE_STATE_LOCK) && replace_node != tree->node_cache->in_cache.tail) {
-				replace_node = replace_node->next;
-			}
-			if (replace_node == tree->node_cache->in_cache.tail) {
-				free(new_node);
-				pthread_mutex_unlock(&(tree->node_cache_lock));
-				return NULL;
-			}
-			if ((replace_node->node_state & NODE_STATE_DIRTY) && (replace_node->node_state & NODE_STATE_VALID)) {
-				tree_write(tree, replace_node->id, &(tree->node_cache->cache_t[replace_node->pos].node));
-			}
-			new_node->pos = replace_node->pos;
-			REMOVE_ENTRY(replace_node);
-			free(replace_node);
-		}
-		/* Adjusting the pointers */
-		PLACE_AT_TAIL(new_node, tree->node_cache);
-		new_node->id = bucket_id;
-		SET_NODE_STATE(new_node, NODE_STATE_LOCK | NODE_STATE_VALID | NODE_STATE_DIRTY);
-
-		/* Reading from flash */
-		if (DB_ERROR(storage_read_from(tree->tree_storage, &(tree->node_cache->cache_t[new_node->pos].node), base_offset + (unsigned long)bucket_id * sizeof(tree_node_t), sizeof(tree_node_t)))) {
-			DB_LOG_E("PANIC TREE READ FAILED AT NODE ID %d\n", new_node->id);
-			UNSET_NODE_STATE(new_node, NODE_STATE_LOCK | NODE_STATE_VALID);
-			pthread_mutex_unlock(&(tree->node_cache_lock));
-			return NULL;
-		}
+		return (tree_node_t *)CACHE_ITEM(tree->node_cache, iter);
+	}
 
+	/* The least recently used node is evicted to make place for the new node */
+	tree->node_cache->misses++;
+	iter = cache_insert(tree, tree->node_cache, bucket_id);
+	if (iter == NULL) {
 		pthread_mutex_unlock(&(tree->node_cache_lock));
+		return NULL;
+	}
+	SET_NODE_STATE(iter, NODE_STATE_LOCK | NODE_STATE_VALID | NODE_STATE_DIRTY);
 
-		return &(tree->node_cache->cache_t[new_node->pos].node);
+	/* Reading from flash */
+	if (DB_ERROR(storage_read_from(tree->tree_storage, CACHE_ITEM(tree->node_cache, iter), base_offset + (unsigned long)bucket_id * sizeof(tree_node_t), sizeof(tree_node_t)))) {
+		DB_LOG_E("PANIC TREE READ FAILED AT NODE ID %d\n", bucket_id);
+		cache_remove(tree->node_cache, iter);
+		pthread_mutex_unlock(&(tree->node_cache_lock));
+		return NULL;
 	}
+
+	pthread_mutex_unlock(&(tree->node_cache_lock));
+
+	return (tree_node_t *)CACHE_ITEM(tree->node_cache, iter);
 }
 
 /****************************************************************************
@@ -1476,20 +1556,14 @@ void tree_print(tree_t *tree, int id)
  ****************************************************************************/
 static bucket_t *bucket_read(tree_t *tree, int bucket_id)
 {
-	pthread_mutex_lock(&(tree->buck_cache_lock));
+	qnode_t *iter;
 
-	bool found = false;
-	qnode_t *iter = (tree->buck_cache->in_cache.tail)->prev;
+	pthread_mutex_lock(&(tree->buck_cache_lock));
 
-	while (iter != (tree->buck_cache->in_cache.head)) {
-		if (bucket_id == iter->id && (iter->node_state & NODE_STATE_VALID)) {
-			found = true;
-			break;
-		}
-		iter = iter->prev;
-	}
-	if (found) {
+	iter = cache_find(tree->buck_cache, bucket_id);
+	if (iter != NULL) {
 		/* If the bucket is found in the cache */
+		tree->buck_cache->hits++;
 		if (iter->node_state & NODE_STATE_LOCK) {
 			pthread_mutex_unlock(&(tree->buck_cache_lock));
 			return NULL;
@@ -1498,51 +1572,27 @@ static bucket_t *bucket_read(tree_t *tree, int bucket_id)
 		REMOVE_ENTRY(iter);
 		PLACE_AT_TAIL(iter, tree->buck_cache);
 		pthread_mutex_unlock(&(tree->buck_cache_lock));
-		return &(tree->buck_cache->cache_t[iter->pos].bucket);
-	} else {
-		/* Bucket has to be read from flash into the cache */
-		qnode_t *new_node = (qnode_t *) malloc(sizeof(qnode_t));
-		if (new_node == NULL) {
-			pthread_mutex_unlock(&(tree->buck_cache_lock));
-			return NULL;
-		}
-		if (tree->buck_cache->num < DB_HEAP_CACHE_LIMIT) {
-			new_node->pos = tree->buck_cache->num++;
-		} else {
-			/* Cache doesn't have enough space and the least recently used bucket needs to be evicted */
-			qnode_t *replace_node = tree->buck_cache->in_cache.head->next;
-			while ((replace_node->node_state & NODE_STATE_LOCK) && (replace_node != tree->buck_cache->in_cache.tail)) {
-				replace_node = replace_node->next;
-			}
-			if (replace_node == tree->buck_cache->in_cache.tail) {
-				free(new_node);
-				pthread_mutex_unlock(&(tree->buck_cache_lock));
-				return NULL;
-			}
-			if ((replace_node->node_state & NODE_STATE_DIRTY) && (replace_node->node_state & NODE_STATE_VALID)) {
-				bucket_write(tree, replace_node->id, &(tree->buck_cache->cache_t[replace_node->pos].bucket));
-			}
-			new_node->pos = replace_node->pos;
-			REMOVE_ENTRY(replace_node);
-			free(replace_node);
-		}
+		return (bucket_t *)CACHE_ITEM(tree->buck_cache, iter);
+	}
 
-		/* Adjust the pointers */
-		PLACE_AT_TAIL(new_node, tree->buck_cache);
-		new_node->id = bucket_id;
-		SET_NODE_STATE(new_node, NODE_STATE_LOCK | NODE_STATE_VALID);
-		UNSET_NODE_STATE(new_node, NODE_STATE_DIRTY);
-
-		/* Read from flash */
-		if (DB_ERROR(storage_read_from(tree->bucket_storage, (void *)&(tree->buck_cache->cache_t[new_node->pos].bucket), (unsigned long)bucket_id * sizeof(bucket_t), sizeof(bucket_t)))) {
-			DB_LOG_E("PANIC BUCKET READ FAILED AT ID %d\n", bucket_id);
-			UNSET_NODE_STATE(new_node, (NODE_STATE_LOCK | NODE_STATE_VALID));
-			pthread_mutex_unlock(&(tree->buck_cache_lock));
-			return NULL;
-		}
+	/* Bucket has to be read from flash into the least recently used entry */
+	tree->buck_cache->misses++;
+	iter = cache_insert(tree, tree->buck_cache, bucket_id);
+	if (iter == NULL) {
+		pthread_mutex_unlock(&(tree->buck_cache_lock));
+		return NULL;
+	}
+	SET_NODE_STATE(iter, NODE_STATE_LOCK | NODE_STATE_VALID);
+
+	/* Read from flash */
+	if (DB_ERROR(storage_read_from(tree->bucket_storage, CACHE_ITEM(tree->buck_cache, iter), (unsigned long)bucket_id * sizeof(bucket_t), sizeof(bucket_t)))) {
+		DB_LOG_E("PANIC BUCKET READ FAILED AT ID %d\n", bucket_id);
+		cache_remove(tree->buck_cache, iter);
 		pthread_mutex_unlock(&(tree->buck_cache_lock));
-		return &(tree->buck_cache->cache_t[new_node->pos].bucket);
+		return NULL;
 	}
+	pthread_mutex_unlock(&(tree->buck_cache_lock));
+	return (bucket_t *)CACHE_ITEM(tree->buck_cache, iter);
 }
 
 /****************************************************************************
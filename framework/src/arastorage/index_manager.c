@@ -306,6 +306,47 @@ db_result_t index_insert(index_t *index, attribute_value_t *value, tuple_id_t tu
 	return index->api->insert(index, value, tuple_id);
 }
 
+/* Insert the keys of a batch of rows. Indexes without a batch operation
+   get the keys one by one. */
+db_result_t index_insert_batch(index_t *index, index_entry_t *entries, tuple_id_t count)
+{
+	attribute_value_t value;
+	tuple_id_t i;
+
+	if (index->api->insert_batch != NULL) {
+		return index->api->insert_batch(index, entries, count);
+	}
+
+	value.domain = DOMAIN_LONG;
+	for (i = 0; i < count; i++) {
+		VALUE_LONG(&value) = entries[i].key;
+		if (DB_ERROR(index->api->insert(index, &value, entries[i].tuple_id))) {
+			return DB_INDEX_ERROR;
+		}
+	}
+	return DB_OK;
+}
+
+/* Drop the index and build it again from the rows of its relation, for an
+   index which no longer matches the relation after a failed update. */
+db_result_t index_rebuild(index_t *index)
+{
+	relation_t *rel;
+	attribute_t *attr;
+	index_type_t type;
+
+	rel = index->rel;
+	attr = index->attr;
+	type = index->type;
+
+	if (DB_ERROR(index_destroy(index))) {
+		DB_LOG_E("DB: Failed to drop the index on %s.%s for a rebuild\n", rel->name, attr->name);
+		return DB_INDEX_ERROR;
+	}
+
+	return index_create(type, rel, attr);
+}
+
 db_result_t index_delete(index_t *index, attribute_value_t *value)
 {
 	if (index->state != INDEX_READY) {
@@ -440,13 +481,13 @@ db_result_t db_indexing(relation_t *rel)
 	int offset;
 	bool isfound;
 
+	row = NULL;
 	index = get_next_index_to_load();
 	if (index == NULL) {
 		DB_LOG_E("DB: Request to load an index, but no index is set to be loaded\n");
 		goto errout;
 	}
 
-	row = NULL;
 	row = (storage_row_t) malloc(sizeof(char) * rel->row_length + 1);
 	if (row == NULL) {
 		DB_LOG_E("DB: Failed to allocate row\n");
@@ -474,18 +515,25 @@ db_result_t db_indexing(relation_t *rel)
 		goto errout;
 	}
 
+#ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
+	/* Rows still in the insert buffer cannot be read from the relation */
+	if (DB_ERROR(storage_flush_insert_buffer())) {
+		DB_LOG_E("DB: Failed to flush the insert buffer\n");
+		goto errout;
+	}
+#endif
+
 	cardinality = relation_cardinality(rel);
 
 	for(tuple_id = 0; tuple_id < cardinality; tuple_id++) {
-		memset(row, 0, sizeof(row));
+		memset(row, 0, rel->row_length);
 		result = storage_get_row(rel, &tuple_id, row);
 		if (DB_ERROR(result)) {
 			DB_LOG_E("DB: Failed to get a row in relation %s!\n", rel->name);
 			goto errout;
 		}
 
-		row += offset;
-		result = db_phy_to_value(&value, index->attr, row);
+		result = db_phy_to_value(&value, index->attr, row + offset);
 		if (DB_ERROR(result)) {
 			DB_LOG_E("DB: Failed to get value from row\n");
 			goto errout;
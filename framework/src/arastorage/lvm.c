@@ -282,6 +282,7 @@ void lvm_reset(lvm_instance_t *p)
 	memset(p->code, 0, sizeof(p->code));
 	memset(p->variables, 0, sizeof(p->variables));
 	memset(p->derivations, 0, sizeof(p->derivations));
+	p->program_length = 0;
 }
 
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p)
@@ -415,6 +416,53 @@ void lvm_set_long(lvm_instance_t *p, long l)
 	lvm_set_operand(p, &op);
 }
 
+void lvm_set_parameter(lvm_instance_t *p, variable_id_t id)
+{
+	operand_t op;
+
+	op.type = LVM_PARAMETER;
+	op.value.l = 0;
+	op.value.id = id;
+
+	lvm_set_operand(p, &op);
+}
+
+/* Replace the parameter operands with the given id by a constant. The
+   bytecode is not evaluated before all of its parameters are bound. */
+lvm_status_t lvm_bind_parameter(lvm_instance_t *p, variable_id_t id, long value)
+{
+	node_type_t type;
+	operand_t operand;
+	lvm_ip_t ip;
+	lvm_status_t r;
+
+	r = INVALID_IDENTIFIER;
+	for (ip = 0; ip < p->end;) {
+		type = *(node_type_t *)(p->code + ip);
+		ip += sizeof(type);
+		if (type != LVM_OPERAND) {
+			ip += sizeof(operator_t);
+			continue;
+		}
+
+		memcpy(&operand, &p->code[ip], sizeof(operand));
+		if (operand.type == LVM_PARAMETER && operand.value.id == id) {
+			operand.type = LVM_LONG;
+			operand.value.l = value;
+			memcpy(&p->code[ip], &operand, sizeof(operand));
+			r = LVM_TRUE;
+		}
+		ip += sizeof(operand);
+	}
+
+	return r;
+}
+
+void lvm_clone(lvm_instance_t *dst, lvm_instance_t *src)
+{
+	memcpy(dst, src, sizeof(*dst));
+}
+
 lvm_status_t lvm_register_variable(lvm_instance_t *p, char *name, operand_type_t type)
 {
 	variable_id_t id;
@@ -499,14 +547,9 @@ static void create_union(derivation_t *result, derivation_t *d1, derivation_t *d
 	int i;
 
 	for (i = 0; i < LVM_MAX_VARIABLE_ID; i++) {
-		if (!d1[i].derived && !d2[i].derived) {
+		if (!d1[i].derived || !d2[i].derived) {
+			/* The variable is unconstrained on one side. */
 			continue;
-		} else if (d1[i].derived && !d2[i].derived) {
-			result[i].min.l = d1[i].min.l;
-			result[i].max.l = d1[i].max.l;
-		} else if (!d1[i].derived && d2[i].derived) {
-			result[i].min.l = d2[i].min.l;
-			result[i].max.l = d2[i].max.l;
 		} else {
 			/* Both derivations have been made; create a
 			   union of the ranges. */
@@ -661,6 +704,515 @@ lvm_status_t lvm_get_derived_range(lvm_instance_t *p, char *name, operand_value_
 	return INVALID_IDENTIFIER;
 }
 
+/*
+ * The compiler lowers the prefix bytecode into a flat program in postfix
+ * order, which lvm_execute_row() runs directly on the row bytes. Variables
+ * are replaced by loads from their offsets in the row, operations on
+ * constants are folded, and logical connectives short-circuit by jumping
+ * over their right operand. Ranges of the variables are derived on the way
+ * so that select_index() can push them into an index iterator.
+ */
+struct lvm_compiler_s {
+	lvm_instance_t *p;
+	uint8_t length;
+	int depth;
+};
+
+static lvm_insn_t *emit(struct lvm_compiler_s *c, uint8_t code, int stack)
+{
+	lvm_insn_t *insn;
+
+	c->depth += stack;
+	if (c->length >= LVM_MAX_INSNS || c->depth > LVM_STACK_SIZE) {
+		return NULL;
+	}
+
+	insn = &c->p->program[c->length++];
+	memset(insn, 0, sizeof(*insn));
+	insn->code = code;
+	return insn;
+}
+
+static lvm_status_t emit_const(struct lvm_compiler_s *c, long value)
+{
+	lvm_insn_t *insn;
+
+	insn = emit(c, LVM_INSN_CONST, 1);
+	if (insn == NULL) {
+		return STACK_OVERFLOW;
+	}
+	insn->value = value;
+	return LVM_TRUE;
+}
+
+static int is_const(struct lvm_compiler_s *c, uint8_t start)
+{
+	return c->length == start + 1 && c->p->program[start].code == LVM_INSN_CONST;
+}
+
+static uint8_t get_insn_code(operator_t op)
+{
+	switch (op) {
+	case LVM_ADD:
+		return LVM_INSN_ADD;
+	case LVM_SUB:
+		return LVM_INSN_SUB;
+	case LVM_MUL:
+		return LVM_INSN_MUL;
+	case LVM_DIV:
+		return LVM_INSN_DIV;
+	case LVM_EQ:
+		return LVM_INSN_EQ;
+	case LVM_NEQ:
+		return LVM_INSN_NEQ;
+	case LVM_GE:
+		return LVM_INSN_GE;
+	case LVM_GEQ:
+		return LVM_INSN_GEQ;
+	case LVM_LE:
+		return LVM_INSN_LE;
+	default:
+		return LVM_INSN_LEQ;
+	}
+}
+
+/* Emit a binary operator whose operands start at start, folding it
+   if both of them are constants. */
+static lvm_status_t emit_operator(struct lvm_compiler_s *c, uint8_t start, uint8_t code)
+{
+	lvm_insn_t *insn;
+	long l1, l2;
+
+	insn = &c->p->program[start];
+	if (c->length == start + 2 && insn[0].code == LVM_INSN_CONST && insn[1].code == LVM_INSN_CONST) {
+		l1 = insn[0].value;
+		l2 = insn[1].value;
+		switch (code) {
+		case LVM_INSN_ADD:
+			l1 = l1 + l2;
+			break;
+		case LVM_INSN_SUB:
+			l1 = l1 - l2;
+			break;
+		case LVM_INSN_MUL:
+			l1 = l1 * l2;
+			break;
+		case LVM_INSN_DIV:
+			if (l2 == 0) {
+				/* Leave the error to the execution. */
+				goto no_folding;
+			}
+			l1 = l1 / l2;
+			break;
+		case LVM_INSN_EQ:
+			l1 = l1 == l2;
+			break;
+		case LVM_INSN_NEQ:
+			l1 = l1 != l2;
+			break;
+		case LVM_INSN_GE:
+			l1 = l1 > l2;
+			break;
+		case LVM_INSN_GEQ:
+			l1 = l1 >= l2;
+			break;
+		case LVM_INSN_LE:
+			l1 = l1 < l2;
+			break;
+		case LVM_INSN_LEQ:
+			l1 = l1 <= l2;
+			break;
+		}
+		c->length = start;
+		c->depth -= 2;
+		return emit_const(c, l1);
+	}
+
+no_folding:
+	if (emit(c, code, -1) == NULL) {
+		return STACK_OVERFLOW;
+	}
+	return LVM_TRUE;
+}
+
+static lvm_status_t compile_expr(struct lvm_compiler_s *c)
+{
+	lvm_instance_t *p;
+	operator_t *operator;
+	operand_t operand;
+	variable_t *var;
+	lvm_insn_t *insn;
+	lvm_status_t r;
+	uint8_t start;
+	int i;
+
+	p = c->p;
+	if (p->ip >= p->end) {
+		return SEMANTIC_ERROR;
+	}
+
+	start = c->length;
+	switch (get_type(p)) {
+	case LVM_ARITH_OP:
+		operator = get_operator(p);
+		for (i = 0; i < 2; i++) {
+			r = compile_expr(c);
+			if (LVM_ERROR(r)) {
+				return r;
+			}
+		}
+		return emit_operator(c, start, get_insn_code(*operator));
+	case LVM_OPERAND:
+		get_operand(p, &operand);
+		if (operand.type == LVM_LONG) {
+			return emit_const(c, operand.value.l);
+		} else if (operand.type != LVM_VARIABLE || operand.value.id >= LVM_MAX_VARIABLE_ID) {
+			return TYPE_ERROR;
+		}
+
+		var = &p->variables[operand.value.id];
+		if (var->domain == DOMAIN_INT) {
+			insn = emit(c, LVM_INSN_LOAD_INT, 1);
+		} else if (var->domain == DOMAIN_LONG) {
+			insn = emit(c, LVM_INSN_LOAD_LONG, 1);
+		} else {
+			/* The variable is not bound to an attribute in the row. */
+			return INVALID_IDENTIFIER;
+		}
+		if (insn == NULL) {
+			return STACK_OVERFLOW;
+		}
+		insn->id = operand.value.id;
+		insn->offset = var->offset;
+		return LVM_TRUE;
+	default:
+		return SEMANTIC_ERROR;
+	}
+}
+
+/* Derive the range of the variable of a compiled comparison between a
+   variable and a constant, in either order. */
+static void derive_comparison(struct lvm_compiler_s *c, uint8_t start, derivation_t *d)
+{
+	lvm_insn_t *insn;
+	derivation_t *derivation;
+	variable_id_t id;
+	uint8_t code;
+	long value;
+
+	insn = &c->p->program[start];
+	if (c->length != start + 3) {
+		return;
+	}
+
+	code = insn[2].code;
+	if (insn[0].code != LVM_INSN_CONST && insn[1].code == LVM_INSN_CONST) {
+		id = insn[0].id;
+		value = insn[1].value;
+	} else if (insn[0].code == LVM_INSN_CONST && insn[1].code != LVM_INSN_CONST) {
+		id = insn[1].id;
+		value = insn[0].value;
+		/* Turn "constant op variable" around. */
+		if (code == LVM_INSN_GE) {
+			code = LVM_INSN_LE;
+		} else if (code == LVM_INSN_GEQ) {
+			code = LVM_INSN_LEQ;
+		} else if (code == LVM_INSN_LE) {
+			code = LVM_INSN_GE;
+		} else if (code == LVM_INSN_LEQ) {
+			code = LVM_INSN_GEQ;
+		}
+	} else {
+		return;
+	}
+
+	derivation = d + id;
+	derivation->max.l = DB_LONG_MAX;
+	derivation->min.l = DB_LONG_MIN;
+
+	switch (code) {
+	case LVM_INSN_EQ:
+		derivation->max.l = value;
+		derivation->min.l = value;
+		break;
+	case LVM_INSN_GE:
+		derivation->min.l = value + 1;
+		break;
+	case LVM_INSN_GEQ:
+		derivation->min.l = value;
+		break;
+	case LVM_INSN_LE:
+		derivation->max.l = value - 1;
+		break;
+	case LVM_INSN_LEQ:
+		derivation->max.l = value;
+		break;
+	default:
+		return;
+	}
+
+	DB_LOG_D("variable id %d, derivation max = %ld, min = %ld\n", id, derivation->max.l, derivation->min.l);
+	derivation->derived = 1;
+}
+
+static lvm_status_t compile_logic(struct lvm_compiler_s *c, derivation_t *d)
+{
+	lvm_instance_t *p;
+	operator_t op;
+	lvm_status_t r;
+	uint8_t start;
+	uint8_t jump;
+	int depth;
+	long value;
+	int i;
+
+	p = c->p;
+	if (p->ip >= p->end || get_type(p) != LVM_CMP_OP) {
+		return SEMANTIC_ERROR;
+	}
+
+	op = *get_operator(p);
+	start = c->length;
+	depth = c->depth;
+
+	if (op == LVM_NOT) {
+		derivation_t d1[LVM_MAX_VARIABLE_ID];
+
+		memset(d1, 0, sizeof(d1));
+		r = compile_logic(c, d1);
+		if (LVM_ERROR(r)) {
+			return r;
+		}
+		if (is_const(c, start)) {
+			p->program[start].value = !p->program[start].value;
+		} else if (emit(c, LVM_INSN_NOT, 0) == NULL) {
+			return STACK_OVERFLOW;
+		}
+		return LVM_TRUE;
+	} else if (op == LVM_AND || op == LVM_OR) {
+		derivation_t d1[LVM_MAX_VARIABLE_ID];
+		derivation_t d2[LVM_MAX_VARIABLE_ID];
+
+		memset(d1, 0, sizeof(d1));
+		memset(d2, 0, sizeof(d2));
+
+		r = compile_logic(c, d1);
+		if (LVM_ERROR(r)) {
+			return r;
+		}
+
+		if (is_const(c, start)) {
+			/* The right operand gives the result unless the left one
+			   already decides it. */
+			value = p->program[start].value;
+			c->length = start;
+			c->depth = depth;
+			r = compile_logic(c, d2);
+			if (LVM_ERROR(r)) {
+				return r;
+			}
+			if ((op == LVM_AND) != (value != 0)) {
+				c->length = start;
+				c->depth = depth;
+				return emit_const(c, value);
+			}
+			memcpy(d, d2, sizeof(d2));
+			return LVM_TRUE;
+		}
+
+		jump = c->length;
+		if (emit(c, op == LVM_AND ? LVM_INSN_AND : LVM_INSN_OR, -1) == NULL) {
+			return STACK_OVERFLOW;
+		}
+
+		r = compile_logic(c, d2);
+		if (LVM_ERROR(r)) {
+			return r;
+		}
+
+		if (is_const(c, jump + 1)) {
+			value = p->program[jump + 1].value;
+			if ((op == LVM_AND) != (value != 0)) {
+				/* x AND FALSE, x OR TRUE */
+				c->length = start;
+				c->depth = depth;
+				return emit_const(c, value);
+			}
+			/* x AND TRUE, x OR FALSE */
+			c->length = jump;
+			c->depth = depth + 1;
+			memcpy(d, d1, sizeof(d1));
+			return LVM_TRUE;
+		}
+
+		p->program[jump].jump = c->length;
+		if (op == LVM_AND) {
+			create_intersection(d, d1, d2);
+		} else {
+			create_union(d, d1, d2);
+		}
+		return LVM_TRUE;
+	}
+
+	for (i = 0; i < 2; i++) {
+		r = compile_expr(c);
+		if (LVM_ERROR(r)) {
+			return r;
+		}
+	}
+
+	r = emit_operator(c, start, get_insn_code(op));
+	if (LVM_ERROR(r)) {
+		return r;
+	}
+
+	derive_comparison(c, start, d);
+	return LVM_TRUE;
+}
+
+/* Compile the predicate after its variables have been bound to the row
+   layout with lvm_bind_variable(). On success lvm_execute_row() evaluates
+   the compiled program and the derived ranges replace those of lvm_derive(). */
+lvm_status_t lvm_compile(lvm_instance_t *p)
+{
+	struct lvm_compiler_s c;
+	derivation_t derivations[LVM_MAX_VARIABLE_ID];
+	lvm_status_t r;
+
+	p->program_length = 0;
+	if (p->error) {
+		return SEMANTIC_ERROR;
+	}
+
+	memset(&c, 0, sizeof(c));
+	memset(derivations, 0, sizeof(derivations));
+	c.p = p;
+
+	p->ip = 0;
+	r = compile_logic(&c, derivations);
+	p->ip = 0;
+	if (LVM_ERROR(r)) {
+		DB_LOG_D("Failed to compile the predicate : %d\n", (int)r);
+		return r;
+	}
+
+	memcpy(p->derivations, derivations, sizeof(derivations));
+	p->program_length = c.length;
+	DB_LOG_D("Compiled the predicate into %d instructions\n", c.length);
+
+	return LVM_TRUE;
+}
+
+void lvm_bind_variable(lvm_instance_t *p, attribute_t *attr, unsigned offset)
+{
+	variable_id_t id;
+
+	id = lookup(p, attr->name);
+	if (id < LVM_MAX_VARIABLE_ID && p->variables[id].name[0] != '\0') {
+		p->variables[id].domain = attr->domain;
+		p->variables[id].offset = offset;
+	}
+}
+
+/* Evaluate the predicate for a row. Predicates which could not be compiled
+   are interpreted with the values set by lvm_set_operand_value(). */
+lvm_status_t lvm_execute_row(lvm_instance_t *p, unsigned char *row)
+{
+	long stack[LVM_STACK_SIZE];
+	lvm_insn_t *insn;
+	lvm_insn_t *end;
+	unsigned char *value;
+	long *top;
+
+	if (p->program_length == 0) {
+		return lvm_execute(p);
+	}
+
+	top = stack - 1;
+	insn = p->program;
+	end = insn + p->program_length;
+	while (insn < end) {
+		switch (insn->code) {
+		case LVM_INSN_CONST:
+			*++top = insn->value;
+			break;
+		case LVM_INSN_LOAD_INT:
+			value = row + insn->offset;
+			*++top = value[0] << 8 | value[1];
+			break;
+		case LVM_INSN_LOAD_LONG:
+			value = row + insn->offset;
+			*++top = (uint32_t) value[0] << 24 | (uint32_t) value[1] << 16 | (uint32_t) value[2] << 8 | value[3];
+			break;
+		case LVM_INSN_ADD:
+			top--;
+			top[0] = top[0] + top[1];
+			break;
+		case LVM_INSN_SUB:
+			top--;
+			top[0] = top[0] - top[1];
+			break;
+		case LVM_INSN_MUL:
+			top--;
+			top[0] = top[0] * top[1];
+			break;
+		case LVM_INSN_DIV:
+			top--;
+			if (top[1] == 0) {
+				return MATH_ERROR;
+			}
+			top[0] = top[0] / top[1];
+			break;
+		case LVM_INSN_EQ:
+			top--;
+			top[0] = top[0] == top[1];
+			break;
+		case LVM_INSN_NEQ:
+			top--;
+			top[0] = top[0] != top[1];
+			break;
+		case LVM_INSN_GE:
+			top--;
+			top[0] = top[0] > top[1];
+			break;
+		case LVM_INSN_GEQ:
+			top--;
+			top[0] = top[0] >= top[1];
+			break;
+		case LVM_INSN_LE:
+			top--;
+			top[0] = top[0] < top[1];
+			break;
+		case LVM_INSN_LEQ:
+			top--;
+			top[0] = top[0] <= top[1];
+			break;
+		case LVM_INSN_NOT:
+			top[0] = !top[0];
+			break;
+		case LVM_INSN_AND:
+			if (!top[0]) {
+				insn = p->program + insn->jump;
+				continue;
+			}
+			top--;
+			break;
+		case LVM_INSN_OR:
+			if (top[0]) {
+				insn = p->program + insn->jump;
+				continue;
+			}
+			top--;
+			break;
+		default:
+			return EXECUTION_ERROR;
+		}
+		insn++;
+	}
+
+	return stack[0] ? LVM_TRUE : LVM_FALSE;
+}
+
 #if DEBUG
 static lvm_ip_t print_operator(lvm_instance_t *p, lvm_ip_t index)
 {
@@ -715,6 +1267,9 @@ static lvm_ip_t print_operand(lvm_instance_t *p, lvm_ip_t index)
 	case LVM_LONG:
 		DB_LOG_D("long:%ld ", operand.value.l);
 		break;
+	case LVM_PARAMETER:
+		DB_LOG_D("param:%d ", operand.value.id);
+		break;
 	default:
 		DB_LOG_D("?? ");
 		break;
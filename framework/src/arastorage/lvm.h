@@ -67,6 +67,7 @@
 * Pre-processor Definitions
 ****************************************************************************/
 #define LVM_ERROR(x)    (x >= 2)
+#define LVM_IS_COMPILED(p)  ((p)->program_length > 0)
 
 /****************************************************************************
 * Public Type Definitions
@@ -118,7 +119,8 @@ typedef enum lvm_operator_e operator_t;
 enum operand_type_e {
 	LVM_VARIABLE,
 	LVM_FLOAT,
-	LVM_LONG
+	LVM_LONG,
+	LVM_PARAMETER				/* placeholder replaced by lvm_bind_parameter() */
 };
 typedef enum operand_type_e operand_type_t;
 
@@ -142,6 +144,8 @@ struct operand_variable_s {
 	operand_type_t type;
 	operand_value_t value;
 	char name[LVM_MAX_NAME_LENGTH + 1];
+	uint8_t domain;				/* domain of the bound attribute */
+	uint16_t offset;			/* offset of the bound attribute in a row */
 };
 typedef struct operand_variable_s variable_t;
 
@@ -152,8 +156,40 @@ struct derivation_s {
 };
 typedef struct derivation_s derivation_t;
 
+/* Instructions of a compiled predicate. Operands are pushed on a stack
+   and replaced by the result of the operators that follow them. */
+enum lvm_insn_code_e {
+	LVM_INSN_CONST,				/* push value */
+	LVM_INSN_LOAD_INT,			/* push the int attribute at offset */
+	LVM_INSN_LOAD_LONG,			/* push the long attribute at offset */
+	LVM_INSN_ADD,
+	LVM_INSN_SUB,
+	LVM_INSN_MUL,
+	LVM_INSN_DIV,
+	LVM_INSN_EQ,
+	LVM_INSN_NEQ,
+	LVM_INSN_GE,
+	LVM_INSN_GEQ,
+	LVM_INSN_LE,
+	LVM_INSN_LEQ,
+	LVM_INSN_NOT,
+	LVM_INSN_AND,				/* keep a false top and go to jump, else pop it */
+	LVM_INSN_OR					/* keep a true top and go to jump, else pop it */
+};
+
+struct lvm_insn_s {
+	uint8_t code;
+	uint8_t jump;
+	variable_id_t id;
+	uint16_t offset;
+	long value;
+};
+typedef struct lvm_insn_s lvm_insn_t;
+
 struct lvm_instance_s {
 	unsigned char code[DB_VM_BYTECODE_SIZE];
+	lvm_insn_t program[LVM_MAX_INSNS];
+	uint8_t program_length;		/* 0 if the code is not compiled */
 	variable_t variables[LVM_MAX_VARIABLE_ID];
 	derivation_t derivations[LVM_MAX_VARIABLE_ID];
 	lvm_ip_t end;
@@ -171,6 +207,9 @@ lvm_status_t lvm_derive(lvm_instance_t *p);
 lvm_status_t lvm_get_derived_range(lvm_instance_t *p, char *name, operand_value_t *min, operand_value_t *max);
 void lvm_print_derivations(lvm_instance_t *p);
 lvm_status_t lvm_execute(lvm_instance_t *p);
+lvm_status_t lvm_compile(lvm_instance_t *p);
+lvm_status_t lvm_execute_row(lvm_instance_t *p, unsigned char *row);
+void lvm_bind_variable(lvm_instance_t *p, attribute_t *attr, unsigned offset);
 lvm_status_t lvm_register_variable(lvm_instance_t *p, char *name, operand_type_t type);
 lvm_status_t lvm_set_variable_value(lvm_instance_t *p, char *name, operand_value_t value);
 void lvm_print_code(lvm_instance_t *p);
@@ -184,5 +223,7 @@ void lvm_set_operand(lvm_instance_t *p, operand_t *op);
 void lvm_set_operand_value(lvm_instance_t *p, attribute_t *attr, unsigned char *value);
 void lvm_set_long(lvm_instance_t *p, long l);
 void lvm_set_variable(lvm_instance_t *p, char *name);
+void lvm_set_parameter(lvm_instance_t *p, variable_id_t id);
+lvm_status_t lvm_bind_parameter(lvm_instance_t *p, variable_id_t id, long value);
 
 #endif							/* LVM_H */
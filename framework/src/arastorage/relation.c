@@ -55,6 +55,7 @@
  * Included Files
  ****************************************************************************/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <tinyara/config.h>
@@ -441,37 +442,36 @@ db_result_t relation_remove(char *name, int remove_tuples)
 	return result;
 }
 
-db_result_t relation_insert(relation_t *rel, attribute_value_t *values)
+/* Convert the values of a tuple into a row of the relation. */
+static db_result_t relation_encode_row(relation_t *rel, unsigned char *record, attribute_value_t *values)
 {
 	attribute_t *attr;
-	unsigned char record[rel->row_length];
 	unsigned char *ptr;
 	attribute_value_t *value;
 	db_result_t result;
 
 	value = values;
-
-	DB_LOG_D("DB: Relation %s has a record size of %u bytes\n", rel->name, (unsigned)rel->row_length);
 	ptr = record;
 
 	DB_LOG_V("DB: Insert (");
 
 	attr = list_head(rel->attributes);
 	while (attr != NULL) {
-		/* Verify that the value is in the expected domain. An exception
-		   to this rule is that INT may be promoted to LONG. */
-		if (attr->domain != value->domain && !(attr->domain == DOMAIN_LONG && value->domain == DOMAIN_INT)) {
-			DB_LOG_E("DB: The value domain %d does not match the domain %d of attribute %s\n", value->domain, attr->domain, attr->name);
-			return DB_RELATIONAL_ERROR;
-		}
-
 		/* Set the data area for removed attributes to 0. */
 		if (attr->flags & ATTRIBUTE_FLAG_INVALID) {
 			memset(ptr, 0, attr->element_size);
 			ptr += attr->element_size;
+			attr = attr->next;
 			continue;
 		}
 
+		/* Verify that the value is in the expected domain. An exception
+		   to this rule is that INT may be promoted to LONG. */
+		if (attr->domain != value->domain && !(attr->domain == DOMAIN_LONG && value->domain == DOMAIN_INT)) {
+			DB_LOG_E("DB: The value domain %d does not match the domain %d of attribute %s\n", value->domain, attr->domain, attr->name);
+			return DB_RELATIONAL_ERROR;
+		}
+
 		result = db_value_to_phy((unsigned char *)ptr, attr, value);
 		if (DB_ERROR(result)) {
 			return result;
@@ -496,24 +496,147 @@ db_result_t relation_insert(relation_t *rel, attribute_value_t *values)
 			DB_LOG_V(", ");
 		}
 #endif              /* DEBUG */
+		ptr += attr->element_size;
+		attr = attr->next;
+		value++;
+	}
+
+	DB_LOG_V(")\n");
+
+	return DB_OK;
+}
+
+db_result_t relation_insert(relation_t *rel, attribute_value_t *values)
+{
+	attribute_t *attr;
+	unsigned char record[rel->row_length];
+	attribute_value_t *value;
+	db_result_t result;
+
+	DB_LOG_D("DB: Relation %s has a record size of %u bytes\n", rel->name, (unsigned)rel->row_length);
+
+	result = relation_encode_row(rel, record, values);
+	if (DB_ERROR(result)) {
+		return result;
+	}
+
+	value = values;
+	for (attr = list_head(rel->attributes); attr != NULL; attr = attr->next) {
+		if (attr->flags & ATTRIBUTE_FLAG_INVALID) {
+			continue;
+		}
 		if (attr->index == NULL) {
 			index_load(rel, attr);
 		}
-		ptr += attr->element_size;
 		if (attr->index != NULL) {
 			if (DB_ERROR(index_insert(attr->index, value, rel->next_row))) {
 				return DB_INDEX_ERROR;
 			}
 		}
-		attr = attr->next;
 		value++;
 	}
 
-	DB_LOG_V(")\n");
-
 	return storage_put_row(rel, record, FALSE);
 }
 
+/*
+ * Insert count tuples of stride values each. All of the tuples are
+ * converted, the indexes loaded and the key buffer allocated before
+ * anything is stored, so a tuple which does not fit the relation or a
+ * failed allocation leaves the relation unchanged. The rows are then
+ * stored as one transaction by storage_put_rows(), so a failed write
+ * leaves no partial rows behind, and each index gets the keys of all the
+ * new rows at once. The keys are kept in row order, which gives the B+tree the
+ * same shape as inserting the rows one by one.
+ *
+ * Stored rows cannot be taken back, and the B+tree cannot delete keys, so
+ * an index which fails to take the keys of the batch is rebuilt from the
+ * relation. DB_INDEX_ERROR is only returned if that rebuild fails too.
+ */
+db_result_t relation_insert_rows(relation_t *rel, attribute_value_t *values, int stride, tuple_id_t count)
+{
+	attribute_t *attr;
+	unsigned char *records;
+	index_entry_t *entries;
+	db_result_t result;
+	tuple_id_t first_row;
+	tuple_id_t i;
+	int offset;
+
+	if (count == 0) {
+		return DB_OK;
+	}
+
+	records = (unsigned char *)malloc((size_t)count * rel->row_length);
+	if (records == NULL) {
+		DB_LOG_E("DB: Failed to malloc %d rows\n", count);
+		return DB_ALLOCATION_ERROR;
+	}
+
+	for (i = 0; i < count; i++) {
+		result = relation_encode_row(rel, records + i * rel->row_length, values + i * stride);
+		if (DB_ERROR(result)) {
+			DB_LOG_E("DB: Tuple %d of the batch does not fit relation %s\n", i, rel->name);
+			free(records);
+			return result;
+		}
+	}
+
+	entries = NULL;
+	for (attr = list_head(rel->attributes); attr != NULL; attr = attr->next) {
+		if (attr->flags & ATTRIBUTE_FLAG_INVALID) {
+			continue;
+		}
+		if (attr->index == NULL) {
+			index_load(rel, attr);
+		}
+		if (attr->index != NULL && entries == NULL) {
+			entries = (index_entry_t *)malloc(count * sizeof(index_entry_t));
+			if (entries == NULL) {
+				DB_LOG_E("DB: Failed to malloc index entries\n");
+				free(records);
+				return DB_ALLOCATION_ERROR;
+			}
+		}
+	}
+
+	first_row = rel->next_row;
+	result = storage_put_rows(rel, records, count);
+	free(records);
+	if (DB_ERROR(result)) {
+		if (entries != NULL) {
+			free(entries);
+		}
+		return result;
+	}
+
+	result = DB_OK;
+	offset = 0;
+	for (attr = list_head(rel->attributes); attr != NULL; attr = attr->next) {
+		if (attr->flags & ATTRIBUTE_FLAG_INVALID) {
+			continue;
+		}
+		if (attr->index != NULL) {
+			for (i = 0; i < count; i++) {
+				entries[i].key = db_value_to_long(&values[i * stride + offset]);
+				entries[i].tuple_id = first_row + i;
+			}
+			if (DB_ERROR(index_insert_batch(attr->index, entries, count))) {
+				DB_LOG_E("DB: Failed to index the batch on %s.%s, rebuilding the index\n", rel->name, attr->name);
+				if (DB_ERROR(index_rebuild(attr->index))) {
+					result = DB_INDEX_ERROR;
+				}
+			}
+		}
+		offset++;
+	}
+
+	if (entries != NULL) {
+		free(entries);
+	}
+	return result;
+}
+
 /*
  * Update aggregation value whenever each tuple is read.
  */
@@ -679,6 +802,7 @@ static db_result_t generate_selection_result(db_handle_t **handle, relation_t *r
 	relation_t *result_rel;
 	unsigned attribute_count;
 	attribute_t *attr;
+	unsigned i;
 
 	result_rel = (*handle)->result_rel;
 
@@ -708,8 +832,13 @@ static db_result_t generate_selection_result(db_handle_t **handle, relation_t *r
 	}
 
 	if ((*handle)->lvm_instance != NULL) {
-		/* Try to establish acceptable ranges for the attribute values. */
-		if (!LVM_ERROR(lvm_derive((*handle)->lvm_instance))) {
+		/* Compile the predicate against the row layout, falling back to
+		   the interpreter if it cannot be compiled. Either way try to
+		   establish acceptable ranges for the attribute values. */
+		for (i = 0; i < attribute_count; i++) {
+			lvm_bind_variable((*handle)->lvm_instance, (*handle)->attr_map[i].from_attr, (*handle)->attr_map[i].from_offset);
+		}
+		if (!LVM_ERROR(lvm_compile((*handle)->lvm_instance)) || !LVM_ERROR(lvm_derive((*handle)->lvm_instance))) {
 			select_index(handle);
 		}
 	}
@@ -721,12 +850,53 @@ static db_result_t generate_selection_result(db_handle_t **handle, relation_t *r
 		return DB_ALLOCATION_ERROR;
 	}
 
+	/* The scan buffer, tuple and attr_map are released by aql_deinit_handle */
+	(*handle)->scan_buf = (unsigned char *)malloc(sizeof(char) * rel->row_length * DB_SCAN_BLOCK_ROWS + 1);
+	if ((*handle)->scan_buf == NULL) {
+		DB_LOG_E("DB: Failed to malloc scan buffer\n");
+		return DB_ALLOCATION_ERROR;
+	}
+	(*handle)->scan_first = 0;
+	(*handle)->scan_rows = 0;
+	if (DB_ERROR(storage_get_row_amount(rel, &(*handle)->scan_total))) {
+		return DB_STORAGE_ERROR;
+	}
+
 	/* Set flag to process tuples which need to be read */
 	(*handle)->flags |= DB_HANDLE_FLAG_PROCESSING;
 
 	return DB_OK;
 }
 
+/* Get the row of tuple_id from the scan buffer of the handle. When the row
+   is not buffered, up to block rows starting from it are read at once.
+   Sequential scans read DB_SCAN_BLOCK_ROWS rows, index lookups only one. */
+static db_result_t relation_scan_row(db_handle_t *handle, tuple_id_t tuple_id, tuple_id_t block, storage_row_t *row)
+{
+	db_result_t result;
+	tuple_id_t count;
+
+	if (tuple_id >= handle->scan_total) {
+		return DB_FINISHED;
+	}
+
+	if (tuple_id < handle->scan_first || tuple_id - handle->scan_first >= handle->scan_rows) {
+		count = handle->scan_total - tuple_id;
+		if (count > block) {
+			count = block;
+		}
+		result = storage_get_rows(handle->rel, tuple_id, count, handle->scan_buf, &handle->scan_rows);
+		if (result != DB_OK) {
+			handle->scan_rows = 0;
+			return result;
+		}
+		handle->scan_first = tuple_id;
+	}
+
+	*row = handle->scan_buf + (tuple_id - handle->scan_first) * handle->rel->row_length;
+	return DB_OK;
+}
+
 db_result_t relation_process(db_handle_t **handle, db_cursor_t *cursor)
 {
 	uint32_t optype;
@@ -764,6 +934,7 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 	char aggr_buf[8];
 	attribute_value_t value;
 	storage_row_t row = NULL;
+	tuple_id_t block;
 	tuple_t result_row;
 
 	if (cursor == NULL) {
@@ -794,15 +965,10 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 		(*handle)->tuple_id++;
 	}
 
-	row = (storage_row_t) malloc(sizeof(char) * (*handle)->rel->row_length + 1);
-	if (row == NULL) {
-		DB_LOG_E("DB: Failed to allocate row\n");
-		return DB_ALLOCATION_ERROR;
-	}
-
 	/* Put the tuples fulfilling the- given condition into a new relation.
 	   The tuples may be projected. */
-	result = storage_get_row((*handle)->rel, &((*handle)->tuple_id), row);
+	block = ((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX) ? 1 : DB_SCAN_BLOCK_ROWS;
+	result = relation_scan_row(*handle, (*handle)->tuple_id, block, &row);
 	if (DB_ERROR(result)) {
 		DB_LOG_E("DB: Failed to get a row in relation %s!\n", (*handle)->rel->name);
 		goto errout;
@@ -810,9 +976,6 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 		if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
 			goto processing_aggregation;
 		}
-		if (row != NULL) {
-			free(row);
-		}
 		return DB_FINISHED;
 	}
 
@@ -821,7 +984,7 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 		from_ptr = row + attr_map_ptr->from_offset;
 		from_attr = attr_map_ptr->from_attr;
 
-		if (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG) {
+		if ((*handle)->lvm_instance != NULL && !LVM_IS_COMPILED((lvm_instance_t *)(*handle)->lvm_instance) && (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG)) {
 			lvm_set_operand_value((*handle)->lvm_instance, from_attr, from_ptr);
 		}
 
@@ -838,7 +1001,7 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 	}
 
 	/* Check whether the given predicate is true for this tuple. */
-	if ((*handle)->lvm_instance == NULL || lvm_execute((*handle)->lvm_instance) == TRUE) {
+	if ((*handle)->lvm_instance == NULL || lvm_execute_row((*handle)->lvm_instance, row) == TRUE) {
 		(*handle)->current_row++;
 
 		if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
@@ -862,9 +1025,6 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 		}
 	}
 
-	if (row != NULL) {
-		free(row);
-	}
 	return DB_OK;
 
 processing_aggregation:
@@ -890,16 +1050,9 @@ processing_aggregation:
 	}
 	cursor->total_rows = 1;
 
-	if (row != NULL) {
-		free(row);
-	}
 	return DB_FINISHED;
 
 errout:
-	if (row != NULL) {
-		free(row);
-	}
-
 	return result;
 }
 
@@ -926,15 +1079,9 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 	/* Search all tuples sequentially without index. */
 	(*handle)->tuple_id++;
 
-	row = (storage_row_t) malloc(sizeof(char) * (*handle)->rel->row_length + 1);
-	if (row == NULL) {
-		DB_LOG_E("DB: Failed to allocate row\n");
-		return DB_ALLOCATION_ERROR;
-	}
-
 	/* Put the tuples fulfilling the- given condition into a new relation.
 	   The tuples may be projected. */
-	result = storage_get_row((*handle)->rel, &((*handle)->tuple_id), row);
+	result = relation_scan_row(*handle, (*handle)->tuple_id, DB_SCAN_BLOCK_ROWS, &row);
 	if (DB_ERROR(result)) {
 		DB_LOG_E("DB: Failed to get a row in relation %s!\n", (*handle)->rel->name);
 		goto errout;
@@ -947,7 +1094,7 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 		from_ptr = row + attr_map_ptr->from_offset;
 		from_attr = attr_map_ptr->from_attr;
 
-		if (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG) {
+		if ((*handle)->lvm_instance != NULL && !LVM_IS_COMPILED((lvm_instance_t *)(*handle)->lvm_instance) && (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG)) {
 			lvm_set_operand_value((*handle)->lvm_instance, from_attr, from_ptr);
 		}
 
@@ -961,7 +1108,7 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 	}
 
 	/* Check whether the given predicate is true for this tuple. */
-	if ((*handle)->lvm_instance == NULL || lvm_execute((*handle)->lvm_instance) == FALSE) {
+	if ((*handle)->lvm_instance == NULL || lvm_execute_row((*handle)->lvm_instance, row) == FALSE) {
 		result = storage_put_row((*handle)->result_rel, result_row, TRUE);
 		if (DB_ERROR(result)) {
 			DB_LOG_E("DB: Failed to store a row in the result relation!\n");
@@ -969,15 +1116,9 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 		}
 
 		(*handle)->current_row++;
-		if (row != NULL) {
-			free(row);
-		}
 		return DB_GOT_ROW;
 	}
 
-	if (row != NULL) {
-		free(row);
-	}
 	return DB_OK;
 
 end_removal:
@@ -1021,10 +1162,6 @@ end_removal:
 		}
 	}
 
-	if (row != NULL) {
-		free(row);
-	}
-
 	return DB_FINISHED;
 
 errout:
@@ -1032,10 +1169,6 @@ errout:
 	storage_write_buffer_clean();
 #endif
 
-	if (row != NULL) {
-		free(row);
-	}
-
 	return result;
 }
 
@@ -1053,7 +1186,7 @@ db_cursor_t *relation_process_result(db_handle_t *handler)
 
 	/* when SELECT, cursor row data is set in processing tuple by tuple.
 	   So we need to initialize cursor and make cursor data before processing tuples */
-	if (handler->optype == AQL_TYPE_SELECT) {
+	if (AQL_GET_EXEC_TYPE(handler->optype) == AQL_TYPE_SELECT) {
 		if (DB_ERROR(cursor_init(&cursor, handler->rel)) || DB_ERROR(cursor_data_set(cursor, handler->attr_map, handler->result_rel->attribute_count))) {
 			DB_LOG_E("DB: Failed to init cursor and set cursor data\n");
 			cursor_deinit(cursor);
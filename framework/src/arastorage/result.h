@@ -107,6 +107,10 @@ struct _db_handle_s {
 	uint8_t ncolumns;
 	void *lvm_instance;
 	source_dest_map_t *attr_map;
+	unsigned char *scan_buf;	/* rows read ahead by the scan */
+	tuple_id_t scan_first;		/* tuple id of the first row in scan_buf */
+	tuple_id_t scan_rows;		/* number of valid rows in scan_buf */
+	tuple_id_t scan_total;		/* number of rows in rel when the scan started */
 };
 
 /****************************************************************************
@@ -57,6 +57,7 @@
  ****************************************************************************/
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -141,12 +142,31 @@ db_result_t storage_generate_file(char *filename)
 	return DB_OK;
 }
 
+/* A batch insert writes the whole relation to the temporary tuple file,
+   removes the tuple file and renames the temporary file in its place.
+   If only the temporary file is found the batch was committed and the
+   rename is finished here; if both are found the batch was not, and the
+   temporary file is dropped. */
 db_result_t storage_load(relation_t *rel)
 {
+	char temp_filename[TUPLE_NAME_LENGTH + 1];
+
+	snprintf(temp_filename, sizeof(temp_filename), "%s%s", rel->tuple_filename, TUPLE_TEMP_SUFFIX);
+
 	rel->tuple_storage = storage_open(rel->tuple_filename, O_APPEND | O_RDWR);
 	if (rel->tuple_storage < 0) {
-		DB_LOG_E("DB: Failed to open the tuple file\n");
-		return DB_STORAGE_ERROR;
+		if (DB_ERROR(storage_rename(temp_filename, rel->tuple_filename))) {
+			DB_LOG_E("DB: Failed to open the tuple file\n");
+			return DB_STORAGE_ERROR;
+		}
+		DB_LOG_D("DB: Finished committing the tuple file %s\n", rel->tuple_filename);
+		rel->tuple_storage = storage_open(rel->tuple_filename, O_APPEND | O_RDWR);
+		if (rel->tuple_storage < 0) {
+			DB_LOG_E("DB: Failed to open the tuple file\n");
+			return DB_STORAGE_ERROR;
+		}
+	} else {
+		storage_remove(temp_filename);
 	}
 	return DB_OK;
 }
@@ -523,6 +543,37 @@ db_result_t storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t
 	return DB_OK;
 }
 
+/* Read up to count rows starting from tuple first with a single read.
+   The number of complete rows read is returned in nrows. */
+db_result_t storage_get_rows(relation_t *rel, tuple_id_t first, tuple_id_t count, storage_row_t rows, tuple_id_t *nrows)
+{
+	ssize_t r;
+
+	*nrows = 0;
+	if (rel->row_length == 0 || count == 0) {
+		return DB_FINISHED;
+	}
+
+	if (storage_seek(rel->tuple_storage, (unsigned long)first * rel->row_length, SEEK_SET) == (off_t) - 1) {
+		return DB_STORAGE_ERROR;
+	}
+
+	r = storage_read(rel->tuple_storage, rows, count * rel->row_length);
+	if (r < 0) {
+		DB_LOG_E("DB: Reading failed on fd %d\n", rel->tuple_storage);
+		return DB_STORAGE_ERROR;
+	} else if (r == 0) {
+		return DB_FINISHED;
+	} else if (r < rel->row_length) {
+		DB_LOG_E("DB: Incomplete record: %d < %d\n", r, rel->row_length);
+		return DB_STORAGE_ERROR;
+	}
+
+	*nrows = (tuple_id_t)(r / rel->row_length);
+	DB_LOG_D("DB: Read %d rows from relation %s\n", *nrows, rel->name);
+	return DB_OK;
+}
+
 db_result_t storage_put_row(relation_t *rel, storage_row_t row, uint8_t flag)
 {
 	db_result_t result;
@@ -541,6 +592,98 @@ db_result_t storage_put_row(relation_t *rel, storage_row_t row, uint8_t flag)
 	return result;
 }
 
+/* Copy the rows of the relation to fd, a block of rows at a time. */
+static db_result_t storage_copy_rows(relation_t *rel, db_storage_id_t fd)
+{
+	unsigned char *block;
+	unsigned length;
+	ssize_t r;
+
+	length = DB_SCAN_BLOCK_ROWS * rel->row_length;
+	block = (unsigned char *)malloc(length);
+	if (block == NULL) {
+		return DB_ALLOCATION_ERROR;
+	}
+
+	if (storage_seek(rel->tuple_storage, 0, SEEK_SET) == (off_t) - 1) {
+		free(block);
+		return DB_STORAGE_ERROR;
+	}
+
+	while ((r = storage_read(rel->tuple_storage, block, length)) > 0) {
+		if (storage_write(fd, block, r) != r) {
+			free(block);
+			return DB_STORAGE_ERROR;
+		}
+	}
+
+	free(block);
+	return r < 0 ? DB_STORAGE_ERROR : DB_OK;
+}
+
+/* Append count rows as one transaction. The rows of the relation and the
+   new rows are written to the temporary tuple file, which then replaces
+   the tuple file, so after a failure or a power loss the relation holds
+   either all of the new rows or none of them. See storage_load() for the
+   recovery. This copies the relation, so large batches pay off best. */
+db_result_t storage_put_rows(relation_t *rel, storage_row_t rows, tuple_id_t count)
+{
+	char temp_filename[TUPLE_NAME_LENGTH + 1];
+	db_storage_id_t fd;
+	db_result_t result;
+	ssize_t r;
+	unsigned length;
+
+	length = count * rel->row_length;
+
+#ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
+	/* Rows waiting in the write buffer go before the new ones. */
+	if (DB_ERROR(storage_flush_insert_buffer())) {
+		return DB_STORAGE_ERROR;
+	}
+#endif
+	snprintf(temp_filename, sizeof(temp_filename), "%s%s", rel->tuple_filename, TUPLE_TEMP_SUFFIX);
+	fd = storage_open(temp_filename, O_RDWR | O_APPEND | O_CREAT | O_TRUNC);
+	if (fd < 0) {
+		DB_LOG_E("DB: Failed to create %s\n", temp_filename);
+		return DB_STORAGE_ERROR;
+	}
+
+	result = storage_copy_rows(rel, fd);
+	if (DB_SUCCESS(result)) {
+		r = storage_write(fd, rows, length);
+		if (r != length) {
+			result = DB_STORAGE_ERROR;
+		}
+	}
+	if (storage_close(fd) < 0 && DB_SUCCESS(result)) {
+		result = DB_STORAGE_ERROR;
+	}
+	if (DB_ERROR(result)) {
+		DB_LOG_E("DB: Failed to store %u bytes of rows in %s\n", length, rel->name);
+		storage_remove(temp_filename);
+		return result;
+	}
+
+	/* Removing the tuple file commits the batch */
+	storage_close(rel->tuple_storage);
+	rel->tuple_storage = -1;
+	if (DB_ERROR(storage_remove(rel->tuple_filename))) {
+		DB_LOG_E("DB: Failed to replace the tuple file of %s\n", rel->name);
+		storage_remove(temp_filename);
+		storage_load(rel);
+		return DB_STORAGE_ERROR;
+	}
+	if (DB_ERROR(storage_load(rel))) {
+		return DB_STORAGE_ERROR;
+	}
+
+	DB_LOG_D("DB: Stored %d rows (%u bytes) in relation %s\n", count, length, rel->name);
+	rel->cardinality += count;
+	rel->next_row += count;
+	return DB_OK;
+}
+
 db_result_t storage_write_row(db_storage_id_t fd, storage_row_t row, unsigned length, char *filename)
 {
 #ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
@@ -569,12 +712,13 @@ db_result_t storage_flush_insert_buffer()
 {
 	ssize_t r;
 	int fd;
-	if (g_storage_write_buffer.data_size > 0) {
-		fd = storage_open(g_storage_write_buffer.file_name, O_APPEND | O_RDWR);
-		if (fd < 0) {
-			DB_LOG_D("Failed to open %s\n", g_storage_write_buffer.file_name);
-			return DB_STORAGE_ERROR;
-		}
+	if (g_storage_write_buffer.data_size == 0) {
+		return DB_OK;
+	}
+	fd = storage_open(g_storage_write_buffer.file_name, O_APPEND | O_RDWR);
+	if (fd < 0) {
+		DB_LOG_D("Failed to open %s\n", g_storage_write_buffer.file_name);
+		return DB_STORAGE_ERROR;
 	}
 	r = storage_write(fd, g_storage_write_buffer.buffer, g_storage_write_buffer.data_size);
 	if (r < 0) {
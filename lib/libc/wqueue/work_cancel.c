@@ -123,6 +123,20 @@ static int work_qcancel(FAR struct usr_wqueue_s *wqueue, FAR struct work_s *work
 	 * new work is typically added to the work queue from interrupt handlers.
 	 */
 
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	if (work_isqueued(wqueue, work)) {
+		/* Work with no delay is in the ready FIFO; work_process() clears the
+		 * delay when it moves expired work there.  Remove the entry and make
+		 * sure that it is mark as available (i.e., the worker field is
+		 * nullified).
+		 */
+
+		if (work->delay == 0) {
+			dq_rem((FAR dq_entry_t *)work, &wqueue->ready);
+		} else {
+			dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+		}
+#else
 	if (work->worker != NULL) {
 		/* A little test of the integrity of the work queue */
 
@@ -134,7 +148,11 @@ static int work_qcancel(FAR struct usr_wqueue_s *wqueue, FAR struct work_s *work
 		 */
 
 		dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+#endif
 		work->worker = NULL;
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+		work->wqueue = NULL;
+#endif
 		ret = OK;
 	}
 
@@ -118,6 +118,67 @@
  *
  ****************************************************************************/
 
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+static int work_qqueue(FAR struct usr_wqueue_s *wqueue, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
+{
+	FAR struct work_s *prev;
+	systime_t now;
+	bool wakeup;
+
+	DEBUGASSERT(work != NULL);
+
+	/* Get exclusive access to the work queue */
+
+	while (work_lock() < 0);
+
+	if (work_isqueued(wqueue, work)) {
+		work_unlock();
+		return -EALREADY;
+	}
+
+	now = clock_systimer();
+	work->worker = worker;		/* Work callback */
+	work->arg = arg;			/* Callback argument */
+	work->delay = delay;		/* Delay until work performed */
+	work->qtime = now;			/* Time work queued */
+	work->wqueue = wqueue;		/* Marks the work as queued */
+
+	if (delay == 0) {
+		dq_addlast((FAR dq_entry_t *)work, &wqueue->ready);
+		wakeup = true;
+	} else {
+		/* Keep the delayed work in order of expiration, searching from the
+		 * tail.  The worker only needs to know if the earliest deadline
+		 * changed.
+		 */
+
+		prev = (FAR struct work_s *)wqueue->q.tail;
+		while (prev != NULL && work_remaining(prev, now) > delay) {
+			prev = (FAR struct work_s *)prev->dq.blink;
+		}
+
+		if (prev != NULL) {
+			dq_addafter((FAR dq_entry_t *)prev, (FAR dq_entry_t *)work, &wqueue->q);
+			wakeup = false;
+		} else {
+			dq_addfirst((FAR dq_entry_t *)work, &wqueue->q);
+			wakeup = true;
+		}
+	}
+
+	/* Signal the worker thread only if it is waiting and has not already
+	 * been signalled.
+	 */
+
+	if (wakeup && !wqueue->busy) {
+		wqueue->busy = true;
+		kill(wqueue->pid, SIGWORK);
+	}
+
+	work_unlock();
+	return OK;
+}
+#else
 static int work_qqueue(FAR struct usr_wqueue_s *wqueue, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
 {
 	DEBUGASSERT(work != NULL);
@@ -142,6 +203,7 @@ static int work_qqueue(FAR struct usr_wqueue_s *wqueue, FAR struct work_s *work,
 	work_unlock();
 	return OK;
 }
+#endif							/* CONFIG_SCHED_WORKQUEUE_DEADLINE */
 
 /****************************************************************************
  * Public Functions
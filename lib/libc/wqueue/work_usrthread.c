@@ -58,6 +58,8 @@
 
 #include <stdint.h>
 #include <unistd.h>
+#include <signal.h>
+#include <time.h>
 #include <pthread.h>
 #include <sched.h>
 #include <errno.h>
@@ -134,6 +136,94 @@ pthread_mutex_t g_usrmutex;
  *
  ****************************************************************************/
 
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+void work_process(FAR struct usr_wqueue_s *wqueue)
+{
+	FAR struct work_s *work;
+	worker_t worker;
+	FAR void *arg;
+	struct timespec timeout;
+	sigset_t set;
+	systime_t remaining;
+	systime_t next;
+	int ret;
+
+	ret = work_lock();
+	if (ret < 0) {
+		/* Break out earlier if we were awakened by a signal */
+
+		return;
+	}
+
+	/* The worker is running, producers need not signal it */
+
+	wqueue->busy = true;
+
+	/* Drain the ready FIFO.  Each pass takes the work at the head, so
+	 * nothing needs to be rescanned after the work queue is unlocked to
+	 * perform the work.
+	 */
+
+	for (;;) {
+		work_expire(&wqueue->q, &wqueue->ready);
+
+		work = (FAR struct work_s *)dq_remfirst(&wqueue->ready);
+		if (work == NULL) {
+			break;
+		}
+
+		/* Extract the work description from the entry (in case the work
+		 * instance is re-used after it has been de-queued) and mark the
+		 * work as no longer being queued.
+		 */
+
+		worker = work->worker;
+		arg = work->arg;
+		work->worker = NULL;
+		work->wqueue = NULL;
+
+		if (worker != NULL) {
+			work_unlock();
+			worker(arg);
+
+			ret = work_lock();
+			if (ret < 0) {
+				return;
+			}
+		}
+	}
+
+	/* Wait until the earliest delayed work expires or until the end of the
+	 * polling period, whichever comes first.
+	 */
+
+	next = wqueue->delay;
+	work = (FAR struct work_s *)wqueue->q.head;
+	if (work != NULL) {
+		remaining = work_remaining(work, clock_systimer());
+		next = MIN(next, remaining);
+	}
+
+	/* From here on, work that needs the worker sooner must signal it.  The
+	 * work queue is unlocked while waiting.  SIGWORK is blocked in the worker
+	 * thread, so a signal sent before the wait begins stays pending and ends
+	 * the wait immediately.
+	 */
+
+	wqueue->busy = false;
+	work_unlock();
+
+	if (next > 0) {
+		sigemptyset(&set);
+		sigaddset(&set, SIGWORK);
+
+		next *= USEC_PER_TICK;
+		timeout.tv_sec = next / USEC_PER_SEC;
+		timeout.tv_nsec = (next % USEC_PER_SEC) * NSEC_PER_USEC;
+		(void)sigtimedwait(&set, NULL, &timeout);
+	}
+}
+#else
 void work_process(FAR struct usr_wqueue_s *wqueue)
 {
 	volatile FAR struct work_s *work;
@@ -282,6 +372,7 @@ void work_process(FAR struct usr_wqueue_s *wqueue)
 
 	work_unlock();
 }
+#endif							/* CONFIG_SCHED_WORKQUEUE_DEADLINE */
 
 /****************************************************************************
  * Name: work_usrthread
@@ -308,6 +399,18 @@ static int work_usrthread(int argc, char *argv[])
 static pthread_addr_t work_usrthread(pthread_addr_t arg)
 #endif
 {
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	sigset_t set;
+
+	/* Keep SIGWORK blocked so that a wakeup is held pending, and not lost,
+	 * while the worker is not waiting for it.
+	 */
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGWORK);
+	(void)sigprocmask(SIG_BLOCK, &set, NULL);
+#endif
+
 	/* Loop forever */
 
 	for (;;) {
@@ -350,6 +453,10 @@ int work_usrstart(void)
 
 	g_usrwork.delay = CONFIG_LIB_USRWORKPERIOD / USEC_PER_TICK;
 	dq_init(&g_usrwork.q);
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	dq_init(&g_usrwork.ready);
+	g_usrwork.busy = true;
+#endif
 
 #ifdef CONFIG_BUILD_PROTECTED
 	{
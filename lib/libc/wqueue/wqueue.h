@@ -59,9 +59,11 @@
 
 #include <tinyara/config.h>
 
+#include <stdbool.h>
 #include <semaphore.h>
 #include <pthread.h>
 
+#include <tinyara/clock.h>
 #include <tinyara/wqueue.h>
 
 #if defined(CONFIG_LIB_USRWORK) && !defined(__KERNEL__)
@@ -79,6 +81,10 @@
 struct usr_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
 	struct dq_queue_s q;		/* The queue of pending work */
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	struct dq_queue_s ready;	/* FIFO of work ready to be performed */
+	volatile bool busy;			/* True: Worker does not need a signal */
+#endif
 	pid_t pid;					/* The task ID of the worker thread(s) */
 };
 
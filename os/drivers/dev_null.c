@@ -121,7 +121,7 @@ static int devnull_poll(FAR struct file *filep, FAR struct pollfd *fds, bool set
 	if (setup) {
 		fds->revents |= (fds->events & (POLLIN | POLLOUT));
 		if (fds->revents != 0) {
-			sem_post(fds->sem);
+			poll_notify(fds);
 		}
 	}
 
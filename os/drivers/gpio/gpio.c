@@ -27,6 +27,7 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <tinyara/fs/fs.h>
 #include <tinyara/gpio.h>
 
 /*******************************************************************************
@@ -150,7 +151,7 @@ static void gpio_pollnotify(FAR struct gpio_dev_s *dev, pollevent_t eventset)
 
 			if (fds->revents != 0) {
 				fvdbg("Report events: %02x\n", fds->revents);
-				sem_post(fds->sem);
+				poll_notify(fds);
 			}
 		}
 	}
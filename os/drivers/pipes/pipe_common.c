@@ -142,7 +142,7 @@ static void pipecommon_pollnotify(FAR struct pipe_dev_s *dev, pollevent_t events
 			fds->revents |= (fds->events & eventset);
 			if (fds->revents != 0) {
 				fvdbg("Report events: %02x\n", fds->revents);
-				sem_post(fds->sem);
+				poll_notify(fds);
 			}
 		}
 	}
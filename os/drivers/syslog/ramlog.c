@@ -195,7 +195,7 @@ static void ramlog_pollnotify(FAR struct ramlog_dev_s *priv, pollevent_t eventse
 		if (fds) {
 			fds->revents |= (fds->events & eventset);
 			if (fds->revents != 0) {
-				sem_post(fds->sem);
+				poll_notify(fds);
 			}
 		}
 		irqrestore(flags);
@@ -484,7 +484,7 @@ static void usbhost_pollnotify(FAR struct usbhost_state_s *priv)
 			fds->revents |= (fds->events & POLLIN);
 			if (fds->revents != 0) {
 				uvdbg("Report events: %02x\n", fds->revents);
-				sem_post(fds->sem);
+				poll_notify(fds);
 			}
 		}
 	}
@@ -694,7 +694,7 @@ static void usbhost_notify(FAR struct usbhost_state_s *priv)
 		if (fds) {
 			fds->revents |= POLLIN;
 			ivdbg("Report events: %02x\n", fds->revents);
-			sem_post(fds->sem);
+			poll_notify(fds);
 		}
 	}
 #endif
@@ -1193,7 +1193,7 @@ static int mtdconfig_poll(FAR struct file *filep, FAR struct pollfd *fds, bool s
 	if (setup) {
 		fds->revents |= (fds->events & (POLLIN | POLLOUT));
 		if (fds->revents != 0) {
-			sem_post(fds->sem);
+			poll_notify(fds);
 		}
 	}
 
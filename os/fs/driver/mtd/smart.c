@@ -73,12 +73,20 @@
 #include <crc16.h>
 #include <crc32.h>
 #include <tinyara/math.h>
+#include <tinyara/clock.h>
 #include <tinyara/kmalloc.h>
 #include <tinyara/fs/fs.h>
 #include <tinyara/fs/ioctl.h>
 #include <tinyara/fs/mtd.h>
 #include <tinyara/fs/smart_procfs.h>
 #include <tinyara/fs/smart.h>
+#if defined(CONFIG_MTD_SMART_GC_BACKGROUND) || defined(CONFIG_SMARTFS_FINE_LOCKING)
+#include <assert.h>
+#include <semaphore.h>
+#endif
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+#include <tinyara/wqueue.h>
+#endif
 
 /****************************************************************************
  * Private Definitions
@@ -159,6 +167,14 @@
 #define SMART_HAVE_RWBUFFER 1
 #endif
 
+/* The device is locked around each access when the background garbage
+ * collection worker or file system tasks may use it concurrently.
+ */
+
+#if defined(CONFIG_MTD_SMART_GC_BACKGROUND) || defined(CONFIG_SMARTFS_FINE_LOCKING)
+#define SMART_HAVE_EXCLSEM 1
+#endif
+
 #ifndef CONFIG_MTD_SMART_SECTOR_SIZE
 #define  CONFIG_MTD_SMART_SECTOR_SIZE 1024
 #endif
@@ -168,6 +184,49 @@
 #endif
 
 #define SMART_MAX_ALLOCS        6
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+#ifndef CONFIG_MTD_SMART_SECTOR_CACHE_SIZE
+#define CONFIG_MTD_SMART_SECTOR_CACHE_SIZE 64
+#endif
+
+#ifndef CONFIG_MTD_SMART_MAP_SEGMENT_SIZE
+#define CONFIG_MTD_SMART_MAP_SEGMENT_SIZE  64
+#endif
+
+#ifndef CONFIG_MTD_SMART_MAP_SEGMENTS
+#define CONFIG_MTD_SMART_MAP_SEGMENTS      4
+#endif
+
+#if CONFIG_MTD_SMART_MAP_SEGMENTS > 254
+#error "CONFIG_MTD_SMART_MAP_SEGMENTS must be less than 255"
+#endif
+
+/* Sector cache and map segment definitions.  The sector cache holds
+ * individual hot mappings and is indexed by a hash of the logical sector
+ * number.  Map segments hold the mapping of a run of consecutive logical
+ * sectors and are rebuilt from the sector headers on demand.
+ */
+
+#define SMART_CACHE_NONE          0xFFFF
+#define SMART_CACHE_HASH(l)       ((l) % CONFIG_MTD_SMART_SECTOR_CACHE_SIZE)
+#define SMART_MAP_NONE            0xFF
+#define SMART_MAP_SEGMENT(l)      ((l) / CONFIG_MTD_SMART_MAP_SEGMENT_SIZE)
+#define SMART_MAP_OFFSET(l)       ((l) % CONFIG_MTD_SMART_MAP_SEGMENT_SIZE)
+#define SMART_MAP_NSEGMENTS(n)    (((n) + CONFIG_MTD_SMART_MAP_SEGMENT_SIZE - 1) / \
+								   CONFIG_MTD_SMART_MAP_SEGMENT_SIZE)
+#define SMART_CACHE_ALLOCSIZE     (CONFIG_MTD_SMART_SECTOR_CACHE_SIZE * \
+								   (sizeof(struct smart_cache_s) + sizeof(uint16_t)) + \
+								   CONFIG_MTD_SMART_MAP_SEGMENTS * \
+								   (CONFIG_MTD_SMART_MAP_SEGMENT_SIZE * sizeof(uint16_t) + \
+									sizeof(struct smart_mapseg_s)))
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+#define smart_mapstat(d, f)       ((d)->f++)
+#else
+#define smart_mapstat(d, f)
+#endif
+#endif
 //#define CONFIG_MTD_SMART_PACK_COUNTS
 
 #ifndef CONFIG_MTD_SMART_ALLOC_DEBUG
@@ -228,11 +287,35 @@ static const uint8_t gWearBitToLevelMap4[] = {
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+struct smart_blklink_s {
+	uint16_t prev;				/* Previous erase block in the bucket */
+	uint16_t next;				/* Next erase block in the bucket */
+};
+
+/* Erase blocks bucketed by a small key (free count, release count or wear
+ * level).  Each bucket is a circular list so the head's prev is the tail.
+ */
+
+struct smart_blkindex_s {
+	FAR uint16_t *head;			/* First erase block in each bucket */
+	FAR struct smart_blklink_s *link;	/* Bucket links of each erase block */
+	uint16_t top;				/* No bucket above this one is in use */
+};
+#endif
+
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
 struct smart_cache_s {
 	uint16_t logical;			/* Logical sector number */
 	uint16_t physical;			/* Associated physical sector */
-	uint16_t birth;				/* The "birthday" of this entry */
+	uint16_t hnext;				/* Next entry in hash chain or free list */
+	uint16_t prev;				/* Previous (more recently used) entry */
+	uint16_t next;				/* Next (less recently used) entry */
+};
+
+struct smart_mapseg_s {
+	uint16_t segment;			/* Map segment held in this slot */
+	uint16_t lastuse;			/* Aging value of the last access */
 };
 #endif
 
@@ -252,6 +335,17 @@ struct smart_allocsector_s {
 };
 #endif
 
+/* State of an erase block relocation.  Garbage collection may spread the
+ * relocation of a block over several writes.
+ */
+
+struct smart_relocate_s {
+	uint16_t block;				/* Erase block being relocated */
+	uint16_t next;				/* Next physical sector to examine */
+	uint16_t freecount;			/* Free sectors withheld from the block */
+	uint16_t moved;				/* Live sectors moved out so far */
+};
+
 struct smart_struct_s {
 	FAR struct mtd_dev_s *mtd;	/* Contained MTD interface */
 	struct mtd_geometry_s geo;	/* Device geometry */
@@ -302,15 +396,59 @@ struct smart_struct_s {
 	FAR uint16_t *sMap;			/* Virtual to physical sector map */
 #else
 	FAR uint8_t *sBitMap;		/* Virtual sector used bit-map */
+	FAR uint8_t *segslot;		/* Resident slot of each map segment */
 	FAR struct smart_cache_s *sCache;	/* Sector cache */
+	FAR uint16_t *cache_hash;	/* Sector cache hash buckets */
+	FAR uint16_t *mapdata;		/* Resident map segment contents */
+	FAR struct smart_mapseg_s *mapseg;	/* Resident map segment slots */
 	uint16_t cache_entries;	/* Number of valid entries in the cache */
+	uint16_t cache_free;		/* First free entry in the cache */
+	uint16_t cache_head;		/* Most recently used cache entry */
+	uint16_t cache_tail;		/* Least recently used cache entry */
 	uint16_t cache_lastlog;	/* Keep track of the last sector accessed */
 	uint16_t cache_lastphys;	/* Keep the physical sector number also */
-	uint16_t cache_nextbirth;	/* Sector cache aging value */
+	uint16_t map_nextuse;		/* Map segment aging value */
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	uint32_t map_lookups;		/* Number of logical sector lookups */
+	uint32_t map_hits;			/* Lookups resolved by the sector cache */
+	uint32_t map_seghits;		/* Lookups resolved by a resident segment */
+	uint32_t map_unused;		/* Lookups of sectors not in use */
+	uint32_t map_segloads;		/* Map segments rebuilt from the volume */
+	uint32_t map_reads;			/* Sector header reads for map segments */
+#endif
 #endif
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	FAR uint8_t *erasecounts;	/* Number of erases for each erase block */
 #endif
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	FAR uint16_t *blkindex;		/* Storage for the erase block indexes */
+	struct smart_blkindex_s freeindex;	/* Blocks by free sector count */
+	struct smart_blkindex_s releaseindex;	/* Blocks by released sector count */
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	struct smart_blkindex_s wearindex;	/* Blocks by wear level */
+#endif
+#endif
+	struct smart_relocate_s gc;	/* Erase block being garbage collected */
+#ifdef SMART_HAVE_EXCLSEM
+	sem_t exclsem;				/* Serializes accesses to the device */
+#endif
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+	struct work_s gcwork;		/* Background garbage collection work */
+	systime_t gclastio;			/* Time of the last write access */
+	sem_t gcdone;				/* Posted when a stopped worker has exited */
+	bool gcqueued;				/* The worker is queued or about to run */
+	bool gcstop;				/* The device is being released */
+#endif
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	uint32_t gc_blocks;			/* Erase blocks reclaimed by collection */
+	uint32_t gc_sectors;		/* Live sectors moved by collection */
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+	uint32_t gc_idleblocks;		/* Erase blocks reclaimed in the background */
+	uint32_t gc_idlesectors;	/* Live sectors moved in the background */
+#endif
+	uint32_t gc_maxstall;		/* Longest write stall in collection (msec) */
+	uint32_t gc_stalls[SMART_GC_STALL_BUCKETS];	/* Write stall histogram */
+#endif
 #ifdef CONFIG_MTD_SMART_ALLOC_DEBUG
 	size_t bytesalloc;
 	struct smart_alloc_s
@@ -321,6 +459,47 @@ struct smart_struct_s {
 #define SMART_WEARFLAGS_FORCE_REORG    0x01
 #define SMART_WEARFLAGS_WRITE_NEEDED   0x02
 
+/* Erase block index definitions.  Blocks that are too worn are left out of
+ * the free and release indexes so they are not allocated from or collected.
+ */
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+#define SMART_BLK_NONE                 0xFFFF
+#define SMART_BLK_UNLINKED             0xFFFE
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+#define SMART_BLK_ALLOCOK(l)           ((l) < SMART_WEAR_FULL_RELOCATE_THRESHOLD)
+#define SMART_BLK_COLLECTOK(l)         ((l) < SMART_WEAR_REORG_THRESHOLD)
+#define SMART_WEAR_NLEVELS             16
+#define SMART_BLK_NINDEXES             3
+#define SMART_BLK_NBUCKETS(d)          (2 * ((d)->sectorsPerBlk + 1) + SMART_WEAR_NLEVELS)
+#else
+#define SMART_BLK_NINDEXES             2
+#define SMART_BLK_NBUCKETS(d)          (2 * ((d)->sectorsPerBlk + 1))
+#endif
+
+#define SMART_BLK_ALLOCSIZE(d)         (SMART_BLK_NBUCKETS(d) * sizeof(uint16_t) + \
+										SMART_BLK_NINDEXES * (d)->neraseblocks * \
+										sizeof(struct smart_blklink_s))
+#endif
+
+/* Garbage collection.  SMART_GC_NONE in dev->gc.block means no erase block
+ * is partially collected.  SMART_GC_ALLSECTORS is the budget that collects
+ * a whole block at once.
+ */
+
+#define SMART_GC_NONE                  0xFFFF
+#define SMART_GC_ALLSECTORS            0x7FFF
+
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+#define SMART_GC_IDLE_TICKS            MSEC2TICK(CONFIG_MTD_SMART_GC_IDLE_MS)
+#endif
+
+#ifndef SMART_HAVE_EXCLSEM
+#define smart_semtake(d)
+#define smart_semgive(d)
+#endif
+
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
 struct smart_multiroot_device_s {
 	FAR struct smart_struct_s *dev;
@@ -415,11 +594,29 @@ static int smart_writesector(FAR struct smart_struct_s *dev, unsigned long arg);
 static int smart_readsector(FAR struct smart_struct_s *dev, unsigned long arg);
 
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+static uint8_t smart_get_wear_level(FAR struct smart_struct_s *dev, uint16_t block);
 static int smart_read_wearstatus(FAR struct smart_struct_s *dev);
 static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t block);
 #endif
 
 static int smart_relocate_sector(FAR struct smart_struct_s *dev, uint16_t oldsector, uint16_t newsector);
+static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block);
+
+#ifdef SMART_HAVE_EXCLSEM
+static void smart_semtake(FAR struct smart_struct_s *dev);
+static void smart_semgive(FAR struct smart_struct_s *dev);
+#endif
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+static void smart_gc_worker(FAR void *arg);
+#endif
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static void smart_cache_reset(FAR struct smart_struct_s *dev);
+#endif
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static void smart_blkindex_setcount(FAR struct smart_struct_s *dev, FAR uint8_t *pCount, uint16_t block, uint8_t count);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -530,6 +727,33 @@ int smart_clean(FAR struct inode *inode)
 	FAR struct smart_struct_s *dev = (FAR struct smart_struct_s *)inode->i_private;
 
 	if (dev != NULL) {
+#ifdef SMART_HAVE_EXCLSEM
+		smart_semtake(dev);
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+		/* Stop the background garbage collection.  If the work can no
+		 * longer be cancelled, the worker has already been dequeued and
+		 * is waiting for exclsem, so let it run and wait until it has
+		 * seen gcstop before the device goes away.
+		 */
+
+		dev->gcstop = true;
+		if (dev->gcqueued && work_cancel(LPWORK, &dev->gcwork) != OK) {
+			smart_semgive(dev);
+			while (sem_wait(&dev->gcdone) != 0) {
+				ASSERT(*get_errno_ptr() == EINTR);
+			}
+
+			smart_semtake(dev);
+		}
+
+		dev->gcqueued = false;
+#endif
+		smart_semgive(dev);
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+		sem_destroy(&dev->gcdone);
+#endif
+		sem_destroy(&dev->exclsem);
+#endif
 
 #ifdef CONFIG_SMARTFS_BAD_SECTOR
 
@@ -573,6 +797,12 @@ int smart_clean(FAR struct inode *inode)
 			dev->wearstatus = NULL;
 		}
 #endif
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+		if (dev->blkindex != NULL) {
+			smart_free(dev, dev->blkindex);
+			dev->blkindex = NULL;
+		}
+#endif
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 		if (dev->erasecounts != NULL) {
@@ -593,6 +823,39 @@ int smart_clean(FAR struct inode *inode)
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: smart_semtake
+ *
+ * Description: Take the device semaphore.  Only needed when the background
+ *              garbage collection worker or several file system tasks at
+ *              a time may access the device.
+ *
+ ****************************************************************************/
+
+#ifdef SMART_HAVE_EXCLSEM
+static void smart_semtake(FAR struct smart_struct_s *dev)
+{
+	/* Take the semaphore (perhaps waiting) */
+
+	while (sem_wait(&dev->exclsem) != 0) {
+		/* The only case that an error should occur here is if
+		 * the wait was awakened by a signal.
+		 */
+
+		ASSERT(*get_errno_ptr() == EINTR);
+	}
+}
+
+/****************************************************************************
+ * Name: smart_semgive
+ ****************************************************************************/
+
+static void smart_semgive(FAR struct smart_struct_s *dev)
+{
+	sem_post(&dev->exclsem);
+}
+#endif
+
 /****************************************************************************
  * Name: smart_open
  *
@@ -627,9 +890,15 @@ static int smart_close(FAR struct inode *inode)
  *
  ****************************************************************************/
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 static void smart_set_count(FAR struct smart_struct_s *dev, FAR uint8_t *pCount, uint16_t block, uint8_t count)
 {
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	/* Move the block to the bucket for its new count */
+
+	smart_blkindex_setcount(dev, pCount, block, count);
+#endif
+
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	if (dev->sectorsPerBlk > 16) {
 		pCount[block] = count;
 	} else {
@@ -653,8 +922,10 @@ static void smart_set_count(FAR struct smart_struct_s *dev, FAR uint8_t *pCount,
 			}
 		}
 	}
-}
+#else
+	pCount[block] = count;
 #endif
+}
 
 /****************************************************************************
  * Name: smart_get_count
@@ -664,9 +935,9 @@ static void smart_set_count(FAR struct smart_struct_s *dev, FAR uint8_t *pCount,
  *
  ****************************************************************************/
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 static uint8_t smart_get_count(FAR struct smart_struct_s *dev, FAR uint8_t *pCount, uint16_t block)
 {
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	uint8_t count;
 
 	if (dev->sectorsPerBlk > 16) {
@@ -692,8 +963,10 @@ static uint8_t smart_get_count(FAR struct smart_struct_s *dev, FAR uint8_t *pCou
 	}
 
 	return count;
-}
+#else
+	return pCount[block];
 #endif
+}
 
 /****************************************************************************
  * Name: smart_add_count
@@ -702,7 +975,6 @@ static uint8_t smart_get_count(FAR struct smart_struct_s *dev, FAR uint8_t *pCou
  *
  ****************************************************************************/
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 static void smart_add_count(struct smart_struct_s *dev, uint8_t *pCount, uint16_t block, int adder)
 {
 	int16_t value;
@@ -710,6 +982,289 @@ static void smart_add_count(struct smart_struct_s *dev, uint8_t *pCount, uint16_
 	value = smart_get_count(dev, pCount, block) + adder;
 	smart_set_count(dev, pCount, block, value);
 }
+
+/****************************************************************************
+ * Name: smart_blkindex_insert
+ *
+ * Description: Add an erase block at the tail of the given bucket.  Blocks
+ *              re-filed within or between buckets go to the back, so blocks
+ *              with equal counts are handed out in turn.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static void smart_blkindex_insert(FAR struct smart_blkindex_s *index, uint16_t block, uint16_t bucket)
+{
+	FAR struct smart_blklink_s *link = &index->link[block];
+	uint16_t first;
+
+	first = index->head[bucket];
+	if (first == SMART_BLK_NONE) {
+		link->prev = block;
+		link->next = block;
+		index->head[bucket] = block;
+	} else {
+		link->prev = index->link[first].prev;
+		link->next = first;
+		index->link[link->prev].next = block;
+		index->link[first].prev = block;
+	}
+
+	if (bucket > index->top) {
+		index->top = bucket;
+	}
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_remove
+ *
+ * Description: Remove an erase block from the given bucket.  Nothing is
+ *              done if the block is not in the index.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static void smart_blkindex_remove(FAR struct smart_blkindex_s *index, uint16_t block, uint16_t bucket)
+{
+	FAR struct smart_blklink_s *link = &index->link[block];
+
+	if (link->prev == SMART_BLK_UNLINKED) {
+		return;
+	}
+
+	if (link->next == block) {
+		index->head[bucket] = SMART_BLK_NONE;
+	} else {
+		index->link[link->prev].next = link->next;
+		index->link[link->next].prev = link->prev;
+		if (index->head[bucket] == block) {
+			index->head[bucket] = link->next;
+		}
+	}
+
+	link->prev = SMART_BLK_UNLINKED;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_top
+ *
+ * Description: Return the highest bucket holding any erase block, or -1 if
+ *              the index is empty.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static int smart_blkindex_top(FAR struct smart_blkindex_s *index)
+{
+	while (index->top > 0 && index->head[index->top] == SMART_BLK_NONE) {
+		index->top--;
+	}
+
+	if (index->head[index->top] == SMART_BLK_NONE) {
+		return -1;
+	}
+
+	return index->top;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_setcount
+ *
+ * Description: Called from smart_set_count before a free or release count
+ *              changes to move the erase block to the bucket of its new
+ *              count.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static void smart_blkindex_setcount(FAR struct smart_struct_s *dev, FAR uint8_t *pCount, uint16_t block, uint8_t count)
+{
+	FAR struct smart_blkindex_s *index;
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	uint8_t level;
+#endif
+
+	if (pCount == dev->freecount) {
+		index = &dev->freeindex;
+	} else if (pCount == dev->releasecount) {
+		index = &dev->releaseindex;
+	} else {
+		return;
+	}
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	/* Worn blocks are kept out of the free and release indexes */
+
+	level = smart_get_wear_level(dev, block);
+	if (dev->wearindex.link[block].prev == SMART_BLK_UNLINKED) {
+		smart_blkindex_insert(&dev->wearindex, block, level);
+	}
+
+	if (index == &dev->freeindex ? !SMART_BLK_ALLOCOK(level) : !SMART_BLK_COLLECTOK(level)) {
+		return;
+	}
+#endif
+
+	smart_blkindex_remove(index, block, smart_get_count(dev, pCount, block));
+	smart_blkindex_insert(index, block, count);
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_setwear
+ *
+ * Description: Called from smart_set_wear_level to move the erase block to
+ *              the bucket of its new wear level and to add or remove it from
+ *              the free and release indexes as it crosses the wear limits.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_MTD_SMART_BLOCK_INDEX) && defined(CONFIG_MTD_SMART_WEAR_LEVEL)
+static void smart_blkindex_setwear(FAR struct smart_struct_s *dev, uint16_t block, uint8_t oldlevel, uint8_t level)
+{
+	uint8_t count;
+
+	smart_blkindex_remove(&dev->wearindex, block, oldlevel);
+	smart_blkindex_insert(&dev->wearindex, block, level);
+
+	count = smart_get_count(dev, dev->freecount, block);
+	smart_blkindex_remove(&dev->freeindex, block, count);
+	if (SMART_BLK_ALLOCOK(level)) {
+		smart_blkindex_insert(&dev->freeindex, block, count);
+	}
+
+	count = smart_get_count(dev, dev->releasecount, block);
+	smart_blkindex_remove(&dev->releaseindex, block, count);
+	if (SMART_BLK_COLLECTOK(level)) {
+		smart_blkindex_insert(&dev->releaseindex, block, count);
+	}
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_reset
+ *
+ * Description: Carve the index storage into bucket heads and block links
+ *              and mark every erase block as not indexed.  Blocks are added
+ *              as their counts are set.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static void smart_blkindex_reset(FAR struct smart_struct_s *dev)
+{
+	FAR struct smart_blkindex_s *index[SMART_BLK_NINDEXES];
+	FAR struct smart_blklink_s *link;
+	FAR uint16_t *head;
+	uint16_t nbuckets;
+	uint16_t x;
+	int i;
+
+	index[0] = &dev->freeindex;
+	index[1] = &dev->releaseindex;
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	index[2] = &dev->wearindex;
+#endif
+
+	head = dev->blkindex;
+	link = (FAR struct smart_blklink_s *)&head[SMART_BLK_NBUCKETS(dev)];
+	for (i = 0; i < SMART_BLK_NINDEXES; i++) {
+		nbuckets = dev->sectorsPerBlk + 1;
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+		if (index[i] == &dev->wearindex) {
+			nbuckets = SMART_WEAR_NLEVELS;
+		}
+#endif
+
+		index[i]->head = head;
+		index[i]->link = link;
+		index[i]->top = 0;
+		for (x = 0; x < nbuckets; x++) {
+			head[x] = SMART_BLK_NONE;
+		}
+
+		for (x = 0; x < dev->neraseblocks; x++) {
+			link[x].prev = SMART_BLK_UNLINKED;
+		}
+
+		head += nbuckets;
+		link += dev->neraseblocks;
+	}
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_rebuild
+ *
+ * Description: Re-file every erase block.  Used after the wear level bits
+ *              have been replaced wholesale from the device.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_MTD_SMART_BLOCK_INDEX) && defined(CONFIG_MTD_SMART_WEAR_LEVEL)
+static void smart_blkindex_rebuild(FAR struct smart_struct_s *dev)
+{
+	uint16_t block;
+	uint8_t level;
+
+	smart_blkindex_reset(dev);
+	for (block = 0; block < dev->neraseblocks; block++) {
+		level = smart_get_wear_level(dev, block);
+		smart_blkindex_insert(&dev->wearindex, block, level);
+		if (SMART_BLK_ALLOCOK(level)) {
+			smart_blkindex_insert(&dev->freeindex, block, smart_get_count(dev, dev->freecount, block));
+		}
+
+		if (SMART_BLK_COLLECTOK(level)) {
+			smart_blkindex_insert(&dev->releaseindex, block, smart_get_count(dev, dev->releasecount, block));
+		}
+	}
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_blkindex_findfree
+ *
+ * Description: Return the erase block with the most free sectors that is
+ *              not worn, or 0xFFFF if there is none.  Like the block scan
+ *              this replaces, the block allocated from last is only chosen
+ *              again if no other block has free sectors.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+static uint16_t smart_blkindex_findfree(FAR struct smart_struct_s *dev)
+{
+	FAR struct smart_blkindex_s *index = &dev->freeindex;
+	uint16_t block;
+	uint16_t lastblock;
+	int bucket;
+
+	lastblock = 0xFFFF;
+	for (bucket = smart_blkindex_top(index); bucket > 0; bucket--) {
+		block = index->head[bucket];
+		if (block == SMART_BLK_NONE) {
+			continue;
+		}
+
+		if (block != dev->lastallocblock) {
+			return block;
+		}
+
+		if (index->link[block].next != block) {
+			return index->link[block].next;
+		}
+
+		if (lastblock == 0xFFFF) {
+			lastblock = block;
+		}
+	}
+
+	return lastblock;
+}
 #endif
 
 /****************************************************************************
@@ -734,11 +1289,7 @@ int smart_checkfree(FAR struct smart_struct_s *dev, int lineno)
 
 	freecount = 0;
 	for (x = 0; x < dev->neraseblocks; x++) {
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		freecount += smart_get_count(dev, dev->freecount, x);
-#else
-		freecount += dev->freecount[x];
-#endif
 	}
 
 	/* Test if the calculated freesectors equals the reported value */
@@ -753,13 +1304,8 @@ int smart_checkfree(FAR struct smart_struct_s *dev, int lineno)
 
 		if (prev_freecount) {
 			for (x = 0; x < dev->neraseblocks; x++) {
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 				blockfree = smart_get_count(dev, dev->freecount, x);
 				blockrelease = smart_get_count(dev, dev->releasecount, x);
-#else
-				blockfree = dev->freecount[x];
-				blockrelease = dev->releasecount[x];
-#endif
 				if (prev_freecount[x] != blockfree || prev_releasecount[x] != blockrelease) {
 					/* This block's values are different from the last time ... report it */
 
@@ -788,13 +1334,8 @@ int smart_checkfree(FAR struct smart_struct_s *dev, int lineno)
 
 	if (prev_freecount != NULL) {
 		for (x = 0; x < dev->neraseblocks; x++) {
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 			prev_freecount[x] = smart_get_count(dev, dev->freecount, x);
 			prev_releasecount[x] = smart_get_count(dev, dev->releasecount, x);
-#else
-			prev_freecount[x] = dev->freecount[x];
-			prev_releasecount[x] = dev->releasecount[x];
-#endif
 		}
 	}
 
@@ -850,6 +1391,7 @@ static ssize_t smart_reload(struct smart_struct_s *dev, FAR uint8_t *buffer, off
 static ssize_t smart_read(FAR struct inode *inode, unsigned char *buffer, size_t start_sector, unsigned int nsectors)
 {
 	struct smart_struct_s *dev;
+	ssize_t ret;
 
 	fvdbg("SMART: sector: %d nsectors: %d\n", start_sector, nsectors);
 
@@ -859,7 +1401,15 @@ static ssize_t smart_read(FAR struct inode *inode, unsigned char *buffer, size_t
 #else
 	dev = (struct smart_struct_s *)inode->i_private;
 #endif
-	return smart_reload(dev, buffer, start_sector, nsectors);
+
+#ifdef SMART_HAVE_EXCLSEM
+	smart_semtake(dev);
+#endif
+	ret = smart_reload(dev, buffer, start_sector, nsectors);
+#ifdef SMART_HAVE_EXCLSEM
+	smart_semgive(dev);
+#endif
+	return ret;
 }
 
 /****************************************************************************
@@ -882,7 +1432,7 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 	off_t eraseblock;
 	size_t remaining;
 	size_t nxfrd;
-	int ret;
+	ssize_t ret;
 	off_t mtdstartblock, mtdblockcount;
 
 	fvdbg("sector: %d nsectors: %d\n", start_sector, nsectors);
@@ -894,7 +1444,9 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 	dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
-	/* I think maybe we need to lock on a mutex here */
+#ifdef SMART_HAVE_EXCLSEM
+	smart_semtake(dev);
+#endif
 
 	/* Get the aligned block.  Here is is assumed: (1) The number of R/W blocks
 	 * per erase block is a power of 2, and (2) the erase begins with that same
@@ -917,6 +1469,7 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 	remaining = mtdblockcount;
 	nextblock = mtdstartblock;
 	offset = 0;
+	ret = OK;
 
 	/* Loop for all blocks to be written */
 
@@ -930,10 +1483,7 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 			ret = MTD_ERASE(dev->mtd, eraseblock, 1);
 			if (ret < 0) {
 				fdbg("Erase block=%d failed: %d\n", eraseblock, ret);
-
-				/* Unlock the mutex if we add one */
-
-				return ret;
+				break;
 			}
 		}
 
@@ -956,10 +1506,8 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 			/* The block is not empty!!  What to do? */
 
 			fdbg("Write block %d failed: %d.\n", nextblock, nxfrd);
-
-			/* Unlock the mutex if we add one */
-
-			return -EIO;
+			ret = -EIO;
+			break;
 		}
 
 		/* Then update for amount written */
@@ -970,7 +1518,14 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 		alignedblock += mtdBlksPerErase;
 	}
 
-	return nsectors;
+	if (remaining == 0) {
+		ret = nsectors;
+	}
+
+#ifdef SMART_HAVE_EXCLSEM
+	smart_semgive(dev);
+#endif
+	return ret;
 }
 #endif							/* CONFIG_FS_WRITABLE */
 
@@ -1083,7 +1638,16 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
 	dev->unusedsectors = 0;
 	dev->blockerases = 0;
+	dev->gc_blocks = 0;
+	dev->gc_sectors = 0;
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+	dev->gc_idleblocks = 0;
+	dev->gc_idlesectors = 0;
 #endif
+	dev->gc_maxstall = 0;
+	memset(dev->gc_stalls, 0, sizeof(dev->gc_stalls));
+#endif
+	dev->gc.block = SMART_GC_NONE;
 
 	/* Release any existing rwbuffer and sMap */
 
@@ -1097,10 +1661,6 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 		smart_free(dev, dev->sBitMap);
 		dev->sBitMap = NULL;
 	}
-
-	dev->cache_entries = 0;
-	dev->cache_lastlog = 0xFFFF;
-	dev->cache_nextbirth = 0;
 #endif
 
 	if (dev->rwbuffer != NULL) {
@@ -1117,6 +1677,12 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 		dev->wearstatus = NULL;
 	}
 #endif
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	if (dev->blkindex != NULL) {
+		smart_free(dev, dev->blkindex);
+		dev->blkindex = NULL;
+	}
+#endif
 
 #ifdef CONFIG_SMARTFS_BAD_SECTOR
 
@@ -1180,12 +1746,16 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 	dev->releasecount = (FAR uint8_t *)dev->sMap + (totalsectors * sizeof(uint16_t));
 	dev->freecount = dev->releasecount + dev->neraseblocks;
 #else
-	dev->sBitMap = (FAR uint8_t *)smart_malloc(dev, (totalsectors + 7) >> 3, "Sector Bitmap");
+	/* The map segment residency table follows the bitmap */
+
+	dev->sBitMap = (FAR uint8_t *)smart_malloc(dev, ((totalsectors + 7) >> 3) + SMART_MAP_NSEGMENTS(totalsectors), "Sector Bitmap");
 	if (dev->sBitMap == NULL) {
 		fdbg("Error allocating SMART sector cache\n");
 		goto errexit;
 	}
 
+	dev->segslot = dev->sBitMap + ((totalsectors + 7) >> 3);
+
 	/* Calculate the alloc size of the freesector and release sector arrays */
 
 #ifdef CONFIG_MTD_SMART_PACK_COUNTS
@@ -1201,10 +1771,12 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 	allocsize = dev->neraseblocks << 1;
 #endif
 
-	/* Allocate the sector cache */
+	/* Allocate the sector cache along with its hash buckets and the map
+	 * segment slots.
+	 */
 
 	if (dev->sCache == NULL) {
-		dev->sCache = (FAR struct smart_cache_s *)smart_malloc(dev, CONFIG_MTD_SMART_SECTOR_CACHE_SIZE * sizeof(struct smart_cache_s) + allocsize, "Sector Cache");
+		dev->sCache = (FAR struct smart_cache_s *)smart_malloc(dev, SMART_CACHE_ALLOCSIZE + allocsize, "Sector Cache");
 	}
 
 	if (!dev->sCache) {
@@ -1212,7 +1784,10 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 		goto errexit;
 	}
 
-	dev->releasecount = (FAR uint8_t *)dev->sCache + (CONFIG_MTD_SMART_SECTOR_CACHE_SIZE * sizeof(struct smart_cache_s));
+	dev->cache_hash = (FAR uint16_t *)&dev->sCache[CONFIG_MTD_SMART_SECTOR_CACHE_SIZE];
+	dev->mapdata = &dev->cache_hash[CONFIG_MTD_SMART_SECTOR_CACHE_SIZE];
+	dev->mapseg = (FAR struct smart_mapseg_s *)&dev->mapdata[CONFIG_MTD_SMART_MAP_SEGMENTS * CONFIG_MTD_SMART_MAP_SEGMENT_SIZE];
+	dev->releasecount = (FAR uint8_t *)&dev->mapseg[CONFIG_MTD_SMART_MAP_SEGMENTS];
 
 #ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	if (dev->sectorsPerBlk > 16) {
@@ -1227,6 +1802,7 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 	dev->freecount = dev->releasecount + dev->neraseblocks;
 #endif
 
+	smart_cache_reset(dev);
 #endif							/* CONFIG_MTD_SMART_MINIMIZE_RAM */
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
@@ -1272,6 +1848,20 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 		goto errexit;
 	}
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	/* Allocate the erase block indexes.  Blocks are added as their free
+	 * and release counts are set.
+	 */
+
+	dev->blkindex = (FAR uint16_t *)smart_malloc(dev, SMART_BLK_ALLOCSIZE(dev), "Block index");
+	if (!dev->blkindex) {
+		fdbg("Error allocating SMART block index\n");
+		goto errexit;
+	}
+
+	smart_blkindex_reset(dev);
+#endif
+
 	return OK;
 
 	/* On error for any allocation, we jump here and free anything that had
@@ -1309,6 +1899,12 @@ errexit:
 	}
 #endif
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	if (dev->blkindex) {
+		smart_free(dev, dev->blkindex);
+	}
+#endif
+
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	if (dev->erasecounts) {
 		smart_free(dev, dev->erasecounts);
@@ -1366,19 +1962,326 @@ static ssize_t smart_bytewrite(FAR struct smart_struct_s *dev, size_t offset, in
 
 		memcpy(&dev->bytebuffer[offset - startblock * dev->geo.blocksize], buffer, nbytes);
 
-		/* Write the data back to the device */
+		/* Write the data back to the device */
+
+		ret = MTD_BWRITE(dev->mtd, startblock, nblocks, (FAR uint8_t *)dev->bytebuffer);
+		if (ret < 0) {
+			fdbg("Error %d writing to device\n", -ret);
+			goto errout;
+		}
+		ret = nbytes;
+	}
+
+errout:
+	return ret;
+}
+
+/****************************************************************************
+ * Name: smart_cache_reset
+ *
+ * Description: Empties the sector map cache and discards all resident map
+ *              segments.  Called whenever the logical sector bitmap is
+ *              rebuilt so that no stale mappings survive a scan or format.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static void smart_cache_reset(FAR struct smart_struct_s *dev)
+{
+	uint16_t x;
+
+	/* Chain all cache entries onto the free list */
+
+	for (x = 0; x < CONFIG_MTD_SMART_SECTOR_CACHE_SIZE; x++) {
+		dev->sCache[x].logical = 0xFFFF;
+		dev->sCache[x].hnext = x + 1;
+		dev->cache_hash[x] = SMART_CACHE_NONE;
+	}
+
+	dev->sCache[CONFIG_MTD_SMART_SECTOR_CACHE_SIZE - 1].hnext = SMART_CACHE_NONE;
+	dev->cache_free = 0;
+	dev->cache_head = SMART_CACHE_NONE;
+	dev->cache_tail = SMART_CACHE_NONE;
+	dev->cache_entries = 0;
+	dev->cache_lastlog = 0xFFFF;
+
+	/* Mark all map segments as not resident */
+
+	for (x = 0; x < CONFIG_MTD_SMART_MAP_SEGMENTS; x++) {
+		dev->mapseg[x].segment = 0xFFFF;
+		dev->mapseg[x].lastuse = 0;
+	}
+
+	memset(dev->segslot, SMART_MAP_NONE, SMART_MAP_NSEGMENTS(dev->totalsectors));
+	dev->map_nextuse = 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cache_unlink / smart_cache_linkfirst
+ *
+ * Description: Remove a sector cache entry from the LRU list, or insert it
+ *              at the most recently used end.  Entries for system sectors
+ *              are never placed on the LRU list so they are never replaced.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static void smart_cache_unlink(FAR struct smart_struct_s *dev, uint16_t index)
+{
+	FAR struct smart_cache_s *entry = &dev->sCache[index];
+
+	if (entry->prev != SMART_CACHE_NONE) {
+		dev->sCache[entry->prev].next = entry->next;
+	} else {
+		dev->cache_head = entry->next;
+	}
+
+	if (entry->next != SMART_CACHE_NONE) {
+		dev->sCache[entry->next].prev = entry->prev;
+	} else {
+		dev->cache_tail = entry->prev;
+	}
+}
+
+static void smart_cache_linkfirst(FAR struct smart_struct_s *dev, uint16_t index)
+{
+	FAR struct smart_cache_s *entry = &dev->sCache[index];
+
+	entry->prev = SMART_CACHE_NONE;
+	entry->next = dev->cache_head;
+	if (dev->cache_head != SMART_CACHE_NONE) {
+		dev->sCache[dev->cache_head].prev = index;
+	} else {
+		dev->cache_tail = index;
+	}
+
+	dev->cache_head = index;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cache_find
+ *
+ * Description: Search the sector cache hash chain for the requested logical
+ *              sector and return its cache index, or SMART_CACHE_NONE.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static uint16_t smart_cache_find(FAR struct smart_struct_s *dev, uint16_t logical)
+{
+	uint16_t index;
+
+	index = dev->cache_hash[SMART_CACHE_HASH(logical)];
+	while (index != SMART_CACHE_NONE && dev->sCache[index].logical != logical) {
+		index = dev->sCache[index].hnext;
+	}
+
+	return index;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cache_remove
+ *
+ * Description: Remove an entry from the sector cache and return it to the
+ *              free list.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static void smart_cache_remove(FAR struct smart_struct_s *dev, uint16_t index)
+{
+	FAR struct smart_cache_s *entry = &dev->sCache[index];
+	FAR uint16_t *link;
+
+	/* Unhook the entry from its hash chain */
+
+	link = &dev->cache_hash[SMART_CACHE_HASH(entry->logical)];
+	while (*link != index) {
+		link = &dev->sCache[*link].hnext;
+	}
+
+	*link = entry->hnext;
+
+	if (entry->logical >= SMART_FIRST_ALLOC_SECTOR) {
+		smart_cache_unlink(dev, index);
+	}
+
+	entry->logical = 0xFFFF;
+	entry->hnext = dev->cache_free;
+	dev->cache_free = index;
+	dev->cache_entries--;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_map_entry
+ *
+ * Description: Returns a pointer to the map segment entry for the logical
+ *              sector if its segment is resident, otherwise NULL.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static FAR uint16_t *smart_map_entry(FAR struct smart_struct_s *dev, uint16_t logical)
+{
+	uint8_t slot;
+
+	if (logical >= dev->totalsectors) {
+		return NULL;
+	}
+
+	slot = dev->segslot[SMART_MAP_SEGMENT(logical)];
+	if (slot == SMART_MAP_NONE) {
+		return NULL;
+	}
+
+	/* Age the segment so the least recently used one is replaced first */
+
+	if (dev->map_nextuse == 0xFFFF) {
+		uint8_t x;
+
+		for (x = 0; x < CONFIG_MTD_SMART_MAP_SEGMENTS; x++) {
+			dev->mapseg[x].lastuse >>= 1;
+		}
+
+		dev->map_nextuse = 0x8000;
+	}
+
+	dev->mapseg[slot].lastuse = dev->map_nextuse++;
+	return &dev->mapdata[slot * CONFIG_MTD_SMART_MAP_SEGMENT_SIZE + SMART_MAP_OFFSET(logical)];
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_map_load
+ *
+ * Description: Builds the map for one segment of consecutive logical
+ *              sectors by reading the sector headers from the volume.  The
+ *              least recently used segment slot is replaced.  The scan stops
+ *              as soon as every in-use logical sector of the segment has
+ *              been located, so a single pass over the headers now resolves
+ *              CONFIG_MTD_SMART_MAP_SEGMENT_SIZE sectors rather than one.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static int smart_map_load(FAR struct smart_struct_s *dev, uint16_t segment)
+{
+	int ret;
+	uint8_t slot;
+	uint16_t x, first, count, expected, found;
+	uint16_t block, sector, logicalsector;
+	FAR uint16_t *map;
+	struct smart_sect_header_s header;
+	size_t readaddress;
+
+	/* Reuse the slot if the segment is resident, else pick a free slot or
+	 * the least recently used one.
+	 */
+
+	slot = dev->segslot[segment];
+	if (slot == SMART_MAP_NONE) {
+		slot = 0;
+		for (x = 0; x < CONFIG_MTD_SMART_MAP_SEGMENTS; x++) {
+			if (dev->mapseg[x].segment == 0xFFFF) {
+				slot = x;
+				break;
+			}
+
+			if (dev->mapseg[x].lastuse < dev->mapseg[slot].lastuse) {
+				slot = x;
+			}
+		}
+
+		if (dev->mapseg[slot].segment != 0xFFFF) {
+			dev->segslot[dev->mapseg[slot].segment] = SMART_MAP_NONE;
+			dev->mapseg[slot].segment = 0xFFFF;
+		}
+	}
+
+	first = segment * CONFIG_MTD_SMART_MAP_SEGMENT_SIZE;
+	count = CONFIG_MTD_SMART_MAP_SEGMENT_SIZE;
+	if (first + count > dev->totalsectors) {
+		count = dev->totalsectors - first;
+	}
+
+	/* Count the in-use logical sectors so we know when to stop searching */
+
+	map = &dev->mapdata[slot * CONFIG_MTD_SMART_MAP_SEGMENT_SIZE];
+	expected = 0;
+	for (x = 0; x < count; x++) {
+		map[x] = 0xFFFF;
+		logicalsector = first + x;
+		if (dev->sBitMap[logicalsector >> 3] & (1 << (logicalsector & 0x07))) {
+			expected++;
+		}
+	}
+
+	/* Mappings already in the sector cache are current and include
+	 * allocated sectors that have not been committed yet.
+	 */
+
+	found = 0;
+	for (x = 0; x < CONFIG_MTD_SMART_SECTOR_CACHE_SIZE; x++) {
+		logicalsector = dev->sCache[x].logical - first;
+		if (logicalsector < count && map[logicalsector] == 0xFFFF) {
+			map[logicalsector] = dev->sCache[x].physical;
+			found++;
+		}
+	}
+
+	/* Now scan the MTD device.  Instead of scanning start to end, we
+	 * span the erase blocks and read one sector from each at a time.
+	 * this helps speed up the search on volumes that aren't full
+	 * because of sector allocation scheme will use the lower sector
+	 * numbers in each erase block first.
+	 */
+
+	for (sector = 0; sector < dev->sectorsPerBlk && found < expected; sector++) {
+		for (block = 0; block < dev->geo.neraseblocks && found < expected; block++) {
+			/* Read the header for this sector */
+
+			readaddress = block * dev->erasesize + sector * dev->sectorsize;
+			ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s), (FAR uint8_t *)&header);
+			smart_mapstat(dev, map_reads);
+			if (ret != sizeof(struct smart_sect_header_s)) {
+				return ret < 0 ? ret : -EIO;
+			}
+
+			/* Get the logical sector number for this physical sector */
+
+			logicalsector = UINT8TOUINT16(header.logicalsector);
+#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
+			if (logicalsector == 0) {
+				continue;
+			}
+#endif
+
+			/* Skip uncommitted, released and foreign version sectors */
+
+			if (!(SECTOR_IS_COMMITTED(header)) || SECTOR_IS_RELEASED(header) || (header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION) {
+				continue;
+			}
+
+			/* Record the mapping if it belongs to this segment */
 
-		ret = MTD_BWRITE(dev->mtd, startblock, nblocks, (FAR uint8_t *)dev->bytebuffer);
-		if (ret < 0) {
-			fdbg("Error %d writing to device\n", -ret);
-			goto errout;
+			logicalsector -= first;
+			if (logicalsector < count && map[logicalsector] == 0xFFFF) {
+				map[logicalsector] = block * dev->sectorsPerBlk + sector;
+				found++;
+			}
 		}
-		ret = nbytes;
 	}
 
-errout:
-	return ret;
+	dev->mapseg[slot].segment = segment;
+	dev->segslot[segment] = slot;
+	smart_mapstat(dev, map_segloads);
+	return slot;
 }
+#endif
 
 /****************************************************************************
  * Name: smart_add_sector_to_cache
@@ -1387,64 +2290,63 @@ errout:
  *              map cache.  The cache is used to minimize RAM by eliminating
  *              a one-to-one mapping of all logical sectors and only keeping
  *              a fixed number of mappings per the
- *              CONFIG_MTD_SMART_SECTOR_CACHE_SIZE parameter.  Sectors are
- *              automatically managed and removed based on the time since
- *              they were accessed last.
+ *              CONFIG_MTD_SMART_SECTOR_CACHE_SIZE parameter.  When the cache
+ *              is full the least recently used entry is replaced.  Entries
+ *              for system sectors are never replaced.  The mapping is also
+ *              stored in the map segment if that segment is resident.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
 static int smart_add_sector_to_cache(FAR struct smart_struct_s *dev, uint16_t logical, uint16_t physical, int line)
 {
-	uint16_t index, x;
-	uint16_t oldest;
+	uint16_t index;
+	FAR uint16_t *map;
 
-	/* If we aren't full yet, just add the sector to the end of the list */
+	index = smart_cache_find(dev, logical);
+	if (index == SMART_CACHE_NONE) {
+		/* If the cache is full, replace the least recently used entry */
 
-	index = 1;
-	if (dev->cache_entries < CONFIG_MTD_SMART_SECTOR_CACHE_SIZE) {
-		index = dev->cache_entries++;
-	} else {
-		/* Cache is full.  We must find the least accessed entry and replace it */
-
-		oldest = 0xFFFF;
-		for (x = 0; x < CONFIG_MTD_SMART_SECTOR_CACHE_SIZE; x++) {
-			/* Never replace cache entries for system sectors */
+		if (dev->cache_free == SMART_CACHE_NONE && dev->cache_tail != SMART_CACHE_NONE) {
+			smart_cache_remove(dev, dev->cache_tail);
+		}
 
-			if (dev->sCache[x].logical < SMART_FIRST_ALLOC_SECTOR) {
-				continue;
-			}
+		/* Take an entry from the free list and hash it */
 
-			/* If the hit count is zero, then choose this entry */
+		index = dev->cache_free;
+		if (index != SMART_CACHE_NONE) {
+			dev->cache_free = dev->sCache[index].hnext;
+			dev->cache_entries++;
 
-			if (dev->sCache[x].birth < oldest) {
-				oldest = dev->sCache[x].birth;
-				index = x;
+			dev->sCache[index].logical = logical;
+			dev->sCache[index].hnext = dev->cache_hash[SMART_CACHE_HASH(logical)];
+			dev->cache_hash[SMART_CACHE_HASH(logical)] = index;
+			if (logical >= SMART_FIRST_ALLOC_SECTOR) {
+				smart_cache_linkfirst(dev, index);
 			}
 		}
+	} else if (logical >= SMART_FIRST_ALLOC_SECTOR && index != dev->cache_head) {
+		smart_cache_unlink(dev, index);
+		smart_cache_linkfirst(dev, index);
+	}
+
+	/* Now set the mapping */
+
+	if (index != SMART_CACHE_NONE) {
+		dev->sCache[index].physical = physical;
 	}
 
-	/* Now add the sector at index */
+	map = smart_map_entry(dev, logical);
+	if (map != NULL) {
+		*map = physical;
+	}
 
-	dev->sCache[index].logical = logical;
-	dev->sCache[index].physical = physical;
-	dev->sCache[index].birth = dev->cache_nextbirth++;
 	dev->cache_lastlog = logical;
 	dev->cache_lastphys = physical;
 	if (dev->debuglevel > 1) {
 		dbg("Add Cache sector:  Log=%d, Phys=%d at index %d from line %d\n", logical, physical, index, line);
 	}
 
-	/* Test if the birthdays need to be adjusted */
-
-	if (oldest >= CONFIG_MTD_SMART_SECTOR_CACHE_SIZE + 1024) {
-		for (x = 0; x < dev->cache_entries; x++) {
-			dev->sCache[x].birth -= 1024;
-		}
-
-		dev->cache_nextbirth -= 1024;
-	}
-
 	return index;
 }
 #endif
@@ -1453,10 +2355,11 @@ static int smart_add_sector_to_cache(FAR struct smart_struct_s *dev, uint16_t lo
  * Name: smart_cache_lookup
  *
  * Description: Perform a cache lookup for the requested logical sector.
- *              If the sector is in the cache, then update the hitcount and
- *              return the physical mapping.  If a cache miss occurs, then
- *              the routine will scan the volume to find the logical sector
- *              and add / replace a cache entry with the newly located sector.
+ *              The sector cache is searched first, then the sector bitmap
+ *              is used to answer lookups of unused sectors, and then the
+ *              resident map segments.  If all of these miss, the map
+ *              segment holding the sector is rebuilt from the volume and
+ *              the sector is added to the cache.
  *
  ****************************************************************************/
 
@@ -1464,92 +2367,63 @@ static int smart_add_sector_to_cache(FAR struct smart_struct_s *dev, uint16_t lo
 static uint16_t smart_cache_lookup(FAR struct smart_struct_s *dev, uint16_t logical)
 {
 	int ret;
-	uint16_t block, sector;
-	uint16_t x, physical, logicalsector;
-	struct smart_sect_header_s header;
-	size_t readaddress;
+	uint16_t index, physical;
+	FAR uint16_t *map;
 
-	physical = 0xFFFF;
+	smart_mapstat(dev, map_lookups);
 
 	/* Test if searching for the last sector used */
 
 	if (logical == dev->cache_lastlog) {
+		smart_mapstat(dev, map_hits);
 		return dev->cache_lastphys;
 	}
 
-	/* First search for the entry in the cache */
-
-	for (x = 0; x < dev->cache_entries; x++) {
-		if (dev->sCache[x].logical == logical) {
-			/* Entry found in the cache.  Grab the physical mapping. */
-
-			physical = dev->sCache[x].physical;
-			break;
-		}
+	if (logical >= dev->totalsectors) {
+		return 0xFFFF;
 	}
 
-	/* If the entry wasn't found in the cache, then we must search the volume
-	 * for it and add it to the cache.
-	 */
+	/* First search for the entry in the cache */
 
-	if (physical == 0xFFFF) {
-		/* Now scan the MTD device.  Instead of scanning start to end, we
-		 * span the erase blocks and read one sector from each at a time.
-		 * this helps speed up the search on volumes that aren't full
-		 * because of sector allocation scheme will use the lower sector
-		 * numbers in each erase block first.
+	index = smart_cache_find(dev, logical);
+	if (index != SMART_CACHE_NONE) {
+		/* Entry found in the cache.  Grab the physical mapping and make
+		 * it the most recently used entry.
 		 */
 
-		for (sector = 0; sector < dev->sectorsPerBlk && physical == 0xFFFF; sector++) {
-			/* Now scan across each erase block */
-
-			for (block = 0; block < dev->geo.neraseblocks; block++) {
-				/* Calculate the read address for this sector */
-
-				readaddress = block * dev->erasesize + sector * CONFIG_MTD_SMART_SECTOR_SIZE;
-
-				/* Read the header for this sector */
-
-				ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s), (FAR uint8_t *)&header);
-				if (ret != sizeof(struct smart_sect_header_s)) {
-					goto err_out;
-				}
-
-				/* Get the logical sector number for this physical sector */
-
-				logicalsector = *((FAR uint16_t *)header.logicalsector);
-#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
-				if (logicalsector == 0) {
-					continue;
-				}
-#endif
-
-				/* Test if this sector has been committed */
-
-				if (!(SECTOR_IS_COMMITTED(header))) {
-					continue;
-				}
-
-				/* Test if this sector has been release and skip it if it has */
+		physical = dev->sCache[index].physical;
+		if (logical >= SMART_FIRST_ALLOC_SECTOR && index != dev->cache_head) {
+			smart_cache_unlink(dev, index);
+			smart_cache_linkfirst(dev, index);
+		}
 
-				if (SECOR_IS_RELEASED(header)) {
-					continue;
-				}
+		smart_mapstat(dev, map_hits);
+	} else if (!(dev->sBitMap[logical >> 3] & (1 << (logical & 0x07)))) {
+		/* The logical sector isn't in use, so there is nothing to find */
 
-				if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION) {
-					continue;
-				}
+		physical = 0xFFFF;
+		smart_mapstat(dev, map_unused);
+	} else {
+		/* Use the resident map segment.  A missing mapping for an in-use
+		 * sector may have been committed since the segment was built, so
+		 * rebuild the segment in that case just as for a segment miss.
+		 */
 
-				/* Test if this is the sector we are looking for */
+		map = smart_map_entry(dev, logical);
+		if (map != NULL && *map != 0xFFFF) {
+			smart_mapstat(dev, map_seghits);
+		} else {
+			ret = smart_map_load(dev, SMART_MAP_SEGMENT(logical));
+			if (ret < 0) {
+				return 0xFFFF;
+			}
 
-				if (logicalsector == logical) {
-					/* This is the sector we are looking for!  Add it to the cache */
+			map = smart_map_entry(dev, logical);
+		}
 
-					physical = block * dev->sectorsPerBlk + sector;
-					smart_add_sector_to_cache(dev, logical, physical, __LINE__);
-					break;
-				}
-			}
+		physical = *map;
+		if (physical != 0xFFFF) {
+			smart_add_sector_to_cache(dev, logical, physical, __LINE__);
 		}
 	}
 
@@ -1558,7 +2432,6 @@ static uint16_t smart_cache_lookup(FAR struct smart_struct_s *dev, uint16_t logi
 	dev->cache_lastlog = logical;
 	dev->cache_lastphys = physical;
 
-err_out:
 	return physical;
 }
 #endif
@@ -1568,41 +2441,39 @@ err_out:
  *
  * Description: Updates a cache entry (if present) replacing the logical
  *              sector's physical sector mapping with the new one provided.
- *              This does not affect the hit count.
+ *              This does not affect the entry's position in the LRU list.
+ *              A resident map segment holding the sector is updated too.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
 static void smart_update_cache(FAR struct smart_struct_s *dev, uint16_t logical, uint16_t physical)
 {
-	uint16_t x;
-
-	/* Scan through all cache entries and find the logical sector entry */
-
-	for (x = 0; x < dev->cache_entries; x++) {
-		if (dev->sCache[x].logical == logical) {
-			/* Entry found.  Update it's physical mapping */
-
-			dev->sCache[x].physical = physical;
-
-			/* If we are freeing a sector, then remove the logical entry from
-			   the cache.
-			 */
+	uint16_t index;
+	FAR uint16_t *map;
 
-			if (physical == 0xFFFF) {
-				dev->sCache[x].logical = dev->sCache[dev->cache_entries - 1].logical;
-				dev->sCache[x].physical = dev->sCache[dev->cache_entries - 1].physical;
-				dev->cache_entries--;
-			}
+	index = smart_cache_find(dev, logical);
+	if (index != SMART_CACHE_NONE) {
+		/* If we are freeing a sector, then remove the logical entry from
+		   the cache, else update it's physical mapping.
+		 */
 
-			if (dev->debuglevel > 1) {
-				dbg("Update Cache:  Log=%d, Phys=%d at index %d\n", logical, physical, x);
-			}
+		if (physical == 0xFFFF) {
+			smart_cache_remove(dev, index);
+		} else {
+			dev->sCache[index].physical = physical;
+		}
 
-			break;
+		if (dev->debuglevel > 1) {
+			dbg("Update Cache:  Log=%d, Phys=%d at index %d\n", logical, physical, index);
 		}
 	}
 
+	map = smart_map_entry(dev, logical);
+	if (map != NULL) {
+		*map = physical;
+	}
+
 	if (dev->cache_lastlog == logical) {
 		dev->cache_lastphys = physical;
 	}
@@ -1654,9 +2525,23 @@ static uint8_t smart_get_wear_level(FAR struct smart_struct_s *dev, uint16_t blo
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 static void smart_find_wear_minmax(FAR struct smart_struct_s *dev)
 {
+#if !defined(CONFIG_MTD_SMART_BLOCK_INDEX) || defined(CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG)
 	uint16_t x;
+#endif
 	unsigned char level;
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	/* The min / max levels are the lowest and highest non-empty buckets */
+
+	for (level = 0; level < SMART_WEAR_NLEVELS - 1; level++) {
+		if (dev->wearindex.head[level] != SMART_BLK_NONE) {
+			break;
+		}
+	}
+
+	dev->minwearlevel = level;
+	dev->maxwearlevel = smart_blkindex_top(&dev->wearindex) < 0 ? 0 : dev->wearindex.top;
+#else
 	dev->minwearlevel = 15;
 	dev->maxwearlevel = 0;
 
@@ -1676,6 +2561,7 @@ static void smart_find_wear_minmax(FAR struct smart_struct_s *dev)
 			dev->maxwearlevel = level;
 		}
 	}
+#endif
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	/* Also adjust the erase counts */
@@ -1733,6 +2619,10 @@ static int smart_set_wear_level(FAR struct smart_struct_s *dev, uint16_t block,
 		dev->uneven_wearcount++;
 	}
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	smart_blkindex_setwear(dev, block, oldlevel, level);
+#endif
+
 	bits = gWearLevelToBitMap4[level];
 
 	if (block & 0x01) {
@@ -1861,6 +2751,7 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 	dev->formatstatus = SMART_FMT_STAT_NOFMT;
 	dev->freesectors = dev->availSectPerBlk * dev->geo.neraseblocks;
 	dev->releasesectors = 0;
+	dev->gc.block = SMART_GC_NONE;
 
 	/* Initialize the freecount and releasecount arrays */
 
@@ -1871,13 +2762,8 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 			prerelease = 0;
 		}
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_set_count(dev, dev->freecount, sector, dev->availSectPerBlk - prerelease);
 		smart_set_count(dev, dev->releasecount, sector, prerelease);
-#else
-		dev->freecount[sector] = dev->availSectPerBlk - prerelease;
-		dev->releasecount[sector] = prerelease;
-#endif
 	}
 
 	/* Initialize the sector map */
@@ -1887,9 +2773,10 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 		dev->sMap[sector] = -1;
 	}
 #else
-	/* Clear all logical sector used bits */
+	/* Clear all logical sector used bits and drop any cached mappings */
 
 	memset(dev->sBitMap, 0, (dev->totalsectors + 7) >> 3);
+	smart_cache_reset(dev);
 #endif
 
 	/* Now scan the MTD device */
@@ -2003,11 +2890,7 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 		 * erase block's freecount.
 		 */
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_add_count(dev, dev->freecount, sector / dev->sectorsPerBlk, -1);
-#else
-		dev->freecount[sector / dev->sectorsPerBlk]--;
-#endif
 		dev->freesectors--;
 
 		/* Test if this sector has been release and if it has,
@@ -2020,11 +2903,7 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 			 */
 
 			dev->releasesectors++;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 			smart_add_count(dev, dev->releasecount, sector / dev->sectorsPerBlk, 1);
-#else
-			dev->releasecount[sector / dev->sectorsPerBlk]++;
-#endif
 			continue;
 		}
 
@@ -2300,13 +3179,11 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 
 #ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
 			dev->sMap[0] = newsector;
-			dev->freecount[newsector / dev->sectorsPerBlk]--;
-			dev->releasecount[sector / dev->sectorsPerBlk]++;
 #else
 			smart_update_cache(dev, 0, newsector);
+#endif
 			smart_add_count(dev, dev->freecount, newsector / dev->sectorsPerBlk, -1);
 			smart_add_count(dev, dev->releasecount, sector / dev->sectorsPerBlk, 1);
-#endif
 
 		}
 	}
@@ -2421,13 +3298,14 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev, uint16_t
 {
 	uint16_t freecount, releasecount, prerelease;
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+	/* A block being garbage collected is erased when its collection ends */
+
+	if (block == dev->gc.block) {
+		return;
+	}
+
 	releasecount = smart_get_count(dev, dev->releasecount, block);
 	freecount = smart_get_count(dev, dev->freecount, block);
-#else
-	releasecount = dev->releasecount[block];
-	freecount = dev->freecount[block];
-#endif
 
 	if ((freecount + releasecount == dev->availSectPerBlk && freecount < 1) || forceerase) {
 		/* Erase the block */
@@ -2462,13 +3340,8 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev, uint16_t
 		dev->freesectors += dev->availSectPerBlk - prerelease - freecount;
 		dev->releasesectors -= releasecount - prerelease;
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_set_count(dev, dev->releasecount, block, prerelease);
 		smart_set_count(dev, dev->freecount, block, dev->availSectPerBlk - prerelease);
-#else
-		dev->releasecount[block] = prerelease;
-		dev->freecount[block] = dev->availSectPerBlk - prerelease;
-#endif							/* CONFIG_MTD_SMART_PACK_COUNTS */
 
 		/* Now that we have erased this block and updated the release / free counts,
 		 * if we are in WEAR LEVELING enabled mode, we must check if this erase block's
@@ -2539,6 +3412,28 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 		freecount = dev->sectorsPerBlk + 1;
 		minblock = dev->geo.neraseblocks;
 		mincount = 0;
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+		/* Only the blocks filed under the minimum wear level are candidates */
+
+		x = dev->wearindex.head[dev->minwearlevel];
+		while (x != SMART_BLK_NONE) {
+			mincount++;
+
+			if (smart_get_count(dev, dev->releasecount, x) + smart_get_count(dev, dev->freecount, x) < freecount) {
+				freecount = smart_get_count(dev, dev->releasecount, x) + smart_get_count(dev, dev->freecount, x);
+				minblock = x;
+			}
+
+			if (freecount == 0) {
+				break;
+			}
+
+			x = dev->wearindex.link[x].next;
+			if (x == dev->wearindex.head[dev->minwearlevel]) {
+				break;
+			}
+		}
+#else
 		for (x = 0; x < dev->geo.neraseblocks; x++) {
 			if (smart_get_wear_level(dev, x) == dev->minwearlevel) {
 				/* Don't allow the format sector or directory sector to
@@ -2548,17 +3443,10 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 
 				mincount++;
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 				if (smart_get_count(dev, dev->releasecount, x) + smart_get_count(dev, dev->freecount, x) < freecount) {
 					freecount = smart_get_count(dev, dev->releasecount, x) + smart_get_count(dev, dev->freecount, x);
 					minblock = x;
 				}
-#else
-				if (dev->freecount[x] + dev->releasecount[x] < freecount) {
-					freecount = dev->freecount[x] + dev->releasecount[x];
-					minblock = x;
-				}
-#endif
 
 				/* Break if freecount reaches zero */
 
@@ -2571,6 +3459,7 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 				}
 			}
 		}
+#endif
 
 		/* Okay, now move block 'x' to block 'block' and erase block 'x' */
 
@@ -2584,13 +3473,8 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 		 * yet.
 		 */
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		nextsector = smart_get_count(dev, dev->freecount, x);
 		newsector = smart_get_count(dev, dev->releasecount, x);
-#else
-		nextsector = dev->freecount[x];
-		newsector = dev->releasecount[x];
-#endif
 		fvdbg("Moving block %d, wear %d, free %d, released %d to block %d, wear %d\n", x, smart_get_wear_level(dev, x), nextsector, newsector, block, smart_get_wear_level(dev, block));
 
 		nextsector = block * dev->sectorsPerBlk;
@@ -2671,11 +3555,7 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 			smart_update_cache(dev, *((FAR uint16_t *)header->logicalsector), newsector);
 #endif
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 			smart_add_count(dev, dev->freecount, block, -1);
-#else
-			dev->freecount[block]--;
-#endif							/* CONFIG_MTD_SMART_PACK_COUNTS */
 		}
 
 #ifdef CONFIG_SMART_LOCAL_CHECKFREE
@@ -2983,22 +3863,13 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev, unsigned long a
 		} else {
 			prerelease = 0;
 		}
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_set_count(dev, dev->releasecount, x, prerelease);
 		smart_set_count(dev, dev->freecount, x, dev->availSectPerBlk - prerelease);
-#else
-		dev->releasecount[x] = prerelease;
-		dev->freecount[x] = dev->availSectPerBlk - prerelease;
-#endif
 	}
 
 	/* Account for the format sector */
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	smart_set_count(dev, dev->freecount, 0, dev->availSectPerBlk - 1);
-#else
-	dev->freecount[0]--;
-#endif
 
 	/* Now initialize the logical to physical sector map */
 
@@ -3144,83 +4015,80 @@ errout:
 }
 
 /****************************************************************************
- * Name: smart_relocate_block
+ * Name: smart_relocate_begin
  *
- * Description:  Relocates the specified MTD erase block by moving any
- *               active sectors to a different erase block and then erases
- *               the selected block.
+ * Description:  Starts the relocation of an erase block.  The free sectors
+ *               of the block are withheld so that no sector is moved into
+ *               the block while its live sectors are moved out.
  *
  ****************************************************************************/
 
-static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
+static int smart_relocate_begin(FAR struct smart_struct_s *dev, FAR struct smart_relocate_s *reloc, uint16_t block)
 {
-	uint16_t newsector, oldrelease;
-	int x;
-	int ret;
-	FAR struct smart_sect_header_s *header;
-	uint8_t prerelease;
-	uint16_t freecount;
-#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
-	uint16_t releasecount;
-#endif
-#ifdef CONFIG_MTD_SMART_ENABLE_CRC
-	FAR struct smart_allocsector_s *allocsector;
-#endif
-
-	/* Perform collection on block with the most released sectors.
-	 * First mark the block as having no free sectors so we don't
-	 * try to move sectors into the block we are trying to erase.
-	 */
-
-	header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
-
 #ifdef CONFIG_SMART_LOCAL_CHECKFREE
 	if (smart_checkfree(dev, __LINE__) != OK) {
 		fdbg("   ...while relocating block %d, free=%d\n", block, dev->freesectors);
 	}
 #endif
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-	freecount = smart_get_count(dev, dev->freecount, block);
-
-#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
-#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
-	releasecount = smart_get_count(dev, dev->releasecount, block);
-#endif
-#endif
+	reloc->block = block;
+	reloc->next = block * dev->sectorsPerBlk;
+	reloc->freecount = smart_get_count(dev, dev->freecount, block);
+	reloc->moved = 0;
 
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	/* Ensure we aren't relocating a block containing the only free sectors */
 
-	if (freecount >= dev->freesectors) {
+	if (reloc->freecount >= dev->freesectors) {
 		fdbg("Program bug!  Relocating the only block (%d) with free sectors!\n", block);
-		ret = -EIO;
-		goto errout;
+		reloc->block = SMART_GC_NONE;
+		return -EIO;
 	}
+#endif
+
+	/* Mark the block as having no free sectors so we don't try to move
+	 * sectors into the block we are trying to erase.
+	 */
 
 	smart_set_count(dev, dev->freecount, block, 0);
+	dev->freesectors -= reloc->freecount;
+	return OK;
+}
 
-#else							/* CONFIG_MTD_SMART_PACK_COUNTS */
+/****************************************************************************
+ * Name: smart_relocate_sectors
+ *
+ * Description:  Moves up to 'budget' live sectors out of the erase block
+ *               being relocated.  Returns the number of sectors moved or a
+ *               negated errno.  The relocation is complete when reloc->next
+ *               reaches the end of the block.
+ *
+ ****************************************************************************/
 
-	freecount = dev->freecount[block];
-#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
-#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
-	releasecount = dev->releasecount[block];
-#endif
+static int smart_relocate_sectors(FAR struct smart_struct_s *dev, FAR struct smart_relocate_s *reloc, int budget)
+{
+	uint16_t newsector;
+	uint16_t end;
+	int moved;
+	int ret;
+	int x;
+	FAR struct smart_sect_header_s *header;
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+	FAR struct smart_allocsector_s *allocsector;
 #endif
 
-	dev->freecount[block] = 0;
-#endif
+	end = reloc->block * dev->sectorsPerBlk + dev->availSectPerBlk;
+	moved = 0;
 
-	/* Next move all live data in the block to a new home. */
+	for (; reloc->next < end && moved < budget; reloc->next++) {
+		x = reloc->next;
 
-	for (x = block * dev->sectorsPerBlk; x < block * dev->sectorsPerBlk + dev->availSectPerBlk; x++) {
 		/* Read the next sector from this erase block */
 
 		ret = MTD_BREAD(dev->mtd, x * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
 		if (ret != dev->mtdBlksPerSector) {
 			fdbg("Error reading sector %d\n", x);
-			ret = -EIO;
-			goto errout;
+			return -EIO;
 		}
 		header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
 		/* Test if the block is in use */
@@ -3254,8 +4122,7 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 					/* Unable to find a free sector!!! */
 
 					//fdbg("Can't find a free sector for relocation\n");
-					ret = -ENOSPC;
-					goto errout;
+					return -ENOSPC;
 				}
 #ifdef CONFIG_SMARTFS_BAD_SECTOR
 				else if (dev->badSectorList[physsector] == FALSE) {
@@ -3263,8 +4130,7 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 				}
 			}
 			if (good_sector_tries_index == no_of_good_sector_tries) {
-				ret = -ENOSPC;
-				goto errout;
+				return -ENOSPC;
 			}
 #endif
 
@@ -3290,14 +4156,13 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 				/* Unable to find a free sector!!! */
 
 				//fdbg("Can't find a free sector for relocation\n");
-				ret = -ENOSPC;
-				goto errout;
+				return -ENOSPC;
 			}
 
 			/* Relocate the sector data */
 
 			if ((ret = smart_relocate_sector(dev, x, newsector)) < 0) {
-				goto errout;
+				return ret;
 			}
 		}
 
@@ -3310,18 +4175,37 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 		smart_update_cache(dev, *((FAR uint16_t *)header->logicalsector), newsector);
 #endif
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_add_count(dev, dev->freecount, newsector / dev->sectorsPerBlk, -1);
-#else
-		dev->freecount[newsector / dev->sectorsPerBlk]--;
-#endif
+		dev->freesectors--;
+		reloc->moved++;
+		moved++;
 	}
 
+	return moved;
+}
+
+/****************************************************************************
+ * Name: smart_relocate_finish
+ *
+ * Description:  Erases an erase block whose live sectors have all been
+ *               moved and returns its sectors to the free pool.
+ *
+ ****************************************************************************/
+
+static void smart_relocate_finish(FAR struct smart_struct_s *dev, FAR struct smart_relocate_s *reloc)
+{
+	uint16_t block;
+	uint16_t oldrelease;
+	uint8_t prerelease;
+
+	block = reloc->block;
+	reloc->block = SMART_GC_NONE;
+
 	/* Now erase the erase block */
 
 	MTD_ERASE(dev->mtd, block, 1);
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
-	dev->unusedsectors += freecount;
+	dev->unusedsectors += reloc->freecount;
 	dev->blockerases++;
 #endif
 
@@ -3340,7 +4224,7 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 
 	/* Update the free and release sectors for this erase block. */
 
-	if (x == dev->neraseblocks && dev->totalsectors == 65534) {
+	if (block == dev->geo.neraseblocks - 1 && dev->totalsectors == 65534) {
 		/* We can't use the last two sectors on a 65536 sector device,
 		   so "pre-release" them so they never get allocated.
 		 */
@@ -3350,45 +4234,84 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 		prerelease = 0;
 	}
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+	/* The withheld free sectors and the sectors moved out were already
+	 * taken off the free count.
+	 */
+
 	oldrelease = smart_get_count(dev, dev->releasecount, block);
-	dev->freesectors += oldrelease - prerelease;
+	dev->freesectors += reloc->freecount + reloc->moved + oldrelease - prerelease;
 	dev->releasesectors -= oldrelease - prerelease;
 	smart_set_count(dev, dev->freecount, block, dev->availSectPerBlk - prerelease);
 	smart_set_count(dev, dev->releasecount, block, prerelease);
-#else
-	oldrelease = dev->releasecount[block];
-	dev->freesectors += oldrelease - prerelease;
-	dev->releasesectors -= oldrelease - prerelease;
-	dev->freecount[block] = dev->availSectPerBlk - prerelease;
-	dev->releasecount[block] = prerelease;
-#endif
 
 #ifdef CONFIG_SMART_LOCAL_CHECKFREE
 	if (smart_checkfree(dev, __LINE__) != OK) {
-		fdbg("   ...while relocating block %d, free=%d, release=%d, oldrelease=%d\n", block, freecount, releasecount, oldrelease);
+		fdbg("   ...while relocating block %d, free=%d, oldrelease=%d\n", block, reloc->freecount, oldrelease);
 	}
 #endif
 
-	/* Test if this erase causes the block to reach the full relocate
-	 * threshold requiring static data relocation.
-	 */
+	/* Test if this erase causes the block to reach the full relocate
+	 * threshold requiring static data relocation.
+	 */
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	smart_relocate_static_data(dev, block);
+#endif
+}
+
+/****************************************************************************
+ * Name: smart_relocate_abort
+ *
+ * Description:  Gives the withheld free sectors back to an erase block
+ *               whose relocation failed.
+ *
+ ****************************************************************************/
+
+static void smart_relocate_abort(FAR struct smart_struct_s *dev, FAR struct smart_relocate_s *reloc)
+{
+	smart_set_count(dev, dev->freecount, reloc->block, reloc->freecount);
+	dev->freesectors += reloc->freecount + reloc->moved;
+	reloc->block = SMART_GC_NONE;
+}
+
+/****************************************************************************
+ * Name: smart_relocate_block
+ *
+ * Description:  Relocates the specified MTD erase block by moving any
+ *               active sectors to a different erase block and then erases
+ *               the selected block.  If the block is partially collected,
+ *               its collection is completed.
+ *
+ ****************************************************************************/
+
+static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
+{
+	struct smart_relocate_s local;
+	FAR struct smart_relocate_s *reloc;
+	int ret;
+
+	if (block == dev->gc.block) {
+		reloc = &dev->gc;
+	} else {
+		reloc = &local;
+		ret = smart_relocate_begin(dev, reloc, block);
+		if (ret < 0) {
+			return ret;
+		}
+	}
 
-#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
-	smart_relocate_static_data(dev, block);
-#endif
+	/* Next move all live data in the block to a new home. */
 
-	return OK;
+	ret = smart_relocate_sectors(dev, reloc, SMART_GC_ALLSECTORS);
+	if (ret < 0) {
+		/* Restore the block's freecount if error */
 
-errout:
-	/* Restore the block's freecount if error */
+		smart_relocate_abort(dev, reloc);
+		return ret;
+	}
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-	smart_set_count(dev, dev->freecount, block, freecount);
-#else
-	dev->freecount[block] = freecount;
-#endif
-	return ret;
+	smart_relocate_finish(dev, reloc);
+	return OK;
 }
 
 /****************************************************************************
@@ -3429,6 +4352,18 @@ retry:
 	maxwearlevel = 0;
 #endif
 	physicalsector = 0xFFFF;
+
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	/* The free index holds every unworn block by free count, so the scan
+	 * below is only needed when no unworn block has a free sector left.
+	 */
+
+	allocblock = smart_blkindex_findfree(dev);
+	if (allocblock != 0xFFFF) {
+		goto found_block;
+	}
+#endif
+
 	if (++dev->lastallocblock >= dev->neraseblocks) {
 		dev->lastallocblock = 0;
 	}
@@ -3439,11 +4374,7 @@ retry:
 		 * currently selected block
 		 */
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		count = smart_get_count(dev, dev->freecount, block);
-#else
-		count = dev->freecount[block];
-#endif
 
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 		/* Keep track of the block with the max free sectors that is worn */
@@ -3526,7 +4457,7 @@ retry:
 		{
 			fdbg("Program bug!  Expected a free sector, free=%d\n", dev->freesectors);
 			for (x = 0; x < dev->neraseblocks; x++) {
-				fdbg("%d ", dev->freecount[x]);
+				fdbg("%d ", smart_get_count(dev, dev->freecount, x));
 			}
 
 			/* No free sectors found!  Bug? */
@@ -3535,6 +4466,9 @@ retry:
 		}
 	}
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+found_block:
+#endif
 	/* Now find a free physical sector within this selected
 	 * erase block to allocate. */
 
@@ -3604,30 +4538,182 @@ retry:
 	return physicalsector;
 }
 
+/****************************************************************************
+ * Name: smart_gc_selectblock
+ *
+ * Description:  Returns the erase block with the most released sectors that
+ *               may be collected, or 0xFFFF if no block has any.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_WRITABLE
+static uint16_t smart_gc_selectblock(FAR struct smart_struct_s *dev)
+{
+	uint16_t collectblock;
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	int bucket;
+#else
+	uint16_t releasemax;
+	int x;
+	uint8_t count;
+#endif
+
+	/* Find the block with the most released sectors */
+
+	collectblock = 0xFFFF;
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	bucket = smart_blkindex_top(&dev->releaseindex);
+	if (bucket > 0) {
+		collectblock = dev->releaseindex.head[bucket];
+	}
+#else
+	releasemax = 0;
+	for (x = 0; x < dev->neraseblocks; x++) {
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+		/* Don't collect blocks that have been worn completely */
+
+		if (smart_get_wear_level(dev, x) >= SMART_WEAR_REORG_THRESHOLD) {
+			continue;
+		}
+#endif
+
+		count = smart_get_count(dev, dev->releasecount, x);
+		if (count > releasemax) {
+			releasemax = count;
+			collectblock = x;
+		}
+	}
+#endif
+
+	return collectblock;
+}
+#endif							/* CONFIG_FS_WRITABLE */
+
+/****************************************************************************
+ * Name: smart_gc_collect
+ *
+ * Description:  Moves up to 'budget' live sectors out of the erase block
+ *               being collected and erases it once it is empty.  If no
+ *               block is being collected, the block with the most released
+ *               sectors is started if it has at least 'minrelease' of them.
+ *               Returns the number of sectors moved or a negated errno.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_WRITABLE
+static int smart_gc_collect(FAR struct smart_struct_s *dev, int budget, uint8_t minrelease)
+{
+	uint16_t collectblock;
+	int ret;
+
+	if (dev->gc.block == SMART_GC_NONE) {
+		collectblock = smart_gc_selectblock(dev);
+		if (collectblock == 0xFFFF || smart_get_count(dev, dev->releasecount, collectblock) < minrelease) {
+			/* Need to collect, but no sectors with released blocks! */
+
+			return -ENOSPC;
+		}
+#ifdef CONFIG_SMART_LOCAL_CHECKFREE
+		if (smart_checkfree(dev, __LINE__) != OK) {
+			fdbg("   ...before collecting block %d\n", collectblock);
+		}
+#endif
+
+		fvdbg("Collecting block %d, free=%d released=%d, totalfree=%d, totalrelease=%d\n", collectblock, smart_get_count(dev, dev->freecount, collectblock), smart_get_count(dev, dev->releasecount, collectblock), dev->freesectors, dev->releasesectors);
+
+		ret = smart_relocate_begin(dev, &dev->gc, collectblock);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	/* Relocate the active data in the collection block */
+
+	collectblock = dev->gc.block;
+	ret = smart_relocate_sectors(dev, &dev->gc, budget);
+	if (ret < 0) {
+		smart_relocate_abort(dev, &dev->gc);
+		return ret;
+	}
+
+	if (dev->gc.next == collectblock * dev->sectorsPerBlk + dev->availSectPerBlk) {
+		smart_relocate_finish(dev, &dev->gc);
+
+#ifdef CONFIG_SMART_LOCAL_CHECKFREE
+		if (smart_checkfree(dev, __LINE__) != OK) {
+			fdbg("   ...while collecting block %d\n", collectblock);
+		}
+#endif
+	}
+
+	return ret;
+}
+#endif							/* CONFIG_FS_WRITABLE */
+
+/****************************************************************************
+ * Name: smart_gc_stall
+ *
+ * Description:  Adds the time a write spent in garbage collection to the
+ *               stall histogram.  Bucket n counts stalls shorter than 4^n
+ *               msec, the last bucket counts all longer stalls.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+static void smart_gc_stall(FAR struct smart_struct_s *dev, systime_t ticks)
+{
+	uint32_t msec;
+	uint32_t limit;
+	int bucket;
+
+	msec = TICK2MSEC(ticks);
+	limit = 1;
+	for (bucket = 0; bucket < SMART_GC_STALL_BUCKETS - 1 && msec >= limit; bucket++) {
+		limit <<= 2;
+	}
+
+	dev->gc_stalls[bucket]++;
+	if (msec > dev->gc_maxstall) {
+		dev->gc_maxstall = msec;
+	}
+}
+#endif
+
 /****************************************************************************
  * Name: smart_garbagecollect
  *
  * Description:  Performs garbage collection if needed.  This is determined
  *               by the count of released sectors relative to free and
- *               total sectors.
+ *               total sectors.  With incremental collection, only a few
+ *               sectors are moved per call until the device is down to its
+ *               reserved free sectors.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_WRITABLE
 static int smart_garbagecollect(FAR struct smart_struct_s *dev)
 {
-	uint16_t collectblock;
-	uint16_t releasemax;
 	bool collect = TRUE;
-	int x;
-	int ret;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-	uint8_t count;
+	int budget;
+	int ret = OK;
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	systime_t start = clock_systimer();
+	bool stalled = FALSE;
 #endif
 
 	while (collect) {
 		collect = FALSE;
 
+		/* Until the device is down to its reserved free sectors only a few
+		 * sectors are moved per write.
+		 */
+
+#ifdef CONFIG_MTD_SMART_GC_INCREMENTAL
+		budget = CONFIG_MTD_SMART_GC_WRITE_SECTORS;
+#else
+		budget = SMART_GC_ALLSECTORS;
+#endif
+
 		/* Test if the released sectors count is greater than the
 		 * free sectors.  If it is, then we will do garbage collection.
 		 */
@@ -3640,77 +4726,41 @@ static int smart_garbagecollect(FAR struct smart_struct_s *dev)
 
 		if (dev->freesectors <= (dev->sectorsPerBlk << 0) + 4) {
 			collect = TRUE;
+			budget = SMART_GC_ALLSECTORS;
 		}
 
 		/* Test if we need to garbage collect */
 
 		if (collect) {
-			/* Find the block with the most released sectors */
-
-			collectblock = 0xFFFF;
-			releasemax = 0;
-			for (x = 0; x < dev->neraseblocks; x++) {
-#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
-				/* Don't collect blocks that have been worn completely */
-
-				if (smart_get_wear_level(dev, x) >= SMART_WEAR_REORG_THRESHOLD) {
-					continue;
-				}
-#endif
-
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-				count = smart_get_count(dev, dev->releasecount, x);
-				if (count > releasemax) {
-					releasemax = count;
-					collectblock = x;
-				}
-#else
-				if (dev->releasecount[x] > releasemax) {
-					releasemax = dev->releasecount[x];
-					collectblock = x;
-				}
-#endif
-			}
-			//releasemax = smart_get_count(dev, dev->releasecount, collectblock);
-
-			if (collectblock == 0xFFFF) {
-				/* Need to collect, but no sectors with released blocks! */
-
-				ret = -ENOSPC;
-				goto errout;
+			ret = smart_gc_collect(dev, budget, 1);
+			if (ret < 0) {
+				break;
 			}
-#ifdef CONFIG_SMART_LOCAL_CHECKFREE
-			if (smart_checkfree(dev, __LINE__) != OK) {
-				fdbg("   ...before collecting block %d\n", collectblock);
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+			stalled = TRUE;
+			dev->gc_sectors += ret;
+			if (dev->gc.block == SMART_GC_NONE) {
+				dev->gc_blocks++;
 			}
 #endif
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-			fvdbg("Collecting block %d, free=%d released=%d, totalfree=%d, totalrelease=%d\n", collectblock, smart_get_count(dev, dev->freecount, collectblock), smart_get_count(dev, dev->releasecount, collectblock), dev->freesectors, dev->releasesectors);
-#else
-			fvdbg("Collecting block %d, free=%d released=%d\n", collectblock, dev->freecount[collectblock], dev->releasecount[collectblock]);
-#endif
-
-			/* Relocate the active data in the collection block */
-
-			ret = smart_relocate_block(dev, collectblock);
+#ifdef CONFIG_MTD_SMART_GC_INCREMENTAL
+			/* Leave the rest of the work to the following writes */
 
-#ifdef CONFIG_SMART_LOCAL_CHECKFREE
-			if (smart_checkfree(dev, __LINE__) != OK) {
-				fdbg("   ...while collecting block %d\n", collectblock);
+			if (budget != SMART_GC_ALLSECTORS) {
+				break;
 			}
 #endif
-
-			if (ret != OK) {
-				goto errout;
-			}
 		}
 	}
 
-	return OK;
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	if (stalled) {
+		smart_gc_stall(dev, clock_systimer() - start);
+	}
+#endif
 
-errout:
-	return ret;
+	return ret < 0 ? ret : OK;
 }
 #endif							/* CONFIG_FS_WRITABLE */
 
@@ -3820,6 +4870,115 @@ errout:
 }
 #endif
 
+/****************************************************************************
+ * Name: smart_gc_idle_needed
+ *
+ * Description:  Tests if background garbage collection should run: a block
+ *               is partially collected, or free sectors are below the idle
+ *               threshold while at least a block worth has been released.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+static bool smart_gc_idle_needed(FAR struct smart_struct_s *dev)
+{
+	if (dev->gc.block != SMART_GC_NONE) {
+		return TRUE;
+	}
+
+	return dev->releasesectors >= dev->availSectPerBlk && (uint32_t)dev->freesectors * 100 < (uint32_t)dev->totalsectors * CONFIG_MTD_SMART_GC_IDLE_FREE;
+}
+
+/****************************************************************************
+ * Name: smart_gc_worker
+ *
+ * Description:  Low priority work queue handler.  Once the device has been
+ *               idle for CONFIG_MTD_SMART_GC_IDLE_MS, relocates a bounded
+ *               number of sectors and queues itself again while collection
+ *               is still needed.  Only blocks with at least half of their
+ *               sectors released are started in the background.
+ *
+ ****************************************************************************/
+
+static void smart_gc_worker(FAR void *arg)
+{
+	FAR struct smart_struct_s *dev = (FAR struct smart_struct_s *)arg;
+	systime_t idle;
+	int32_t delay;
+	int ret;
+
+	smart_semtake(dev);
+
+	if (dev->gcstop) {
+		/* smart_clean() is waiting for us to exit */
+
+		dev->gcqueued = false;
+		smart_semgive(dev);
+		sem_post(&dev->gcdone);
+		return;
+	}
+
+	delay = -1;
+	idle = clock_systimer() - dev->gclastio;
+	if (idle < SMART_GC_IDLE_TICKS) {
+		/* Written again since the work was queued */
+
+		delay = SMART_GC_IDLE_TICKS - idle;
+	} else if (smart_gc_idle_needed(dev)) {
+		ret = smart_gc_collect(dev, CONFIG_MTD_SMART_GC_IDLE_SECTORS, dev->availSectPerBlk >> 1);
+		if (ret >= 0) {
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+			dev->gc_sectors += ret;
+			dev->gc_idlesectors += ret;
+			if (dev->gc.block == SMART_GC_NONE) {
+				dev->gc_blocks++;
+				dev->gc_idleblocks++;
+			}
+#endif
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+			if (dev->wearflags & SMART_WEARFLAGS_WRITE_NEEDED) {
+				smart_write_wearstatus(dev);
+			}
+#endif
+
+			if (smart_gc_idle_needed(dev)) {
+				delay = 0;
+			}
+		}
+	}
+
+	/* Requeue while still holding exclsem so that smart_clean() sees a
+	 * consistent gcqueued.
+	 */
+
+	if (delay >= 0) {
+		(void)work_queue(LPWORK, &dev->gcwork, smart_gc_worker, dev, delay);
+	} else {
+		dev->gcqueued = false;
+	}
+
+	smart_semgive(dev);
+}
+
+/****************************************************************************
+ * Name: smart_gc_notify
+ *
+ * Description:  Called after each write access.  Restarts the idle time and
+ *               queues the background collection if it may be needed.
+ *               Called with exclsem held.
+ *
+ ****************************************************************************/
+
+static void smart_gc_notify(FAR struct smart_struct_s *dev)
+{
+	dev->gclastio = clock_systimer();
+	if (!dev->gcqueued && !dev->gcstop && smart_gc_idle_needed(dev)) {
+		dev->gcqueued = true;
+		(void)work_queue(LPWORK, &dev->gcwork, smart_gc_worker, dev, SMART_GC_IDLE_TICKS);
+	}
+}
+#endif							/* CONFIG_MTD_SMART_GC_BACKGROUND */
+
 /****************************************************************************
  * Name: smart_read_wearstatus
  *
@@ -3918,6 +5077,9 @@ static inline int smart_read_wearstatus(FAR struct smart_struct_s *dev)
 
 	/* Now interrogate the status bits */
 
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	smart_blkindex_rebuild(dev);
+#endif
 	smart_find_wear_minmax(dev);
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
@@ -3931,6 +5093,13 @@ static inline int smart_read_wearstatus(FAR struct smart_struct_s *dev)
 	ret = OK;
 
 errout:
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	/* Part of the wear bits may have been replaced, re-file the blocks */
+
+	if (ret != OK) {
+		smart_blkindex_rebuild(dev);
+	}
+#endif
 	return ret;
 }
 #endif							/* CONFIG_MTD_SMART_WEAR_LEVEL */
@@ -4377,13 +5546,8 @@ relocate_good_sector:
 		/* Update releasecount for released sector and freecount for the
 		 * newly allocated physical sector. */
 		block = oldphyssector / dev->sectorsPerBlk;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_add_count(dev, dev->releasecount, block, 1);
 		smart_add_count(dev, dev->freecount, physsector / dev->sectorsPerBlk, -1);
-#else
-		dev->releasecount[block]++;
-		dev->freecount[physsector / dev->sectorsPerBlk]--;
-#endif
 		dev->freesectors--;
 		dev->releasesectors++;
 
@@ -4497,13 +5661,8 @@ errout:
 		 * newly allocated but bad physical sector. */
 
 		block = physsector / dev->sectorsPerBlk;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 		smart_add_count(dev, dev->releasecount, block, 1);
 		smart_add_count(dev, dev->freecount, physsector / dev->sectorsPerBlk, -1);
-#else
-		dev->releasecount[block]++;
-		dev->freecount[physsector / dev->sectorsPerBlk]--;
-#endif
 		dev->freesectors--;
 		dev->releasesectors++;
 
@@ -4873,11 +6032,7 @@ static inline int smart_allocsector(FAR struct smart_struct_s *dev, unsigned lon
 	smart_add_sector_to_cache(dev, logsector, physicalsector, __LINE__);
 #endif
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	smart_add_count(dev, dev->freecount, physicalsector / dev->sectorsPerBlk, -1);
-#else
-	dev->freecount[physicalsector / dev->sectorsPerBlk]--;
-#endif
 	dev->freesectors--;
 
 	/* Return the logical sector number */
@@ -4966,11 +6121,7 @@ static inline int smart_freesector(FAR struct smart_struct_s *dev, unsigned long
 
 	dev->releasesectors++;
 	block = physsector / dev->sectorsPerBlk;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	smart_add_count(dev, dev->releasecount, block, 1);
-#else
-	dev->releasecount[block]++;
-#endif
 
 	/* Unmap this logical sector */
 
@@ -5015,6 +6166,8 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 	dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
+	smart_semtake(dev);
+
 	/* Process the ioctl's we care about first, pass any we don't respond
 	 * to directly to the underlying MTD device.
 	 */
@@ -5029,7 +6182,8 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 #ifdef CONFIG_DEBUG
 		if (arg == 0) {
 			fdbg("ERROR: BIOC_XIPBASE argument is NULL\n");
-			return -EINVAL;
+			ret = -EINVAL;
+			goto ok_out;
 		}
 #endif
 
@@ -5068,14 +6222,14 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 		/* Allocate a logical sector for the upper layer file system */
 
 		ret = smart_allocsector(dev, arg);
-		goto ok_out;
+		goto write_out;
 
 	case BIOC_FREESECT:
 
 		/* Free the specified logical sector */
 
 		ret = smart_freesector(dev, arg);
-		goto ok_out;
+		goto write_out;
 
 	case BIOC_WRITESECT:
 
@@ -5091,7 +6245,7 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 		}
 #endif
 
-		goto ok_out;
+		goto write_out;
 #endif							/* CONFIG_FS_WRITABLE */
 
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
@@ -5129,6 +6283,23 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 		procfs_data->uneven_wearcount = dev->uneven_wearcount;
 #endif
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+		procfs_data->map_lookups = dev->map_lookups;
+		procfs_data->map_hits = dev->map_hits;
+		procfs_data->map_seghits = dev->map_seghits;
+		procfs_data->map_unused = dev->map_unused;
+		procfs_data->map_segloads = dev->map_segloads;
+		procfs_data->map_reads = dev->map_reads;
+		procfs_data->cacheentries = dev->cache_entries;
+#endif
+		procfs_data->gc_blocks = dev->gc_blocks;
+		procfs_data->gc_sectors = dev->gc_sectors;
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+		procfs_data->gc_idleblocks = dev->gc_idleblocks;
+		procfs_data->gc_idlesectors = dev->gc_idlesectors;
+#endif
+		procfs_data->gc_maxstall = dev->gc_maxstall;
+		memcpy(procfs_data->gc_stalls, dev->gc_stalls, sizeof(dev->gc_stalls));
 		ret = OK;
 		goto ok_out;
 #endif
@@ -5160,7 +6331,17 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 		fdbg("ERROR: MTD ioctl(%04x) failed: %d\n", cmd, ret);
 	}
 
+	goto ok_out;
+
+#ifdef CONFIG_FS_WRITABLE
+write_out:
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+	smart_gc_notify(dev);
+#endif
+#endif
+
 ok_out:
+	smart_semgive(dev);
 	return ret;
 }
 
@@ -5253,8 +6434,21 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 		dev->wearstatus = NULL;
 #endif
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+		dev->blkindex = NULL;
+#endif
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
 		dev->allocsector = NULL;
+#endif
+#ifdef SMART_HAVE_EXCLSEM
+		sem_init(&dev->exclsem, 0, 1);
+#endif
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+		dev->gcwork.worker = NULL;
+		dev->gclastio = 0;
+		dev->gcqueued = false;
+		dev->gcstop = false;
+		sem_init(&dev->gcdone, 0, 0);
 #endif
 		dev->sectorsize = 0;
 		ret = smart_setsectorsize(dev, CONFIG_MTD_SMART_SECTOR_SIZE);
@@ -5366,6 +6560,11 @@ errout:
 		smart_free(dev, dev->wearstatus);
 	}
 #endif
+#ifdef CONFIG_MTD_SMART_BLOCK_INDEX
+	if (dev->blkindex != NULL) {
+		smart_free(dev, dev->blkindex);
+	}
+#endif
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	smart_free(dev, dev->erasecounts);
 #endif
@@ -5374,6 +6573,12 @@ errout:
 		smart_free(dev, rootdirdev);
 	}
 #endif
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+	sem_destroy(&dev->gcdone);
+#endif
+#ifdef SMART_HAVE_EXCLSEM
+	sem_destroy(&dev->exclsem);
+#endif
 
 	kmm_free(dev);
 	return ret;
@@ -5402,11 +6607,13 @@ int smart_validatesector(FAR struct inode *inode, uint16_t logsector, char *vali
 		return -EINVAL;
 	}
 
+	smart_semtake(dev);
 #ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
 	physsector = dev->sMap[logsector];
 #else
 	physsector = smart_cache_lookup(dev, logsector);
 #endif
+	smart_semgive(dev);
 	if (physsector != 0xFFFF) {
 		SET_TO_TRUE(validsectors, physsector);
 		return OK;
@@ -5445,6 +6652,7 @@ int smart_recoversectors(FAR struct inode *inode, char *validsectors, int *nobso
 		smart_validatesector(inode, logicalsector, validsectors);
 	}
 
+	smart_semtake(dev);
 	for (sector = 1; sector < totalsectors; sector++) {
 		readaddress = sector * dev->mtdBlksPerSector * dev->geo.blocksize;
 		ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s), (FAR uint8_t *)&header);
@@ -5491,11 +6699,7 @@ int smart_recoversectors(FAR struct inode *inode, char *validsectors, int *nobso
 
 			dev->releasesectors++;
 			block = sector / dev->sectorsPerBlk;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 			smart_add_count(dev, dev->releasecount, block, 1);
-#else
-			dev->releasecount[block]++;
-#endif
 
 			/* if the mapping is sane, Unmap this logical->physicalsector map */
 			if (physsector == sector) {
@@ -5514,6 +6718,7 @@ int smart_recoversectors(FAR struct inode *inode, char *validsectors, int *nobso
 
 	ret = OK;
 err_out:
+	smart_semgive(dev);
 	return ret;
 }
 #endif
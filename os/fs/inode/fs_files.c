@@ -130,6 +130,14 @@ static int _files_close(FAR struct file *filep)
 	/* Check if the struct file is open (i.e., assigned an inode) */
 
 	if (inode) {
+#ifdef CONFIG_FS_EPOLL
+		/* Drop any epoll registration while the driver can still tear it
+		 * down.
+		 */
+
+		epoll_detach(filep);
+#endif
+
 		/* Close the file, driver, or mountpoint. */
 
 		if (inode->u.i_ops && inode->u.i_ops->close) {
@@ -0,0 +1,342 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <sys/statfs.h>
+#include <sys/stat.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/kmalloc.h>
+#include <tinyara/mm/mm.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/procfs.h>
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
+#if defined(CONFIG_MM_CACHE) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MMCACHE)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+/* Determines the size of an intermediate buffer that must be large enough
+ * to handle the longest line generated by this logic.
+ */
+
+#define MMCACHE_LINELEN 64
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure describes one open "file" */
+
+struct mmcache_file_s {
+	struct procfs_file_s base;	/* Base open file structure */
+	char line[MMCACHE_LINELEN];	/* Pre-allocated buffer for formatted lines */
+};
+
+/* This structure describes one cached heap */
+
+struct mmcache_heap_s {
+	FAR const char *name;
+	FAR struct mm_heap_s *heap;
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* File system methods */
+
+static int mmcache_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode);
+static int mmcache_close(FAR struct file *filep);
+static ssize_t mmcache_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+
+static int mmcache_dup(FAR const struct file *oldp, FAR struct file *newp);
+
+static int mmcache_stat(FAR const char *relpath, FAR struct stat *buf);
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+static const struct mmcache_heap_s g_mmcacheheaps[] = {
+#ifdef CONFIG_BUILD_FLAT
+	{"umm", &g_mmheap},
+#endif
+#ifdef CONFIG_MM_KERNEL_HEAP
+	{"kmm", &g_kmmheap},
+#endif
+};
+
+#define MMCACHE_NHEAPS (sizeof(g_mmcacheheaps) / sizeof(struct mmcache_heap_s))
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/* See fs_mount.c -- this structure is explicitly externed there.
+ * We use the old-fashioned kind of initializers so that this will compile
+ * with any compiler.
+ */
+
+const struct procfs_operations mmcache_operations = {
+	mmcache_open,				/* open */
+	mmcache_close,				/* close */
+	mmcache_read,				/* read */
+	NULL,						/* write */
+
+	mmcache_dup,				/* dup */
+
+	NULL,						/* opendir */
+	NULL,						/* closedir */
+	NULL,						/* readdir */
+	NULL,						/* rewinddir */
+
+	mmcache_stat				/* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mmcache_open
+ ****************************************************************************/
+
+static int mmcache_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode)
+{
+	FAR struct mmcache_file_s *attr;
+
+	fvdbg("Open '%s'\n", relpath);
+
+	/* PROCFS is read-only.  Any attempt to open with any kind of write
+	 * access is not permitted.
+	 */
+
+	if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0) {
+		fdbg("ERROR: Only O_RDONLY supported\n");
+		return -EACCES;
+	}
+
+	/* "mmcache" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "mmcache") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* Allocate a container to hold the file attributes */
+
+	attr = (FAR struct mmcache_file_s *)kmm_zalloc(sizeof(struct mmcache_file_s));
+	if (!attr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* Save the attributes as the open-specific state in filep->f_priv */
+
+	filep->f_priv = (FAR void *)attr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: mmcache_close
+ ****************************************************************************/
+
+static int mmcache_close(FAR struct file *filep)
+{
+	FAR struct mmcache_file_s *attr;
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct mmcache_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Release the file attributes structure */
+
+	kmm_free(attr);
+	filep->f_priv = NULL;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: mmcache_read
+ *
+ * Description:
+ *   Report, for every size class of every cached heap, the number of
+ *   chunks and bytes held by the caches (summed over all priority bands),
+ *   the cache hit rate and the number of batches drained to the heap.
+ *
+ ****************************************************************************/
+
+static ssize_t mmcache_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	FAR struct mmcache_file_s *attr;
+	FAR struct mm_cache_s *cache;
+	FAR struct mm_cachestat_s *stat;
+	size_t linesize;
+	size_t copysize;
+	size_t totalsize = 0;
+	size_t heldbytes;
+	uint32_t held;
+	uint32_t lookups;
+	off_t offset;
+	int heapndx;
+	int cls;
+	int band;
+
+	fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct mmcache_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	offset = filep->f_pos;
+
+	linesize = snprintf(attr->line, MMCACHE_LINELEN, "%-4s %5s %6s %7s %4s %8s %6s\n", "HEAP", "CHUNK", "CACHED", "BYTES", "HIT%", "MISSES", "DRAINS");
+	copysize = procfs_memcpy(attr->line, linesize, buffer, buflen, &offset);
+	totalsize += copysize;
+
+	for (heapndx = 0; heapndx < MMCACHE_NHEAPS && totalsize < buflen; heapndx++) {
+		cache = &g_mmcacheheaps[heapndx].heap->mm_cache;
+		heldbytes = 0;
+
+		for (cls = 0; cls < MM_CACHE_NCLASSES && totalsize < buflen; cls++) {
+			stat = &cache->stat[cls];
+
+			held = 0;
+			for (band = 0; band < CONFIG_MM_CACHE_NBANDS; band++) {
+				held += cache->band[band].count[cls];
+			}
+
+			heldbytes += held * MM_CACHE_CLASSSIZE(cls);
+
+			/* Skip size classes that have never been used */
+
+			lookups = stat->hits + stat->misses;
+			if (lookups == 0 && held == 0) {
+				continue;
+			}
+
+			linesize = snprintf(attr->line, MMCACHE_LINELEN, "%-4s %5d %6u %7u %4u %8u %6u\n",
+								g_mmcacheheaps[heapndx].name, MM_CACHE_CLASSSIZE(cls),
+								(unsigned int)held, (unsigned int)(held * MM_CACHE_CLASSSIZE(cls)),
+								lookups ? (unsigned int)(((uint64_t)stat->hits * 100) / lookups) : 0,
+								(unsigned int)stat->misses, (unsigned int)stat->drains);
+			copysize = procfs_memcpy(attr->line, linesize, buffer + totalsize, buflen - totalsize, &offset);
+			totalsize += copysize;
+		}
+
+		if (totalsize < buflen) {
+			linesize = snprintf(attr->line, MMCACHE_LINELEN, "%-4s total %u bytes cached\n", g_mmcacheheaps[heapndx].name, (unsigned int)heldbytes);
+			copysize = procfs_memcpy(attr->line, linesize, buffer + totalsize, buflen - totalsize, &offset);
+			totalsize += copysize;
+		}
+	}
+
+	/* Update the file offset */
+
+	filep->f_pos += totalsize;
+	return totalsize;
+}
+
+/****************************************************************************
+ * Name: mmcache_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int mmcache_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+	FAR struct mmcache_file_s *oldattr;
+	FAR struct mmcache_file_s *newattr;
+
+	fvdbg("Dup %p->%p\n", oldp, newp);
+
+	/* Recover our private data from the old struct file instance */
+
+	oldattr = (FAR struct mmcache_file_s *)oldp->f_priv;
+	DEBUGASSERT(oldattr);
+
+	/* Allocate a new container to hold the task and attribute selection */
+
+	newattr = (FAR struct mmcache_file_s *)kmm_malloc(sizeof(struct mmcache_file_s));
+	if (!newattr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* The copy the file attributes from the old attributes to the new */
+
+	memcpy(newattr, oldattr, sizeof(struct mmcache_file_s));
+
+	/* Save the new attributes in the new file structure */
+
+	newp->f_priv = (FAR void *)newattr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: mmcache_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int mmcache_stat(const char *relpath, struct stat *buf)
+{
+	/* "mmcache" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "mmcache") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* "mmcache" is the name for a read-only file */
+
+	buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+	buf->st_size = 0;
+	buf->st_blksize = 0;
+	buf->st_blocks = 0;
+	return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#endif							/* CONFIG_MM_CACHE && !CONFIG_FS_PROCFS_EXCLUDE_MMCACHE */
+#endif							/* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS */
@@ -205,6 +205,20 @@
 #define FS_BOPS(f)        (f)->fs_blkdriver->u.i_bops
 #define FS_IOCTL(f, c, a) (FS_BOPS(f)->ioctl ? FS_BOPS(f)->ioctl((f)->fs_blkdriver, c, a) : (-ENOSYS))
 
+/* Locking of the data path of an open file.  Without fine grained locking
+ * the volume semaphore protects everything.
+ */
+
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+#define SMARTFS_RWBUFFER(f, sf)   ((sf)->rwbuffer)
+#else
+#define smartfs_filetake(f, sf)   smartfs_semtake(f)
+#define smartfs_filegive(f, sf)   smartfs_semgive(f)
+#define smartfs_listtake(f)
+#define smartfs_listgive(f)
+#define SMARTFS_RWBUFFER(f, sf)   ((f)->fs_rwbuffer)
+#endif
+
 /* The logical sector number of the root directory. */
 
 #define SMARTFS_ROOT_DIR_SECTOR   3
@@ -223,6 +237,11 @@
 #define SMARTFS_BFLAG_DIRTY       0x01	/* Set if data changed in the sector */
 #define SMARTFS_BFLAG_NEWALLOC    0x02	/* Set if sector not written since alloc */
 
+/* Stream flags */
+
+#define SMARTFS_SFLAG_TAIL        0x01	/* Pending data starts in currsector */
+#define SMARTFS_SFLAG_SEQ         0x02	/* The last read ended at filepos */
+
 #define SMARTFS_ERASEDSTATE_16BIT (uint16_t)((CONFIG_SMARTFS_ERASEDSTATE << 8) | \
 								  CONFIG_SMARTFS_ERASEDSTATE)
 
@@ -238,6 +257,9 @@
 #ifdef CONFIG_SMARTFS_BAD_SECTOR
 #define SMARTFS_BSM_LOG_SECTOR_NUMBER   11
 #endif
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+#define SMARTFS_SEEK_INDEX_SIZE         (CONFIG_SMARTFS_SEEK_INDEX_SIZE & ~1)
+#endif
 
 #define USED_ARRAY_SIZE                 2
 
@@ -349,8 +371,25 @@ struct smartfs_chain_header_s {
 };
 #endif
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+/* The lock of a file, shared by all of its open instances and taken by
+ * truncate, unlink and rename of the file.  The locks of a volume are
+ * found by the first sector of the file in a list protected by the open
+ * file list semaphore.
+ */
+
+struct smartfs_flock_s {
+	FAR struct smartfs_flock_s *next;	/* The next lock of the volume */
+	uint16_t firstsector;		/* First sector of the file */
+	uint16_t crefs;				/* Open instances and other holders */
+	sem_t sem;					/* Serializes accesses to the file */
+};
+#endif
+
 /* This structure describes the state of one open file.  This structure
- * is protected by the volume semaphore.
+ * is protected by the volume semaphore, or with CONFIG_SMARTFS_FINE_LOCKING
+ * by the lock of the file.  fnext is then protected by the open file list
+ * semaphore of the volume.
  */
 
 struct smartfs_ofile_s {
@@ -371,8 +410,49 @@ struct smartfs_ofile_s {
 								 * used field until the file is closed,
 								 * a seek, or more data is written that
 								 * causes the sector to change. */
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	uint16_t *seekindex;		/* Sector of every seekstride'th chain position */
+	uint16_t seekcount;			/* Number of valid seekindex entries */
+	uint16_t seekstride;		/* Chain positions per seekindex entry */
+	uint8_t seekgen;			/* Bumped when the sector chain is released */
+	uint8_t seekvalid;			/* seekgen the seekindex was built for */
+#endif
+#ifdef CONFIG_SMARTFS_STREAMING
+	uint8_t *sbuffer;			/* Sector images for write behind and read ahead */
+	uint32_t spending;			/* Bytes in sbuffer not yet written to the device */
+	uint16_t sbase;				/* Data offset of the first pending byte */
+	uint8_t sflags;				/* Stream flags */
+	uint8_t scached;			/* Number of read ahead sectors in sbuffer */
+	uint16_t ssector[CONFIG_SMARTFS_STREAM_SECTORS];	/* Logical sector of each sbuffer sector */
+#endif
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	FAR struct smartfs_flock_s *flock;	/* Lock of the file */
+	char *rwbuffer;				/* Read/Write working buffer of this file */
+#ifdef CONFIG_SMARTFS_STREAMING
+	uint8_t sstale;				/* Read ahead sectors changed on the device */
+#endif
+#endif
 };
 
+/* This structure is the cached result of looking up a name in a directory.
+ * A firstsector of SMARTFS_ERASEDSTATE_16BIT caches a name that does not
+ * exist.
+ */
+
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+struct smartfs_dcache_s {
+	uint16_t parent;			/* 1st sector of the directory, 0 if unused */
+	uint16_t hash;				/* Hash of the name */
+	uint16_t lastuse;			/* Lookup count at the last use */
+	uint16_t firstsector;		/* Sector number of the name */
+	uint16_t dsector;			/* Sector number of the directory entry */
+	uint16_t doffset;			/* Offset of the directory entry */
+	uint16_t flags;				/* Flags, including mode */
+	uint32_t utc;				/* Time stamp */
+	char name[CONFIG_SMARTFS_MAXNAMLEN + 1];	/* Name, NULL terminated */
+};
+#endif
+
 /* This structure represents the overall mountpoint state.  An instance of this
  * structure is retained as inode private data on each mountpoint that is
  * mounted with a smartfs filesystem.
@@ -386,6 +466,10 @@ struct smartfs_mountpt_s {
 	sem_t *fs_sem;			/* Used to assure thread-safe access */
 	FAR struct smartfs_ofile_s
 		*fs_head;					/* A singly-linked list of open files */
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	sem_t fs_listsem;			/* Protects the lists of open files and locks */
+	FAR struct smartfs_flock_s *fs_locks;	/* Locks of the files in use */
+#endif
 	bool fs_mounted;			/* true: The file system is ready */
 	struct smart_format_s fs_llformat;	/* Low level device format info */
 	char *fs_rwbuffer;			/* Read/Write working buffer */
@@ -394,6 +478,13 @@ struct smartfs_mountpt_s {
 	uint8_t *fs_chunk_buffer;
 #endif
 	uint8_t fs_rootsector;		/* Root directory sector num */
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+	uint16_t fs_dcacheuse;		/* Lookup count, ages the cache entries */
+	uint32_t fs_dcachehits;		/* Lookups answered with an entry */
+	uint32_t fs_dcacheneghits;	/* Lookups answered with a missing name */
+	uint32_t fs_dcachemisses;	/* Lookups that read the directory */
+	struct smartfs_dcache_s fs_dcache[CONFIG_SMARTFS_DENTRY_CACHE_SIZE];
+#endif
 };
 
 #ifdef CONFIG_SMARTFS_JOURNALING
@@ -502,6 +593,17 @@ struct journal_transaction_manager_s {
 void smartfs_semtake(struct smartfs_mountpt_s *fs);
 void smartfs_semgive(struct smartfs_mountpt_s *fs);
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+FAR struct smartfs_flock_s *smartfs_flockget(struct smartfs_mountpt_s *fs, uint16_t firstsector, bool create);
+void smartfs_flockput(struct smartfs_mountpt_s *fs, FAR struct smartfs_flock_s *flock);
+void smartfs_flocktake(FAR struct smartfs_flock_s *flock);
+void smartfs_flockgive(FAR struct smartfs_flock_s *flock);
+void smartfs_filetake(struct smartfs_mountpt_s *fs, FAR struct smartfs_ofile_s *sf);
+void smartfs_filegive(struct smartfs_mountpt_s *fs, FAR struct smartfs_ofile_s *sf);
+void smartfs_listtake(struct smartfs_mountpt_s *fs);
+void smartfs_listgive(struct smartfs_mountpt_s *fs);
+#endif
+
 /* Forward references for utility functions */
 
 struct smartfs_mountpt_s;
@@ -520,8 +622,20 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *en
 
 int smartfs_countdirentries(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *entry);
 
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+void smartfs_dcache_invalidate(struct smartfs_mountpt_s *fs, uint16_t dirsector);
+#endif
+
 int smartfs_truncatefile(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *entry, FAR struct smartfs_ofile_s *sf);
 
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+void smartfs_seekindex_add(FAR struct smartfs_ofile_s *sf, uint16_t chainpos, uint16_t sector);
+
+uint16_t smartfs_seekindex_find(FAR struct smartfs_ofile_s *sf, uint16_t chainpos, FAR uint16_t *indexpos);
+
+void smartfs_seekindex_reset(struct smartfs_mountpt_s *fs, uint16_t firstsector);
+#endif
+
 uint16_t smartfs_rdle16(FAR const void *val);
 
 void smartfs_wrle16(void *dest, uint16_t val);
@@ -153,6 +153,13 @@ static size_t smartfs_mem_read(FAR struct file *filep, FAR char *buffer, size_t
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 static size_t smartfs_erasemap_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
 #endif
+static size_t smartfs_gc_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+static size_t smartfs_dcache_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+#endif
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static size_t smartfs_mapcache_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+#endif
 #ifdef CONFIG_SMARTFS_FILE_SECTOR_DEBUG
 static size_t smartfs_files_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
 #endif
@@ -162,9 +169,16 @@ static size_t smartfs_files_read(FAR struct file *filep, FAR char *buffer, size_
  ****************************************************************************/
 
 static const struct smartfs_procfs_entry_s g_direntry[] = {
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+	{"dcache", smartfs_dcache_read, NULL, DTYPE_FILE},
+#endif
 	{"debuglevel", NULL, smartfs_debug_write, DTYPE_FILE},
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	{"erasemap", smartfs_erasemap_read, NULL, DTYPE_FILE},
+#endif
+	{"gc", smartfs_gc_read, NULL, DTYPE_FILE},
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+	{"mapcache", smartfs_mapcache_read, NULL, DTYPE_FILE},
 #endif
 #ifdef CONFIG_MTD_SMART_ALLOC_DEBUG
 	{"mem", smartfs_mem_read, NULL, DTYPE_FILE},
@@ -781,6 +795,177 @@ static size_t smartfs_status_read(FAR struct file *filep, FAR char *buffer, size
 	return len;
 }
 
+/****************************************************************************
+ * Name: smartfs_dcache_read
+ *
+ * Description: Performs the read operation for the "dcache" dir entry.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+static size_t smartfs_dcache_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	FAR struct smartfs_file_s *priv;
+	FAR struct smartfs_mountpt_s *fs;
+	int entries;
+	int x;
+	size_t len;
+
+	priv = (FAR struct smartfs_file_s *)filep->f_priv;
+	fs = priv->level1.mount;
+
+	/* Initialize the read length to zero and test if we are at the
+	 * end of the file (i.e. already read the data.
+	 */
+
+	len = 0;
+	if (priv->offset == 0) {
+		entries = 0;
+		for (x = 0; x < CONFIG_SMARTFS_DENTRY_CACHE_SIZE; x++) {
+			if (fs->fs_dcache[x].parent != 0) {
+				entries++;
+			}
+		}
+
+		len = snprintf(buffer, buflen, "Entries          %d / %d\nHits             %u\nNegative Hits    %u\nMisses           %u\n", entries, CONFIG_SMARTFS_DENTRY_CACHE_SIZE, fs->fs_dcachehits, fs->fs_dcacheneghits, fs->fs_dcachemisses);
+		if (len > buflen) {
+			len = buflen;
+		}
+
+		/* Indicate we have already provided all the data */
+
+		priv->offset = 0xFF;
+	}
+
+	return len;
+}
+#endif
+
+/****************************************************************************
+ * Name: smartfs_gc_read
+ *
+ * Description: Performs the read operation for the "gc" dir entry.
+ *              Reports the garbage collection counters and the histogram
+ *              of the time writes were stalled in garbage collection.
+ *
+ ****************************************************************************/
+
+static size_t smartfs_gc_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	struct mtd_smart_procfs_data_s procfs_data;
+	FAR struct smartfs_file_s *priv;
+	uint32_t limit;
+	int ret;
+	int x;
+	size_t len;
+
+	priv = (FAR struct smartfs_file_s *)filep->f_priv;
+
+	/* Initialize the read length to zero and test if we are at the
+	 * end of the file (i.e. already read the data.
+	 */
+
+	len = 0;
+	if (priv->offset == 0) {
+		/* Get the ProcFS data from the block driver */
+
+		ret = priv->level1.mount->fs_blkdriver->u.i_bops->ioctl(priv->level1.mount->fs_blkdriver, BIOC_GETPROCFSD, (unsigned long)&procfs_data);
+
+		if (ret == OK) {
+			len = snprintf(buffer, buflen, "Blocks Collected %u\nSectors Moved    %u\n", procfs_data.gc_blocks, procfs_data.gc_sectors);
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+			if (len < buflen) {
+				len += snprintf(&buffer[len], buflen - len, "Idle Blocks      %u\nIdle Sectors     %u\n", procfs_data.gc_idleblocks, procfs_data.gc_idlesectors);
+			}
+#endif
+			if (len < buflen) {
+				len += snprintf(&buffer[len], buflen - len, "Max Stall        %u ms\nWrite Stalls\n", procfs_data.gc_maxstall);
+			}
+
+			/* One line per histogram bucket, bucket x is < 4^x msec */
+
+			limit = 1;
+			for (x = 0; x < SMART_GC_STALL_BUCKETS && len < buflen; x++) {
+				if (x < SMART_GC_STALL_BUCKETS - 1) {
+					len += snprintf(&buffer[len], buflen - len, "  < %5u ms     %u\n", limit, procfs_data.gc_stalls[x]);
+				} else {
+					len += snprintf(&buffer[len], buflen - len, "  >=%5u ms     %u\n", limit >> 2, procfs_data.gc_stalls[x]);
+				}
+				limit <<= 2;
+			}
+
+			if (len > buflen) {
+				len = buflen;
+			}
+		}
+
+		/* Indicate we have already provided all the data */
+
+		priv->offset = 0xFF;
+	}
+
+	return len;
+}
+
+/****************************************************************************
+ * Name: smartfs_mapcache_read
+ *
+ * Description: Performs the read operation for the "mapcache" dir entry.
+ *              Reports how logical sector lookups were resolved and the
+ *              average number of sector header reads per lookup.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static size_t smartfs_mapcache_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	struct mtd_smart_procfs_data_s procfs_data;
+	FAR struct smartfs_file_s *priv;
+	uint32_t hitrate;
+	uint32_t readrate;
+	int ret;
+	size_t len;
+
+	priv = (FAR struct smartfs_file_s *)filep->f_priv;
+
+	/* Initialize the read length to zero and test if we are at the
+	 * end of the file (i.e. already read the data.
+	 */
+
+	len = 0;
+	if (priv->offset == 0) {
+		/* Get the ProcFS data from the block driver */
+
+		ret = priv->level1.mount->fs_blkdriver->u.i_bops->ioctl(priv->level1.mount->fs_blkdriver, BIOC_GETPROCFSD, (unsigned long)&procfs_data);
+
+		if (ret == OK) {
+			/* Hit rate in percent and header reads per lookup in 1/100ths */
+
+			/* Lookups of unused sectors never touch the cache or the map,
+			 * so they are left out of the hit rate.
+			 */
+
+			hitrate = 0;
+			readrate = 0;
+			if (procfs_data.map_lookups > procfs_data.map_unused) {
+				hitrate = (uint32_t)(((uint64_t)procfs_data.map_hits + procfs_data.map_seghits) * 100 / (procfs_data.map_lookups - procfs_data.map_unused));
+			}
+			if (procfs_data.map_lookups != 0) {
+				readrate = (uint32_t)((uint64_t)procfs_data.map_reads * 100 / procfs_data.map_lookups);
+			}
+
+			len = snprintf(buffer, buflen, "Cache Entries    %d\nLookups          %u\n" "Cache Hits       %u\nSegment Hits     %u\n" "Unused Lookups   %u\n" "Segment Loads    %u\nHeader Reads     %u\n" "Hit Rate         %u%%\nReads/Lookup     %u.%02u\n", procfs_data.cacheentries, procfs_data.map_lookups, procfs_data.map_hits, procfs_data.map_seghits, procfs_data.map_unused, procfs_data.map_segloads, procfs_data.map_reads, hitrate, readrate / 100, readrate % 100);
+		}
+
+		/* Indicate we have already provided all the data */
+
+		priv->offset = 0xFF;
+	}
+
+	return len;
+}
+#endif
+
 /****************************************************************************
  * Name: smartfs_mem_read
  *
@@ -115,6 +115,18 @@ static int smartfs_rename(struct inode *mountpt, const char *oldrelpath, const c
 static int smartfs_stat(struct inode *mountpt, const char *relpath, struct stat *buf);
 
 static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, off_t offset, int whence);
+static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+static void smartfs_rewind_instances(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+
+#ifdef CONFIG_SMARTFS_STREAMING
+static void smartfs_stream_invalidate(struct smartfs_mountpt_s *fs, uint16_t firstsector);
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+static void smartfs_stream_checkstale(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+#endif
+static int smartfs_stream_flush(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+static ssize_t smartfs_stream_append(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, const char *buffer, size_t buflen);
+static int smartfs_stream_readsector(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, uint8_t *zerobuf, uint8_t **sectorbuf);
+#endif
 
 /****************************************************************************
  * Private Variables
@@ -220,7 +232,39 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 	sf->bflags = 0;
 #endif							/* CONFIG_SMARTFS_USE_SECTOR_BUFFER */
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	/* The data path of the file does not share the volume buffer */
+
+	sf->rwbuffer = (char *)kmm_malloc(fs->fs_llformat.availbytes);
+	if (sf->rwbuffer == NULL) {
+#ifdef CONFIG_SMARTFS_USE_SECTOR_BUFFER
+		kmm_free(sf->buffer);
+#endif
+		kmm_free(sf);
+		ret = -ENOMEM;
+		goto errout_with_semaphore;
+	}
+
+	sf->flock = NULL;
+#endif
+
 	sf->entry.name = NULL;
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	sf->seekindex = NULL;
+	sf->seekcount = 0;
+	sf->seekstride = 1;
+	sf->seekgen = 0;
+	sf->seekvalid = 0;
+#endif
+#ifdef CONFIG_SMARTFS_STREAMING
+	sf->sbuffer = NULL;
+	sf->spending = 0;
+	sf->sflags = 0;
+	sf->scached = 0;
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	sf->sstale = 0;
+#endif
+#endif
 	ret = smartfs_finddirentry(fs, &sf->entry, relpath, &parentdirsector, &filename);
 
 	/* Three possibilities: (1) a node exists for the relpath and
@@ -249,6 +293,16 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 
 		/* TODO: Test open mode based on the file mode */
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+		/* Share the lock of the other open instances of the file */
+
+		sf->flock = smartfs_flockget(fs, sf->entry.firstsector, true);
+		if (sf->flock == NULL) {
+			ret = -ENOMEM;
+			goto errout_with_buffer;
+		}
+#endif
+
 		/* The file exists.  Check if we are opening it for O_CREAT or
 		 * O_TRUNC mode and delete the sector chain if we are. */
 
@@ -256,9 +310,23 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 			/* Don't truncate if open for APPEND */
 
 			if (!(oflags & O_APPEND)) {
-				/* Truncate the file as part of the open */
+				/* Truncate the file as part of the open.  Other open
+				 * instances may be reading or writing it meanwhile.
+				 */
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+				smartfs_flocktake(sf->flock);
+#endif
+				smartfs_rewind_instances(fs, sf);
 				ret = smartfs_truncatefile(fs, &sf->entry, sf);
+#ifdef CONFIG_SMARTFS_STREAMING
+				if (ret == OK) {
+					smartfs_stream_invalidate(fs, sf->entry.firstsector);
+				}
+#endif
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+				smartfs_flockgive(sf->flock);
+#endif
 				if (ret < 0) {
 					goto errout_with_buffer;
 				}
@@ -297,6 +365,13 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 			if (ret != OK) {
 				goto errout_with_buffer;
 			}
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+			sf->flock = smartfs_flockget(fs, sf->entry.firstsector, true);
+			if (sf->flock == NULL) {
+				ret = -ENOMEM;
+				goto errout_with_buffer;
+			}
+#endif
 		} else {
 			/* Trying to create in a directory that doesn't exist */
 
@@ -323,7 +398,13 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 	if (oflags & O_APPEND) {
 		/* Perform the seek */
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+		smartfs_flocktake(sf->flock);
+#endif
 		smartfs_seek_internal(fs, sf, 0, SEEK_END);
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+		smartfs_flockgive(sf->flock);
+#endif
 	}
 
 	/* Attach the private date to the struct file instance */
@@ -336,8 +417,10 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 	 * (but a simple reference count could have done that).
 	 */
 
+	smartfs_listtake(fs);
 	sf->fnext = fs->fs_head;
 	fs->fs_head = sf;
+	smartfs_listgive(fs);
 
 	ret = OK;
 	goto errout_with_semaphore;
@@ -349,6 +432,18 @@ errout_with_buffer:
 		kmm_free(sf->entry.name);
 		sf->entry.name = NULL;
 	}
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	if (sf->seekindex) {
+		kmm_free(sf->seekindex);
+	}
+#endif
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	if (sf->flock != NULL) {
+		smartfs_flockput(fs, sf->flock);
+	}
+
+	kmm_free(sf->rwbuffer);
+#endif
 
 	kmm_free(sf);
 
@@ -372,6 +467,7 @@ static int smartfs_close(FAR struct file *filep)
 	struct smartfs_ofile_s *sf;
 	struct smartfs_ofile_s *nextfile;
 	struct smartfs_ofile_s *prevfile;
+	int ret;
 
 	/* Sanity checks */
 
@@ -383,9 +479,11 @@ static int smartfs_close(FAR struct file *filep)
 	fs = inode->i_private;
 	sf = filep->f_priv;
 
-	/* Sync the file */
+	/* Sync the file.  The file is closed even if that fails, but the
+	 * caller is told that its data may not have been written.
+	 */
 
-	smartfs_sync(filep);
+	ret = smartfs_sync(filep);
 
 	/* Take the semaphore */
 
@@ -404,6 +502,7 @@ static int smartfs_close(FAR struct file *filep)
 
 	/* Remove ourselves from the linked list */
 
+	smartfs_listtake(fs);
 	nextfile = fs->fs_head;
 	prevfile = nextfile;
 	while ((nextfile != sf) && (nextfile != NULL)) {
@@ -427,6 +526,8 @@ static int smartfs_close(FAR struct file *filep)
 		}
 	}
 
+	smartfs_listgive(fs);
+
 	/* Now free the pointer */
 
 	filep->f_priv = NULL;;
@@ -441,12 +542,26 @@ static int smartfs_close(FAR struct file *filep)
 		kmm_free(sf->buffer);
 	}
 #endif
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	if (sf->seekindex) {
+		kmm_free(sf->seekindex);
+	}
+#endif
+#ifdef CONFIG_SMARTFS_STREAMING
+	if (sf->sbuffer) {
+		kmm_free(sf->sbuffer);
+	}
+#endif
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	smartfs_flockput(fs, sf->flock);
+	kmm_free(sf->rwbuffer);
+#endif
 
 	kmm_free(sf);
 
 okout:
 	smartfs_semgive(fs);
-	return OK;
+	return ret;
 }
 
 /****************************************************************************
@@ -458,12 +573,20 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 	struct inode *inode;
 	struct smartfs_mountpt_s *fs;
 	struct smartfs_ofile_s *sf;
+#ifndef CONFIG_SMARTFS_STREAMING
 	struct smart_read_write_s readwrite;
+#endif
 	struct smartfs_chain_header_s *header;
 	int ret = OK;
 	uint32_t bytesread;
 	uint16_t bytestoread;
 	uint16_t bytesinsector;
+	uint8_t *sectorbuf;
+#ifdef CONFIG_SMARTFS_STREAMING
+	struct smartfs_chain_header_s zeroheader;
+	struct smartfs_chain_header_s zerosave;
+	uint8_t *zerobuf;
+#endif
 
 	/* Sanity checks */
 
@@ -479,7 +602,16 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 
 	/* Take the semaphore */
 
-	smartfs_semtake(fs);
+	smartfs_filetake(fs, sf);
+
+#ifdef CONFIG_SMARTFS_STREAMING
+	/* Data still buffered for this file has to be on the device first */
+
+	ret = smartfs_stream_flush(fs, sf);
+	if (ret < 0) {
+		goto errout_with_semaphore;
+	}
+#endif
 
 	/* Loop until all byte read or error */
 
@@ -495,9 +627,36 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 
 		/* Read the curent sector into our buffer */
 
+		sectorbuf = (uint8_t *)SMARTFS_RWBUFFER(fs, sf);
+#ifdef CONFIG_SMARTFS_STREAMING
+		/* When the rest of the sector fits in the caller's buffer, read the
+		 * whole sector into it in front of the data.  The chain header then
+		 * lands on bytes already read, which are saved and put back.
+		 */
+
+		zerobuf = NULL;
+		if (sf->curroffset == sizeof(struct smartfs_chain_header_s) && bytesread >= sizeof(struct smartfs_chain_header_s) && buflen - bytesread >= fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s)) {
+			zerobuf = (uint8_t *)&buffer[bytesread - sizeof(struct smartfs_chain_header_s)];
+			memcpy(&zerosave, zerobuf, sizeof(struct smartfs_chain_header_s));
+		}
+
+		ret = smartfs_stream_readsector(fs, sf, zerobuf, &sectorbuf);
+		if (ret < 0) {
+			goto errout_with_semaphore;
+		}
+
+		/* Point header to the read data to get used byte count */
+
+		header = (struct smartfs_chain_header_s *)sectorbuf;
+		if (sectorbuf == zerobuf) {
+			memcpy(&zeroheader, zerobuf, sizeof(struct smartfs_chain_header_s));
+			memcpy(zerobuf, &zerosave, sizeof(struct smartfs_chain_header_s));
+			header = &zeroheader;
+		}
+#else
 		readwrite.logsector = sf->currsector;
 		readwrite.offset = 0;
-		readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+		readwrite.buffer = sectorbuf;
 		readwrite.count = fs->fs_llformat.availbytes;
 		ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
 		if (ret < 0) {
@@ -507,11 +666,12 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 
 		/* Point header to the read data to get used byte count */
 
-		header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+		header = (struct smartfs_chain_header_s *)sectorbuf;
+#endif
 
 		/* Get number of used bytes in this sector */
 #ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
-		bytesinsector = get_leftover_used_byte_count((uint8_t *)readwrite.buffer, get_used_byte_count((uint8_t *)header->used));
+		bytesinsector = get_leftover_used_byte_count(sectorbuf, get_used_byte_count((uint8_t *)header->used));
 #else
 		bytesinsector = SMARTFS_USED(header);
 
@@ -533,9 +693,13 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 		/* Copy data to the read buffer */
 
 		if (bytestoread > 0) {
-			/* Do incremental copy from this sector */
+			/* Do incremental copy from this sector, unless it was read
+			 * straight into the caller's buffer.
+			 */
 
-			memcpy(&buffer[bytesread], &fs->fs_rwbuffer[sf->curroffset], bytestoread);
+			if (&sectorbuf[sf->curroffset] != (uint8_t *)&buffer[bytesread]) {
+				memcpy(&buffer[bytesread], &sectorbuf[sf->curroffset], bytestoread);
+			}
 			bytesread += bytestoread;
 			sf->filepos += bytestoread;
 			sf->curroffset += bytestoread;
@@ -562,9 +726,12 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 	/* Return the number of bytes we read */
 
 	ret = bytesread;
+#ifdef CONFIG_SMARTFS_STREAMING
+	sf->sflags |= SMARTFS_SFLAG_SEQ;
+#endif
 
 errout_with_semaphore:
-	smartfs_semgive(fs);
+	smartfs_filegive(fs, sf);
 	return ret;
 }
 
@@ -590,6 +757,13 @@ static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_of
 	uint16_t t_sector, t_offset;
 #endif
 
+#ifdef CONFIG_SMARTFS_STREAMING
+	ret = smartfs_stream_flush(fs, sf);
+	if (ret < 0) {
+		goto errout;
+	}
+#endif
+
 #ifdef CONFIG_SMARTFS_USE_SECTOR_BUFFER
 	if (sf->bflags & SMARTFS_BFLAG_DIRTY) {
 		/* Update the header with the number of bytes written */
@@ -634,13 +808,16 @@ static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_of
 
 	if (sf->byteswritten > 0) {
 		fvdbg("Syncing sector %d\n", sf->currsector);
+#ifdef CONFIG_SMARTFS_STREAMING
+		smartfs_stream_invalidate(fs, sf->entry.firstsector);
+#endif
 
 		/* Read the existing sector used bytes value */
 
 		readwrite.logsector = sf->currsector;
 		readwrite.offset = 0;
-		header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
-		readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+		header = (struct smartfs_chain_header_s *)SMARTFS_RWBUFFER(fs, sf);
+		readwrite.buffer = (uint8_t *)SMARTFS_RWBUFFER(fs, sf);
 		readwrite.count = sizeof(struct smartfs_chain_header_s);
 		ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
 		if (ret < 0) {
@@ -667,7 +844,7 @@ static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_of
 #endif
 		readwrite.offset = offsetof(struct smartfs_chain_header_s, used);
 		readwrite.count = sizeof(uint16_t);
-		readwrite.buffer = (uint8_t *)&fs->fs_rwbuffer[readwrite.offset];
+		readwrite.buffer = (uint8_t *)&SMARTFS_RWBUFFER(fs, sf)[readwrite.offset];
 #ifdef CONFIG_SMARTFS_JOURNALING
 		used_bytes = ((header->used[0] & 0x00FF) | (header->used[1] & 0x00FF) << 8);
 
@@ -698,6 +875,422 @@ errout:
 	return ret;
 }
 
+/****************************************************************************
+ * Name: smartfs_rewind_instances
+ *
+ * Description: Write out what the other open instances of a file still
+ *   buffer and move them to the start of the file before it is truncated,
+ *   so they do not go on using the released sectors.  Called with the
+ *   volume semaphore held, which keeps the list of open files stable, and
+ *   with CONFIG_SMARTFS_FINE_LOCKING also with the lock of the file.
+ *
+ ****************************************************************************/
+
+static void smartfs_rewind_instances(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf)
+{
+	struct smartfs_ofile_s *other;
+
+	for (other = fs->fs_head; other != NULL; other = other->fnext) {
+		if (other == sf || other->entry.firstsector != sf->entry.firstsector) {
+			continue;
+		}
+
+		smartfs_sync_internal(fs, other);
+		other->filepos = 0;
+		other->currsector = other->entry.firstsector;
+		other->curroffset = sizeof(struct smartfs_chain_header_s);
+		other->byteswritten = 0;
+		other->entry.datlen = 0;
+#ifdef CONFIG_SMARTFS_STREAMING
+		other->scached = 0;
+#endif
+	}
+}
+
+#ifdef CONFIG_SMARTFS_STREAMING
+/****************************************************************************
+ * Name: smartfs_stream_invalidate
+ *
+ * Description: Drop the read ahead sectors of every open instance of the
+ *   file starting at firstsector.  Called whenever the file changes on the
+ *   device.  With fine grained locking other instances may be reading, so
+ *   they are only marked stale and drop the sectors themselves.
+ *
+ ****************************************************************************/
+
+static void smartfs_stream_invalidate(struct smartfs_mountpt_s *fs, uint16_t firstsector)
+{
+	struct smartfs_ofile_s *sf;
+
+	smartfs_listtake(fs);
+	for (sf = fs->fs_head; sf != NULL; sf = sf->fnext) {
+		if (sf->entry.firstsector == firstsector) {
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+			sf->sstale = 1;
+#else
+			sf->scached = 0;
+#endif
+		}
+	}
+
+	smartfs_listgive(fs);
+}
+
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+/****************************************************************************
+ * Name: smartfs_stream_checkstale
+ *
+ * Description: Drop the read ahead sectors of the file if they were marked
+ *   stale by smartfs_stream_invalidate().
+ *
+ ****************************************************************************/
+
+static void smartfs_stream_checkstale(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf)
+{
+	smartfs_listtake(fs);
+	if (sf->sstale) {
+		sf->scached = 0;
+		sf->sstale = 0;
+	}
+
+	smartfs_listgive(fs);
+}
+#endif
+
+/****************************************************************************
+ * Name: smartfs_stream_flush
+ *
+ * Description: Write the data collected in the stream buffer to the device.
+ *   The rest of the current last sector is filled like a normal write, the
+ *   remaining data goes to a batch of new sectors which are allocated
+ *   together and programmed once each, header included.  The new sectors
+ *   are written last to first and chained to the file at the end, so a
+ *   power loss never leaves the file pointing to an unwritten sector.
+ *   Sectors written but not chained are reclaimed by smartfs_recover().
+ *
+ ****************************************************************************/
+
+static int smartfs_stream_flush(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf)
+{
+	struct smart_read_write_s readwrite;
+	struct smartfs_chain_header_s *header;
+	uint32_t pending;
+	uint16_t datasize;
+	uint16_t count;
+	uint16_t lastcount;
+	int nsectors;
+	int first;
+	int x;
+	int ret;
+#ifdef CONFIG_SMARTFS_JOURNALING
+	uint16_t t_sector, t_offset;
+#endif
+
+	if (sf->spending == 0) {
+		return OK;
+	}
+
+	/* Until the data is on the device the file only extends to where the
+	 * pending data starts.
+	 */
+
+	datasize = fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s);
+	pending = sf->spending;
+	nsectors = (sf->sbase + pending + datasize - 1) / datasize;
+	sf->spending = 0;
+	sf->entry.datlen -= pending;
+	first = 0;
+
+	smartfs_stream_invalidate(fs, sf->entry.firstsector);
+
+	/* Fill up the current last sector of the file first */
+
+	if (sf->sflags & SMARTFS_SFLAG_TAIL) {
+		count = datasize - sf->sbase;
+		if (count > pending) {
+			count = pending;
+		}
+
+		readwrite.logsector = sf->currsector;
+		readwrite.offset = sf->curroffset;
+		readwrite.count = count;
+		readwrite.buffer = &sf->sbuffer[sf->curroffset];
+#ifdef CONFIG_SMARTFS_JOURNALING
+		ret = smartfs_create_journalentry(fs, T_WRITE, readwrite.logsector, readwrite.offset, readwrite.count, sf->curroffset + readwrite.count - sizeof(struct smartfs_chain_header_s), 1, readwrite.buffer, &t_sector, &t_offset);
+		if (ret != OK) {
+			fdbg("Journal entry creation failed.\n");
+			goto errout;
+		}
+#endif
+		ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+		if (ret < 0) {
+			fdbg("Error %d writing sector %d data\n", ret, sf->currsector);
+			goto errout;
+		}
+
+		sf->entry.datlen += count;
+		sf->byteswritten += count;
+		sf->curroffset += count;
+		pending -= count;
+		first = 1;
+	}
+
+	if (first == nsectors) {
+		return OK;
+	}
+
+	/* Record the used bytes of the last sector before chaining to it */
+
+	ret = smartfs_sync_internal(fs, sf);
+	if (ret < 0) {
+		goto errout;
+	}
+
+	/* Allocate the new sectors */
+
+	for (x = first; x < nsectors; x++) {
+		ret = FS_IOCTL(fs, BIOC_ALLOCSECT, 0xFFFF);
+		if (ret < 0) {
+			fdbg("Error %d allocating new sector\n", ret);
+			while (--x >= first) {
+				FS_IOCTL(fs, BIOC_FREESECT, sf->ssector[x]);
+			}
+
+			goto errout;
+		}
+
+		sf->ssector[x] = (uint16_t)ret;
+	}
+
+	/* Build the chain header of each sector in front of its data and
+	 * write it out.  Only the last sector may be partially used.
+	 */
+
+	lastcount = pending - (nsectors - 1 - first) * datasize;
+	for (x = nsectors - 1; x >= first; x--) {
+		header = (struct smartfs_chain_header_s *)&sf->sbuffer[x * fs->fs_llformat.availbytes];
+		count = x == nsectors - 1 ? lastcount : datasize;
+
+		memset(header, CONFIG_SMARTFS_ERASEDSTATE, sizeof(struct smartfs_chain_header_s));
+		header->type = SMARTFS_SECTOR_TYPE_FILE;
+		if (x < nsectors - 1) {
+			header->nextsector[0] = (uint8_t)(sf->ssector[x + 1] & 0x00FF);
+			header->nextsector[1] = (uint8_t)(sf->ssector[x + 1] >> 8);
+		}
+#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
+		set_used_byte_count((uint8_t *)header->used, count);
+#else
+		header->used[0] = (uint8_t)(count & 0x00FF);
+		header->used[1] = (uint8_t)(count >> 8);
+#endif
+
+		readwrite.logsector = sf->ssector[x];
+		readwrite.offset = 0;
+		readwrite.count = sizeof(struct smartfs_chain_header_s) + count;
+		readwrite.buffer = (uint8_t *)header;
+		ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+		if (ret < 0) {
+			fdbg("Error %d writing sector %d data\n", ret, sf->ssector[x]);
+			goto errout_with_sectors;
+		}
+	}
+
+	/* Chain the batch to the last sector of the file */
+
+	header = (struct smartfs_chain_header_s *)SMARTFS_RWBUFFER(fs, sf);
+	header->nextsector[0] = (uint8_t)(sf->ssector[first] & 0x00FF);
+	header->nextsector[1] = (uint8_t)(sf->ssector[first] >> 8);
+
+	readwrite.logsector = sf->currsector;
+	readwrite.offset = offsetof(struct smartfs_chain_header_s, nextsector);
+	readwrite.buffer = (uint8_t *)header->nextsector;
+	readwrite.count = sizeof(uint16_t);
+	ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+	if (ret < 0) {
+		fdbg("Error %d writing next sector\n", ret);
+		goto errout_with_sectors;
+	}
+
+	/* The last new sector is now the current one, its used bytes are
+	 * already recorded.
+	 */
+
+	sf->entry.datlen += pending;
+	sf->currsector = sf->ssector[nsectors - 1];
+	sf->curroffset = sizeof(struct smartfs_chain_header_s) + lastcount;
+	sf->byteswritten = 0;
+	return OK;
+
+errout_with_sectors:
+	for (x = first; x < nsectors; x++) {
+		FS_IOCTL(fs, BIOC_FREESECT, sf->ssector[x]);
+	}
+
+errout:
+	/* The data that did not make it to the device is lost */
+
+	sf->filepos = sf->entry.datlen;
+	return ret;
+}
+
+/****************************************************************************
+ * Name: smartfs_stream_append
+ *
+ * Description: Collect data appended to the file in the stream buffer,
+ *   writing it out each time the buffer fills up.  Returns the number of
+ *   bytes taken, zero if the buffer is not available.
+ *
+ ****************************************************************************/
+
+static ssize_t smartfs_stream_append(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, const char *buffer, size_t buflen)
+{
+	uint32_t pos;
+	uint16_t datasize;
+	uint16_t count;
+	size_t total;
+	int ret;
+
+	if (sf->currsector == SMARTFS_ERASEDSTATE_16BIT) {
+		return 0;
+	}
+
+	if (sf->sbuffer == NULL) {
+		sf->sbuffer = (uint8_t *)kmm_malloc(CONFIG_SMARTFS_STREAM_SECTORS * fs->fs_llformat.availbytes);
+		if (sf->sbuffer == NULL) {
+			return 0;
+		}
+	}
+
+	datasize = fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s);
+	total = 0;
+	while (buflen > 0) {
+		if (sf->spending == 0) {
+			/* Start a new batch.  The first sector of the buffer mirrors
+			 * the current sector if it has room left.
+			 */
+
+			sf->scached = 0;
+			if (sf->curroffset < fs->fs_llformat.availbytes) {
+				sf->sflags |= SMARTFS_SFLAG_TAIL;
+				sf->sbase = sf->curroffset - sizeof(struct smartfs_chain_header_s);
+			} else {
+				sf->sflags &= ~SMARTFS_SFLAG_TAIL;
+				sf->sbase = 0;
+			}
+		}
+
+		pos = sf->sbase + sf->spending;
+		count = datasize - pos % datasize;
+		if (count > buflen) {
+			count = buflen;
+		}
+
+		memcpy(&sf->sbuffer[(pos / datasize) * fs->fs_llformat.availbytes + sizeof(struct smartfs_chain_header_s) + pos % datasize], buffer, count);
+		sf->spending += count;
+		sf->entry.datlen += count;
+		sf->filepos += count;
+		buffer += count;
+		buflen -= count;
+		total += count;
+
+		if (sf->sbase + sf->spending == CONFIG_SMARTFS_STREAM_SECTORS * datasize) {
+			ret = smartfs_stream_flush(fs, sf);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+	}
+
+	return total;
+}
+
+/****************************************************************************
+ * Name: smartfs_stream_readsector
+ *
+ * Description: Get the current sector of the file for reading.  A read ahead
+ *   copy is used if there is one.  Otherwise the sector is read into
+ *   zerobuf if given, or on a sequential read together with the sectors
+ *   that follow it into the stream buffer, or else into *sectorbuf.
+ *   *sectorbuf is set to where the sector is.
+ *
+ ****************************************************************************/
+
+static int smartfs_stream_readsector(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, uint8_t *zerobuf, uint8_t **sectorbuf)
+{
+	struct smart_read_write_s readwrite;
+	uint8_t *slot;
+	int x;
+	int ret;
+
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	smartfs_stream_checkstale(fs, sf);
+#endif
+
+	for (x = 0; x < sf->scached; x++) {
+		if (sf->ssector[x] == sf->currsector) {
+			*sectorbuf = &sf->sbuffer[x * fs->fs_llformat.availbytes];
+			return OK;
+		}
+	}
+
+	readwrite.offset = 0;
+	readwrite.count = fs->fs_llformat.availbytes;
+
+	if (zerobuf == NULL && (sf->sflags & SMARTFS_SFLAG_SEQ)) {
+		if (sf->sbuffer == NULL) {
+			sf->sbuffer = (uint8_t *)kmm_malloc(CONFIG_SMARTFS_STREAM_SECTORS * fs->fs_llformat.availbytes);
+		}
+
+		if (sf->sbuffer != NULL) {
+			/* Read ahead along the sector chain.  Failing to read past the
+			 * current sector just ends the read ahead.
+			 */
+
+			sf->scached = 0;
+			readwrite.logsector = sf->currsector;
+			for (x = 0; x < CONFIG_SMARTFS_STREAM_SECTORS && readwrite.logsector != SMARTFS_ERASEDSTATE_16BIT; x++) {
+				slot = &sf->sbuffer[x * fs->fs_llformat.availbytes];
+				readwrite.buffer = slot;
+				ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+				if (ret < 0) {
+					if (x == 0) {
+						fdbg("Error %d reading sector %d data\n", ret, sf->currsector);
+						return ret;
+					}
+
+					break;
+				}
+
+				sf->ssector[x] = readwrite.logsector;
+				sf->scached = x + 1;
+				readwrite.logsector = SMARTFS_NEXTSECTOR(((struct smartfs_chain_header_s *)slot));
+			}
+
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+			/* The file may have been written while the sectors were read.
+			 * Only the current sector is used then.
+			 */
+
+			smartfs_stream_checkstale(fs, sf);
+#endif
+			*sectorbuf = sf->sbuffer;
+			return OK;
+		}
+	}
+
+	readwrite.logsector = sf->currsector;
+	readwrite.buffer = zerobuf != NULL ? zerobuf : *sectorbuf;
+	ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+	if (ret < 0) {
+		fdbg("Error %d reading sector %d data\n", ret, sf->currsector);
+		return ret;
+	}
+
+	*sectorbuf = (uint8_t *)readwrite.buffer;
+	return OK;
+}
+#endif							/* CONFIG_SMARTFS_STREAMING */
+
 /****************************************************************************
  * Name: smartfs_write
  ****************************************************************************/
@@ -740,7 +1333,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 
 	/* Take the semaphore */
 
-	smartfs_semtake(fs);
+	smartfs_filetake(fs, sf);
 
 	/* Test the permissions.  Only allow write if the file was opened with
 	 * write flags.
@@ -751,10 +1344,16 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 		goto errout_with_semaphore;
 	}
 
+#ifdef CONFIG_SMARTFS_STREAMING
+	/* Read ahead copies of this file's sectors may become stale */
+
+	smartfs_stream_invalidate(fs, sf->entry.firstsector);
+#endif
+
 	/* First test if we are overwriting an existing location or writing to
 	 * a new one. */
 
-	header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+	header = (struct smartfs_chain_header_s *)SMARTFS_RWBUFFER(fs, sf);
 	byteswritten = 0;
 	while ((sf->filepos < sf->entry.datlen) && (buflen > 0)) {
 		/* Overwriting data caused by a seek, etc.  In this case, we need
@@ -823,7 +1422,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 			 */
 
 			readwrite.offset = 0;
-			readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+			readwrite.buffer = (uint8_t *)SMARTFS_RWBUFFER(fs, sf);
 			readwrite.count = sizeof(struct smartfs_chain_header_s);
 			ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
 			if (ret < 0) {
@@ -840,6 +1439,22 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 
 	/* Now append data to end of the file. */
 
+#ifdef CONFIG_SMARTFS_STREAMING
+	if (buflen > 0) {
+		/* Collect the data in the stream buffer.  Whatever it does not
+		 * take is written by the loop below.
+		 */
+
+		ret = smartfs_stream_append(fs, sf, &buffer[byteswritten], buflen);
+		if (ret < 0) {
+			goto errout_with_semaphore;
+		}
+
+		buflen -= ret;
+		byteswritten += ret;
+	}
+#endif
+
 	while (buflen > 0) {
 		/* We will fill up the current sector. Write data to
 		 * the current sector first.
@@ -956,7 +1571,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 
 				/* Copy the new sector to the old one and chain it */
 
-				header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+				header = (struct smartfs_chain_header_s *)SMARTFS_RWBUFFER(fs, sf);
 				header->nextsector[0] = (uint8_t)(ret & 0x00FF);
 				header->nextsector[1] = (uint8_t)((ret >> 8) & 0x00FF);
 
@@ -989,7 +1604,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 	ret = byteswritten;
 
 errout_with_semaphore:
-	smartfs_semgive(fs);
+	smartfs_filegive(fs, sf);
 	return ret;
 }
 
@@ -1010,6 +1625,12 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 	int ret;
 	off_t newpos;
 	off_t sectorstartpos;
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	uint16_t datasize;
+	uint16_t chainpos;
+	uint16_t indexpos;
+	uint16_t sector;
+#endif
 #ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
 	int sector_used = 0;
 #endif
@@ -1019,6 +1640,17 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 		return sf->filepos;
 	}
 
+#ifdef CONFIG_SMARTFS_STREAMING
+	/* Write out buffered data, the next read is not sequential */
+
+	ret = smartfs_stream_flush(fs, sf);
+	if (ret < 0) {
+		goto errout;
+	}
+
+	sf->sflags &= ~SMARTFS_SFLAG_SEQ;
+#endif
+
 	/* Test if we need to sync the file */
 
 	if (sf->byteswritten > 0) {
@@ -1055,11 +1687,12 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 	}
 
 	/* Now perform the seek.  Test if we are seeking within the current
-	 * sector and can skip the search to save time.
+	 * sector and can skip the search to save time.  After reading to the
+	 * end of the file there is no current sector.
 	 */
 
 	sectorstartpos = sf->filepos - (sf->curroffset - sizeof(struct smartfs_chain_header_s));
-	if (newpos >= sectorstartpos && newpos < sectorstartpos + fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s)) {
+	if (sf->currsector != SMARTFS_ERASEDSTATE_16BIT && newpos >= sectorstartpos && newpos < sectorstartpos + fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s)) {
 		/* Seeking within the current sector.  Just update the offset */
 
 		sf->curroffset = sizeof(struct smartfs_chain_header_s) + newpos - sectorstartpos;
@@ -1073,6 +1706,25 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 	 * sector, otherwise we have to start from the beginning of the file.
 	 */
 
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	/* All sectors of the chain but the last one are full, so the chain
+	 * position holding newpos is known.  A newpos on a sector boundary
+	 * stays at the end of the previous sector, like the search below.
+	 * Start from the closest indexed sector unless the current sector is
+	 * closer.
+	 */
+
+	datasize = fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s);
+	chainpos = newpos > 0 ? (newpos - 1) / datasize : 0;
+	sector = smartfs_seekindex_find(sf, chainpos, &indexpos);
+	if (sector != SMARTFS_ERASEDSTATE_16BIT && (newpos <= sf->filepos || (off_t)indexpos * datasize > sectorstartpos)) {
+		sf->currsector = sector;
+		sf->filepos = (off_t)indexpos * datasize;
+#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
+		sector_used = indexpos;
+#endif
+	} else
+#endif
 	if (newpos > sf->filepos) {
 		sf->filepos = sectorstartpos;
 	} else {
@@ -1080,14 +1732,18 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 		sf->filepos = 0;
 	}
 
-	header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+	header = (struct smartfs_chain_header_s *)SMARTFS_RWBUFFER(fs, sf);
 	while ((sf->currsector != SMARTFS_ERASEDSTATE_16BIT) && (sf->filepos + fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s) < newpos)) {
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+		smartfs_seekindex_add(sf, sf->filepos / datasize, sf->currsector);
+#endif
+
 		/* Read the sector's header */
 
 		readwrite.logsector = sf->currsector;
 		readwrite.offset = 0;
 		readwrite.count = sizeof(struct smartfs_chain_header_s);
-		readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+		readwrite.buffer = (uint8_t *)SMARTFS_RWBUFFER(fs, sf);
 		ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
 		if (ret < 0) {
 			fdbg("Error %d reading sector %d header\n", ret, sf->currsector);
@@ -1106,6 +1762,12 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 		sf->currsector = SMARTFS_NEXTSECTOR(header);
 	}
 
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	if (sf->currsector != SMARTFS_ERASEDSTATE_16BIT) {
+		smartfs_seekindex_add(sf, sf->filepos / datasize, sf->currsector);
+	}
+#endif
+
 #ifdef CONFIG_SMARTFS_USE_SECTOR_BUFFER
 
 	/* When using sector buffering, we must read in the last buffer to our
@@ -1160,7 +1822,7 @@ static off_t smartfs_seek(FAR struct file *filep, off_t offset, int whence)
 
 	/* Take the semaphore */
 
-	smartfs_semtake(fs);
+	smartfs_filetake(fs, sf);
 
 	/* Call our internal routine to perform the seek */
 
@@ -1170,7 +1832,7 @@ static off_t smartfs_seek(FAR struct file *filep, off_t offset, int whence)
 		filep->f_pos = ret;
 	}
 
-	smartfs_semgive(fs);
+	smartfs_filegive(fs, sf);
 	return ret;
 }
 
@@ -1214,11 +1876,11 @@ static int smartfs_sync(FAR struct file *filep)
 
 	/* Take the semaphore */
 
-	smartfs_semtake(fs);
+	smartfs_filetake(fs, sf);
 
 	ret = smartfs_sync_internal(fs, sf);
 
-	smartfs_semgive(fs);
+	smartfs_filegive(fs, sf);
 	return ret;
 }
 
@@ -1498,12 +2160,19 @@ static int smartfs_bind(FAR struct inode *blkdriver, const void *data, void **ha
 
 	fs->fs_blkdriver = blkdriver;	/* Save the block driver reference */
 	fs->fs_head = NULL;
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	sem_init(&fs->fs_listsem, 0, 1);
+	fs->fs_locks = NULL;
+#endif
 
 	/* Now perform the mount.  */
 
 	ret = smartfs_mount(fs, true);
 	if (ret != 0) {
 		smartfs_semgive(fs);
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+		sem_destroy(&fs->fs_listsem);
+#endif
 		kmm_free(fs);
 		return ret;
 	}
@@ -1547,6 +2216,9 @@ static int smartfs_unbind(void *handle, FAR struct inode **blkdriver)
 	/* Unmount ... close the block driver */
 	ret = smartfs_unmount(fs);
 	smartfs_semgive(fs);
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	sem_destroy(&fs->fs_listsem);
+#endif
 	kmm_free(fs);
 
 	return ret;
@@ -1616,6 +2288,9 @@ static int smartfs_unlink(struct inode *mountpt, const char *relpath)
 #ifdef CONFIG_SMARTFS_JOURNALING
 	uint16_t t_sector, t_offset;
 #endif
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	FAR struct smartfs_flock_s *flock;
+#endif
 
 	/* Sanity checks */
 
@@ -1652,7 +2327,21 @@ static int smartfs_unlink(struct inode *mountpt, const char *relpath)
 		}
 #endif
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+		/* Wait for the open instances of the file to leave its sectors */
+
+		flock = smartfs_flockget(fs, entry.firstsector, false);
+		if (flock != NULL) {
+			smartfs_flocktake(flock);
+		}
+#endif
 		smartfs_deleteentry(fs, &entry);
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+		if (flock != NULL) {
+			smartfs_flockgive(flock);
+			smartfs_flockput(fs, flock);
+		}
+#endif
 #ifdef CONFIG_SMARTFS_JOURNALING
 		ret = smartfs_finish_journalentry(fs, 0, t_sector, t_offset, T_DELETE);
 		if (ret != OK) {
@@ -1884,6 +2573,9 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath, const char *ne
 #ifdef CONFIG_SMARTFS_JOURNALING
 	uint16_t t_sector, t_offset;
 #endif
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	FAR struct smartfs_flock_s *flock;
+#endif
 
 	uint8_t *tmp_pntr = NULL;
 	uint16_t tmp_flag = 0;
@@ -1902,11 +2594,23 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath, const char *ne
 
 	oldentry.name = NULL;
 	newentry.name = NULL;
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	flock = NULL;
+#endif
 	ret = smartfs_finddirentry(fs, &oldentry, oldrelpath, &oldparentdirsector, &oldfilename);
 	if (ret < 0) {
 		goto errout_with_semaphore;
 	}
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	/* Keep the open instances of the file out while its entry moves */
+
+	flock = smartfs_flockget(fs, oldentry.firstsector, false);
+	if (flock != NULL) {
+		smartfs_flocktake(flock);
+	}
+#endif
+
 	/* Search for the new entry and validate it DOESN'T exist, unless we
 	 * are copying to a directory and keeping the same filename, such as:
 	 *
@@ -2022,6 +2726,10 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath, const char *ne
 		tmp_pntr[0] = (uint8_t)(tmp_flag & 0x00FF);
 		tmp_pntr[1] = (uint8_t)((tmp_flag >> 8) & 0x00FF);
 
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+		smartfs_dcache_invalidate(fs, oldentry.dfirst);
+#endif
+
 		/* Now write the updated flags back to the device */
 
 		readwrite.offset = oldentry.doffset;
@@ -2058,6 +2766,12 @@ errout_with_semaphore:
 		kmm_free(newentry.name);
 		newentry.name = NULL;
 	}
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+	if (flock != NULL) {
+		smartfs_flockgive(flock);
+		smartfs_flockput(fs, flock);
+	}
+#endif
 
 	smartfs_semgive(fs);
 	return ret;
@@ -213,6 +213,144 @@ void smartfs_semgive(struct smartfs_mountpt_s *fs)
 	sem_post(fs->fs_sem);
 }
 
+#ifdef CONFIG_SMARTFS_FINE_LOCKING
+/****************************************************************************
+ * Name: smartfs_flockget
+ *
+ * Description: Return a reference to the lock of the file starting at
+ *              firstsector.  If no one holds the lock yet, a new lock is
+ *              created if create is true, else NULL is returned.  NULL is
+ *              also returned if no memory is left.
+ *
+ ****************************************************************************/
+
+FAR struct smartfs_flock_s *smartfs_flockget(struct smartfs_mountpt_s *fs, uint16_t firstsector, bool create)
+{
+	FAR struct smartfs_flock_s *flock;
+
+	smartfs_listtake(fs);
+	for (flock = fs->fs_locks; flock != NULL; flock = flock->next) {
+		if (flock->firstsector == firstsector) {
+			flock->crefs++;
+			smartfs_listgive(fs);
+			return flock;
+		}
+	}
+
+	if (create) {
+		flock = (FAR struct smartfs_flock_s *)kmm_malloc(sizeof(struct smartfs_flock_s));
+		if (flock != NULL) {
+			flock->firstsector = firstsector;
+			flock->crefs = 1;
+			sem_init(&flock->sem, 0, 1);
+			flock->next = fs->fs_locks;
+			fs->fs_locks = flock;
+		}
+	}
+
+	smartfs_listgive(fs);
+	return flock;
+}
+
+/****************************************************************************
+ * Name: smartfs_flockput
+ *
+ * Description: Drop a reference returned by smartfs_flockget().  The lock
+ *              is freed with its last reference.
+ *
+ ****************************************************************************/
+
+void smartfs_flockput(struct smartfs_mountpt_s *fs, FAR struct smartfs_flock_s *flock)
+{
+	FAR struct smartfs_flock_s **prev;
+
+	smartfs_listtake(fs);
+	if (--flock->crefs > 0) {
+		smartfs_listgive(fs);
+		return;
+	}
+
+	for (prev = &fs->fs_locks; *prev != flock; prev = &(*prev)->next) ;
+	*prev = flock->next;
+	smartfs_listgive(fs);
+
+	sem_destroy(&flock->sem);
+	kmm_free(flock);
+}
+
+/****************************************************************************
+ * Name: smartfs_flocktake
+ *
+ * Description: Take the lock of a file.  Taken after the volume semaphore
+ *              if both are needed.
+ *
+ ****************************************************************************/
+
+void smartfs_flocktake(FAR struct smartfs_flock_s *flock)
+{
+	while (sem_wait(&flock->sem) != 0) {
+		ASSERT(*get_errno_ptr() == EINTR);
+	}
+}
+
+/****************************************************************************
+ * Name: smartfs_flockgive
+ ****************************************************************************/
+
+void smartfs_flockgive(FAR struct smartfs_flock_s *flock)
+{
+	sem_post(&flock->sem);
+}
+
+/****************************************************************************
+ * Name: smartfs_filetake
+ *
+ * Description: Take the lock of the file of an open instance.  Held by
+ *              read, write, seek and sync on the file instead of the
+ *              volume semaphore.
+ *
+ ****************************************************************************/
+
+void smartfs_filetake(struct smartfs_mountpt_s *fs, FAR struct smartfs_ofile_s *sf)
+{
+	smartfs_flocktake(sf->flock);
+}
+
+/****************************************************************************
+ * Name: smartfs_filegive
+ ****************************************************************************/
+
+void smartfs_filegive(struct smartfs_mountpt_s *fs, FAR struct smartfs_ofile_s *sf)
+{
+	smartfs_flockgive(sf->flock);
+}
+
+/****************************************************************************
+ * Name: smartfs_listtake
+ *
+ * Description: Take the semaphore protecting the list of open files of the
+ *              volume.  Taken last, after the volume or a file semaphore,
+ *              and never held across an access to the device.
+ *
+ ****************************************************************************/
+
+void smartfs_listtake(struct smartfs_mountpt_s *fs)
+{
+	while (sem_wait(&fs->fs_listsem) != 0) {
+		ASSERT(*get_errno_ptr() == EINTR);
+	}
+}
+
+/****************************************************************************
+ * Name: smartfs_listgive
+ ****************************************************************************/
+
+void smartfs_listgive(struct smartfs_mountpt_s *fs)
+{
+	sem_post(&fs->fs_listsem);
+}
+#endif							/* CONFIG_SMARTFS_FINE_LOCKING */
+
 /****************************************************************************
  * Name: smartfs_rdle16
  *
@@ -742,6 +880,237 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 	return ret;
 }
 
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+/****************************************************************************
+ * Name: smartfs_dcache_hash
+ *
+ * Description: Hashes the first 'len' characters of a name.
+ *
+ ****************************************************************************/
+
+static uint16_t smartfs_dcache_hash(const char *name, uint16_t len)
+{
+	uint16_t hash = 0;
+
+	while (len-- > 0 && *name != '\0') {
+		hash = (hash << 5) + hash + (uint8_t)*name++;
+	}
+
+	return hash;
+}
+
+/****************************************************************************
+ * Name: smartfs_dcache_hasname
+ *
+ * Description: Tests if the rest of a path has a segment other than "."
+ *              and "..".
+ *
+ ****************************************************************************/
+
+static bool smartfs_dcache_hasname(const char *path)
+{
+	const char *segment;
+
+	while (*path != '\0') {
+		while (*path == '/') {
+			path++;
+		}
+
+		segment = path;
+		while (*path != '/' && *path != '\0') {
+			path++;
+		}
+
+		if (path - segment > 2 || (path - segment == 2 && strncmp(segment, "..", 2) != 0) || (path - segment == 1 && *segment != '.')) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/****************************************************************************
+ * Name: smartfs_dcache_lookup
+ *
+ * Description: Returns the cached result of looking up 'name' in the
+ *              directory starting at 'dirsector', or NULL if not cached.
+ *
+ ****************************************************************************/
+
+static FAR struct smartfs_dcache_s *smartfs_dcache_lookup(struct smartfs_mountpt_s *fs, uint16_t dirsector, const char *name)
+{
+	FAR struct smartfs_dcache_s *dcache;
+	uint16_t hash;
+	int x;
+
+	/* Names of this volume may be too long to be cached */
+
+	if (fs->fs_llformat.namesize > CONFIG_SMARTFS_MAXNAMLEN) {
+		return NULL;
+	}
+
+	hash = smartfs_dcache_hash(name, fs->fs_llformat.namesize);
+	fs->fs_dcacheuse++;
+
+	for (x = 0; x < CONFIG_SMARTFS_DENTRY_CACHE_SIZE; x++) {
+		dcache = &fs->fs_dcache[x];
+		if (dcache->parent == dirsector && dcache->hash == hash && strncmp(dcache->name, name, fs->fs_llformat.namesize) == 0) {
+			dcache->lastuse = fs->fs_dcacheuse;
+			if (dcache->firstsector == SMARTFS_ERASEDSTATE_16BIT) {
+				fs->fs_dcacheneghits++;
+			} else {
+				fs->fs_dcachehits++;
+			}
+
+			return dcache;
+		}
+	}
+
+	fs->fs_dcachemisses++;
+	return NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_dcache_add
+ *
+ * Description: Caches the result of looking up 'name' in the directory
+ *              starting at 'dirsector'.  'entry' is the directory entry
+ *              found at dsector/doffset, or NULL if the name doesn't exist.
+ *              Replaces the least recently used entry if the cache is full.
+ *
+ ****************************************************************************/
+
+static void smartfs_dcache_add(struct smartfs_mountpt_s *fs, uint16_t dirsector, const char *name, struct smartfs_entry_header_s *entry, uint16_t dsector, uint16_t doffset)
+{
+	FAR struct smartfs_dcache_s *dcache;
+	uint16_t age;
+	uint16_t oldest;
+	int x;
+
+	if (fs->fs_llformat.namesize > CONFIG_SMARTFS_MAXNAMLEN) {
+		return;
+	}
+
+	dcache = &fs->fs_dcache[0];
+	oldest = 0;
+	for (x = 0; x < CONFIG_SMARTFS_DENTRY_CACHE_SIZE; x++) {
+		if (fs->fs_dcache[x].parent == 0) {
+			dcache = &fs->fs_dcache[x];
+			break;
+		}
+
+		age = fs->fs_dcacheuse - fs->fs_dcache[x].lastuse;
+		if (age > oldest) {
+			oldest = age;
+			dcache = &fs->fs_dcache[x];
+		}
+	}
+
+	dcache->parent = dirsector;
+	dcache->hash = smartfs_dcache_hash(name, fs->fs_llformat.namesize);
+	dcache->lastuse = fs->fs_dcacheuse;
+	strncpy(dcache->name, name, fs->fs_llformat.namesize);
+	dcache->name[fs->fs_llformat.namesize] = '\0';
+
+	if (entry == NULL) {
+		dcache->firstsector = SMARTFS_ERASEDSTATE_16BIT;
+		return;
+	}
+#ifdef CONFIG_SMARTFS_ALIGNED_ACCESS
+	dcache->firstsector = smartfs_rdle16(&entry->firstsector);
+	dcache->flags = smartfs_rdle16(&entry->flags);
+	dcache->utc = smartfs_rdle32(&entry->utc);
+#else
+	dcache->firstsector = entry->firstsector;
+	dcache->flags = entry->flags;
+	dcache->utc = entry->utc;
+#endif
+	dcache->dsector = dsector;
+	dcache->doffset = doffset;
+}
+
+/****************************************************************************
+ * Name: smartfs_dcache_invalidate
+ *
+ * Description: Drops the cached lookups in the directory starting at
+ *              'dirsector', or all cached lookups if 'dirsector' is 0.
+ *              Must be called before the entries of a directory change.
+ *
+ ****************************************************************************/
+
+void smartfs_dcache_invalidate(struct smartfs_mountpt_s *fs, uint16_t dirsector)
+{
+	int x;
+
+	for (x = 0; x < CONFIG_SMARTFS_DENTRY_CACHE_SIZE; x++) {
+		if (dirsector == 0 || fs->fs_dcache[x].parent == dirsector) {
+			fs->fs_dcache[x].parent = 0;
+		}
+	}
+}
+#endif							/* CONFIG_SMARTFS_DENTRY_CACHE */
+
+/****************************************************************************
+ * Name: smartfs_scanfilelen
+ *
+ * Description: Walks the sector chain of a file entry to calculate its
+ *              length.  The walk stops at the first sector that can't be
+ *              read.
+ *
+ ****************************************************************************/
+
+static void smartfs_scanfilelen(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *direntry)
+{
+	int ret;
+	uint16_t sector;
+	struct smartfs_chain_header_s *header;
+	struct smart_read_write_s readwrite;
+#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
+	int used_value;
+#endif
+
+	header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+	sector = direntry->firstsector;
+	readwrite.count = sizeof(struct smartfs_chain_header_s);
+	readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+	readwrite.offset = 0;
+
+	while (sector != SMARTFS_ERASEDSTATE_16BIT) {
+		/* Read the next sector of the file */
+
+		readwrite.logsector = sector;
+		ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+		if (ret < 0) {
+			fdbg("Error in sector chain at %d!\n", sector);
+			break;
+		}
+#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
+		if (SMARTFS_NEXTSECTOR(header) == SMARTFS_ERASEDSTATE_16BIT) {
+
+			readwrite.count = fs->fs_llformat.availbytes;
+			readwrite.buffer = (uint8_t *)fs->fs_chunk_buffer;
+
+			ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+			if (ret < 0) {
+				fdbg("Error %d reading sector %d header\n", ret, sector);
+				break;
+			}
+			used_value = get_leftover_used_byte_count((uint8_t *)readwrite.buffer, get_used_byte_count((uint8_t *)header->used));
+			direntry->datlen += used_value;
+		} else {
+			direntry->datlen += (fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s));
+		}
+		readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+#else
+		/* Add used bytes to the total and point to next sector */
+		if (SMARTFS_USED(header) != SMARTFS_ERASEDSTATE_16BIT) {
+			direntry->datlen += SMARTFS_USED(header);
+		}
+#endif
+		sector = SMARTFS_NEXTSECTOR(header);
+	}
+}
+
 /****************************************************************************
  * Name: smartfs_finddirentry
  *
@@ -772,8 +1141,8 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 	struct smartfs_chain_header_s *header;
 	struct smart_read_write_s readwrite;
 	struct smartfs_entry_header_s *entry;
-#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
-	int used_value;
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+	FAR struct smartfs_dcache_s *dcache;
 #endif
 
 	/* Initialize directory level zero as the root sector */
@@ -843,6 +1212,65 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 			segment = ptr;
 			continue;
 		} else {
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+			/* Try the cache first.  A path ending in a directory, like "dir/"
+			 * or "dir/..", leaves this loop without reporting an entry, so
+			 * the segments before such an ending are read from the device.
+			 */
+
+			dcache = NULL;
+			if (*ptr == '\0' || smartfs_dcache_hasname(ptr)) {
+				dcache = smartfs_dcache_lookup(fs, dirstack[depth], fs->fs_workbuffer);
+			}
+
+			if (dcache != NULL && dcache->firstsector == SMARTFS_ERASEDSTATE_16BIT) {
+				/* Known not to exist */
+
+				if (*ptr == '\0') {
+					*parentdirsector = dirstack[depth];
+					*filename = segment;
+				} else {
+					*parentdirsector = 0xFFFF;
+					*filename = NULL;
+				}
+
+				ret = -ENOENT;
+				goto errout;
+			} else if (dcache != NULL && *ptr == '\0') {
+				/* We are at the last segment.  Report the entry */
+
+				direntry->firstsector = dcache->firstsector;
+				direntry->flags = dcache->flags;
+				direntry->utc = dcache->utc;
+				direntry->dsector = dcache->dsector;
+				direntry->doffset = dcache->doffset;
+				direntry->dfirst = dirstack[depth];
+				direntry->datlen = 0;
+				if ((direntry->flags & SMARTFS_DIRENT_TYPE) == SMARTFS_DIRENT_TYPE_FILE) {
+					smartfs_scanfilelen(fs, direntry);
+				}
+
+				*parentdirsector = dirstack[depth];
+				*filename = segment;
+				ret = OK;
+				goto errout;
+			} else if (dcache != NULL) {
+				if ((dcache->flags & SMARTFS_DIRENT_TYPE) != SMARTFS_DIRENT_TYPE_DIR) {
+					ret = -ENOTDIR;
+					goto errout;
+				}
+
+				if (depth >= CONFIG_SMARTFS_DIRDEPTH - 1) {
+					ret = -ENAMETOOLONG;
+					goto errout;
+				}
+
+				dirstack[++depth] = dcache->firstsector;
+				segment = ptr + 1;
+				continue;
+			}
+#endif
+
 			/* Search for the entry in the current directory */
 
 			dirsector = dirstack[depth];
@@ -899,6 +1327,10 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 						 * open it and continue searching.
 						 */
 
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+						smartfs_dcache_add(fs, dirstack[depth], fs->fs_workbuffer, entry, readwrite.logsector, offset);
+#endif
+
 						if (*ptr == '\0') {
 							/* We are at the last segment.  Report the entry */
 
@@ -932,51 +1364,8 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 							 * a rudimentary check.
 							 */
 
-#ifdef CONFIG_SMARTFS_ALIGNED_ACCESS
-							if ((smartfs_rdle16(&entry->flags) & SMARTFS_DIRENT_TYPE) == SMARTFS_DIRENT_TYPE_FILE) {
-								dirsector = smartfs_rdle16(&entry->firstsector);
-#else
-							if ((entry->flags & SMARTFS_DIRENT_TYPE) == SMARTFS_DIRENT_TYPE_FILE) {
-								dirsector = entry->firstsector;
-#endif
-								readwrite.count = sizeof(struct smartfs_chain_header_s);
-								readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
-								readwrite.offset = 0;
-
-								while (dirsector != SMARTFS_ERASEDSTATE_16BIT) {
-									/* Read the next sector of the file */
-
-									readwrite.logsector = dirsector;
-									ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
-									if (ret < 0) {
-										fdbg("Error in sector chain at %d!\n", dirsector);
-										break;
-									}
-#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
-									if (SMARTFS_NEXTSECTOR(header) == SMARTFS_ERASEDSTATE_16BIT) {
-
-										readwrite.count = fs->fs_llformat.availbytes;
-										readwrite.buffer = (uint8_t *)fs->fs_chunk_buffer;
-
-										ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
-										if (ret < 0) {
-											fdbg("Error %d reading sector %d header\n", ret, sf->currsector);
-											break;
-										}
-										used_value = get_leftover_used_byte_count((uint8_t *)readwrite.buffer, get_used_byte_count((uint8_t *)header->used));
-										direntry->datlen += used_value;
-									} else {
-										direntry->datlen += (fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s));
-									}
-									readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
-#else
-									/* Add used bytes to the total and point to next sector */
-									if (SMARTFS_USED(header) != SMARTFS_ERASEDSTATE_16BIT) {
-										direntry->datlen += SMARTFS_USED(header);
-									}
-#endif
-									dirsector = SMARTFS_NEXTSECTOR(header);
-								}
+							if ((direntry->flags & SMARTFS_DIRENT_TYPE) == SMARTFS_DIRENT_TYPE_FILE) {
+								smartfs_scanfilelen(fs, direntry);
 							}
 
 							*parentdirsector = dirstack[depth];
@@ -1047,6 +1436,10 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 			 * segment, then report the parent directory sector.
 			 */
 
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+			smartfs_dcache_add(fs, dirstack[depth], fs->fs_workbuffer, NULL, 0, 0);
+#endif
+
 			if (*ptr == '\0') {
 				*parentdirsector = dirstack[depth];
 				*filename = segment;
@@ -1101,6 +1494,12 @@ int smartfs_createentry(struct smartfs_mountpt_s *fs, uint16_t parentdirsector,
 	if (strlen(filename) > fs->fs_llformat.namesize) {
 		return -ENAMETOOLONG;
 	}
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+
+	/* The name may be cached as missing */
+
+	smartfs_dcache_invalidate(fs, parentdirsector);
+#endif
 
 	/* Read the parent directory sector and find a place to insert
 	 * the new entry.
@@ -1340,6 +1739,13 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *en
 	 *        bytes of the buffer to read in header info.
 	 */
 
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+	/* Forget the entry and, if it is a directory, its contents */
+
+	smartfs_dcache_invalidate(fs, entry->dfirst);
+	smartfs_dcache_invalidate(fs, entry->firstsector);
+
+#endif
 	nextsector = entry->firstsector;
 	header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
 	readwrite.offset = 0;
@@ -1680,12 +2086,135 @@ int smartfs_truncatefile(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *e
 	}
 #endif
 
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+	/* The sector chain is gone, forget it in all open instances */
+
+	smartfs_seekindex_reset(fs, entry->firstsector);
+#endif
+
 	ret = OK;
 
 errout:
 	return ret;
 }
 
+#ifdef CONFIG_SMARTFS_SEEK_INDEX
+/****************************************************************************
+ * Name: smartfs_seekindex_check
+ *
+ * Description: Empties the sector chain index of an open file if the chain
+ *              has been released since the index was built.  Called by the
+ *              owner of the file only, see smartfs_seekindex_reset().
+ *
+ ****************************************************************************/
+
+static void smartfs_seekindex_check(FAR struct smartfs_ofile_s *sf)
+{
+	uint8_t gen = sf->seekgen;
+
+	if (sf->seekvalid != gen) {
+		sf->seekcount = 0;
+		sf->seekstride = 1;
+		sf->seekvalid = gen;
+	}
+}
+
+/****************************************************************************
+ * Name: smartfs_seekindex_add
+ *
+ * Description: Records the logical sector at position 'chainpos' of the
+ *              sector chain of an open file.  Positions must be added in
+ *              chain order; only every seekstride'th position is kept.  When
+ *              the index is full, every other entry is dropped and the
+ *              stride doubled.
+ *
+ ****************************************************************************/
+
+void smartfs_seekindex_add(FAR struct smartfs_ofile_s *sf, uint16_t chainpos, uint16_t sector)
+{
+	uint16_t x;
+
+	smartfs_seekindex_check(sf);
+	if ((uint32_t)chainpos != (uint32_t)sf->seekcount * sf->seekstride) {
+		/* Already indexed, not on the stride or beyond a gap */
+
+		return;
+	}
+
+	if (sf->seekindex == NULL) {
+		sf->seekindex = (FAR uint16_t *)kmm_malloc(SMARTFS_SEEK_INDEX_SIZE * sizeof(uint16_t));
+		if (sf->seekindex == NULL) {
+			/* Seeks just walk the chain then */
+
+			return;
+		}
+	}
+
+	if (sf->seekcount == SMARTFS_SEEK_INDEX_SIZE) {
+		for (x = 0; x < SMARTFS_SEEK_INDEX_SIZE / 2; x++) {
+			sf->seekindex[x] = sf->seekindex[x << 1];
+		}
+
+		sf->seekcount = SMARTFS_SEEK_INDEX_SIZE / 2;
+		sf->seekstride <<= 1;
+	}
+
+	sf->seekindex[sf->seekcount++] = sector;
+}
+
+/****************************************************************************
+ * Name: smartfs_seekindex_find
+ *
+ * Description: Returns the indexed sector closest to and not after position
+ *              'chainpos' of the sector chain and its position in
+ *              'indexpos', or SMARTFS_ERASEDSTATE_16BIT if nothing has been
+ *              indexed yet.
+ *
+ ****************************************************************************/
+
+uint16_t smartfs_seekindex_find(FAR struct smartfs_ofile_s *sf, uint16_t chainpos, FAR uint16_t *indexpos)
+{
+	uint16_t x;
+
+	smartfs_seekindex_check(sf);
+	if (sf->seekcount == 0) {
+		return SMARTFS_ERASEDSTATE_16BIT;
+	}
+
+	x = chainpos / sf->seekstride;
+	if (x >= sf->seekcount) {
+		x = sf->seekcount - 1;
+	}
+
+	*indexpos = x * sf->seekstride;
+	return sf->seekindex[x];
+}
+
+/****************************************************************************
+ * Name: smartfs_seekindex_reset
+ *
+ * Description: Invalidates the sector chain index of all open instances of
+ *              the file starting at 'firstsector'.  Other instances are
+ *              protected by their own locks, so only their generation is
+ *              bumped here; each empties its index on next use.
+ *
+ ****************************************************************************/
+
+void smartfs_seekindex_reset(struct smartfs_mountpt_s *fs, uint16_t firstsector)
+{
+	FAR struct smartfs_ofile_s *sf;
+
+	smartfs_listtake(fs);
+	for (sf = fs->fs_head; sf != NULL; sf = sf->fnext) {
+		if (sf->entry.firstsector == firstsector) {
+			sf->seekgen++;
+		}
+	}
+
+	smartfs_listgive(fs);
+}
+#endif							/* CONFIG_SMARTFS_SEEK_INDEX */
+
 /****************************************************************************
  * Name: smartfs_get_first_mount
  *
@@ -2645,6 +3174,12 @@ static int process_transaction(struct journal_transaction_manager_s *j_mgr)
 
 	/* Check whether the transaction qualifies for redo */
 	if (T_START_CHECK(entry->trans_info) && !T_FINISH_CHECK(entry->trans_info)) {
+#ifdef CONFIG_SMARTFS_DENTRY_CACHE
+		/* Redo may change directory entries directly */
+
+		smartfs_dcache_invalidate(j_mgr->fs, 0);
+
+#endif
 		/* Choose redo routine based on transaction type */
 		switch (GET_TRANS_TYPE(entry->trans_info)) {
 		case T_SYNC:
@@ -0,0 +1,863 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * fs/vfs/fs_epoll.c
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/epoll.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <semaphore.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <tinyara/clock.h>
+#include <tinyara/kmalloc.h>
+#include <tinyara/fs/fs.h>
+
+#ifdef CONFIG_NET_LWIP
+#include <net/lwip/sockets.h>
+#endif
+
+#include <arch/irq.h>
+
+#ifdef CONFIG_FS_EPOLL
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct epoll_head_s;
+
+/* One descriptor of the interest list.  The pollfd stays registered with
+ * the driver (or socket) for as long as the descriptor is in the list; the
+ * driver's poll_notify() then queues the entry on the ready list.  The
+ * descriptor is identified by its struct file or struct socket rather than
+ * by its number, which is only meaningful to the task that added it and is
+ * reused once the descriptor is closed.
+ */
+
+struct epoll_entry_s {
+	struct pollfd pfd;			/* Must be first, the notify callback gets &pfd */
+	FAR struct epoll_entry_s *flink;	/* Next entry of the interest list */
+	FAR struct epoll_entry_s *rlink;	/* Next entry of the ready list */
+	FAR struct epoll_head_s *eph;	/* The epoll instance */
+	FAR void *obj;				/* struct file or struct socket of pfd.fd */
+	epoll_data_t data;			/* Returned with the events */
+	bool queued;				/* Entry is on a ready list */
+	bool armed;					/* pfd is registered with the driver */
+};
+
+struct epoll_head_s {
+	int16_t crefs;				/* Handle table and calls in progress */
+	sem_t sem;					/* Posted when an entry is queued as ready */
+	sem_t exclsem;				/* Serializes epoll_ctl() and epoll_wait() */
+	FAR struct epoll_entry_s *entries;	/* Interest list */
+	FAR struct epoll_entry_s *rhead;	/* Ready list, accessed with interrupts disabled */
+	FAR struct epoll_entry_s *rtail;
+	bool closed;				/* epoll_close() was called, no more entries */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The handles returned by epoll_create() index this table */
+
+static FAR struct epoll_head_s *g_epoll_heads[CONFIG_FS_EPOLL_NINSTANCES];
+static sem_t g_epoll_sem = SEM_INITIALIZER(1);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: epoll_semtake
+ ****************************************************************************/
+
+static void epoll_semtake(FAR sem_t *sem)
+{
+	while (sem_wait(sem) != 0) {
+		/* The only case that an error should occur here is if the wait
+		 * was awakened by a signal.
+		 */
+
+		ASSERT(get_errno() == EINTR);
+	}
+}
+
+#define epoll_semgive(sem) sem_post(sem)
+
+/****************************************************************************
+ * Name: epoll_notify
+ *
+ * Description:
+ *   poll_notify() callback of a registered descriptor.  Queues the entry on
+ *   the ready list unless it is already queued.  May run in interrupt
+ *   context.
+ *
+ ****************************************************************************/
+
+static void epoll_notify(FAR struct pollfd *fds)
+{
+	FAR struct epoll_entry_s *ent = (FAR struct epoll_entry_s *)fds;
+	FAR struct epoll_head_s *eph = ent->eph;
+	irqstate_t flags;
+
+	flags = irqsave();
+	if (!ent->queued) {
+		ent->queued = true;
+		ent->rlink = NULL;
+		if (eph->rtail) {
+			eph->rtail->rlink = ent;
+		} else {
+			eph->rhead = ent;
+		}
+
+		eph->rtail = ent;
+		sem_post(&eph->sem);
+	}
+
+	irqrestore(flags);
+}
+
+/****************************************************************************
+ * Name: epoll_unqueue
+ *
+ * Description:
+ *   Remove an entry from the ready list.  The entry must no longer be
+ *   registered with its driver.
+ *
+ ****************************************************************************/
+
+static void epoll_unqueue(FAR struct epoll_head_s *eph, FAR struct epoll_entry_s *ent)
+{
+	FAR struct epoll_entry_s *prev = NULL;
+	FAR struct epoll_entry_s *curr;
+	irqstate_t flags;
+
+	flags = irqsave();
+	if (ent->queued) {
+		for (curr = eph->rhead; curr && curr != ent; curr = curr->rlink) {
+			prev = curr;
+		}
+
+		if (curr) {
+			if (prev) {
+				prev->rlink = ent->rlink;
+			} else {
+				eph->rhead = ent->rlink;
+			}
+
+			if (eph->rtail == ent) {
+				eph->rtail = prev;
+			}
+		}
+
+		ent->queued = false;
+	}
+
+	irqrestore(flags);
+}
+
+/****************************************************************************
+ * Name: epoll_fdobj
+ *
+ * Description:
+ *   Return the struct file or struct socket that the descriptor refers to
+ *   in the calling task.
+ *
+ * Return:
+ *   The object, or NULL with errno set to EBADF if fd is not open.
+ *
+ ****************************************************************************/
+
+static FAR void *epoll_fdobj(int fd)
+{
+	FAR struct file *filep;
+
+	if ((unsigned int)fd < CONFIG_NFILE_DESCRIPTORS) {
+		filep = fs_getfilep(fd);
+		if (filep && !filep->f_inode) {
+			set_errno(EBADF);
+			filep = NULL;
+		}
+
+		return filep;
+	}
+#if defined(CONFIG_NET_LWIP) && CONFIG_NSOCKET_DESCRIPTORS > 0
+	else if ((unsigned int)fd < (CONFIG_NFILE_DESCRIPTORS + CONFIG_NSOCKET_DESCRIPTORS)) {
+		/* get_socket() sets errno if the socket is not open */
+
+		return get_socket(fd);
+	}
+#endif
+
+	set_errno(EBADF);
+	return NULL;
+}
+
+/****************************************************************************
+ * Name: epoll_poll
+ *
+ * Description:
+ *   Set up or tear down the poll of the entry through its struct file or
+ *   struct socket.  Unlike poll_fdsetup(), this does not depend on the
+ *   descriptor table of the calling task.
+ *
+ ****************************************************************************/
+
+static int epoll_poll(FAR struct epoll_entry_s *ent, bool setup)
+{
+	FAR struct file *filep;
+	FAR struct inode *inode;
+
+	if ((unsigned int)ent->pfd.fd < CONFIG_NFILE_DESCRIPTORS) {
+		filep = (FAR struct file *)ent->obj;
+		inode = filep->f_inode;
+		if (inode && inode->u.i_ops && inode->u.i_ops->poll) {
+			return (int)inode->u.i_ops->poll(filep, &ent->pfd, setup);
+		}
+
+		return -ENOSYS;
+	}
+#if defined(CONFIG_NET_LWIP) && CONFIG_NSOCKET_DESCRIPTORS > 0
+	return lwip_sock_poll(ent->pfd.fd, (FAR struct socket *)ent->obj, &ent->pfd, setup);
+#else
+	return -EBADF;
+#endif
+}
+
+/****************************************************************************
+ * Name: epoll_arm
+ *
+ * Description:
+ *   Register the entry with its driver.  The driver sets pfd.revents to the
+ *   events already in effect and, if there are any, notifies at once.
+ *
+ ****************************************************************************/
+
+static int epoll_arm(FAR struct epoll_entry_s *ent)
+{
+	int ret;
+
+	ent->pfd.revents = 0;
+	ent->pfd.priv = NULL;
+#ifdef CONFIG_NET_LWIP
+	ent->pfd.scb = NULL;
+#endif
+
+	ret = epoll_poll(ent, true);
+	ent->armed = (ret >= 0);
+	return ret;
+}
+
+/****************************************************************************
+ * Name: epoll_disarm
+ ****************************************************************************/
+
+static void epoll_disarm(FAR struct epoll_entry_s *ent)
+{
+	if (ent->armed) {
+		(void)epoll_poll(ent, false);
+		ent->armed = false;
+	}
+}
+
+/****************************************************************************
+ * Name: epoll_remove
+ *
+ * Description:
+ *   Unregister an entry that has been unlinked from the interest list and
+ *   free it.
+ *
+ ****************************************************************************/
+
+static void epoll_remove(FAR struct epoll_head_s *eph, FAR struct epoll_entry_s *ent)
+{
+	epoll_disarm(ent);
+	epoll_unqueue(eph, ent);
+	kmm_free(ent);
+}
+
+/****************************************************************************
+ * Name: epoll_find
+ ****************************************************************************/
+
+static FAR struct epoll_entry_s *epoll_find(FAR struct epoll_head_s *eph, FAR void *obj, FAR struct epoll_entry_s **prev)
+{
+	FAR struct epoll_entry_s *ent;
+
+	*prev = NULL;
+	for (ent = eph->entries; ent; ent = ent->flink) {
+		if (ent->obj == obj) {
+			break;
+		}
+
+		*prev = ent;
+	}
+
+	return ent;
+}
+
+/****************************************************************************
+ * Name: epoll_collect
+ *
+ * Description:
+ *   Take the entries queued on the ready list and return the events their
+ *   drivers reported since they were last collected.  The entries stay
+ *   registered with their drivers; only the reported event bits are
+ *   consumed, so a descriptor is returned again when its driver reports a
+ *   new event.  Entries that do not fit in evs are put back at the head of
+ *   the ready list.
+ *
+ * Assumptions:
+ *   The caller holds exclsem.
+ *
+ ****************************************************************************/
+
+static int epoll_collect(FAR struct epoll_head_s *eph, FAR struct epoll_event *evs, int maxevents)
+{
+	FAR struct epoll_entry_s *list;
+	FAR struct epoll_entry_s *ent;
+	pollevent_t revents;
+	irqstate_t flags;
+	int n = 0;
+
+	/* Consume the pending wakeups before detaching the list: an entry that
+	 * is queued from here on posts the semaphore again.
+	 */
+
+	while (sem_trywait(&eph->sem) == OK) ;
+
+	flags = irqsave();
+	list = eph->rhead;
+	eph->rhead = NULL;
+	eph->rtail = NULL;
+	irqrestore(flags);
+
+	while (list && n < maxevents) {
+		/* Once 'queued' is cleared the driver may queue the entry again,
+		 * overwriting its rlink.
+		 */
+
+		flags = irqsave();
+		ent = list;
+		list = ent->rlink;
+		ent->queued = false;
+		revents = ent->pfd.revents;
+		ent->pfd.revents = 0;
+		irqrestore(flags);
+
+		if (ent->armed && revents != 0) {
+			evs[n].events = revents;
+			evs[n].data = ent->data;
+			n++;
+		}
+	}
+
+	if (list) {
+		/* These entries are still marked as queued, so their rlink is
+		 * stable.
+		 */
+
+		flags = irqsave();
+		for (ent = list; ent->rlink; ent = ent->rlink) ;
+		ent->rlink = eph->rhead;
+		if (!eph->rtail) {
+			eph->rtail = ent;
+		}
+
+		eph->rhead = list;
+		sem_post(&eph->sem);
+		irqrestore(flags);
+	}
+
+	return n;
+}
+
+/****************************************************************************
+ * Name: epoll_destroy
+ *
+ * Description:
+ *   Free the instance.  Called when the last reference is released; the
+ *   interest list was emptied by epoll_close().
+ *
+ ****************************************************************************/
+
+static void epoll_destroy(FAR struct epoll_head_s *eph)
+{
+	DEBUGASSERT(eph->entries == NULL);
+
+	sem_destroy(&eph->sem);
+	sem_destroy(&eph->exclsem);
+	kmm_free(eph);
+}
+
+/****************************************************************************
+ * Name: epoll_lookup
+ *
+ * Description:
+ *   Look up the instance of a handle and take a reference to it, so that
+ *   a concurrent epoll_close() does not free it while it is in use.
+ *
+ * Return:
+ *   The instance, or NULL for an unknown handle.
+ *
+ ****************************************************************************/
+
+static FAR struct epoll_head_s *epoll_lookup(int epfd)
+{
+	FAR struct epoll_head_s *eph = NULL;
+
+	epoll_semtake(&g_epoll_sem);
+	if (epfd >= 0 && epfd < CONFIG_FS_EPOLL_NINSTANCES) {
+		eph = g_epoll_heads[epfd];
+		if (eph) {
+			eph->crefs++;
+		}
+	}
+
+	epoll_semgive(&g_epoll_sem);
+	return eph;
+}
+
+/****************************************************************************
+ * Name: epoll_get
+ *
+ * Description:
+ *   Like epoll_lookup(), but sets errno to EBADF for an unknown handle.
+ *
+ ****************************************************************************/
+
+static FAR struct epoll_head_s *epoll_get(int epfd)
+{
+	FAR struct epoll_head_s *eph;
+
+	eph = epoll_lookup(epfd);
+	if (!eph) {
+		set_errno(EBADF);
+	}
+
+	return eph;
+}
+
+/****************************************************************************
+ * Name: epoll_put
+ *
+ * Description:
+ *   Release a reference taken by epoll_get() or held by the handle table.
+ *
+ ****************************************************************************/
+
+static void epoll_put(FAR struct epoll_head_s *eph)
+{
+	int16_t crefs;
+
+	epoll_semtake(&g_epoll_sem);
+	crefs = --eph->crefs;
+	epoll_semgive(&g_epoll_sem);
+
+	if (crefs == 0) {
+		epoll_destroy(eph);
+	}
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: epoll_create
+ *
+ * Description:
+ *   Create an epoll instance.  The returned handle is not a file
+ *   descriptor but an index into a table of CONFIG_FS_EPOLL_NINSTANCES
+ *   instances; it must be released with epoll_close().
+ *
+ * Return:
+ *   The handle on success.  On error, -1 is returned and errno is set:
+ *
+ *   EINVAL - size is not positive
+ *   EMFILE - All CONFIG_FS_EPOLL_NINSTANCES instances are in use
+ *   ENOMEM - There was no space to allocate the instance
+ *
+ ****************************************************************************/
+
+int epoll_create(int size)
+{
+	FAR struct epoll_head_s *eph;
+	int epfd;
+
+	if (size <= 0) {
+		set_errno(EINVAL);
+		return ERROR;
+	}
+
+	eph = (FAR struct epoll_head_s *)kmm_zalloc(sizeof(struct epoll_head_s));
+	if (!eph) {
+		set_errno(ENOMEM);
+		return ERROR;
+	}
+
+	sem_init(&eph->sem, 0, 0);
+	sem_init(&eph->exclsem, 0, 1);
+	eph->crefs = 1;
+
+	epoll_semtake(&g_epoll_sem);
+	for (epfd = 0; epfd < CONFIG_FS_EPOLL_NINSTANCES; epfd++) {
+		if (!g_epoll_heads[epfd]) {
+			g_epoll_heads[epfd] = eph;
+			break;
+		}
+	}
+
+	epoll_semgive(&g_epoll_sem);
+
+	if (epfd == CONFIG_FS_EPOLL_NINSTANCES) {
+		sem_destroy(&eph->sem);
+		sem_destroy(&eph->exclsem);
+		kmm_free(eph);
+		set_errno(EMFILE);
+		return ERROR;
+	}
+
+	return epfd;
+}
+
+/****************************************************************************
+ * Name: epoll_ctl
+ *
+ * Description:
+ *   Add (EPOLL_CTL_ADD), change (EPOLL_CTL_MOD) or remove (EPOLL_CTL_DEL) a
+ *   descriptor of the interest list.  The descriptor is registered with its
+ *   driver here, not on each epoll_wait().  Notification is edge-triggered,
+ *   so ADD and MOD must request EPOLLET.  A descriptor that is closed is
+ *   removed by epoll_detach().
+ *
+ * Return:
+ *   Zero on success.  On error, -1 is returned and errno is set:
+ *
+ *   EBADF  - epfd is not a valid epoll handle or fd is not open
+ *   EINVAL - Invalid operation or event, or EPOLLET is missing
+ *   EEXIST - EPOLL_CTL_ADD of a descriptor that is already registered
+ *   ENOENT - EPOLL_CTL_MOD or EPOLL_CTL_DEL of an unknown descriptor
+ *   ENOMEM - There was no space to allocate the entry
+ *   Any error reported by the poll method of the descriptor.
+ *
+ ****************************************************************************/
+
+int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
+{
+	FAR struct epoll_head_s *eph;
+	FAR struct epoll_entry_s *prev;
+	FAR struct epoll_entry_s *ent;
+	FAR void *obj;
+	int ret = OK;
+
+	if (fd < 0 || (op != EPOLL_CTL_DEL && (!ev || !(ev->events & EPOLLET)))) {
+		set_errno(EINVAL);
+		return ERROR;
+	}
+
+	eph = epoll_get(epfd);
+	if (!eph) {
+		return ERROR;
+	}
+
+	obj = epoll_fdobj(fd);
+	if (!obj) {
+		epoll_put(eph);
+		return ERROR;
+	}
+
+	epoll_semtake(&eph->exclsem);
+	if (eph->closed) {
+		epoll_semgive(&eph->exclsem);
+		epoll_put(eph);
+		set_errno(EBADF);
+		return ERROR;
+	}
+
+	ent = epoll_find(eph, obj, &prev);
+
+	switch (op) {
+	case EPOLL_CTL_ADD:
+		if (ent) {
+			ret = -EEXIST;
+			break;
+		}
+
+		ent = (FAR struct epoll_entry_s *)kmm_zalloc(sizeof(struct epoll_entry_s));
+		if (!ent) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		ent->pfd.fd = fd;
+		ent->pfd.sem = &eph->sem;
+		ent->pfd.events = (ev->events & ~EPOLLET) | POLLERR | POLLHUP;
+		ent->pfd.cb = epoll_notify;
+		ent->eph = eph;
+		ent->obj = obj;
+		ent->data = ev->data;
+
+		ret = epoll_arm(ent);
+		if (ret < 0) {
+			epoll_unqueue(eph, ent);
+			kmm_free(ent);
+			break;
+		}
+
+		ent->flink = eph->entries;
+		eph->entries = ent;
+		break;
+
+	case EPOLL_CTL_MOD:
+		if (!ent) {
+			ret = -ENOENT;
+			break;
+		}
+
+		epoll_disarm(ent);
+		epoll_unqueue(eph, ent);
+
+		ent->pfd.events = (ev->events & ~EPOLLET) | POLLERR | POLLHUP;
+		ent->data = ev->data;
+		ret = epoll_arm(ent);
+		break;
+
+	case EPOLL_CTL_DEL:
+		if (!ent) {
+			ret = -ENOENT;
+			break;
+		}
+
+		if (prev) {
+			prev->flink = ent->flink;
+		} else {
+			eph->entries = ent->flink;
+		}
+
+		epoll_remove(eph, ent);
+		break;
+
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	epoll_semgive(&eph->exclsem);
+	epoll_put(eph);
+
+	if (ret < 0) {
+		set_errno(-ret);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: epoll_wait
+ *
+ * Description:
+ *   Wait until at least one descriptor of the interest list is ready, a
+ *   signal is received or the timeout elapses.  Only the descriptors that
+ *   their driver reported as ready are examined.
+ *
+ * Inputs:
+ *   epfd - The handle returned by epoll_create()
+ *   evs  - The ready descriptors are returned here
+ *   maxevents - The number of entries in evs
+ *   timeout - Specifies an upper limit on the time for which epoll_wait()
+ *     will block in milliseconds.  A negative value of timeout means an
+ *     infinite timeout.
+ *
+ * Return:
+ *   The number of entries returned in evs, zero on timeout.  On error, -1
+ *   is returned and errno is set appropriately:
+ *
+ *   EBADF  - epfd is not a valid epoll handle
+ *   EINVAL - Invalid evs or maxevents
+ *   EINTR  - A signal occurred before any requested event.
+ *
+ ****************************************************************************/
+
+int epoll_wait(int epfd, FAR struct epoll_event *evs, int maxevents, int timeout)
+{
+	FAR struct epoll_head_s *eph;
+	struct timespec abstime;
+	int ret;
+	int n;
+
+	if (!evs || maxevents <= 0) {
+		set_errno(EINVAL);
+		return ERROR;
+	}
+
+	eph = epoll_get(epfd);
+	if (!eph) {
+		return ERROR;
+	}
+
+	if (timeout > 0) {
+		time_t sec = timeout / MSEC_PER_SEC;
+		uint32_t nsec = (timeout - MSEC_PER_SEC * sec) * NSEC_PER_MSEC;
+
+		(void)clock_gettime(CLOCK_REALTIME, &abstime);
+
+		abstime.tv_sec += sec;
+		abstime.tv_nsec += nsec;
+		if (abstime.tv_nsec >= NSEC_PER_SEC) {
+			abstime.tv_sec++;
+			abstime.tv_nsec -= NSEC_PER_SEC;
+		}
+	}
+
+	for (;;) {
+		epoll_semtake(&eph->exclsem);
+		n = epoll_collect(eph, evs, maxevents);
+		epoll_semgive(&eph->exclsem);
+
+		if (n > 0 || timeout == 0) {
+			break;
+		}
+
+		/* Nothing ready.  Wait for a driver to queue an entry */
+
+		if (timeout > 0) {
+			ret = sem_timedwait(&eph->sem, &abstime);
+		} else {
+			ret = sem_wait(&eph->sem);
+		}
+
+		if (ret < 0) {
+			int err = get_errno();
+
+			if (err == ETIMEDOUT) {
+				n = 0;
+				break;
+			}
+
+			/* EINTR is the only other error expected in normal operation */
+
+			epoll_put(eph);
+			set_errno(err);
+			return ERROR;
+		}
+	}
+
+	epoll_put(eph);
+	return n;
+}
+
+/****************************************************************************
+ * Name: epoll_close
+ *
+ * Description:
+ *   Release the handle.  All descriptors are removed from the interest
+ *   list and the instance is freed once no other call is using it.
+ *
+ ****************************************************************************/
+
+void epoll_close(int epfd)
+{
+	FAR struct epoll_head_s *eph = NULL;
+	FAR struct epoll_entry_s *ent;
+
+	epoll_semtake(&g_epoll_sem);
+	if (epfd >= 0 && epfd < CONFIG_FS_EPOLL_NINSTANCES) {
+		eph = g_epoll_heads[epfd];
+		g_epoll_heads[epfd] = NULL;
+	}
+
+	epoll_semgive(&g_epoll_sem);
+
+	if (!eph) {
+		set_errno(EBADF);
+		return;
+	}
+
+	/* Empty the interest list now rather than when the last reference is
+	 * released: epoll_detach() no longer finds the instance in the table.
+	 */
+
+	epoll_semtake(&eph->exclsem);
+	eph->closed = true;
+	while ((ent = eph->entries) != NULL) {
+		eph->entries = ent->flink;
+		epoll_remove(eph, ent);
+	}
+
+	epoll_semgive(&eph->exclsem);
+	epoll_put(eph);
+}
+
+/****************************************************************************
+ * Name: epoll_detach
+ *
+ * Description:
+ *   Remove the descriptor backed by obj, a struct file or struct socket,
+ *   from every interest list.  Called when the descriptor is closed, before
+ *   the driver or socket is released, so that neither keeps a pollfd of a
+ *   freed entry and no entry outlives the descriptor number it was added
+ *   with.
+ *
+ ****************************************************************************/
+
+void epoll_detach(FAR void *obj)
+{
+	FAR struct epoll_head_s *eph;
+	FAR struct epoll_entry_s *prev;
+	FAR struct epoll_entry_s *ent;
+	int epfd;
+
+	for (epfd = 0; epfd < CONFIG_FS_EPOLL_NINSTANCES; epfd++) {
+		eph = epoll_lookup(epfd);
+		if (!eph) {
+			continue;
+		}
+
+		epoll_semtake(&eph->exclsem);
+		ent = epoll_find(eph, obj, &prev);
+		if (ent) {
+			if (prev) {
+				prev->flink = ent->flink;
+			} else {
+				eph->entries = ent->flink;
+			}
+
+			epoll_remove(eph, ent);
+		}
+
+		epoll_semgive(&eph->exclsem);
+		epoll_put(eph);
+	}
+}
+
+#endif							/* CONFIG_FS_EPOLL */
@@ -191,6 +191,9 @@ static inline int poll_setup(FAR struct pollfd *fds, nfds_t nfds, sem_t *sem)
 		fds[i].sem = sem;
 		fds[i].revents = 0;
 		fds[i].priv = NULL;
+#ifdef CONFIG_FS_EPOLL
+		fds[i].cb = NULL;
+#endif
 
 		/* Check for invalid descriptors. "If the value of fd is less than 0,
 		 * events shall be ignored, and revents shall be set to 0 in that entry
@@ -264,6 +267,30 @@ static inline int poll_teardown(FAR struct pollfd *fds, nfds_t nfds, int *count,
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: poll_notify
+ *
+ * Description:
+ *   Report that an event has been set in fds->revents.  Drivers call this
+ *   in place of posting fds->sem directly so that descriptors registered
+ *   with epoll can be queued on their ready list instead.
+ *
+ ****************************************************************************/
+
+void poll_notify(FAR struct pollfd *fds)
+{
+#ifdef CONFIG_FS_EPOLL
+	if (fds->cb) {
+		fds->cb(fds);
+		return;
+	}
+#endif
+
+	if (fds->sem) {
+		poll_semgive(fds->sem);
+	}
+}
+
 /****************************************************************************
  * Name: poll
  *
@@ -135,7 +135,7 @@
 
 ssize_t sendfile(int outfd, int infd, off_t *offset, size_t count)
 {
-#if defined(CONFIG_NET_TCP) && CONFIG_NSOCKET_DESCRIPTORS > 0
+#if CONFIG_NSOCKET_DESCRIPTORS > 0
 
 	/* Check the destination file descriptor:  Is it a (probable) file
 	 * descriptor?  Check the source file:  Is it a normal file?
@@ -148,7 +148,7 @@ ssize_t sendfile(int outfd, int infd, off_t *offset, size_t count)
 		 * structure.
 		 */
 
-		filep = fs_getfilep(fd);
+		filep = fs_getfilep(infd);
 		if (!filep) {
 			/* The errno value has already been set */
 
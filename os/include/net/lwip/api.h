@@ -256,6 +256,10 @@ err_t netconn_send(struct netconn *conn, struct netbuf *buf);
 err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written);
 #define netconn_write(conn, dataptr, size, apiflags) \
 	netconn_write_partly(conn, dataptr, size, apiflags, NULL)
+struct tcp_zc;
+#if LWIP_TCP_ZEROCOPY
+err_t netconn_write_zc(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, struct tcp_zc *zc, size_t *bytes_written);
+#endif							/* LWIP_TCP_ZEROCOPY */
 err_t netconn_close(struct netconn *conn);
 err_t netconn_shutdown(struct netconn *conn, u8_t shut_rx, u8_t shut_tx);
 
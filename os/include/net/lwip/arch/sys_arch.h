@@ -39,19 +39,27 @@ typedef pid_t sys_thread_t;
 
 // === MAIL BOX ===
 
+/* The ring is updated with interrupts disabled; the semaphores are only
+ * touched when a task has to block because the ring is empty or full.
+ */
+
 struct sys_mbox {
 	u8_t is_valid;
 	u8_t id;
 	u32_t queue_size;
-	u32_t wait_send;
-	u32_t wait_fetch;
+	u32_t wait_send;			/* Posters blocked on not_full */
+	u32_t wait_fetch;			/* Fetchers blocked on not_empty */
 	u32_t front;
 	u32_t rear;
 	void *msgs[SYS_MBOX_MAXSIZE];
-	sys_sem_t mail;
-	sys_sem_t mutex;
+	sys_sem_t not_empty;
+	sys_sem_t not_full;
 };
 
 typedef struct sys_mbox sys_mbox_t;
 
+/* Fetch up to 'max' messages without blocking, returns the number fetched */
+
+u32_t sys_arch_mbox_tryfetch_n(sys_mbox_t *mbox, void **msgs, u32_t max);
+
 #endif							/* __ARCH_SYS_ARCH_H__ */
@@ -88,8 +88,18 @@
 #define LWIP_TCP                        1
 #define TCP_TTL                         255
 #define LWIP_TCP_KEEPALIVE              1
-#define LWIP_TCPIP_CORE_LOCKING_INPUT   0
+
+#ifdef CONFIG_NET_LWIP_CORE_LOCKING
+#define LWIP_TCPIP_CORE_LOCKING         1
+#else
 #define LWIP_TCPIP_CORE_LOCKING         0
+#endif
+
+#ifdef CONFIG_NET_LWIP_CORE_LOCKING_INPUT
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   1
+#else
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   0
+#endif
 
 /* TCP Maximum segment size. */
 #define TCP_MSS                         (1500 - 40)	/* TCP_MSS = (Ethernet MTU - IP header size - TCP header size) */
@@ -103,7 +113,36 @@
 //#define TCP_SND_QUEUELEN                (4*TCP_SND_BUF/TCP_MSS)
 
 /* TCP receive window. */
+#ifdef CONFIG_NET_LWIP_WND_SCALE
+#define LWIP_WND_SCALE                  1
+#define TCP_RCV_SCALE                   CONFIG_NET_LWIP_TCP_RCV_SCALE
+#define TCP_WND                         (CONFIG_NET_LWIP_TCP_WND_SEGMENTS*TCP_MSS)
+#else
+#define LWIP_WND_SCALE                  0
 #define TCP_WND                         (40*TCP_MSS)
+#endif
+
+#ifdef CONFIG_NET_LWIP_TCP_SACK
+#define LWIP_TCP_SACK                   1
+#else
+#define LWIP_TCP_SACK                   0
+#endif
+
+#ifdef CONFIG_NET_LWIP_TCP_ZEROCOPY
+#define LWIP_TCP_ZEROCOPY               1
+#define MEMP_NUM_TCP_ZC_PBUF            CONFIG_NET_LWIP_TCP_ZC_PBUFS
+#else
+#define LWIP_TCP_ZEROCOPY               0
+#endif
+
+/* ---------- Checksum options ---------- */
+/* Compute the TCP checksum of transmitted data while copying it into the
+   segment pbufs instead of walking the segment again in tcp_output.
+   lwip_sendto() only copies UDP data when LWIP_NETIF_TX_SINGLE_PBUF is
+   set, and then sums it in the same pass. Otherwise the datagram refers
+   to the user buffer and udp_sendto() sums it once, with no copy to fuse
+   the checksum into. */
+#define LWIP_CHECKSUM_ON_COPY           1
 
 /* ---------- UDP options ---------- */
 #define LWIP_UDP                        1
@@ -284,6 +284,15 @@
 #define MEMP_NUM_TCP_SEG                16
 #endif
 
+/**
+ * MEMP_NUM_TCP_ZC_PBUF: the number of pbufs referencing zero-copy data
+ * passed to tcp_write_zc() that can be queued at the same time.
+ * (requires the LWIP_TCP_ZEROCOPY option)
+ */
+#ifndef MEMP_NUM_TCP_ZC_PBUF
+#define MEMP_NUM_TCP_ZC_PBUF            MEMP_NUM_TCP_SEG
+#endif
+
 /**
  * MEMP_NUM_REASSDATA: the number of IP packets simultaneously queued for
  * reassembly (whole packets, not fragments!)
@@ -1023,6 +1032,48 @@
 #define LWIP_TCP_TIMESTAMPS             0
 #endif
 
+/**
+ * LWIP_WND_SCALE==1: support the TCP window scale option (RFC 7323).
+ * When enabled, TCP_WND may be larger than 0xffff and TCP_RCV_SCALE
+ * is the shift count announced for our receive window. The window
+ * stays limited to 0xffff on connections where the remote host does
+ * not send the option.
+ */
+#ifndef LWIP_WND_SCALE
+#define LWIP_WND_SCALE                  0
+#endif
+
+#ifndef TCP_RCV_SCALE
+#define TCP_RCV_SCALE                   0
+#endif
+
+/**
+ * LWIP_TCP_SACK==1: support TCP selective acknowledgements (RFC 2018).
+ * Out-of-order data received is reported in SACK blocks on ACKs, and
+ * SACK blocks received are used to retransmit every lost segment of a
+ * window in one round trip instead of one segment per round trip.
+ */
+#ifndef LWIP_TCP_SACK
+#define LWIP_TCP_SACK                   0
+#endif
+
+/**
+ * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK blocks sent on an
+ * ACK (at most 4 fit into the TCP header, 3 with timestamps).
+ */
+#ifndef LWIP_TCP_MAX_SACK_NUM
+#define LWIP_TCP_MAX_SACK_NUM           4
+#endif
+
+/**
+ * LWIP_TCP_ZEROCOPY==1: Support tcp_write_zc(), which queues caller owned
+ * data by reference and reports when the stack has released it, and the
+ * zero-copy socket calls lwip_send_ref() and lwip_recv_loan().
+ */
+#ifndef LWIP_TCP_ZEROCOPY
+#define LWIP_TCP_ZEROCOPY               0
+#endif
+
 /**
  * TCP_WND_UPDATE_THRESHOLD: difference in window to trigger an
  * explicit window update
@@ -1230,6 +1281,14 @@
 #define TCPIP_MBOX_SIZE                 0
 #endif
 
+/**
+ * TCPIP_MBOX_BATCH: The maximum number of messages the tcpip thread
+ * takes from its mailbox in one pass after waking up for a message.
+ */
+#ifndef TCPIP_MBOX_BATCH
+#define TCPIP_MBOX_BATCH                8
+#endif
+
 /**
  * SLIPIF_THREAD_NAME: The name assigned to the slipif_loop thread.
  */
@@ -1347,16 +1406,20 @@
    ----------------------------------------------
 */
 /**
- * LWIP_TCPIP_CORE_LOCKING: (EXPERIMENTAL!)
- * Don't use it if you're not an active lwIP project member
+ * LWIP_TCPIP_CORE_LOCKING==1: netconn and socket calls lock the stack core
+ * (lock_tcpip_core) and run in the calling thread instead of being passed
+ * to tcpip_thread.  tcpip_thread holds the lock while processing messages
+ * and timeouts.  sys_mutex_t should inherit priority.
  */
 #ifndef LWIP_TCPIP_CORE_LOCKING
 #define LWIP_TCPIP_CORE_LOCKING         0
 #endif
 
 /**
- * LWIP_TCPIP_CORE_LOCKING_INPUT: (EXPERIMENTAL!)
- * Don't use it if you're not an active lwIP project member
+ * LWIP_TCPIP_CORE_LOCKING_INPUT==1: tcpip_input() processes the packet
+ * under the core lock in the calling thread instead of passing it to
+ * tcpip_thread.  Requires LWIP_TCPIP_CORE_LOCKING; tcpip_input() must then
+ * not be called from interrupt context.
  */
 #ifndef LWIP_TCPIP_CORE_LOCKING_INPUT
 #define LWIP_TCPIP_CORE_LOCKING_INPUT   0
@@ -235,10 +235,18 @@ int lwip_send(int s, const void *dataptr, size_t size, int flags);
 int lwip_sendto(int s, const void *dataptr, size_t size, int flags, const struct sockaddr *to, socklen_t tolen);
 int lwip_socket(int domain, int type, int protocol);
 int lwip_write(int s, const void *dataptr, size_t size);
+#if LWIP_TCP_ZEROCOPY
+struct pbuf;
+struct tcp_zc;
+int lwip_send_ref(int s, const void *dataptr, size_t size, int flags, struct tcp_zc *zc);
+int lwip_recv_loan(int s, struct pbuf **loan, int flags);
+void lwip_recv_loan_free(int s, struct pbuf *loan);
+#endif							/* LWIP_TCP_ZEROCOPY */
 #if LWIP_SELECT
 int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset, struct timeval *timeout);
 #endif
 int lwip_poll(int fd, struct pollfd *fds, bool setup);
+int lwip_sock_poll(int fd, struct socket *sock, struct pollfd *fds, bool setup);
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
 
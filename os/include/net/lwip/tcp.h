@@ -124,6 +124,26 @@ typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
  */
 typedef void (*tcp_err_fn)(void *arg, err_t err);
 
+#if LWIP_TCP_ZEROCOPY
+/** Function prototype for zero-copy completion callbacks. Called when the
+ * stack no longer references the data passed to tcp_write_zc(), i.e. it has
+ * been ACKed or the connection was aborted. May be called from the tcpip
+ * thread or from the thread calling tcp_zc_release().
+ *
+ * @param arg Additional argument passed to tcp_zc_init()
+ */
+typedef void (*tcp_zc_fn)(void *arg);
+
+/** Caller owned descriptor of data queued with tcp_write_zc(). The data
+ * must not be changed or freed before 'done' has been called. */
+struct tcp_zc {
+	tcp_zc_fn done;
+	void *arg;
+	/* references held by queued pbufs plus the one of the writer */
+	u16_t ref;
+};
+#endif							/* LWIP_TCP_ZEROCOPY */
+
 /** Function prototype for tcp connected callback functions. Called when a pcb
  * is connected to the remote side after initiating a connection attempt by
  * calling tcp_connect().
@@ -138,6 +158,31 @@ typedef void (*tcp_err_fn)(void *arg, err_t err);
  */
 typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *tpcb, err_t err);
 
+#if LWIP_WND_SCALE
+/* Windows are kept unscaled in the pcb and shifted when a header is
+   read or written. */
+typedef u32_t tcpwnd_size_t;
+#define TCPWNDSIZE_F             U32_F
+#define RCV_WND_SCALE(pcb, wnd)  ((wnd) >> (pcb)->rcv_scale)
+#define SND_WND_SCALE(pcb, wnd)  ((tcpwnd_size_t)(wnd) << (pcb)->snd_scale)
+#define TCPWND_MIN16(x)          ((u16_t)LWIP_MIN((x), 0xFFFF))
+#define TCP_WND_MAX(pcb)         ((tcpwnd_size_t)(((pcb)->flags & TF_WND_SCALE) ? TCP_WND : TCPWND_MIN16(TCP_WND)))
+#else							/* LWIP_WND_SCALE */
+typedef u16_t tcpwnd_size_t;
+#define TCPWNDSIZE_F             U16_F
+#define RCV_WND_SCALE(pcb, wnd)  (wnd)
+#define SND_WND_SCALE(pcb, wnd)  (wnd)
+#define TCPWND_MIN16(x)          ((u16_t)(x))
+#define TCP_WND_MAX(pcb)         TCP_WND
+#endif							/* LWIP_WND_SCALE */
+
+/* pcb->flags needs more than 8 bits for the negotiated options */
+#if LWIP_WND_SCALE || LWIP_TCP_SACK
+typedef u16_t tcpflags_t;
+#else
+typedef u8_t tcpflags_t;
+#endif
+
 enum tcp_state {
 	CLOSED = 0,
 	LISTEN = 1,
@@ -188,15 +233,21 @@ struct tcp_pcb {
 	/* ports are in host byte order */
 	u16_t remote_port;
 
-	u8_t flags;
-#define TF_ACK_DELAY   ((u8_t)0x01U)	/* Delayed ACK. */
-#define TF_ACK_NOW     ((u8_t)0x02U)	/* Immediate ACK. */
-#define TF_INFR        ((u8_t)0x04U)	/* In fast recovery. */
-#define TF_TIMESTAMP   ((u8_t)0x08U)	/* Timestamp option enabled */
-#define TF_RXCLOSED    ((u8_t)0x10U)	/* rx closed by tcp_shutdown */
-#define TF_FIN         ((u8_t)0x20U)	/* Connection was closed locally (FIN segment enqueued). */
-#define TF_NODELAY     ((u8_t)0x40U)	/* Disable Nagle algorithm */
-#define TF_NAGLEMEMERR ((u8_t)0x80U)	/* nagle enabled, memerr, try to output to prevent delayed ACK to happen */
+	tcpflags_t flags;
+#define TF_ACK_DELAY   ((tcpflags_t)0x01U)	/* Delayed ACK. */
+#define TF_ACK_NOW     ((tcpflags_t)0x02U)	/* Immediate ACK. */
+#define TF_INFR        ((tcpflags_t)0x04U)	/* In fast recovery. */
+#define TF_TIMESTAMP   ((tcpflags_t)0x08U)	/* Timestamp option enabled */
+#define TF_RXCLOSED    ((tcpflags_t)0x10U)	/* rx closed by tcp_shutdown */
+#define TF_FIN         ((tcpflags_t)0x20U)	/* Connection was closed locally (FIN segment enqueued). */
+#define TF_NODELAY     ((tcpflags_t)0x40U)	/* Disable Nagle algorithm */
+#define TF_NAGLEMEMERR ((tcpflags_t)0x80U)	/* nagle enabled, memerr, try to output to prevent delayed ACK to happen */
+#if LWIP_WND_SCALE
+#define TF_WND_SCALE   ((tcpflags_t)0x0100U)	/* Window scale option enabled */
+#endif
+#if LWIP_TCP_SACK
+#define TF_SACK        ((tcpflags_t)0x0200U)	/* SACK option enabled */
+#endif
 
 	/* the rest of the fields are in host byte order
 	   as we have to do some math with them */
@@ -208,8 +259,8 @@ struct tcp_pcb {
 
 	/* receiver variables */
 	u32_t rcv_nxt;			/* next seqno expected */
-	u16_t rcv_wnd;			/* receiver window available */
-	u16_t rcv_ann_wnd;		/* receiver window to announce */
+	tcpwnd_size_t rcv_wnd;	/* receiver window available */
+	tcpwnd_size_t rcv_ann_wnd;	/* receiver window to announce */
 	u32_t rcv_ann_right_edge;	/* announced right edge of window */
 
 	/* Retransmission timer. */
@@ -230,16 +281,16 @@ struct tcp_pcb {
 	u32_t lastack;			/* Highest acknowledged seqno. */
 
 	/* congestion avoidance/control variables */
-	u16_t cwnd;
-	u16_t ssthresh;
+	tcpwnd_size_t cwnd;
+	tcpwnd_size_t ssthresh;
 
 	/* sender variables */
 	u32_t snd_nxt;			/* next new seqno to be sent */
 	u32_t snd_wl1, snd_wl2;	/* Sequence and acknowledgement numbers of last
 								   window update. */
 	u32_t snd_lbb;			/* Sequence number of next byte to be buffered. */
-	u16_t snd_wnd;			/* sender window */
-	u16_t snd_wnd_max;		/* the maximum sender window announced by the remote host */
+	tcpwnd_size_t snd_wnd;	/* sender window */
+	tcpwnd_size_t snd_wnd_max;	/* the maximum sender window announced by the remote host */
 
 	u16_t acked;
 
@@ -280,6 +331,16 @@ struct tcp_pcb {
 	u32_t ts_recent;
 #endif							/* LWIP_TCP_TIMESTAMPS */
 
+#if LWIP_WND_SCALE
+	u8_t snd_scale;			/* shift applied to windows received */
+	u8_t rcv_scale;			/* shift applied to windows sent */
+#endif							/* LWIP_WND_SCALE */
+
+#if LWIP_TCP_SACK
+	u32_t recover;			/* snd_nxt when SACK loss recovery started */
+	u32_t rcv_sack_last;	/* seqno of the last out-of-order segment queued */
+#endif							/* LWIP_TCP_SACK */
+
 	/* idle time before KEEPALIVE is sent */
 	u32_t keep_idle;
 #if LWIP_TCP_KEEPALIVE
@@ -367,6 +428,11 @@ err_t tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 #define TCP_WRITE_FLAG_MORE 0x02
 
 err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags);
+#if LWIP_TCP_ZEROCOPY
+void tcp_zc_init(struct tcp_zc *zc, tcp_zc_fn done, void *arg);
+void tcp_zc_release(struct tcp_zc *zc);
+err_t tcp_write_zc(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags, struct tcp_zc *zc);
+#endif							/* LWIP_TCP_ZEROCOPY */
 
 void tcp_setprio(struct tcp_pcb *pcb, u8_t prio);
 
@@ -296,12 +296,30 @@ struct tcp_seg {
 #define TF_SEG_OPTS_TS          (u8_t)0x02U	/* Include timestamp option. */
 #define TF_SEG_DATA_CHECKSUMMED (u8_t)0x04U	/* ALL data (not the header) is
 											   checksummed into 'chksum' */
+#define TF_SEG_OPTS_WND_SCALE   (u8_t)0x08U	/* Include window scale option. */
+#define TF_SEG_OPTS_SACK_PERM   (u8_t)0x10U	/* Include SACK permitted option. */
+#define TF_SEG_SACKED           (u8_t)0x20U	/* Covered by a SACK block received. */
+#define TF_SEG_RETRANSMITTED    (u8_t)0x40U	/* Retransmitted during the current
+											   SACK loss recovery */
 	struct tcp_hdr *tcphdr;	/* the TCP header */
 };
 
+#if LWIP_TCP_ZEROCOPY
+/* A PBUF_REF pbuf referencing data passed to tcp_write_zc() */
+struct tcp_zc_pbuf {
+	struct pbuf_custom pc;
+	struct tcp_zc *zc;
+};
+#endif							/* LWIP_TCP_ZEROCOPY */
+
 #define LWIP_TCP_OPT_LENGTH(flags)              \
-	(flags & TF_SEG_OPTS_MSS ? 4  : 0) +        \
-	(flags & TF_SEG_OPTS_TS  ? 12 : 0)
+	((flags) & TF_SEG_OPTS_MSS       ? 4  : 0) + \
+	((flags) & TF_SEG_OPTS_TS        ? 12 : 0) + \
+	((flags) & TF_SEG_OPTS_WND_SCALE ? 4  : 0) + \
+	((flags) & TF_SEG_OPTS_SACK_PERM ? 4  : 0)
+
+/** Length of a SACK option carrying n blocks (including 2 NOPs for alignment) */
+#define LWIP_TCP_SACK_OPT_LENGTH(n)  (4 + 8 * (n))
 
 /** This returns a TCP header option for MSS in an u32_t */
 #define TCP_BUILD_MSS_OPTION(mss) htonl(0x02040000 | ((mss) & 0xFFFF))
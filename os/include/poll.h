@@ -140,6 +140,9 @@ struct pollfd {
 #ifdef CONFIG_NET_LWIP
 	FAR void *scb;
 #endif
+#ifdef CONFIG_FS_EPOLL
+	CODE void (*cb)(FAR struct pollfd *fds);	/* If non-NULL, called instead of posting sem */
+#endif
 };
 
 /****************************************************************************
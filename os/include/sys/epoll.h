@@ -0,0 +1,165 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/**
+ * @defgroup EPOLL_KERNEL EPOLL
+ * @ingroup KERNEL
+ *
+ * @{
+ */
+
+/// @file epoll.h
+/// @brief I/O event notification APIs
+
+#ifndef __INCLUDE_SYS_EPOLL_H
+#define __INCLUDE_SYS_EPOLL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+#include <poll.h>
+
+#ifdef CONFIG_FS_EPOLL
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/* Events reported by epoll_wait().  These are the poll() event bits.
+ * Notification is edge-triggered only, and EPOLL_CTL_ADD and EPOLL_CTL_MOD
+ * fail with EINVAL unless EPOLLET is requested: a descriptor is reported
+ * once for the events its driver signalled since the previous
+ * epoll_wait(), and ADD and MOD report the events already in effect.
+ */
+
+#define EPOLLIN         POLLIN
+#define EPOLLPRI        POLLPRI
+#define EPOLLOUT        POLLOUT
+#define EPOLLRDNORM     POLLRDNORM
+#define EPOLLWRNORM     POLLWRNORM
+#define EPOLLERR        POLLERR
+#define EPOLLHUP        POLLHUP
+
+#define EPOLLET         0x80		/* Edge-triggered notification, required */
+
+/* Operations for epoll_ctl() */
+
+#define EPOLL_CTL_ADD   1		/* Add a descriptor to the interest list */
+#define EPOLL_CTL_DEL   2		/* Remove a descriptor from the interest list */
+#define EPOLL_CTL_MOD   3		/* Change the events of a registered descriptor */
+
+/****************************************************************************
+ * Public Type Definitions
+ ****************************************************************************/
+
+typedef union epoll_data {
+	FAR void *ptr;
+	int fd;
+	uint32_t u32;
+} epoll_data_t;
+
+struct epoll_event {
+	pollevent_t events;			/* Requested events, or the events reported */
+	epoll_data_t data;			/* Returned unchanged by epoll_wait() */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/**
+ * @ingroup EPOLL_KERNEL
+ * @brief Create an epoll instance
+ * @details [SYSTEM CALL API]
+ *   The returned handle is not a file descriptor: it can only be passed
+ *   to epoll_ctl(), epoll_wait() and epoll_close().  At most
+ *   CONFIG_FS_EPOLL_NINSTANCES instances exist at a time.
+ * @param[in] size ignored, must be greater than zero
+ * @return On success, the epoll handle. On failure, -1 is returned and
+ *   errno is set appropriately.
+ * @since Tizen RT v1.1
+ */
+int epoll_create(int size);
+
+/**
+ * @ingroup EPOLL_KERNEL
+ * @brief Add, modify or remove a descriptor of the interest list
+ * @details [SYSTEM CALL API]
+ *   A descriptor is registered with its driver or socket once, when it is
+ *   added.  Closing it removes it from every interest list.
+ * @param[in] epfd the handle returned by epoll_create()
+ * @param[in] op EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL
+ * @param[in] fd the file or socket descriptor
+ * @param[in] ev the events to monitor, which must include EPOLLET, and the
+ *   data to return, ignored for EPOLL_CTL_DEL
+ * @return On success, 0 is returned. On failure, -1 is returned and errno
+ *   is set appropriately, EBADF if epfd or fd is not a valid handle and
+ *   EINVAL if EPOLLET is missing.
+ * @since Tizen RT v1.1
+ */
+int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev);
+
+/**
+ * @ingroup EPOLL_KERNEL
+ * @brief Wait for events on an epoll instance
+ * @details [SYSTEM CALL API]
+ *   Only the descriptors that became ready are examined.  A descriptor is
+ *   not reported again until its driver signals a new event, so read or
+ *   write until it would block before waiting again.
+ * @param[in] epfd the handle returned by epoll_create()
+ * @param[out] evs the ready descriptors are returned here
+ * @param[in] maxevents the number of entries in evs
+ * @param[in] timeout upper limit in milliseconds, negative to wait forever
+ * @return The number of entries stored in evs, 0 on timeout. On failure,
+ *   -1 is returned and errno is set appropriately, EBADF if epfd is not a
+ *   valid handle.
+ * @since Tizen RT v1.1
+ */
+int epoll_wait(int epfd, FAR struct epoll_event *evs, int maxevents, int timeout);
+
+/**
+ * @ingroup EPOLL_KERNEL
+ * @brief Release an epoll instance
+ * @details [SYSTEM CALL API]
+ *   Any descriptors still in the interest list are removed.
+ * @param[in] epfd the handle returned by epoll_create()
+ * @return none
+ * @since Tizen RT v1.1
+ */
+void epoll_close(int epfd);
+
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
+#endif							/* CONFIG_FS_EPOLL */
+#endif							/* __INCLUDE_SYS_EPOLL_H */
+/**
+ * @} */
@@ -291,9 +291,19 @@
 
 #if defined(CONFIG_NET_SENDFILE)
 #define SYS_sendfile,                  __SYS_sendfile
-#define __SYS_mountpoint               (__SYS_sendfile+1)
+#define __SYS_epoll                    (__SYS_sendfile+1)
 #else
-#define __SYS_mountpoint               __SYS_sendfile
+#define __SYS_epoll                    __SYS_sendfile
+#endif
+
+#ifdef CONFIG_FS_EPOLL
+#define SYS_epoll_create               (__SYS_epoll+0)
+#define SYS_epoll_ctl                  (__SYS_epoll+1)
+#define SYS_epoll_wait                 (__SYS_epoll+2)
+#define SYS_epoll_close                (__SYS_epoll+3)
+#define __SYS_mountpoint               (__SYS_epoll+4)
+#else
+#define __SYS_mountpoint               __SYS_epoll
 #endif
 
 #if !defined(CONFIG_DISABLE_MOUNTPOINT)
@@ -827,6 +827,36 @@ int file_fsync(FAR struct file *filep);
 int file_vfcntl(FAR struct file *filep, int cmd, va_list ap);
 #endif
 
+/* fs/fs_poll.c *************************************************************/
+/****************************************************************************
+ * Name: poll_notify
+ *
+ * Description:
+ *   Called by drivers and sockets to report that an event has been set in
+ *   fds->revents.  Wakes up the poll() waiter or, for a descriptor that is
+ *   registered with epoll, queues it on the ready list of its epoll
+ *   instance.  May be called from interrupt handlers.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_DISABLE_POLL
+void poll_notify(FAR struct pollfd *fds);
+#endif
+
+/* fs/fs_epoll.c ************************************************************/
+/****************************************************************************
+ * Name: epoll_detach
+ *
+ * Description:
+ *   Remove the descriptor backed by obj, a struct file or struct socket,
+ *   from every epoll interest list.  Called when the descriptor is closed.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_EPOLL
+void epoll_detach(FAR void *obj);
+#endif
+
 /* drivers/dev_null.c *******************************************************/
 /****************************************************************************
  * Name: devnull_register
@@ -69,6 +69,13 @@
 #define SMART_DEBUG_CMD_SET_DEBUG_LEVEL   1
 #define SMART_DEBUG_CMD_SHOW_LOGMAP       2
 
+/* Number of buckets in the garbage collection write stall histogram.
+ * Bucket n counts stalls shorter than 4^n msec, the last bucket counts
+ * all longer stalls.
+ */
+
+#define SMART_GC_STALL_BUCKETS            8
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -111,6 +118,23 @@ struct mtd_smart_procfs_data_s {
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 	uint32_t uneven_wearcount;	/* Number of uneven block erases */
 #endif
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+	uint32_t map_lookups;		/* Number of logical sector lookups */
+	uint32_t map_hits;			/* Lookups resolved by the sector cache */
+	uint32_t map_seghits;		/* Lookups resolved by a resident map segment */
+	uint32_t map_unused;		/* Lookups of sectors not in use */
+	uint32_t map_segloads;		/* Map segments rebuilt from the volume */
+	uint32_t map_reads;			/* Sector header reads to rebuild segments */
+	uint16_t cacheentries;		/* Number of valid sector cache entries */
+#endif
+	uint32_t gc_blocks;			/* Erase blocks reclaimed by garbage collection */
+	uint32_t gc_sectors;		/* Live sectors moved by garbage collection */
+#ifdef CONFIG_MTD_SMART_GC_BACKGROUND
+	uint32_t gc_idleblocks;		/* Erase blocks reclaimed in the background */
+	uint32_t gc_idlesectors;	/* Live sectors moved in the background */
+#endif
+	uint32_t gc_maxstall;		/* Longest write stall in collection (msec) */
+	uint32_t gc_stalls[SMART_GC_STALL_BUCKETS];	/* Write stall histogram */
 };
 
 /* The following defines debug command data passed from the procfs layer to
@@ -19,6 +19,8 @@
 #ifndef __OS_INCLUDE_TINYARA_LOGM_H
 #define __OS_INCLUDE_TINYARA_LOGM_H
 
+#include <tinyara/config.h>
+#include <stdint.h>
 #include <stdarg.h>
 
 #define LOGM_DEF_PRIORITY (7)
@@ -36,6 +38,16 @@ enum logm_loglevels_e {
 	LOGM_OFF  /* Is this needed? */
 };
 
+#ifdef CONFIG_LOGM_BINARY
+/* Counters of the binary log ring */
+
+struct logm_stats_s {
+	uint32_t dropped;	/* Messages dropped because the ring was full */
+	uint32_t highwater;	/* Largest number of bytes used in the ring */
+	uint32_t size;		/* Size of the ring in bytes */
+};
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 #define EXTERN extern "C"
@@ -48,6 +60,9 @@ extern "C"
 void logm_start(void);
 int logm_internal(int priority, const char *fmt, va_list valst);
 int logm(int flag, int mod, int priority, const char *fmt, ...);
+#ifdef CONFIG_LOGM_BINARY
+int logm_getstats(struct logm_stats_s *stats);
+#endif
 
 #undef EXTERN
 #if defined(__cplusplus)
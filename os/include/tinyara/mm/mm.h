@@ -176,6 +176,22 @@
 #define MM_MAX_CHUNK     (1 << MM_MAX_SHIFT)
 #define MM_NNODES        (MM_MAX_SHIFT - MM_MIN_SHIFT + 1)
 
+/* TLSF (two-level segregated fit) mode.  Each of the MM_NNODES power-of-two
+ * first level classes is split into MM_TLSF_SLCOUNT linear second level
+ * classes.  A bitmap of non-empty first level classes and one bitmap of
+ * non-empty second level classes per first level class let a suitable free
+ * list be located with a couple of find-first-set operations.
+ */
+
+#ifdef CONFIG_MM_TLSF
+#define MM_TLSF_SLSHIFT  CONFIG_MM_TLSF_SLSHIFT
+#define MM_TLSF_SLCOUNT  (1 << MM_TLSF_SLSHIFT)
+
+#if MM_TLSF_SLSHIFT > MM_MIN_SHIFT
+#error CONFIG_MM_TLSF_SLSHIFT must not be larger than MM_MIN_SHIFT
+#endif
+#endif
+
 #define MM_GRAN_MASK     (MM_MIN_CHUNK-1)
 #define MM_ALIGN_UP(a)   (((a) + MM_GRAN_MASK) & ~MM_GRAN_MASK)
 #define MM_ALIGN_DOWN(a) ((a) & ~MM_GRAN_MASK)
@@ -259,8 +275,10 @@ struct mm_allocnode_s {
 
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 #define SIZEOF_MM_ALLOCNODE   16	/* 8 Bytes added for storing memory allocation info  */
-#else
+#elif UINTPTR_MAX <= UINT32_MAX
 #define SIZEOF_MM_ALLOCNODE   8
+#else
+#define SIZEOF_MM_ALLOCNODE   16	/* 64-bit hosts (e.g. tools/heapbench) */
 #endif
 #endif
 
@@ -289,6 +307,36 @@ struct mm_freenode_s {
 #define CHECK_FREENODE_SIZE \
 	DEBUGASSERT(sizeof(struct mm_freenode_s) == SIZEOF_MM_FREENODE)
 
+#ifdef CONFIG_MM_CACHE
+/* Small object caches.  Freed chunks of up to CONFIG_MM_CACHE_MAXSIZE user
+ * bytes are kept, still marked allocated, on per-size-class free lists in
+ * front of the heap so that most small allocations never take the heap
+ * semaphore.  There is one set of lists per priority band so that tasks of
+ * very different priorities do not contend for, or drain, the same lists.
+ * The link to the next cached chunk is stored in the chunk payload.
+ */
+
+#define MM_CACHE_NCLASSES \
+	(MM_ALIGN_UP(CONFIG_MM_CACHE_MAXSIZE + SIZEOF_MM_ALLOCNODE) >> MM_MIN_SHIFT)
+#define MM_CACHE_CLASSSIZE(c) (((c) + 1) << MM_MIN_SHIFT)
+
+struct mm_cacheband_s {
+	FAR void *head[MM_CACHE_NCLASSES];	/* Cached chunk payloads */
+	uint16_t count[MM_CACHE_NCLASSES];	/* Number of chunks in each list */
+};
+
+struct mm_cachestat_s {
+	uint32_t hits;					/* Allocations served from the cache */
+	uint32_t misses;				/* Allocations that needed a refill */
+	uint32_t drains;				/* Batches returned to the heap */
+};
+
+struct mm_cache_s {
+	struct mm_cacheband_s band[CONFIG_MM_CACHE_NBANDS];
+	struct mm_cachestat_s stat[MM_CACHE_NCLASSES];
+};
+#endif
+
 /* This describes one heap (possibly with multiple regions) */
 
 struct mm_heap_s {
@@ -317,12 +365,31 @@ struct mm_heap_s {
 	int mm_nregions;
 #endif
 
+#ifdef CONFIG_MM_CACHE
+	/* Small object caches in front of this heap */
+
+	struct mm_cache_s mm_cache;
+#endif
+
+#ifdef CONFIG_MM_TLSF
+	/* Free nodes are kept in unordered, NULL terminated doubly linked lists,
+	 * one per (first level, second level) size class.  A set bit in
+	 * mm_flbitmap means that mm_slbitmap[fl] is non-zero; a set bit in
+	 * mm_slbitmap[fl] means that the matching mm_freelist[fl][sl] is not
+	 * empty.
+	 */
+
+	uint32_t mm_flbitmap;
+	uint32_t mm_slbitmap[MM_NNODES];
+	FAR struct mm_freenode_s *mm_freelist[MM_NNODES][MM_TLSF_SLCOUNT];
+#else
 	/* All free nodes are maintained in a doubly linked list.  This
 	 * array provides some hooks into the list at various points to
 	 * speed searches for free nodes.
 	 */
 
 	struct mm_freenode_s mm_nodelist[MM_NNODES];
+#endif
 };
 
 /****************************************************************************
@@ -579,13 +646,32 @@ int kmm_mallinfo(struct mallinfo *info);
 
 void mm_shrinkchunk(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node, size_t size);
 
-/* Functions contained in mm_addfreechunk.c *********************************/
+/* Functions contained in mm_addfreechunk.c (or mm_tlsf.c) *****************/
 
 void mm_addfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
 
+/* Functions contained in mm_delfreechunk.c (or mm_tlsf.c) *****************/
+
+void mm_delfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
+
+/* Functions contained in mm_findfreechunk.c (or mm_tlsf.c) ****************/
+
+FAR struct mm_freenode_s *mm_findfreechunk(FAR struct mm_heap_s *heap, size_t size);
+
+/* Functions contained in mm_cache.c ***************************************/
+
+#ifdef CONFIG_MM_CACHE
+void mm_cache_initialize(FAR struct mm_heap_s *heap);
+FAR void *mm_cache_alloc(FAR struct mm_heap_s *heap, size_t size);
+bool mm_cache_free(FAR struct mm_heap_s *heap, FAR void *mem);
+void mm_cache_flush(FAR struct mm_heap_s *heap);
+#endif
+
 /* Functions contained in mm_size2ndx.c.c ***********************************/
 
+#ifndef CONFIG_MM_TLSF
 int mm_size2ndx(size_t size);
+#endif
 
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 /* Functions contained in kmm_mallinfo.c . Used to display memory allocation details */
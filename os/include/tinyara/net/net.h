@@ -107,6 +107,8 @@ typedef uint16_t socktimeo_t;
  * descriptor.
  */
 
+struct lwip_select_cb;
+
 struct socket {
 	/** sockets currently are built on netconns, each socket has one netconn */
 	struct netconn *conn;
@@ -126,6 +128,8 @@ struct socket {
 	int err;
 	/** counter of how many threads are waiting for this socket using select */
 	int select_waiting;
+	/** poll and epoll waiters of this socket, woken up by event_callback() */
+	struct lwip_select_cb *select_cb;
 };
 
 /* This defines a list of sockets indexed by the socket descriptor */
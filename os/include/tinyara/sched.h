@@ -518,6 +518,9 @@ struct tcb_s {
 	/* POSIX Semaphore Control Fields ******************************************** */
 
 	sem_t *waitsem;				/* Semaphore ID waiting on             */
+#ifdef CONFIG_SEM_WAITHASH
+	dq_entry_t waitlink;		/* Link in the semaphore wait queue    */
+#endif
 
 	/* POSIX Signal Control Fields *********************************************** */
 
@@ -61,6 +61,7 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <semaphore.h>
 #include <queue.h>
 
@@ -308,8 +309,85 @@ struct work_s {
 	FAR void *arg;				/* Callback argument */
 	systime_t qtime;			/* Time work queued */
 	systime_t delay;			/* Delay until work performed */
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	FAR void *wqueue;			/* Queue holding the work, NULL if not queued */
+#endif
 };
 
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/* These helpers are shared by the kernel and user-mode work queue
+ * implementations.  They are not part of the work queue API.
+ */
+
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+/****************************************************************************
+ * Name: work_remaining
+ *
+ * Description:
+ *   Return the number of clock ticks until the delayed work expires, or
+ *   zero if it has already expired.
+ *
+ ****************************************************************************/
+
+static inline systime_t work_remaining(FAR struct work_s *work, systime_t now)
+{
+	systime_t elapsed = now - work->qtime;
+
+	return elapsed >= work->delay ? 0 : work->delay - elapsed;
+}
+
+/****************************************************************************
+ * Name: work_isqueued
+ *
+ * Description:
+ *   Return true if the work is in the given queue.  The wqueue field is
+ *   only set while the work is queued, so a structure that was never
+ *   zeroed is recognized without searching the queue.
+ *
+ ****************************************************************************/
+
+static inline bool work_isqueued(FAR void *wqueue, FAR struct work_s *work)
+{
+	return work->worker != NULL && work->wqueue == wqueue;
+}
+
+/****************************************************************************
+ * Name: work_expire
+ *
+ * Description:
+ *   Move the delayed work that has expired from the delayed list q to the
+ *   tail of the ready FIFO.  The delayed list is kept in order of
+ *   expiration so this stops at the first entry that has not expired.
+ *   The caller must have exclusive access to the queue.
+ *
+ ****************************************************************************/
+
+static inline void work_expire(FAR struct dq_queue_s *q, FAR struct dq_queue_s *ready)
+{
+	FAR struct work_s *work;
+	systime_t now;
+
+	work = (FAR struct work_s *)q->head;
+	if (work == NULL) {
+		return;
+	}
+
+	now = clock_systimer();
+	while (work != NULL && work_remaining(work, now) == 0) {
+		(void)dq_remfirst(q);
+
+		/* A zero delay marks the work as being in the ready FIFO */
+
+		work->delay = 0;
+		dq_addlast((FAR dq_entry_t *)work, ready);
+		work = (FAR struct work_s *)q->head;
+	}
+}
+#endif							/* CONFIG_SCHED_WORKQUEUE_DEADLINE */
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -358,6 +436,11 @@ int work_usrstart(void);
  *   from the queue, or (2) work_cancel() has been called to cancel the work
  *   and remove it from the work queue.
  *
+ *   The work structure should be zeroed before it is first used, as
+ *   work_available() relies on its worker field.  With
+ *   CONFIG_SCHED_WORKQUEUE_DEADLINE a structure that was not zeroed is
+ *   still queued.
+ *
  * Input parameters:
  *   qid    - The work queue ID
  *   work   - The work structure to queue
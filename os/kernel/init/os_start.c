@@ -128,6 +128,13 @@ volatile dq_queue_t g_readytorun;
 
 volatile dq_queue_t g_pendingtasks;
 
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+/* Priority indexes of the g_readytorun and g_pendingtasks lists */
+
+struct sched_prioindex_s g_readytorunindex;
+struct sched_prioindex_s g_pendingindex;
+#endif
+
 /* This is the list of all tasks that are blocked waiting for a semaphore */
 
 volatile dq_queue_t g_waitingforsemaphore;
@@ -208,7 +215,11 @@ const struct tasklist_s g_tasklisttable[NUM_TASK_STATES] = {
 	{&g_readytorun,           true },	/* TSTATE_TASK_READYTORUN */
 	{&g_readytorun,           true },	/* TSTATE_TASK_RUNNING */
 	{&g_inactivetasks,        false},	/* TSTATE_TASK_INACTIVE */
+#ifdef CONFIG_SEM_WAITHASH
+	{&g_waitingforsemaphore,  false}	/* TSTATE_WAIT_SEM (ordered by g_semwaitqueue) */
+#else
 	{&g_waitingforsemaphore,  true }	/* TSTATE_WAIT_SEM */
+#endif
 #ifndef CONFIG_DISABLE_SIGNALS
 	,
 	{&g_waitingforsignal,     false}	/* TSTATE_WAIT_SIG */
@@ -277,6 +288,10 @@ void os_start(void)
 
 	dq_init(&g_readytorun);
 	dq_init(&g_pendingtasks);
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+	memset(&g_readytorunindex, 0, sizeof(struct sched_prioindex_s));
+	memset(&g_pendingindex, 0, sizeof(struct sched_prioindex_s));
+#endif
 	dq_init(&g_waitingforsemaphore);
 #ifndef CONFIG_DISABLE_SIGNALS
 	dq_init(&g_waitingforsignal);
@@ -114,6 +114,22 @@ struct tasklist_s {
 	bool prioritized;			/* true if the list is prioritized */
 };
 
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+/* This structure indexes a prioritized task list by priority.  Tasks of
+ * the same priority are contiguous in the list, so each priority present
+ * is described by its last TCB, and the map has one bit set for each
+ * priority present.  summary has bit n set when map[n] is non-zero.
+ */
+
+#define SCHED_PRIOINDEX_NWORDS  ((SCHED_PRIORITY_MAX + 32) >> 5)
+
+struct sched_prioindex_s {
+	FAR struct tcb_s *last[SCHED_PRIORITY_MAX + 1];
+	uint32_t map[SCHED_PRIOINDEX_NWORDS];
+	uint32_t summary;
+};
+#endif
+
 /****************************************************************************
  * Global Variables
  ****************************************************************************/
@@ -218,6 +234,16 @@ extern struct pidhash_s g_pidhash[CONFIG_MAX_TASKS];
 
 extern const struct tasklist_s g_tasklisttable[NUM_TASK_STATES];
 
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+/* Priority indexes of the g_readytorun and g_pendingtasks lists.  The IDLE
+ * task is never indexed:  every other task has a higher priority, so it can
+ * never be the task that a new task is queued behind.
+ */
+
+extern struct sched_prioindex_s g_readytorunindex;
+extern struct sched_prioindex_s g_pendingindex;
+#endif
+
 #ifdef CONFIG_SCHED_CPULOAD
 /* This is the total number of clock tick counts.  Essentially the
  * 'denominator' for all CPU load calculations.
@@ -233,6 +259,25 @@ extern volatile uint32_t g_cpuload_total;
 bool sched_addreadytorun(FAR struct tcb_s *rtrtcb);
 bool sched_removereadytorun(FAR struct tcb_s *rtrtcb);
 bool sched_addprioritized(FAR struct tcb_s *newTcb, DSEG dq_queue_t *list);
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+void sched_removeprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list);
+
+/* Return the priority index of a task list, or NULL if it has none */
+
+static inline FAR struct sched_prioindex_s *sched_prioindex(DSEG dq_queue_t *list)
+{
+	if (list == (FAR dq_queue_t *)&g_readytorun) {
+		return &g_readytorunindex;
+	} else if (list == (FAR dq_queue_t *)&g_pendingtasks) {
+		return &g_pendingindex;
+	}
+
+	return NULL;
+}
+#else
+#define sched_removeprioritized(tcb, list) \
+		dq_rem((FAR dq_entry_t *)(tcb), (FAR dq_queue_t *)(list))
+#endif
 bool sched_mergepending(void);
 void sched_addblocked(FAR struct tcb_s *btcb, tstate_t task_state);
 void sched_removeblocked(FAR struct tcb_s *btcb);
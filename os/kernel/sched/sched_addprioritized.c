@@ -79,6 +79,75 @@
  * Private Variables
  ************************************************************************/
 
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+/************************************************************************
+ * Name: sched_prioindex_ctz
+ *
+ * Description:
+ *   Return the index of the least significant bit set in a non-zero
+ *   word.
+ *
+ ************************************************************************/
+
+static inline int sched_prioindex_ctz(uint32_t word)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(word);
+#else
+	int bit = 0;
+
+	while ((word & 1) == 0) {
+		word >>= 1;
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+/************************************************************************
+ * Name: sched_prioindex_find
+ *
+ * Description:
+ *   Return the last TCB of the lowest priority present in the list that
+ *   is greater than or equal to sched_priority, or NULL if there is none.
+ *   A new TCB of priority sched_priority belongs right behind it.
+ *
+ ************************************************************************/
+
+static inline FAR struct tcb_s *sched_prioindex_find(FAR struct sched_prioindex_s *index, uint8_t sched_priority)
+{
+	uint32_t word;
+	int ndx = sched_priority >> 5;
+	int bit = sched_priority & 31;
+
+	if (index->last[sched_priority] != NULL) {
+		return index->last[sched_priority];
+	}
+
+	/* Look for a higher priority in the same word of the map */
+
+	word = (bit < 31) ? (index->map[ndx] & ~((2ul << bit) - 1)) : 0;
+	if (word == 0) {
+		/* Then for the next non-empty word */
+
+		word = (ndx < 31) ? (index->summary & ~((2ul << ndx) - 1)) : 0;
+		if (word == 0) {
+			return NULL;
+		}
+
+		ndx = sched_prioindex_ctz(word);
+		word = index->map[ndx];
+	}
+
+	return index->last[(ndx << 5) + sched_prioindex_ctz(word)];
+}
+#endif
+
 /************************************************************************
  * Private Function Prototypes
  ************************************************************************/
@@ -116,6 +185,9 @@ bool sched_addprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
 {
 	FAR struct tcb_s *next;
 	FAR struct tcb_s *prev;
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+	FAR struct sched_prioindex_s *index;
+#endif
 	uint8_t sched_priority = tcb->sched_priority;
 	bool ret = false;
 
@@ -123,11 +195,29 @@ bool sched_addprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
 
 	ASSERT(sched_priority >= SCHED_PRIORITY_MIN);
 
-	/* Search the list to find the location to insert the new Tcb.
-	 * Each is list is maintained in ascending sched_priority order.
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+	/* If the list is indexed, the new TCB goes right behind the last TCB of
+	 * the same or of the nearest higher priority, or at the head of the
+	 * list if there is none.  The TCB becomes the last of its priority.
 	 */
 
-	for (next = (FAR struct tcb_s *)list->head; (next && sched_priority <= next->sched_priority); next = next->flink) ;
+	index = sched_prioindex(list);
+	if (index != NULL) {
+		prev = sched_prioindex_find(index, sched_priority);
+		next = prev ? prev->flink : (FAR struct tcb_s *)list->head;
+
+		index->last[sched_priority] = tcb;
+		index->map[sched_priority >> 5] |= (1ul << (sched_priority & 31));
+		index->summary |= (1ul << (sched_priority >> 5));
+	} else
+#endif
+	{
+		/* Search the list to find the location to insert the new Tcb.
+		 * Each is list is maintained in ascending sched_priority order.
+		 */
+
+		for (next = (FAR struct tcb_s *)list->head; (next && sched_priority <= next->sched_priority); next = next->flink) ;
+	}
 
 	/* Add the tcb to the spot found in the list.  Check if the tcb
 	 * goes at the end of the list. NOTE:  This could only happen if list
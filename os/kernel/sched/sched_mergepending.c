@@ -109,6 +109,38 @@
  *
  ************************************************************************/
 
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+bool sched_mergepending(void)
+{
+	FAR struct tcb_s *rtrtcb;
+	FAR struct tcb_s *pndtcb;
+	bool ret = false;
+
+	/* Both lists are indexed, so each pending TCB can be moved to its place
+	 * in the g_readytorun list in constant time.  Taking them from the head
+	 * preserves the FIFO order of TCBs of equal priority.
+	 */
+
+	rtrtcb = (FAR struct tcb_s *)g_readytorun.head;
+	while ((pndtcb = (FAR struct tcb_s *)g_pendingtasks.head) != NULL) {
+		sched_removeprioritized(pndtcb, (FAR dq_queue_t *)&g_pendingtasks);
+
+		if (sched_addprioritized(pndtcb, (FAR dq_queue_t *)&g_readytorun)) {
+			/* Inform the instrumentation layer that we are switching tasks */
+
+			sched_note_switch(rtrtcb, pndtcb);
+			rtrtcb->task_state = TSTATE_TASK_READYTORUN;
+			pndtcb->task_state = TSTATE_TASK_RUNNING;
+			rtrtcb = pndtcb;
+			ret = true;
+		} else {
+			pndtcb->task_state = TSTATE_TASK_READYTORUN;
+		}
+	}
+
+	return ret;
+}
+#else
 bool sched_mergepending(void)
 {
 	FAR struct tcb_s *pndtcb;
@@ -181,3 +213,4 @@ bool sched_mergepending(void)
 
 	return ret;
 }
+#endif							/* CONFIG_SCHED_PRIORITY_BITMAP */
@@ -0,0 +1,88 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/************************************************************************
+ * kernel/sched/sched_removeprioritized.c
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+#include <queue.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_removeprioritized
+ *
+ * Description:
+ *  This function removes a TCB from a task list and, if the list has a
+ *  priority index, keeps the index consistent.  It may be used with
+ *  any task list.
+ *
+ * Inputs:
+ *   tcb - Points to the TCB to remove
+ *   list - Points to the task list that holds tcb
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ * - tcb->sched_priority has not changed since tcb was added to list.
+ *
+ ************************************************************************/
+
+void sched_removeprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
+{
+	FAR struct sched_prioindex_s *index = sched_prioindex(list);
+	FAR struct tcb_s *prev;
+	uint8_t sched_priority = tcb->sched_priority;
+
+	if (index != NULL && index->last[sched_priority] == tcb) {
+		/* The TCB was the last of its priority.  The TCB before it takes
+		 * over if it has the same priority, otherwise the priority is no
+		 * longer present in the list.
+		 */
+
+		prev = tcb->blink;
+		if (prev != NULL && prev->sched_priority == sched_priority) {
+			index->last[sched_priority] = prev;
+		} else {
+			index->last[sched_priority] = NULL;
+			index->map[sched_priority >> 5] &= ~(1ul << (sched_priority & 31));
+			if (index->map[sched_priority >> 5] == 0) {
+				index->summary &= ~(1ul << (sched_priority >> 5));
+			}
+		}
+	}
+
+	dq_rem((FAR dq_entry_t *)tcb, (FAR dq_queue_t *)list);
+}
+
+#endif							/* CONFIG_SCHED_PRIORITY_BITMAP */
@@ -62,6 +62,7 @@
 #include <tinyara/arch.h>
 
 #include "sched/sched.h"
+#include "semaphore/semaphore.h"
 
 /****************************************************************************
  * Definitions
@@ -161,9 +162,19 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 		/* Otherwise, we can just change priority since it has no effect */
 
 		else {
+#ifdef CONFIG_SCHED_PRIORITY_BITMAP
+			/* The task stays at the head of the list but must be
+			 * re-indexed under its new priority.
+			 */
+
+			sched_removeprioritized(tcb, (FAR dq_queue_t *)&g_readytorun);
+			tcb->sched_priority = (uint8_t)sched_priority;
+			(void)sched_addprioritized(tcb, (FAR dq_queue_t *)&g_readytorun);
+#else
 			/* Change the task priority */
 
 			tcb->sched_priority = (uint8_t)sched_priority;
+#endif
 		}
 		break;
 
@@ -213,7 +224,7 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 		if (g_tasklisttable[task_state].prioritized) {
 			/* Remove the TCB from the prioritized task list */
 
-			dq_rem((FAR dq_entry_t *)tcb, (FAR dq_queue_t *)g_tasklisttable[task_state].list);
+			sched_removeprioritized(tcb, (FAR dq_queue_t *)g_tasklisttable[task_state].list);
 
 			/* Change the task priority */
 
@@ -233,6 +244,17 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 
 			tcb->sched_priority = (uint8_t)sched_priority;
 		}
+
+#ifdef CONFIG_SEM_WAITHASH
+		/* A task waiting on a semaphore is also ordered by priority in the
+		 * wait queue of that semaphore.
+		 */
+
+		if (task_state == TSTATE_WAIT_SEM && tcb->waitsem != NULL) {
+			sem_removewaiter(tcb);
+			sem_addwaiter(tcb);
+		}
+#endif
 		break;
 	}
 
@@ -56,11 +56,11 @@
 
 #include <tinyara/config.h>
 
-#include "semaphore/semaphore.h"
+#include <queue.h>
 
-/* Currently only need to setup priority inheritance logic */
+#include "semaphore/semaphore.h"
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#if defined(CONFIG_PRIORITY_INHERITANCE) || defined(CONFIG_SEM_WAITHASH)
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -105,9 +105,19 @@
 
 void sem_initialize(void)
 {
+#ifdef CONFIG_SEM_WAITHASH
+	int i;
+
+	/* Initialize the semaphore wait queues */
+
+	for (i = 0; i < CONFIG_SEM_WAITHASH_SIZE; i++) {
+		dq_init(&g_semwaitqueue[i]);
+	}
+#endif
+
 	/* Initialize holder structures needed to support priority inheritance */
 
 	sem_initholders();
 }
 
-#endif							/* CONFIG_PRIORITY_INHERITANCE */
+#endif							/* CONFIG_PRIORITY_INHERITANCE || CONFIG_SEM_WAITHASH */
@@ -159,13 +159,18 @@ int sem_post(FAR sem_t *sem)
 			 * that we want.
 			 */
 
+#ifdef CONFIG_SEM_WAITHASH
+			stcb = sem_nextwaiter(sem);
+#else
 			for (stcb = (FAR struct tcb_s *)g_waitingforsemaphore.head; (stcb && stcb->waitsem != sem); stcb = stcb->flink) ;
+#endif
 
 			if (stcb) {
 				sem_addholder_tcb(stcb, sem);
 
 				/* It is, let the task take the semaphore */
 
+				sem_removewaiter(stcb);
 				stcb->waitsem = NULL;
 
 				/* Restart the waiting task. */
@@ -253,11 +258,16 @@ int sem_post_from_isr(FAR sem_t *sem)
 			 * that we want.
 			 */
 
+#ifdef CONFIG_SEM_WAITHASH
+			stcb = sem_nextwaiter(sem);
+#else
 			for (stcb = (FAR struct tcb_s *)g_waitingforsemaphore.head; (stcb && stcb->waitsem != sem); stcb = stcb->flink) ;
+#endif
 
 			if (stcb) {
 				/* It is, let the task take the semaphore */
 
+				sem_removewaiter(stcb);
 				stcb->waitsem = NULL;
 
 				/* Restart the waiting task. */
@@ -157,6 +157,7 @@ void sem_recover(FAR struct tcb_s *tcb)
 		 * semaphore list.
 		 */
 
+		sem_removewaiter(tcb);
 		tcb->waitsem = NULL;
 
 	}
@@ -181,6 +181,8 @@ int sem_wait(FAR sem_t *sem)
 #endif
 			/* Add the TCB to the prioritized semaphore wait queue */
 
+			sem_addwaiter(rtcb);
+
 			set_errno(0);
 			up_block_task(rtcb, TSTATE_WAIT_SEM);
 
@@ -296,6 +298,9 @@ int sem_wait_for_isr(FAR sem_t *sem)
 			rtcb->waitsem = sem;
 
 			/* Add the TCB to the prioritized semaphore wait queue */
+
+			sem_addwaiter(rtcb);
+
 			set_errno(0);
 
 			up_block_task(rtcb, TSTATE_WAIT_SEM);
@@ -147,6 +147,7 @@ void sem_waitirq(FAR struct tcb_s *wtcb, int errcode)
 
 		/* Indicate that the semaphore wait is over. */
 
+		sem_removewaiter(wtcb);
 		wtcb->waitsem = NULL;
 
 		/* Mark the errno value for the thread. */
@@ -0,0 +1,146 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * kernel/semaphore/sem_waitqueue.c
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <semaphore.h>
+#include <queue.h>
+#include <assert.h>
+
+#include "sched/sched.h"
+#include "semaphore/semaphore.h"
+
+#ifdef CONFIG_SEM_WAITHASH
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Map a waitlink entry back to its TCB */
+
+#define WAITLINK2TCB(e) \
+	((FAR struct tcb_s *)((uintptr_t)(e) - offsetof(struct tcb_s, waitlink)))
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+dq_queue_t g_semwaitqueue[CONFIG_SEM_WAITHASH_SIZE];
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sem_addwaiter
+ *
+ * Description:
+ *   Queue a task that is about to block on tcb->waitsem.  The task goes
+ *   behind every task of the same or higher priority in the wait queue.
+ *
+ * Parameters:
+ *   tcb - The TCB of the task that waits
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sem_addwaiter(FAR struct tcb_s *tcb)
+{
+	FAR dq_queue_t *queue = &g_semwaitqueue[SEM_WAITHASH(tcb->waitsem)];
+	FAR dq_entry_t *next;
+
+	DEBUGASSERT(tcb->waitsem != NULL);
+
+	for (next = queue->head; next && WAITLINK2TCB(next)->sched_priority >= tcb->sched_priority; next = next->flink) ;
+
+	if (next) {
+		dq_addbefore(next, &tcb->waitlink, queue);
+	} else {
+		dq_addlast(&tcb->waitlink, queue);
+	}
+}
+
+/****************************************************************************
+ * Name: sem_removewaiter
+ *
+ * Description:
+ *   Remove a task from the wait queue of tcb->waitsem.
+ *
+ * Parameters:
+ *   tcb - The TCB of the task that no longer waits
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sem_removewaiter(FAR struct tcb_s *tcb)
+{
+	DEBUGASSERT(tcb->waitsem != NULL);
+	dq_rem(&tcb->waitlink, &g_semwaitqueue[SEM_WAITHASH(tcb->waitsem)]);
+}
+
+/****************************************************************************
+ * Name: sem_nextwaiter
+ *
+ * Description:
+ *   Return the highest priority task waiting on the semaphore, the one that
+ *   has waited longest among several of equal priority.
+ *
+ * Parameters:
+ *   sem - Semaphore descriptor
+ *
+ * Return Value:
+ *   The TCB of the task to wake, or NULL if no task waits on sem.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+FAR struct tcb_s *sem_nextwaiter(FAR sem_t *sem)
+{
+	FAR dq_entry_t *entry;
+
+	for (entry = g_semwaitqueue[SEM_WAITHASH(sem)].head; entry; entry = entry->flink) {
+		if (WAITLINK2TCB(entry)->waitsem == sem) {
+			return WAITLINK2TCB(entry);
+		}
+	}
+
+	return NULL;
+}
+
+#endif							/* CONFIG_SEM_WAITHASH */
@@ -70,6 +70,17 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+#ifdef CONFIG_SEM_WAITHASH
+#if (CONFIG_SEM_WAITHASH_SIZE & (CONFIG_SEM_WAITHASH_SIZE - 1)) != 0
+#error CONFIG_SEM_WAITHASH_SIZE must be a power of two
+#endif
+
+/* Map a semaphore address to its wait queue */
+
+#define SEM_WAITHASH(s) \
+	((((uintptr_t)(s) >> 2) ^ ((uintptr_t)(s) >> 8)) & (CONFIG_SEM_WAITHASH_SIZE - 1))
+#endif
+
 /****************************************************************************
  * Public Type Declarations
  ****************************************************************************/
@@ -78,6 +89,16 @@
  * Public Variables
  ****************************************************************************/
 
+#ifdef CONFIG_SEM_WAITHASH
+/* Tasks blocked on a semaphore are queued, by the waitlink field of their
+ * TCB, in the wait queue selected by SEM_WAITHASH(waitsem).  Each queue is
+ * kept in priority order, FIFO among tasks of equal priority, so the first
+ * task in a queue waiting for a given semaphore is the one to wake.
+ */
+
+extern dq_queue_t g_semwaitqueue[CONFIG_SEM_WAITHASH_SIZE];
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -91,7 +112,7 @@ extern "C" {
 
 /* Common semaphore logic */
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#if defined(CONFIG_PRIORITY_INHERITANCE) || defined(CONFIG_SEM_WAITHASH)
 void sem_initialize(void);
 #else
 #define sem_initialize()
@@ -99,6 +120,19 @@ void sem_initialize(void);
 
 void sem_waitirq(FAR struct tcb_s *wtcb, int errcode);
 
+/* Semaphore wait queues.  All must be called with interrupts disabled and
+ * while tcb->waitsem identifies the semaphore.
+ */
+
+#ifdef CONFIG_SEM_WAITHASH
+void sem_addwaiter(FAR struct tcb_s *tcb);
+void sem_removewaiter(FAR struct tcb_s *tcb);
+FAR struct tcb_s *sem_nextwaiter(FAR sem_t *sem);
+#else
+#define sem_addwaiter(tcb)
+#define sem_removewaiter(tcb)
+#endif
+
 /* Recover semaphore resources with a task or thread is destroyed  */
 
 void sem_recover(FAR struct tcb_s *tcb);
@@ -108,8 +108,12 @@
 
 int wd_cancel(WDOG_ID wdog)
 {
+#if defined(CONFIG_WDOG_TIMERWHEEL) && defined(CONFIG_SCHED_TICKLESS)
+	unsigned int next;
+#elif !defined(CONFIG_WDOG_TIMERWHEEL)
 	FAR struct wdog_s *curr;
 	FAR struct wdog_s *prev;
+#endif
 	irqstate_t state;
 	int ret = ERROR;
 
@@ -124,6 +128,22 @@ int wd_cancel(WDOG_ID wdog)
 	 */
 
 	if (wdog && WDOG_ISACTIVE(wdog)) {
+#ifdef CONFIG_WDOG_TIMERWHEEL
+		/* The watchdog knows its slot in the timing wheel, so it can be
+		 * unlinked directly.  The interval timer only needs to be reassessed
+		 * if this changes the next time that the wheel needs service.
+		 */
+
+#ifdef CONFIG_SCHED_TICKLESS
+		next = wd_wheel_nextevent();
+		wd_wheel_remove(wdog);
+		if (wd_wheel_nextevent() != next) {
+			sched_timer_reassess();
+		}
+#else
+		wd_wheel_remove(wdog);
+#endif
+#else
 		/* Search the g_wdactivelist for the target FCB.  We can't use sq_rem
 		 * to do this because there are additional operations that need to be
 		 * done.
@@ -169,9 +189,11 @@ int wd_cancel(WDOG_ID wdog)
 			sched_timer_reassess();
 		}
 
+		wdog->next = NULL;
+#endif
+
 		/* Mark the watchdog inactive */
 
-		wdog->next = NULL;
 		WDOG_CLRACTIVE(wdog);
 
 		/* Return success */
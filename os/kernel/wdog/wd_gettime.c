@@ -110,6 +110,14 @@ int wd_gettime(WDOG_ID wdog)
 
 	flags = irqsave();
 	if (wdog && WDOG_ISACTIVE(wdog)) {
+#ifdef CONFIG_WDOG_TIMERWHEEL
+		/* The watchdog holds its absolute expiration time */
+
+		int delay = (int)(wdog->expire - g_wdtick);
+
+		irqrestore(flags);
+		return delay;
+#else
 		/* Traverse the watchdog list accumulating lag times until we find the wdog
 		 * that we are looking for
 		 */
@@ -124,6 +132,7 @@ int wd_gettime(WDOG_ID wdog)
 				return delay;
 			}
 		}
+#endif
 	}
 
 	irqrestore(flags);
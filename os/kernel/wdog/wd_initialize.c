@@ -138,6 +138,9 @@ void wd_initialize(void)
 
 	sq_init(&g_wdfreelist);
 	sq_init(&g_wdactivelist);
+#ifdef CONFIG_WDOG_TIMERWHEEL
+	wd_wheel_initialize();
+#endif
 
 	/* The g_wdfreelist must be loaded at initialization time to hold the
 	 * configured number of watchdogs.
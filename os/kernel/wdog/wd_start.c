@@ -111,6 +111,93 @@ typedef void (*wdentry4_t)(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
+/****************************************************************************
+ * Name: wd_dispatch
+ *
+ * Description:
+ *   Execute the function of a watchdog that has just expired.
+ *
+ * Parameters:
+ *   wdog - The expired watchdog, already removed from the active watchdogs
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called from the timer interrupt handler with interrupts disabled.
+ *
+ ****************************************************************************/
+
+static inline void wd_dispatch(FAR struct wdog_s *wdog)
+{
+	/* Indicate that the watchdog is no longer active. */
+
+	WDOG_CLRACTIVE(wdog);
+
+	/* Execute the watchdog function */
+
+	up_setpicbase(wdog->picbase);
+	switch (wdog->argc) {
+	default:
+		DEBUGPANIC();
+		break;
+
+	case 0:
+		(*((wdentry0_t)(wdog->func)))(0);
+		break;
+
+#if CONFIG_MAX_WDOGPARMS > 0
+	case 1:
+		(*((wdentry1_t)(wdog->func)))(1, wdog->parm[0]);
+		break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 1
+	case 2:
+		(*((wdentry2_t)(wdog->func)))(2, wdog->parm[0], wdog->parm[1]);
+		break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 2
+	case 3:
+		(*((wdentry3_t)(wdog->func)))(3, wdog->parm[0], wdog->parm[1], wdog->parm[2]);
+		break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 3
+	case 4:
+		(*((wdentry4_t)(wdog->func)))(4, wdog->parm[0], wdog->parm[1], wdog->parm[2], wdog->parm[3]);
+		break;
+#endif
+	}
+}
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/****************************************************************************
+ * Name: wd_expiration
+ *
+ * Description:
+ *   Execute every watchdog that expires at the current tick of the wheel.
+ *   A watchdog function that restarts a watchdog always files it at a later
+ *   tick, so this terminates.
+ *
+ * Parameters:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+static inline void wd_expiration(void)
+{
+	FAR struct wdog_s *wdog;
+
+	while ((wdog = wd_wheel_expired()) != NULL) {
+		wd_dispatch(wdog);
+	}
+}
+
+#else
 /****************************************************************************
  * Name: wd_expiration
  *
@@ -152,46 +239,13 @@ static inline void wd_expiration(void)
 				((FAR struct wdog_s *)g_wdactivelist.head)->lag += wdog->lag;
 			}
 
-			/* Indicate that the watchdog is no longer active. */
+			/* Mark the watchdog inactive and execute its function */
 
-			WDOG_CLRACTIVE(wdog);
-
-			/* Execute the watchdog function */
-
-			up_setpicbase(wdog->picbase);
-			switch (wdog->argc) {
-			default:
-				DEBUGPANIC();
-				break;
-
-			case 0:
-				(*((wdentry0_t)(wdog->func)))(0);
-				break;
-
-#if CONFIG_MAX_WDOGPARMS > 0
-			case 1:
-				(*((wdentry1_t)(wdog->func)))(1, wdog->parm[0]);
-				break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 1
-			case 2:
-				(*((wdentry2_t)(wdog->func)))(2, wdog->parm[0], wdog->parm[1]);
-				break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 2
-			case 3:
-				(*((wdentry3_t)(wdog->func)))(3, wdog->parm[0], wdog->parm[1], wdog->parm[2]);
-				break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 3
-			case 4:
-				(*((wdentry4_t)(wdog->func)))(4, wdog->parm[0], wdog->parm[1], wdog->parm[2], wdog->parm[3]);
-				break;
-#endif
-			}
+			wd_dispatch(wdog);
 		}
 	}
 }
+#endif							/* CONFIG_WDOG_TIMERWHEEL */
 
 /****************************************************************************
  * Public Functions
@@ -233,10 +287,12 @@ static inline void wd_expiration(void)
 int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry, int argc, ...)
 {
 	va_list ap;
+#ifndef CONFIG_WDOG_TIMERWHEEL
 	FAR struct wdog_s *curr;
 	FAR struct wdog_s *prev;
 	FAR struct wdog_s *next;
 	int32_t now;
+#endif
 	irqstate_t state;
 	int i;
 
@@ -292,6 +348,14 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry, int argc, ...)
 	(void)sched_timer_cancel();
 #endif
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+	/* File the watchdog in the timing wheel.  This takes constant time no
+	 * matter how many watchdogs are active.
+	 */
+
+	wdog->expire = g_wdtick + (uint32_t)delay;
+	wd_wheel_add(wdog);
+#else
 	/* Do the easy case first -- when the watchdog timer queue is empty. */
 
 	if (g_wdactivelist.head == NULL) {
@@ -363,9 +427,13 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry, int argc, ...)
 		}
 	}
 
-	/* Put the lag into the watchdog structure and mark it as active. */
+	/* Put the lag into the watchdog structure */
 
 	wdog->lag = delay;
+#endif							/* CONFIG_WDOG_TIMERWHEEL */
+
+	/* Mark the watchdog as active */
+
 	WDOG_SETACTIVE(wdog);
 
 #ifdef CONFIG_SCHED_TICKLESS
@@ -406,7 +474,48 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry, int argc, ...)
  *
  ****************************************************************************/
 
-#ifdef CONFIG_SCHED_TICKLESS
+#if defined(CONFIG_WDOG_TIMERWHEEL) && defined(CONFIG_SCHED_TICKLESS)
+unsigned int wd_timer(int ticks)
+{
+	unsigned int next;
+
+	/* Jump over the ticks in which the wheel has nothing to do, stopping
+	 * only at the ticks where a slot expires or cascades.
+	 */
+
+	while (ticks > 0) {
+		next = wd_wheel_nextevent();
+		if (next == 0 || next > (unsigned int)ticks) {
+			g_wdtick += ticks;
+			break;
+		}
+
+		g_wdtick += next - 1;
+		ticks -= next;
+		wd_wheel_tick();
+
+		/* Execute the watchdogs that expire at this tick */
+
+		wd_expiration();
+	}
+
+	/* Return the delay until the wheel next needs to be serviced.  This may
+	 * be a cascade of a coarse slot rather than an expiration.
+	 */
+
+	return wd_wheel_nextevent();
+}
+
+#elif defined(CONFIG_WDOG_TIMERWHEEL)
+void wd_timer(void)
+{
+	/* Advance the wheel and execute the watchdogs that expire at this tick */
+
+	wd_wheel_tick();
+	wd_expiration();
+}
+
+#elif defined(CONFIG_SCHED_TICKLESS)
 unsigned int wd_timer(int ticks)
 {
 	FAR struct wdog_s *wdog;
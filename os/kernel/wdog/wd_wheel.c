@@ -0,0 +1,276 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * kernel/wdog/wd_wheel.c
+ *
+ *   Hierarchical timing wheel for active watchdogs.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+#include <queue.h>
+#include <assert.h>
+
+#include <tinyara/wdog.h>
+
+#include "wdog/wdog.h"
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/* The wheel's current time in ticks */
+
+uint32_t g_wdtick;
+
+/* Slots of the wheel and the map of non-empty slots of each level */
+
+dq_queue_t g_wdwheel[WD_WHEEL_LEVELS][WD_WHEEL_SIZE];
+uint32_t g_wdwheelmap[WD_WHEEL_LEVELS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_ctz
+ *
+ * Description:
+ *   Return the index of the least significant bit set in a non-zero map.
+ *
+ ****************************************************************************/
+
+static inline unsigned int wd_wheel_ctz(uint32_t map)
+{
+#ifdef __GNUC__
+	return (unsigned int)__builtin_ctz(map);
+#else
+	unsigned int bit = 0;
+
+	while ((map & 1) == 0) {
+		map >>= 1;
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+/****************************************************************************
+ * Name: wd_wheel_cascade
+ *
+ * Description:
+ *   Move every watchdog of one slot of a coarse level back into the wheel.
+ *   Each of them is now close enough to be filed in a finer level.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_cascade(int level, int index)
+{
+	dq_queue_t pending;
+	FAR struct wdog_s *wdog;
+
+	pending = g_wdwheel[level][index];
+	dq_init(&g_wdwheel[level][index]);
+	g_wdwheelmap[level] &= ~(1ul << index);
+
+	while ((wdog = (FAR struct wdog_s *)dq_remfirst(&pending)) != NULL) {
+		wd_wheel_add(wdog);
+	}
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_initialize
+ ****************************************************************************/
+
+void wd_wheel_initialize(void)
+{
+	int level;
+	int index;
+
+	for (level = 0; level < WD_WHEEL_LEVELS; level++) {
+		for (index = 0; index < WD_WHEEL_SIZE; index++) {
+			dq_init(&g_wdwheel[level][index]);
+		}
+
+		g_wdwheelmap[level] = 0;
+	}
+
+	g_wdtick = 0;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_add
+ *
+ * Description:
+ *   File the watchdog in the finest level whose span still covers its
+ *   expiration time.  A watchdog expiring within WD_WHEEL_SIZE ticks goes
+ *   to level 0 and is dispatched directly from its slot; the others wait in
+ *   a coarser slot until that slot cascades.  Delays beyond the range of
+ *   the wheel are parked in the last slot that the wheel can reach and
+ *   re-filed when it cascades.
+ *
+ ****************************************************************************/
+
+void wd_wheel_add(FAR struct wdog_s *wdog)
+{
+	uint32_t delta = wdog->expire - g_wdtick;
+	uint32_t when = wdog->expire;
+	int level;
+	int index;
+
+	DEBUGASSERT((int32_t)delta >= 0);
+
+	if (delta >= WD_WHEEL_RANGE) {
+		delta = WD_WHEEL_RANGE - 1;
+		when = g_wdtick + delta;
+	}
+
+	for (level = 0; level < WD_WHEEL_LEVELS - 1; level++) {
+		if (delta < (1ul << (WD_WHEEL_BITS * (level + 1)))) {
+			break;
+		}
+	}
+
+	index = (when >> (WD_WHEEL_BITS * level)) & WD_WHEEL_MASK;
+
+	wdog->slot = WD_WHEEL_SLOT(level, index);
+	dq_addlast((FAR dq_entry_t *)wdog, &g_wdwheel[level][index]);
+	g_wdwheelmap[level] |= (1ul << index);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_remove
+ ****************************************************************************/
+
+void wd_wheel_remove(FAR struct wdog_s *wdog)
+{
+	int level = WD_WHEEL_LEVEL(wdog);
+	int index = WD_WHEEL_INDEX(wdog);
+
+	dq_rem((FAR dq_entry_t *)wdog, &g_wdwheel[level][index]);
+	if (dq_empty(&g_wdwheel[level][index])) {
+		g_wdwheelmap[level] &= ~(1ul << index);
+	}
+
+	wdog->next = NULL;
+	wdog->prev = NULL;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_tick
+ *
+ * Description:
+ *   Advance the wheel by one tick.  Each time level n wraps around, the
+ *   next slot of level n + 1 is redistributed over the finer levels.
+ *
+ ****************************************************************************/
+
+void wd_wheel_tick(void)
+{
+	int level;
+	int index;
+
+	g_wdtick++;
+
+	for (level = 1; level < WD_WHEEL_LEVELS; level++) {
+		if ((g_wdtick & ((1ul << (WD_WHEEL_BITS * level)) - 1)) != 0) {
+			break;
+		}
+
+		index = (g_wdtick >> (WD_WHEEL_BITS * level)) & WD_WHEEL_MASK;
+		if ((g_wdwheelmap[level] & (1ul << index)) != 0) {
+			wd_wheel_cascade(level, index);
+		}
+	}
+}
+
+/****************************************************************************
+ * Name: wd_wheel_expired
+ ****************************************************************************/
+
+FAR struct wdog_s *wd_wheel_expired(void)
+{
+	int index = g_wdtick & WD_WHEEL_MASK;
+	FAR struct wdog_s *wdog;
+
+	if ((g_wdwheelmap[0] & (1ul << index)) == 0) {
+		return NULL;
+	}
+
+	wdog = (FAR struct wdog_s *)g_wdwheel[0][index].head;
+	DEBUGASSERT(wdog->expire == g_wdtick);
+	wd_wheel_remove(wdog);
+	return wdog;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_nextevent
+ *
+ * Description:
+ *   For every level, rotate the map of non-empty slots so that bit 0 is the
+ *   next slot that the wheel will reach; the lowest bit set then gives the
+ *   time of the next expiration (level 0) or cascade (other levels).
+ *
+ ****************************************************************************/
+
+unsigned int wd_wheel_nextevent(void)
+{
+	uint32_t best = UINT32_MAX;
+	uint32_t delta;
+	uint32_t current;
+	uint32_t map;
+	unsigned int first;
+	unsigned int shift;
+	int level;
+
+	for (level = 0; level < WD_WHEEL_LEVELS; level++) {
+		map = g_wdwheelmap[level];
+		if (map == 0) {
+			continue;
+		}
+
+		shift = WD_WHEEL_BITS * level;
+		current = g_wdtick >> shift;
+		first = (current + 1) & WD_WHEEL_MASK;
+		if (first != 0) {
+			map = (map >> first) | (map << (WD_WHEEL_SIZE - first));
+		}
+
+		delta = ((current + 1 + wd_wheel_ctz(map)) << shift) - g_wdtick;
+		if (delta < best) {
+			best = delta;
+		}
+	}
+
+	return best == UINT32_MAX ? 0 : (unsigned int)best;
+}
+
+#endif							/* CONFIG_WDOG_TIMERWHEEL */
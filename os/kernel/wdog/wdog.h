@@ -62,6 +62,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <queue.h>
+
 #include <tinyara/compiler.h>
 #include <tinyara/wdog.h>
 
@@ -69,6 +71,26 @@
  * Pre-processor Definitions
  ************************************************************************/
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* Geometry of the timing wheel.  Each level has WD_WHEEL_SIZE slots and
+ * each slot of level n covers WD_WHEEL_SIZE^n ticks, so the wheel spans
+ * WD_WHEEL_RANGE ticks.  Longer delays are parked in the last level and
+ * re-filed whenever that slot cascades.
+ */
+
+#define WD_WHEEL_BITS      5
+#define WD_WHEEL_SIZE      (1 << WD_WHEEL_BITS)
+#define WD_WHEEL_MASK      (WD_WHEEL_SIZE - 1)
+#define WD_WHEEL_LEVELS    5
+#define WD_WHEEL_RANGE     (1ul << (WD_WHEEL_BITS * WD_WHEEL_LEVELS))
+
+/* Encoding of the slot field of struct wdog_s */
+
+#define WD_WHEEL_SLOT(l, s) ((uint8_t)(((l) << WD_WHEEL_BITS) | (s)))
+#define WD_WHEEL_LEVEL(w)   ((w)->slot >> WD_WHEEL_BITS)
+#define WD_WHEEL_INDEX(w)   ((w)->slot & WD_WHEEL_MASK)
+#endif
+
 /************************************************************************
  * Public Type Declarations
  ************************************************************************/
@@ -104,6 +126,22 @@ extern sq_queue_t g_wdactivelist;
 
 extern uint16_t g_wdnfree;
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* g_wdtick is the wheel's notion of the current time in ticks.  It is
+ * advanced by wd_timer() and wraps freely.
+ */
+
+extern uint32_t g_wdtick;
+
+/* g_wdwheel holds the active watchdogs.  Each slot is a doubly linked
+ * list so that a watchdog can be removed without searching, and
+ * g_wdwheelmap has one bit set for each non-empty slot of a level.
+ */
+
+extern dq_queue_t g_wdwheel[WD_WHEEL_LEVELS][WD_WHEEL_SIZE];
+extern uint32_t g_wdwheelmap[WD_WHEEL_LEVELS];
+#endif
+
 /************************************************************************
  * Public Function Prototypes
  ************************************************************************/
@@ -182,6 +220,38 @@ void wd_timer(void);
 struct tcb_s;
 void wd_recover(FAR struct tcb_s *tcb);
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/****************************************************************************
+ * Name: wd_wheel_*
+ *
+ * Description:
+ *   Timing wheel primitives used by wd_start(), wd_cancel() and wd_timer()
+ *   when CONFIG_WDOG_TIMERWHEEL is selected.
+ *
+ *   wd_wheel_initialize - Empty the wheel.
+ *   wd_wheel_add        - File an active watchdog according to wdog->expire.
+ *   wd_wheel_remove     - Unlink a watchdog from its slot.
+ *   wd_wheel_tick       - Advance g_wdtick by one tick and cascade watchdogs
+ *                         from the coarser levels that became due.
+ *   wd_wheel_expired    - Remove and return the next watchdog that expires
+ *                         at g_wdtick, or NULL.
+ *   wd_wheel_nextevent  - Return the number of ticks until the wheel next
+ *                         needs attention (an expiration or a cascade), or
+ *                         zero if the wheel is empty.
+ *
+ * Assumptions:
+ *   Called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+void wd_wheel_initialize(void);
+void wd_wheel_add(FAR struct wdog_s *wdog);
+void wd_wheel_remove(FAR struct wdog_s *wdog);
+void wd_wheel_tick(void);
+FAR struct wdog_s *wd_wheel_expired(void);
+unsigned int wd_wheel_nextevent(void);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -109,6 +109,35 @@
  *
  ****************************************************************************/
 
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
+{
+	irqstate_t flags;
+	int ret = -ENOENT;
+
+	DEBUGASSERT(work != NULL);
+
+	/* Work with no delay is in the ready FIFO; work_process() clears the
+	 * delay when it moves expired work there.
+	 */
+
+	flags = irqsave();
+	if (work_isqueued(wqueue, work)) {
+		if (work->delay == 0) {
+			dq_rem((FAR dq_entry_t *)work, &wqueue->ready);
+		} else {
+			dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+		}
+
+		work->worker = NULL;
+		work->wqueue = NULL;
+		ret = OK;
+	}
+
+	irqrestore(flags);
+	return ret;
+}
+#else
 static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
 {
 	struct work_s *cur_work;
@@ -154,6 +183,7 @@ static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wo
 	irqrestore(flags);
 	return ret;
 }
+#endif							/* CONFIG_SCHED_WORKQUEUE_DEADLINE */
 #endif
 
 /****************************************************************************
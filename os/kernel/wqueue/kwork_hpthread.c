@@ -56,6 +56,7 @@
 
 #include <tinyara/config.h>
 
+#include <sched.h>
 #include <errno.h>
 #include <queue.h>
 #include <debug.h>
@@ -177,6 +178,16 @@ int work_hpstart(void)
 
 	g_hpwork.delay = CONFIG_SCHED_HPWORKPERIOD / USEC_PER_TICK;
 	dq_init(&g_hpwork.q);
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	dq_init(&g_hpwork.ready);
+	g_hpwork.nthreads = 1;
+#endif
+
+	/* Don't permit the thread to run until we have fully initialized
+	 * g_hpwork.  Otherwise it could go idle before it is marked busy below.
+	 */
+
+	sched_lock();
 
 	/* Start the high-priority, kernel mode worker thread */
 
@@ -190,11 +201,14 @@ int work_hpstart(void)
 		DEBUGASSERT(errcode > 0);
 
 		slldbg("kernel_thread failed: %d\n", errcode);
+		sched_unlock();
 		return -errcode;
 	}
 
 	g_hpwork.worker[0].pid = pid;
 	g_hpwork.worker[0].busy = true;
+
+	sched_unlock();
 	return pid;
 }
 
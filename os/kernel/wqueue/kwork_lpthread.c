@@ -212,6 +212,10 @@ int work_lpstart(void)
 
 	g_lpwork.delay = CONFIG_SCHED_LPWORKPERIOD / USEC_PER_TICK;
 	dq_init(&g_lpwork.q);
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	dq_init(&g_lpwork.ready);
+	g_lpwork.nthreads = CONFIG_SCHED_LPNTHREADS;
+#endif
 
 	/* Don't permit any of the threads to run until we have fully initialized
 	 * g_lpwork.
@@ -124,6 +124,90 @@
  *   None
  *
  ****************************************************************************/
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
+{
+	FAR struct work_s *work;
+	worker_t worker;
+	irqstate_t flags;
+	FAR void *arg;
+	systime_t remaining;
+	systime_t next;
+
+	flags = irqsave();
+
+	/* Drain the ready FIFO.  Each pass takes the work at the head, so
+	 * nothing needs to be rescanned after interrupts are re-enabled to
+	 * perform the work.
+	 */
+
+	for (;;) {
+		work_expire(&wqueue->q, &wqueue->ready);
+
+		work = (FAR struct work_s *)dq_remfirst(&wqueue->ready);
+		if (work == NULL) {
+			break;
+		}
+
+		/* Extract the work description from the entry (in case the work
+		 * instance is re-used after it has been de-queued) and mark the
+		 * work as no longer being queued.
+		 */
+
+		worker = work->worker;
+		arg = work->arg;
+		work->worker = NULL;
+		work->wqueue = NULL;
+
+		/* If there is more ready work, let an idle worker thread share it */
+
+		if (wqueue->ready.head != NULL && wqueue->nthreads > 1) {
+			work_notify(wqueue, wqueue->nthreads);
+		}
+
+		if (worker != NULL) {
+			irqrestore(flags);
+			worker(arg);
+			flags = irqsave();
+		}
+	}
+
+	if (period == 0) {
+		sigset_t set;
+
+		/* Wait indefinitely until signalled with SIGWORK.  Only worker 0
+		 * waits with a timeout on the earliest delayed work.
+		 */
+
+		sigemptyset(&set);
+		sigaddset(&set, SIGWORK);
+
+		wqueue->worker[wndx].busy = false;
+		DEBUGVERIFY(sigwaitinfo(&set, NULL));
+		wqueue->worker[wndx].busy = true;
+	} else {
+		/* Wait until the earliest delayed work expires or until the end of
+		 * the polling period, whichever comes first.  Queueing work that
+		 * needs this worker sooner will wake it up with a signal.
+		 */
+
+		next = period;
+		work = (FAR struct work_s *)wqueue->q.head;
+		if (work != NULL) {
+			remaining = work_remaining(work, clock_systimer());
+			next = MIN(next, remaining);
+		}
+
+		if (next > 0) {
+			wqueue->worker[wndx].busy = false;
+			usleep(next * USEC_PER_TICK);
+			wqueue->worker[wndx].busy = true;
+		}
+	}
+
+	irqrestore(flags);
+}
+#else
 void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
 {
 	volatile FAR struct work_s *work;
@@ -303,5 +387,6 @@ void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
 
 	irqrestore(flags);
 }
+#endif							/* CONFIG_SCHED_WORKQUEUE_DEADLINE */
 
 #endif							/* CONFIG_SCHED_WORKQUEUE */
@@ -118,6 +118,63 @@
  *
  ****************************************************************************/
 
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
+{
+	FAR struct work_s *prev;
+	irqstate_t flags;
+	systime_t now;
+
+	DEBUGASSERT(work != NULL);
+
+	flags = irqsave();
+	if (work_isqueued(wqueue, work)) {
+		irqrestore(flags);
+		return -EALREADY;
+	}
+
+	now = clock_systimer();
+	work->worker = worker;		/* Work callback */
+	work->arg = arg;			/* Callback argument */
+	work->delay = delay;		/* Delay until work performed */
+	work->qtime = now;			/* Time work queued */
+	work->wqueue = wqueue;		/* Marks the work as queued */
+
+	if (delay == 0) {
+		/* Immediate work goes to the tail of the ready FIFO.  Any idle
+		 * worker may take it.
+		 */
+
+		dq_addlast((FAR dq_entry_t *)work, &wqueue->ready);
+		work_notify(wqueue, wqueue->nthreads);
+	} else {
+		/* Delayed work is kept in order of expiration.  Most work is queued
+		 * with similar delays, so search for the insertion point from the
+		 * tail of the list.
+		 */
+
+		prev = (FAR struct work_s *)wqueue->q.tail;
+		while (prev != NULL && work_remaining(prev, now) > delay) {
+			prev = (FAR struct work_s *)prev->dq.blink;
+		}
+
+		if (prev != NULL) {
+			dq_addafter((FAR dq_entry_t *)prev, (FAR dq_entry_t *)work, &wqueue->q);
+		} else {
+			dq_addfirst((FAR dq_entry_t *)work, &wqueue->q);
+
+			/* This is now the earliest deadline.  Only worker 0 waits with a
+			 * timeout, so it is the one that has to re-arm its wait.
+			 */
+
+			work_notify(wqueue, 1);
+		}
+	}
+
+	irqrestore(flags);
+	return OK;
+}
+#else
 static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
 {
 	struct work_s *cur_work;
@@ -162,6 +219,7 @@ static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wor
 
 	return OK;
 }
+#endif							/* CONFIG_SCHED_WORKQUEUE_DEADLINE */
 #endif
 
 /****************************************************************************
@@ -207,10 +265,14 @@ int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg,
 		/* Cancel high priority work */
 
 		result = work_qqueue((FAR struct kwork_wqueue_s *)&g_hpwork, work, worker, arg, delay);
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+		return result;
+#else
 		if (result != OK) {
 			return result;
 		}
 		return work_signal(HPWORK);
+#endif
 	} else
 #endif
 #ifdef CONFIG_SCHED_LPWORK
@@ -218,10 +280,14 @@ int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg,
 			/* Cancel low priority work */
 
 			result = work_qqueue((FAR struct kwork_wqueue_s *)&g_lpwork, work, worker, arg, delay);
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+			return result;
+#else
 			if (result != OK) {
 				return result;
 			}
 			return work_signal(LPWORK);
+#endif
 		} else
 #endif
 		{
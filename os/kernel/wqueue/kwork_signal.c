@@ -136,4 +136,39 @@ int work_signal(int qid)
 	return OK;
 }
 
+/****************************************************************************
+ * Name: work_notify
+ *
+ * Description:
+ *   Wake up one idle worker thread among the first 'nthreads' workers of
+ *   the work queue.  Must be called with interrupts disabled.
+ *
+ * Input parameters:
+ *   wqueue   - Describes the work queue
+ *   nthreads - Number of workers to consider, starting with worker 0
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+void work_notify(FAR struct kwork_wqueue_s *wqueue, int nthreads)
+{
+	int wndx;
+
+	for (wndx = 0; wndx < nthreads; wndx++) {
+		if (!wqueue->worker[wndx].busy) {
+			/* Mark the worker busy now so that it is not signalled again
+			 * before it has had a chance to look at the queues.
+			 */
+
+			wqueue->worker[wndx].busy = true;
+			(void)kill(wqueue->worker[wndx].pid, SIGWORK);
+			return;
+		}
+	}
+}
+#endif
+
 #endif							/* CONFIG_SCHED_WORKQUEUE */
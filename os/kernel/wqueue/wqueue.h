@@ -60,9 +60,13 @@
 #include <tinyara/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <queue.h>
 
+#include <tinyara/clock.h>
+#include <tinyara/wqueue.h>
+
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
@@ -89,6 +93,10 @@ struct kworker_s {
 struct kwork_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
 	struct dq_queue_s q;		/* The queue of pending work */
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	struct dq_queue_s ready;	/* FIFO of work ready to be performed */
+	uint8_t nthreads;			/* Number of worker threads */
+#endif
 	struct kworker_s worker[1];	/* Describes a worker thread */
 };
 
@@ -100,6 +108,10 @@ struct kwork_wqueue_s {
 struct hp_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
 	struct dq_queue_s q;		/* The queue of pending work */
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	struct dq_queue_s ready;	/* FIFO of work ready to be performed */
+	uint8_t nthreads;			/* Number of worker threads */
+#endif
 	struct kworker_s worker[1];	/* Describes the single high priority worker */
 };
 #endif
@@ -112,6 +124,10 @@ struct hp_wqueue_s {
 struct lp_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
 	struct dq_queue_s q;		/* The queue of pending work */
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+	struct dq_queue_s ready;	/* FIFO of work ready to be performed */
+	uint8_t nthreads;			/* Number of worker threads */
+#endif
 
 	/* Describes each thread in the low priority queue's thread pool */
 
@@ -198,5 +214,30 @@ int work_lpstart(void);
 
 void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx);
 
+#ifdef CONFIG_SCHED_WORKQUEUE_DEADLINE
+/****************************************************************************
+ * Name: work_notify
+ *
+ * Description:
+ *   Wake up one idle worker thread among the first 'nthreads' workers of
+ *   the work queue.  The worker is marked busy when it is signalled so
+ *   that further notifications are coalesced until it goes idle again.
+ *   Nothing is done if all of those workers are already busy; a busy
+ *   worker always rechecks the queues before it waits.
+ *
+ *   Must be called with interrupts disabled.
+ *
+ * Input parameters:
+ *   wqueue   - Describes the work queue
+ *   nthreads - Number of workers to consider, starting with worker 0
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void work_notify(FAR struct kwork_wqueue_s *wqueue, int nthreads);
+#endif
+
 #endif							/* CONFIG_SCHED_WORKQUEUE */
 #endif							/* __SCHED_WQUEUE_WQUEUE_H */
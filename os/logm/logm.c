@@ -30,18 +30,31 @@
 
 #include "logm.h"
 
+#ifndef CONFIG_LOGM_BINARY
 /* An additional line is for logm buffer overflow message */
 char g_logm_rsvbuf[LOGM_RSVBUF_COUNT + 1][LOGM_MAX_MSG_LEN];
 int g_logm_head;
 int g_logm_tail;
 int g_logm_count;
+#endif
 
 /* logm_internal hook for syslog & printfs */
 int logm_internal(int priority, const char *fmt, va_list ap)
 {
+#ifndef CONFIG_LOGM_BINARY
 	irqstate_t flags;
+#endif
 	int ret = 0;
 
+#ifdef CONFIG_LOGM_BINARY
+	if (g_logm_isready) {
+		/* Only the arguments are copied here, so this is safe from interrupt
+		 * handlers too.  The logm task does the formatting.
+		 */
+
+		ret = logm_bin_write(priority, fmt, ap);
+	} else
+#else
 	if (g_logm_isready && !up_interrupt_context()) {
 		flags = irqsave();
 
@@ -66,7 +79,9 @@ int logm_internal(int priority, const char *fmt, va_list ap)
 		g_logm_count++;
 
 		irqrestore(flags);
-	} else {
+	} else
+#endif
+	{
 		/* Low Output: Sytem is not yet completely ready or this is called from interrupt handler */
 #ifdef CONFIG_ARCH_LOWPUTC
 		struct lib_outstream_s strm;
@@ -20,6 +20,8 @@
 
 #include <queue.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
 #include <tinyara/config.h>
 
 /****************************************************************************
@@ -31,12 +33,63 @@
 #define LOGM_MAX_MSG_LEN CONFIG_LOGM_MAX_MSG_LENGTH
 #define LOGM_PRINTERR_AND_RETURN() do { dbg("LOGM Launch Failed \n"); return; } while (0)
 
+#ifdef CONFIG_LOGM_BINARY
+#define LOGM_BIN_RINGSIZE CONFIG_LOGM_BINARY_RINGSIZE
+#define LOGM_BIN_RINGMASK (LOGM_BIN_RINGSIZE - 1)
+
+#if (LOGM_BIN_RINGSIZE & LOGM_BIN_RINGMASK) != 0 || (LOGM_BIN_RINGSIZE & 3) != 0
+#error "CONFIG_LOGM_BINARY_RINGSIZE must be a power of two"
+#endif
+
+#if LOGM_BIN_RINGSIZE > 32768
+#error "CONFIG_LOGM_BINARY_RINGSIZE does not fit the 16-bit record length"
+#endif
+
+/* Largest binary record: header, argument words and copied strings */
+
+#define LOGM_BIN_MAXREC ((sizeof(struct logm_binhdr_s) + LOGM_MAX_MSG_LEN + 32) & ~3)
+
+/* The first word of a record holds its length, priority and a tag */
+
+#define LOGM_BIN_MAGIC 0xa5		/* A committed log record */
+#define LOGM_BIN_PAD   0x5a		/* Unused space up to the end of the ring */
+#define LOGM_BIN_WORD(len, pri, tag) ((uint32_t)(len) | ((uint32_t)(pri) << 16) | ((uint32_t)(tag) << 24))
+#define LOGM_BIN_LEN(word) ((word) & 0xffff)
+#define LOGM_BIN_PRI(word) (((word) >> 16) & 0xff)
+#define LOGM_BIN_TAG(word) ((word) >> 24)
+
+/* Raw records written to the console are preceded by these sync bytes */
+
+#define LOGM_BIN_SYNC0 'L'
+#define LOGM_BIN_SYNC1 'G'
+#endif
+
 /****************************************************************************
  * Private Declarations
  ****************************************************************************/
 
 /* Structure for a single debug message */
 
+#ifdef CONFIG_LOGM_BINARY
+/* Header of a binary log record.  It is followed by the arguments: one
+ * 32-bit word for each int, long, pointer and '*' width or precision, two
+ * words for each long long and floating point value, and a length word
+ * followed by the characters (padded to a word) for each string.
+ *
+ * A producer reserves space for the whole record with interrupts disabled
+ * only long enough to advance the ring tail, copies the record outside of
+ * the critical section and writes 'word' last.  A zero word means that the
+ * record is not yet committed.
+ */
+
+struct logm_binhdr_s {
+	uint32_t word;				/* Length, priority and tag, see LOGM_BIN_WORD */
+	uint32_t fmt;				/* Address of the format string */
+	uint32_t timestamp;			/* System timer ticks when logged */
+	uint32_t pid;				/* Task that logged the message */
+};
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 #define EXTERN extern "C"
@@ -51,6 +104,12 @@ EXTERN volatile int g_logm_isready;
  * Private Function Prototypes
  ************************************************************************************/
 int logm_task(int argc, char *argv[]);
+#ifdef CONFIG_LOGM_BINARY
+void logm_bin_initialize(void);
+int logm_bin_write(int priority, const char *fmt, va_list ap);
+void logm_bin_flush(void);
+void logm_bin_wait(void);
+#endif
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -0,0 +1,671 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+#include <semaphore.h>
+#include <tinyara/clock.h>
+#include <tinyara/logm.h>
+#include <arch/irq.h>
+
+#include "logm.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* How a printf conversion takes its argument */
+
+enum logm_argtype_e {
+	LOGM_ARG_NONE,				/* %% or an unknown conversion */
+	LOGM_ARG_INT,
+	LOGM_ARG_LONG,
+	LOGM_ARG_LLONG,
+	LOGM_ARG_SIZE,
+	LOGM_ARG_PTR,
+	LOGM_ARG_DOUBLE,
+	LOGM_ARG_LDOUBLE,
+	LOGM_ARG_STRING,
+	LOGM_ARG_COUNT				/* %n, the pointer is consumed but never written */
+};
+
+/* One conversion specification in a format string */
+
+struct logm_spec_s {
+	const char *start;			/* The '%' */
+	const char *end;			/* One past the conversion character */
+	uint8_t type;				/* See enum logm_argtype_e */
+	uint8_t nstar;				/* Number of '*' width and precision arguments */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Start and end of .text and .rodata, set up by the linker script.  Format
+ * strings in this range stay valid until the logm task formats them.
+ */
+
+extern uint32_t _stext;
+extern uint32_t _etext;
+
+/* Format used for messages which had to be formatted by the caller */
+
+static const char g_logm_strfmt[] = "%s";
+
+static uint32_t g_logm_binring[LOGM_BIN_RINGSIZE / sizeof(uint32_t)];
+static volatile uint32_t g_logm_binhead;	/* Consumer position, free running */
+static volatile uint32_t g_logm_bintail;	/* Reserved up to here, free running */
+static volatile uint32_t g_logm_bindropped;
+static volatile uint32_t g_logm_binhighwater;
+static volatile bool g_logm_binwaiting;	/* The logm task waits on g_logm_binsem */
+static sem_t g_logm_binsem;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Parse the conversion specification starting at the '%' in fmt */
+
+static const char *logm_bin_parse(const char *fmt, struct logm_spec_s *spec)
+{
+	int lng = 0;
+	bool size = false;
+	bool ldbl = false;
+
+	spec->start = fmt++;
+	spec->nstar = 0;
+
+	while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0') {
+		fmt++;
+	}
+
+	if (*fmt == '*') {
+		spec->nstar++;
+		fmt++;
+	} else {
+		while (*fmt >= '0' && *fmt <= '9') {
+			fmt++;
+		}
+	}
+
+	if (*fmt == '.') {
+		fmt++;
+		if (*fmt == '*') {
+			spec->nstar++;
+			fmt++;
+		} else {
+			while (*fmt >= '0' && *fmt <= '9') {
+				fmt++;
+			}
+		}
+	}
+
+	for (;; fmt++) {
+		if (*fmt == 'l') {
+			lng++;
+		} else if (*fmt == 'j') {
+			lng = 2;
+		} else if (*fmt == 'z' || *fmt == 't') {
+			size = true;
+		} else if (*fmt == 'L') {
+			ldbl = true;
+		} else if (*fmt != 'h') {
+			break;
+		}
+	}
+
+	switch (*fmt) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'c':
+		spec->type = lng >= 2 ? LOGM_ARG_LLONG : lng == 1 ? LOGM_ARG_LONG : size ? LOGM_ARG_SIZE : LOGM_ARG_INT;
+		break;
+	case 'p':
+		spec->type = LOGM_ARG_PTR;
+		break;
+	case 's':
+		spec->type = LOGM_ARG_STRING;
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		spec->type = ldbl ? LOGM_ARG_LDOUBLE : LOGM_ARG_DOUBLE;
+		break;
+	case 'n':
+		spec->type = LOGM_ARG_COUNT;
+		break;
+	case '\0':
+		spec->type = LOGM_ARG_NONE;
+		spec->end = fmt;
+		return fmt;
+	default:
+		spec->type = LOGM_ARG_NONE;
+		break;
+	}
+
+	spec->end = fmt + 1;
+	return spec->end;
+}
+
+/* Store 'size' bytes of an argument, padded to a word.  Returns NULL once
+ * the record is full; the rest of the arguments are then dropped.
+ */
+
+static uint8_t *logm_bin_put(uint8_t *ptr, uint8_t *end, const void *val, size_t size)
+{
+	if (ptr == NULL || (size_t)(end - ptr) < size) {
+		return NULL;
+	}
+
+	memcpy(ptr, val, size);
+	memset(ptr + size, 0, ((size + 3) & ~3) - size);
+	return ptr + ((size + 3) & ~3);
+}
+
+static uint8_t *logm_bin_putstr(uint8_t *ptr, uint8_t *end, const char *str)
+{
+	uint32_t len;
+
+	if (ptr == NULL || end - ptr < (ptrdiff_t)sizeof(uint32_t)) {
+		return NULL;
+	}
+
+	if (str == NULL) {
+		str = "(null)";
+	}
+
+	len = strnlen(str, end - ptr - sizeof(uint32_t));
+	memcpy(ptr, &len, sizeof(uint32_t));
+	memcpy(ptr + sizeof(uint32_t), str, len);
+	memset(ptr + sizeof(uint32_t) + len, 0, ((len + 3) & ~3) - len);
+	return ptr + sizeof(uint32_t) + ((len + 3) & ~3);
+}
+
+/* Read back an argument stored by logm_bin_put() */
+
+static bool logm_bin_get(const uint8_t **ptr, const uint8_t *end, void *val, size_t size)
+{
+	if ((size_t)(end - *ptr) < size) {
+		return false;
+	}
+
+	memcpy(val, *ptr, size);
+	*ptr += (size + 3) & ~3;
+	return true;
+}
+
+/* Copy the conversion specification, replacing each '*' with the stored
+ * width or precision.  'L' is dropped since long doubles are stored as
+ * doubles.
+ */
+
+static bool logm_bin_spec(const struct logm_spec_s *spec, const int *star, char *buf, size_t size)
+{
+	const char *src;
+	int nstar = 0;
+	int ret;
+
+	for (src = spec->start; src < spec->end; src++) {
+		if (size <= 1) {
+			return false;
+		}
+
+		if (*src == '*') {
+			ret = snprintf(buf, size, "%d", star[nstar++]);
+			if (ret < 0 || (size_t)ret >= size) {
+				return false;
+			}
+
+			buf += ret;
+			size -= ret;
+		} else if (*src != 'L') {
+			*buf++ = *src;
+			size--;
+		}
+	}
+
+	*buf = '\0';
+	return true;
+}
+
+/* Format the record into buf.  Returns the length of the message. */
+
+static int logm_bin_format(const struct logm_binhdr_s *hdr, char *buf, size_t size)
+{
+	const uint8_t *ptr = (const uint8_t *)(hdr + 1);
+	const uint8_t *end = (const uint8_t *)hdr + LOGM_BIN_LEN(hdr->word);
+	const char *fmt = (const char *)(uintptr_t)hdr->fmt;
+	struct logm_spec_s spec;
+	char str[LOGM_MAX_MSG_LEN + 1];
+	char conv[24];
+	size_t pos = 0;
+	int star[2];
+	int ret;
+	int i;
+
+	while (*fmt != '\0' && pos < size - 1) {
+		if (*fmt != '%') {
+			buf[pos++] = *fmt++;
+			continue;
+		}
+
+		fmt = logm_bin_parse(fmt, &spec);
+
+		for (i = 0; i < spec.nstar; i++) {
+			if (!logm_bin_get(&ptr, end, &star[i], sizeof(int))) {
+				goto truncated;
+			}
+		}
+
+		if (!logm_bin_spec(&spec, star, conv, sizeof(conv))) {
+			continue;
+		}
+
+		ret = 0;
+		switch (spec.type) {
+		case LOGM_ARG_NONE:
+			ret = snprintf(&buf[pos], size - pos, conv);
+			break;
+
+		case LOGM_ARG_INT: {
+			int val;
+			if (!logm_bin_get(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			ret = snprintf(&buf[pos], size - pos, conv, val);
+		}
+		break;
+
+		case LOGM_ARG_LONG: {
+			long val;
+			if (!logm_bin_get(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			ret = snprintf(&buf[pos], size - pos, conv, val);
+		}
+		break;
+
+		case LOGM_ARG_LLONG: {
+			long long val;
+			if (!logm_bin_get(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			ret = snprintf(&buf[pos], size - pos, conv, val);
+		}
+		break;
+
+		case LOGM_ARG_SIZE: {
+			size_t val;
+			if (!logm_bin_get(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			ret = snprintf(&buf[pos], size - pos, conv, val);
+		}
+		break;
+
+		case LOGM_ARG_PTR: {
+			void *val;
+			if (!logm_bin_get(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			ret = snprintf(&buf[pos], size - pos, conv, val);
+		}
+		break;
+
+		case LOGM_ARG_DOUBLE:
+		case LOGM_ARG_LDOUBLE: {
+			double val;
+			if (!logm_bin_get(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			ret = snprintf(&buf[pos], size - pos, conv, val);
+		}
+		break;
+
+		case LOGM_ARG_STRING: {
+			uint32_t len;
+			if (!logm_bin_get(&ptr, end, &len, sizeof(len)) || len > (uint32_t)(end - ptr)) {
+				goto truncated;
+			}
+			if (len > LOGM_MAX_MSG_LEN) {
+				len = LOGM_MAX_MSG_LEN;
+			}
+			memcpy(str, ptr, len);
+			str[len] = '\0';
+			ptr += (len + 3) & ~3;
+			ret = snprintf(&buf[pos], size - pos, conv, str);
+		}
+		break;
+
+		default:
+			break;
+		}
+
+		if (ret > 0) {
+			pos += ret;
+			if (pos > size - 1) {
+				pos = size - 1;
+			}
+		}
+	}
+
+truncated:
+	buf[pos] = '\0';
+	return pos;
+}
+
+/* Write one committed record to the console */
+
+static void logm_bin_output(const struct logm_binhdr_s *hdr)
+{
+#ifdef CONFIG_LOGM_BINARY_RAW
+	static const char sync[2] = { LOGM_BIN_SYNC0, LOGM_BIN_SYNC1 };
+
+	fwrite(sync, 1, sizeof(sync), stdout);
+	fwrite(hdr, 1, LOGM_BIN_LEN(hdr->word), stdout);
+#else
+	char line[LOGM_MAX_MSG_LEN + 1];
+	int len;
+
+	len = logm_bin_format(hdr, line, sizeof(line));
+
+	/* Keep the line break of truncated messages */
+
+	if (len >= LOGM_MAX_MSG_LEN) {
+		line[LOGM_MAX_MSG_LEN - 1] = '\n';
+	}
+
+	fputs(line, stdout);
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void logm_bin_initialize(void)
+{
+	g_logm_binhead = 0;
+	g_logm_bintail = 0;
+	g_logm_bindropped = 0;
+	g_logm_binhighwater = 0;
+	g_logm_binwaiting = false;
+	sem_init(&g_logm_binsem, 0, 0);
+}
+
+/* Queue a binary record.  This only copies the arguments, so it may be
+ * called from any context including interrupt handlers.
+ */
+
+int logm_bin_write(int priority, const char *fmt, va_list ap)
+{
+	uint32_t rec[LOGM_BIN_MAXREC / sizeof(uint32_t)];
+	struct logm_binhdr_s *hdr = (struct logm_binhdr_s *)rec;
+	uint8_t *ptr = (uint8_t *)(hdr + 1);
+	uint8_t *end = (uint8_t *)rec + sizeof(rec);
+	struct logm_spec_s spec;
+	uint8_t *last = ptr;
+	const char *src;
+	irqstate_t flags;
+	uint32_t tail;
+	uint32_t used;
+	uint32_t off;
+	uint32_t pad;
+	uint32_t len;
+	int i;
+
+	if ((uintptr_t)fmt >= (uintptr_t)&_stext && (uintptr_t)fmt < (uintptr_t)&_etext) {
+		/* Store the arguments as they are */
+
+		for (src = fmt; *src != '\0' && ptr != NULL;) {
+			if (*src != '%') {
+				src++;
+				continue;
+			}
+
+			src = logm_bin_parse(src, &spec);
+			last = ptr;
+			for (i = 0; i < spec.nstar; i++) {
+				int val = va_arg(ap, int);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+
+			switch (spec.type) {
+			case LOGM_ARG_INT: {
+				int val = va_arg(ap, int);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_LONG: {
+				long val = va_arg(ap, long);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_LLONG: {
+				long long val = va_arg(ap, long long);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_SIZE: {
+				size_t val = va_arg(ap, size_t);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_PTR: {
+				void *val = va_arg(ap, void *);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_DOUBLE: {
+				double val = va_arg(ap, double);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_LDOUBLE: {
+				double val = (double)va_arg(ap, long double);
+				ptr = logm_bin_put(ptr, end, &val, sizeof(val));
+			}
+			break;
+
+			case LOGM_ARG_STRING:
+				ptr = logm_bin_putstr(ptr, end, va_arg(ap, const char *));
+				break;
+
+			case LOGM_ARG_COUNT:
+				(void)va_arg(ap, void *);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		/* Commit only the arguments that fit.  The reader stops at the end
+		 * of the record.
+		 */
+
+		if (ptr == NULL) {
+			ptr = last;
+		}
+	} else {
+		/* The format string may not outlive the caller, format it now */
+
+		len = vsnprintf((char *)(ptr + sizeof(uint32_t)), LOGM_MAX_MSG_LEN + 1, fmt, ap);
+		if (len > LOGM_MAX_MSG_LEN) {
+			len = LOGM_MAX_MSG_LEN;
+		}
+
+		memcpy(ptr, &len, sizeof(uint32_t));
+		memset(ptr + sizeof(uint32_t) + len, 0, ((len + 3) & ~3) - len);
+		ptr += sizeof(uint32_t) + ((len + 3) & ~3);
+		fmt = g_logm_strfmt;
+	}
+
+	len = ptr - (uint8_t *)rec;
+	hdr->fmt = (uint32_t)(uintptr_t)fmt;
+	hdr->timestamp = (uint32_t)clock_systimer();
+	hdr->pid = (uint32_t)getpid();
+
+	/* Reserve contiguous space for the record.  If it does not fit before
+	 * the end of the ring, the rest of the ring is skipped with a padding
+	 * record.
+	 */
+
+	flags = irqsave();
+
+	tail = g_logm_bintail;
+	off = tail & LOGM_BIN_RINGMASK;
+	pad = off + len > LOGM_BIN_RINGSIZE ? LOGM_BIN_RINGSIZE - off : 0;
+	used = tail - g_logm_binhead;
+
+	if (used + pad + len > LOGM_BIN_RINGSIZE) {
+		g_logm_bindropped++;
+		irqrestore(flags);
+		return 0;
+	}
+
+	if (pad > 0) {
+		g_logm_binring[off / sizeof(uint32_t)] = LOGM_BIN_WORD(pad, 0, LOGM_BIN_PAD);
+		off = 0;
+	}
+
+	/* Not committed until the first word is written below */
+
+	g_logm_binring[off / sizeof(uint32_t)] = 0;
+	g_logm_bintail = tail + pad + len;
+
+	used += pad + len;
+	if (used > g_logm_binhighwater) {
+		g_logm_binhighwater = used;
+	}
+
+	irqrestore(flags);
+
+	/* Copy the record and commit it */
+
+	memcpy(&g_logm_binring[off / sizeof(uint32_t) + 1], &rec[1], len - sizeof(uint32_t));
+	*(volatile uint32_t *)&g_logm_binring[off / sizeof(uint32_t)] = LOGM_BIN_WORD(len, priority, LOGM_BIN_MAGIC);
+
+	/* Wake up the logm task if it is waiting for records */
+
+	if (g_logm_binwaiting) {
+		g_logm_binwaiting = false;
+		sem_post(&g_logm_binsem);
+	}
+
+	return 0;
+}
+
+/* Output all committed records.  Called only by the logm task. */
+
+void logm_bin_flush(void)
+{
+	static uint32_t reported;
+	const struct logm_binhdr_s *hdr;
+	uint32_t dropped;
+	uint32_t head;
+	uint32_t word;
+	char msg[48];
+
+	for (head = g_logm_binhead; head != g_logm_bintail; head += LOGM_BIN_LEN(word)) {
+		hdr = (const struct logm_binhdr_s *)&g_logm_binring[(head & LOGM_BIN_RINGMASK) / sizeof(uint32_t)];
+		word = *(volatile const uint32_t *)&hdr->word;
+		if (word == 0) {
+			/* Reserved, but the producer has not committed it yet */
+
+			break;
+		}
+
+		if (LOGM_BIN_TAG(word) == LOGM_BIN_MAGIC) {
+			logm_bin_output(hdr);
+		}
+
+		/* Release the space to the producers */
+
+		g_logm_binhead = head + LOGM_BIN_LEN(word);
+	}
+
+	dropped = g_logm_bindropped;
+	if (dropped != reported) {
+		snprintf(msg, sizeof(msg), "LOGM: %u messages dropped\n", (unsigned int)(dropped - reported));
+		fputs(msg, stdout);
+		reported = dropped;
+	}
+
+	fflush(stdout);
+}
+
+/* Wait until there is a committed record to output */
+
+void logm_bin_wait(void)
+{
+	uint32_t head;
+
+	/* Announce that we are about to wait before looking at the ring.  A
+	 * record committed after this point will post the semaphore.
+	 */
+
+	g_logm_binwaiting = true;
+
+	head = g_logm_binhead;
+	if (head != g_logm_bintail && g_logm_binring[(head & LOGM_BIN_RINGMASK) / sizeof(uint32_t)] != 0) {
+		g_logm_binwaiting = false;
+		return;
+	}
+
+	while (sem_wait(&g_logm_binsem) < 0) {
+		DEBUGASSERT(errno == EINTR);
+	}
+}
+
+int logm_getstats(struct logm_stats_s *stats)
+{
+	if (stats == NULL) {
+		return -EINVAL;
+	}
+
+	stats->dropped = g_logm_bindropped;
+	stats->highwater = g_logm_binhighwater;
+	stats->size = LOGM_BIN_RINGSIZE;
+	return OK;
+}
@@ -21,15 +21,31 @@
 #include "logm.h"
 
 volatile int g_logm_isready;
+#ifndef CONFIG_LOGM_BINARY
 extern char g_logm_rsvbuf[][LOGM_MAX_MSG_LEN];
 extern int g_logm_head;
 extern int g_logm_tail;
 extern int g_logm_count;
+#endif
 
 int logm_task(int argc, char *argv[])
 {
 	(void)argc;
 	(void)argv;
+#ifdef CONFIG_LOGM_BINARY
+	logm_bin_initialize();
+	/* Now logm is ready */
+	g_logm_isready = 1;
+
+#ifdef CONFIG_LOGM_TEST
+	logmtest_init();
+#endif
+
+	while (1) {
+		logm_bin_flush();
+		logm_bin_wait();
+	}
+#else
 	g_logm_head = 0;
 	g_logm_tail = 0;
 	g_logm_count = 0;
@@ -51,5 +67,6 @@ int logm_task(int argc, char *argv[])
 		}
 		sleep(1);
 	}
+#endif
 	return 0;					// Just to make compiler happy
 }
@@ -31,6 +31,10 @@ static int g_logmtest_handle = 123;
 /* LOGM test routine */
 static int logmtest_kthread(int argc, char *argv[])
 {
+#ifdef CONFIG_LOGM_BINARY
+	struct logm_stats_s stats;
+#endif
+
 	while (1) {
 		logm(1, 0, 3, "lom direct call test1 %d\n", g_logmtest_handle);
 		logm(1, 0, 3, "lom direct call test2 %d\n", g_logmtest_handle);
@@ -38,6 +42,11 @@ static int logmtest_kthread(int argc, char *argv[])
 		syslog(4, "syslog call test2 %d\n", g_logmtest_handle);
 		printf("Printf testcall1 %d\n", g_logmtest_handle);
 		printf("printf testcall2 %d\n", g_logmtest_handle);
+#ifdef CONFIG_LOGM_BINARY
+		if (logm_getstats(&stats) == OK) {
+			printf("logm ring %u bytes, highwater %u, dropped %u\n", stats.size, stats.highwater, stats.dropped);
+		}
+#endif
 
 		sleep(2);
 	}
@@ -93,6 +93,13 @@
 void kmm_free(FAR void *mem)
 {
 	DEBUGASSERT(kmm_heapmember(mem));
+#ifdef CONFIG_MM_CACHE
+	/* Small chunks go back to the small object cache */
+
+	if (mm_cache_free(&g_kmmheap, mem)) {
+		return;
+	}
+#endif
 	mm_free(&g_kmmheap, mem);
 }
 
@@ -103,7 +103,18 @@ FAR void *kmm_malloc(size_t size)
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	return mm_malloc(&g_kmmheap, size, __builtin_return_address(0));
 #else
+#ifdef CONFIG_MM_CACHE
+	/* Try the small object cache first */
+
+	FAR void *mem = mm_cache_alloc(&g_kmmheap, size);
+	if (mem) {
+		return mem;
+	}
+
 	return mm_malloc(&g_kmmheap, size);
+#else
+	return mm_malloc(&g_kmmheap, size);
+#endif
 #endif
 }
 
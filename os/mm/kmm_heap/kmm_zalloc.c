@@ -56,6 +56,8 @@
 
 #include <tinyara/config.h>
 
+#include <string.h>
+
 #include <tinyara/mm/mm.h>
 
 #ifdef CONFIG_MM_KERNEL_HEAP
@@ -86,9 +88,21 @@ FAR void *kmm_zalloc(size_t size)
 {
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	return mm_zalloc(&g_kmmheap, size, __builtin_return_address(0));
+#else
+#ifdef CONFIG_MM_CACHE
+	/* Try the small object cache first */
+
+	FAR void *mem = mm_cache_alloc(&g_kmmheap, size);
+	if (mem) {
+		memset(mem, 0, size);
+		return mem;
+	}
+
+	return mm_zalloc(&g_kmmheap, size);
 #else
 	return mm_zalloc(&g_kmmheap, size);
 #endif
+#endif
 }
 
 #endif							/* CONFIG_MM_KERNEL_HEAP */
@@ -0,0 +1,367 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_cache.c
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <arch/irq.h>
+#include <tinyara/sched.h>
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MM_CACHE_BATCH < 1 || CONFIG_MM_CACHE_BATCH > CONFIG_MM_CACHE_DEPTH
+#error CONFIG_MM_CACHE_BATCH must be between 1 and CONFIG_MM_CACHE_DEPTH
+#endif
+
+/* The next cached chunk is linked through the first word of the payload */
+
+#define MM_CACHE_NEXT(mem) (*(FAR void **)(mem))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_cache_band
+ *
+ * Description:
+ *   Return the cache band of the calling task.
+ *
+ ****************************************************************************/
+
+static inline FAR struct mm_cacheband_s *mm_cache_band(FAR struct mm_heap_s *heap)
+{
+	FAR struct tcb_s *tcb = sched_self();
+	int band = 0;
+
+	if (tcb) {
+		band = (tcb->sched_priority * CONFIG_MM_CACHE_NBANDS) / (SCHED_PRIORITY_MAX + 1);
+	}
+
+	return &heap->mm_cache.band[band];
+}
+
+/****************************************************************************
+ * Name: mm_cache_chunk2class
+ *
+ * Description:
+ *   Convert a chunk size into a cache size class.  Returns a negative value
+ *   if chunks of this size are not cached.
+ *
+ ****************************************************************************/
+
+static inline int mm_cache_chunk2class(size_t chunksize)
+{
+	int cls = (int)(chunksize >> MM_MIN_SHIFT) - 1;
+
+	return cls < MM_CACHE_NCLASSES ? cls : -1;
+}
+
+/****************************************************************************
+ * Name: mm_cache_push
+ *
+ * Description:
+ *   Push a chunk payload onto a cache list.  Interrupts must be disabled.
+ *
+ ****************************************************************************/
+
+static inline void mm_cache_push(FAR struct mm_cacheband_s *band, int cls, FAR void *mem)
+{
+	MM_CACHE_NEXT(mem) = band->head[cls];
+	band->head[cls] = mem;
+	band->count[cls]++;
+}
+
+/****************************************************************************
+ * Name: mm_cache_pop
+ *
+ * Description:
+ *   Pop a chunk payload from a cache list.  Interrupts must be disabled.
+ *
+ ****************************************************************************/
+
+static inline FAR void *mm_cache_pop(FAR struct mm_cacheband_s *band, int cls)
+{
+	FAR void *mem = band->head[cls];
+
+	if (mem) {
+		band->head[cls] = MM_CACHE_NEXT(mem);
+		band->count[cls]--;
+	}
+
+	return mem;
+}
+
+/****************************************************************************
+ * Name: mm_cache_refill
+ *
+ * Description:
+ *   Allocate a batch of chunks for one size class from the heap, holding
+ *   the heap semaphore once for the whole batch.  One chunk is returned to
+ *   the caller and the remainder are added to the cache.
+ *
+ ****************************************************************************/
+
+static FAR void *mm_cache_refill(FAR struct mm_heap_s *heap, FAR struct mm_cacheband_s *band, int cls)
+{
+	FAR struct mm_allocnode_s *node;
+	FAR void *batch[CONFIG_MM_CACHE_BATCH];
+	FAR void *ret = NULL;
+	irqstate_t flags;
+	size_t size;
+	int nalloc;
+	int i;
+
+	size = MM_CACHE_CLASSSIZE(cls) - SIZEOF_MM_ALLOCNODE;
+
+	/* mm_malloc() takes the semaphore again, but that is only a reference
+	 * count increment because this task already holds it.
+	 */
+
+	mm_takesemaphore(heap);
+	for (nalloc = 0; nalloc < CONFIG_MM_CACHE_BATCH; nalloc++) {
+		batch[nalloc] = mm_malloc(heap, size);
+		if (batch[nalloc] == NULL) {
+			break;
+		}
+	}
+	mm_givesemaphore(heap);
+
+	if (nalloc == 0) {
+		return NULL;
+	}
+
+	/* mm_malloc() may have handed out a slightly larger chunk than asked
+	 * for, so each chunk goes back into the class of its real size.
+	 */
+
+	ret = batch[0];
+	flags = irqsave();
+	for (i = 1; i < nalloc; i++) {
+		node = (FAR struct mm_allocnode_s *)((FAR char *)batch[i] - SIZEOF_MM_ALLOCNODE);
+		cls = mm_cache_chunk2class(node->size);
+		if (cls >= 0) {
+			mm_cache_push(band, cls, batch[i]);
+		} else {
+			/* Too large to cache; hand it straight back */
+
+			irqrestore(flags);
+			mm_free(heap, batch[i]);
+			flags = irqsave();
+		}
+	}
+	irqrestore(flags);
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: mm_cache_drain
+ *
+ * Description:
+ *   Return CONFIG_MM_CACHE_BATCH chunks of one size class to the heap,
+ *   holding the heap semaphore once for the whole batch.
+ *
+ ****************************************************************************/
+
+static void mm_cache_drain(FAR struct mm_heap_s *heap, FAR struct mm_cacheband_s *band, int cls)
+{
+	FAR void *batch[CONFIG_MM_CACHE_BATCH];
+	irqstate_t flags;
+	int ndrain;
+	int i;
+
+	flags = irqsave();
+	for (ndrain = 0; ndrain < CONFIG_MM_CACHE_BATCH; ndrain++) {
+		batch[ndrain] = mm_cache_pop(band, cls);
+		if (batch[ndrain] == NULL) {
+			break;
+		}
+	}
+
+	if (ndrain > 0) {
+		heap->mm_cache.stat[cls].drains++;
+	}
+	irqrestore(flags);
+
+	mm_takesemaphore(heap);
+	for (i = 0; i < ndrain; i++) {
+		mm_free(heap, batch[i]);
+	}
+	mm_givesemaphore(heap);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_cache_initialize
+ *
+ * Description:
+ *   Initialize the (empty) small object caches of a heap.
+ *
+ ****************************************************************************/
+
+void mm_cache_initialize(FAR struct mm_heap_s *heap)
+{
+	memset(&heap->mm_cache, 0, sizeof(struct mm_cache_s));
+}
+
+/****************************************************************************
+ * Name: mm_cache_alloc
+ *
+ * Description:
+ *   Allocate a small chunk from the calling task's cache, refilling the
+ *   cache from the heap if it is empty.
+ *
+ * Return Value:
+ *   The allocated memory or NULL if the size is not cached or the heap is
+ *   exhausted.  The caller should fall back to mm_malloc() on NULL, which
+ *   flushes the caches itself if the heap is exhausted.
+ *
+ ****************************************************************************/
+
+FAR void *mm_cache_alloc(FAR struct mm_heap_s *heap, size_t size)
+{
+	FAR struct mm_cacheband_s *band;
+	FAR void *mem;
+	irqstate_t flags;
+	int cls;
+
+	if (size < 1 || size > CONFIG_MM_CACHE_MAXSIZE) {
+		return NULL;
+	}
+
+	cls = mm_cache_chunk2class(MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE));
+	DEBUGASSERT(cls >= 0);
+	band = mm_cache_band(heap);
+
+	flags = irqsave();
+	mem = mm_cache_pop(band, cls);
+	if (mem) {
+		heap->mm_cache.stat[cls].hits++;
+		irqrestore(flags);
+		return mem;
+	}
+
+	heap->mm_cache.stat[cls].misses++;
+	irqrestore(flags);
+
+	return mm_cache_refill(heap, band, cls);
+}
+
+/****************************************************************************
+ * Name: mm_cache_free
+ *
+ * Description:
+ *   Return a chunk to the calling task's cache if it is small enough,
+ *   draining a batch back to the heap if the cache is full.
+ *
+ * Return Value:
+ *   true if the chunk was taken by the cache; false if the caller must
+ *   free it with mm_free().
+ *
+ ****************************************************************************/
+
+bool mm_cache_free(FAR struct mm_heap_s *heap, FAR void *mem)
+{
+	FAR struct mm_cacheband_s *band;
+	FAR struct mm_allocnode_s *node;
+	irqstate_t flags;
+	bool full;
+	int cls;
+
+	if (mem == NULL) {
+		return false;
+	}
+
+	node = (FAR struct mm_allocnode_s *)((FAR char *)mem - SIZEOF_MM_ALLOCNODE);
+	DEBUGASSERT((node->preceding & MM_ALLOC_BIT) != 0);
+
+	cls = mm_cache_chunk2class(node->size);
+	if (cls < 0) {
+		return false;
+	}
+
+	band = mm_cache_band(heap);
+
+	flags = irqsave();
+	mm_cache_push(band, cls, mem);
+	full = band->count[cls] > CONFIG_MM_CACHE_DEPTH;
+	irqrestore(flags);
+
+	if (full) {
+		mm_cache_drain(heap, band, cls);
+	}
+
+	return true;
+}
+
+/****************************************************************************
+ * Name: mm_cache_flush
+ *
+ * Description:
+ *   Return every cached chunk of every band to the heap.
+ *
+ ****************************************************************************/
+
+void mm_cache_flush(FAR struct mm_heap_s *heap)
+{
+	FAR struct mm_cacheband_s *band;
+	FAR void *mem;
+	irqstate_t flags;
+	int cls;
+	int i;
+
+	mvdbg("Flushing small object caches\n");
+
+	mm_takesemaphore(heap);
+	for (i = 0; i < CONFIG_MM_CACHE_NBANDS; i++) {
+		band = &heap->mm_cache.band[i];
+		for (cls = 0; cls < MM_CACHE_NCLASSES; cls++) {
+			do {
+				flags = irqsave();
+				mem = mm_cache_pop(band, cls);
+				irqrestore(flags);
+
+				if (mem) {
+					mm_free(heap, mem);
+				}
+			} while (mem);
+		}
+	}
+	mm_givesemaphore(heap);
+}
+
+#endif /* CONFIG_MM_CACHE */
@@ -99,7 +99,9 @@
  *  Find the smallest chunk that satisfies the request. Take the memory from
  *  that chunk, save the remaining, smaller chunk (if any).
  *
- *  8-byte alignment of the allocated data is assured.
+ *  8-byte alignment of the allocated data is assured.  If no chunk is
+ *  large enough, the small object caches are flushed and the search is
+ *  repeated once.
  *
  ****************************************************************************/
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
@@ -110,7 +112,6 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 {
 	FAR struct mm_freenode_s *node;
 	void *ret = NULL;
-	int ndx;
 
 	/* Handle bad sizes */
 
@@ -128,44 +129,37 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
 	mm_takesemaphore(heap);
 
-	/* Get the location in the node list to start the search. Special case
-	 * really big allocations
+	/* Search for a large enough free chunk.  With the size ordered nodelist
+	 * this is the best fitting chunk available; with CONFIG_MM_TLSF it is
+	 * the first chunk of a large enough size class.
 	 */
 
-	if (size >= MM_MAX_CHUNK) {
-		ndx = MM_NNODES - 1;
-	} else {
-		/* Convert the request size into a nodelist index */
-
-		ndx = mm_size2ndx(size);
-	}
+	node = mm_findfreechunk(heap, size);
 
-	/* Search for a large enough chunk in the list of nodes. This list is
-	 * ordered by size, but will have occasional zero sized nodes as we visit
-	 * other mm_nodelist[] entries.
+#if defined(CONFIG_MM_CACHE) && (defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__))
+	/* The heap may only look exhausted because the small object caches are
+	 * holding on to free chunks.  Give them back and search once more.  This
+	 * covers every allocator built on mm_malloc(), including calloc(),
+	 * memalign() and realloc().  The semaphore is held, but taking it again
+	 * only increments its count.
 	 */
 
-	for (node = heap->mm_nodelist[ndx].flink; node && node->size < size; node = node->flink) ;
+	if (!node) {
+		mm_cache_flush(heap);
+		node = mm_findfreechunk(heap, size);
+	}
+#endif
 
-	/* If we found a node with non-zero size, then this is one to use. Since
-	 * the list is ordered, we know that is must be best fitting chunk
-	 * available.
-	 */
+	/* If we found a node with non-zero size, then this is one to use. */
 
 	if (node) {
 		FAR struct mm_freenode_s *remainder;
 		FAR struct mm_freenode_s *next;
 		size_t remaining;
 
-		/* Remove the node.  There must be a predecessor, but there may not be
-		 * a successor node.
-		 */
+		/* Remove the node from the free list */
 
-		DEBUGASSERT(node->blink);
-		node->blink->flink = node->flink;
-		if (node->flink) {
-			node->flink->blink = node->blink;
-		}
+		mm_delfreechunk(heap, node);
 
 		/* Check if we have to split the free node into one of the allocated
 		 * size and another smaller freenode.  In some cases, the remaining
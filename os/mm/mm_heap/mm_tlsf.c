@@ -0,0 +1,266 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_tlsf.c
+ *
+ * Two-level segregated fit free chunk index.  This replaces the size ordered
+ * nodelist (mm_addfreechunk.c, mm_delfreechunk.c, mm_findfreechunk.c and
+ * mm_size2ndx.c) when CONFIG_MM_TLSF is selected.  Chunk headers and the
+ * physical chunk layout are unchanged, so mm_free(), mm_realloc(),
+ * mm_memalign(), mm_mallinfo() and the heapinfo logic work as before.
+ *
+ * A free chunk of size s lives in mm_freelist[fl][sl] where
+ *
+ *   fl = floor(log2(s)) - MM_MIN_SHIFT
+ *   sl = the MM_TLSF_SLSHIFT bits of s below its most significant bit
+ *
+ * Chunks of MM_MAX_CHUNK bytes or more all share the top first level class.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <assert.h>
+
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_TLSF
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MM_TLSF_SLMASK   (MM_TLSF_SLCOUNT - 1)
+
+/* Any chunk at least this large belongs to the last first level class */
+
+#define MM_TLSF_TOPSIZE  ((size_t)MM_MAX_CHUNK << 1)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_tlsf_fls
+ *
+ * Description:
+ *   Return the bit index of the most significant set bit of a non-zero
+ *   value.
+ *
+ ****************************************************************************/
+
+static inline int mm_tlsf_fls(size_t value)
+{
+#ifdef __GNUC__
+	return (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl((unsigned long)value);
+#else
+	int bit = 0;
+
+	while (value > 1) {
+		value >>= 1;
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+/****************************************************************************
+ * Name: mm_tlsf_ffs
+ *
+ * Description:
+ *   Return the bit index of the least significant set bit of a non-zero
+ *   bitmap.
+ *
+ ****************************************************************************/
+
+static inline int mm_tlsf_ffs(uint32_t bitmap)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(bitmap);
+#else
+	int bit = 0;
+
+	while ((bitmap & 1) == 0) {
+		bitmap >>= 1;
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+/****************************************************************************
+ * Name: mm_tlsf_mapping
+ *
+ * Description:
+ *   Convert a chunk size into its (first level, second level) class.
+ *
+ ****************************************************************************/
+
+static inline void mm_tlsf_mapping(size_t size, FAR int *fl, FAR int *sl)
+{
+	int msb;
+
+	if (size >= MM_TLSF_TOPSIZE) {
+		*fl = MM_NNODES - 1;
+		*sl = MM_TLSF_SLMASK;
+		return;
+	}
+
+	msb = mm_tlsf_fls(size);
+	*fl = msb - MM_MIN_SHIFT;
+	*sl = (int)(size >> (msb - MM_TLSF_SLSHIFT)) & MM_TLSF_SLMASK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_addfreechunk
+ *
+ * Description:
+ *   Add a free chunk to the head of its size class list.  It is assumed
+ *   that the caller holds the mm semaphore.
+ *
+ ****************************************************************************/
+
+void mm_addfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
+{
+	FAR struct mm_freenode_s *head;
+	int fl;
+	int sl;
+
+	mm_tlsf_mapping(node->size, &fl, &sl);
+
+	head = heap->mm_freelist[fl][sl];
+	node->blink = NULL;
+	node->flink = head;
+	if (head) {
+		head->blink = node;
+	}
+
+	heap->mm_freelist[fl][sl] = node;
+	heap->mm_flbitmap |= (uint32_t)1 << fl;
+	heap->mm_slbitmap[fl] |= (uint32_t)1 << sl;
+}
+
+/****************************************************************************
+ * Name: mm_delfreechunk
+ *
+ * Description:
+ *   Remove a free chunk from its size class list, clearing the bitmaps if
+ *   the list becomes empty.  It is assumed that the caller holds the mm
+ *   semaphore.
+ *
+ ****************************************************************************/
+
+void mm_delfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
+{
+	int fl;
+	int sl;
+
+	if (node->flink) {
+		node->flink->blink = node->blink;
+	}
+
+	if (node->blink) {
+		node->blink->flink = node->flink;
+		return;
+	}
+
+	/* This was the head of its list */
+
+	mm_tlsf_mapping(node->size, &fl, &sl);
+	DEBUGASSERT(heap->mm_freelist[fl][sl] == node);
+
+	heap->mm_freelist[fl][sl] = node->flink;
+	if (node->flink == NULL) {
+		heap->mm_slbitmap[fl] &= ~((uint32_t)1 << sl);
+		if (heap->mm_slbitmap[fl] == 0) {
+			heap->mm_flbitmap &= ~((uint32_t)1 << fl);
+		}
+	}
+}
+
+/****************************************************************************
+ * Name: mm_findfreechunk
+ *
+ * Description:
+ *   Find a free chunk of at least 'size' bytes (including the allocation
+ *   header).  The request is rounded up to the next size class boundary so
+ *   that any chunk in the first non-empty class at or above it is large
+ *   enough.  The chunk is left in its list.  It is assumed that the caller
+ *   holds the mm semaphore.
+ *
+ ****************************************************************************/
+
+FAR struct mm_freenode_s *mm_findfreechunk(FAR struct mm_heap_s *heap, size_t size)
+{
+	FAR struct mm_freenode_s *node;
+	uint32_t bitmap;
+	size_t rounded;
+	int fl;
+	int sl;
+
+	rounded = size + ((size_t)1 << (mm_tlsf_fls(size) - MM_TLSF_SLSHIFT)) - 1;
+	if (rounded >= size && rounded < MM_TLSF_TOPSIZE) {
+		mm_tlsf_mapping(rounded, &fl, &sl);
+
+		/* Look for a non-empty second level class in this first level
+		 * class.
+		 */
+
+		bitmap = heap->mm_slbitmap[fl] & (~(uint32_t)0 << sl);
+		if (bitmap == 0 && fl + 1 < MM_NNODES) {
+			/* None.  Look for a larger, non-empty first level class */
+
+			bitmap = heap->mm_flbitmap & (~(uint32_t)0 << (fl + 1));
+			if (bitmap != 0) {
+				fl = mm_tlsf_ffs(bitmap);
+				bitmap = heap->mm_slbitmap[fl];
+			}
+		}
+
+		if (bitmap != 0) {
+			sl = mm_tlsf_ffs(bitmap);
+			node = heap->mm_freelist[fl][sl];
+			DEBUGASSERT(node && node->size >= size);
+			return node;
+		}
+	}
+
+	/* Nothing in the classes above the request.  A chunk that is large
+	 * enough may still exist in the request's own class (the last class
+	 * is also unbounded above), so fall back to searching that one list.
+	 * This only happens when the heap is nearly exhausted or for requests
+	 * that fall in the last class.
+	 */
+
+	mm_tlsf_mapping(size, &fl, &sl);
+	for (node = heap->mm_freelist[fl][sl]; node && node->size < size; node = node->flink) ;
+
+	return node;
+}
+
+#endif /* CONFIG_MM_TLSF */
@@ -102,6 +102,13 @@
 
 void free(FAR void *mem)
 {
+#if defined(CONFIG_MM_CACHE) && defined(CONFIG_BUILD_FLAT)
+	/* Small chunks go back to the small object cache */
+
+	if (mm_cache_free(USR_HEAP, mem)) {
+		return;
+	}
+#endif
 	mm_free(USR_HEAP, mem);
 }
 
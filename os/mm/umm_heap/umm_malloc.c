@@ -151,7 +151,18 @@ FAR void *malloc(size_t size)
 	ARCH_GET_RET_ADDRESS
 	return mm_malloc(USR_HEAP, size, retaddr);
 #else
+#if defined(CONFIG_MM_CACHE) && defined(CONFIG_BUILD_FLAT)
+	/* Try the small object cache first */
+
+	FAR void *mem = mm_cache_alloc(USR_HEAP, size);
+	if (mem) {
+		return mem;
+	}
+
 	return mm_malloc(USR_HEAP, size);
+#else
+	return mm_malloc(USR_HEAP, size);
+#endif
 #endif
 #endif
 }
@@ -592,20 +592,8 @@ err_t netconn_send(struct netconn *conn, struct netbuf *buf)
 	return err;
 }
 
-/**
- * Send data over a TCP netconn.
- *
- * @param conn the TCP netconn over which to send data
- * @param dataptr pointer to the application buffer that contains the data to send
- * @param size size of the application data to send
- * @param apiflags combination of following flags :
- * - NETCONN_COPY: data will be copied into memory belonging to the stack
- * - NETCONN_MORE: for TCP connection, PSH flag will be set on last segment sent
- * - NETCONN_DONTBLOCK: only write the data if all dat can be written at once
- * @param bytes_written pointer to a location that receives the number of written bytes
- * @return ERR_OK if data was sent, any other err_t on error
- */
-err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written)
+/** Common part of netconn_write_partly() and netconn_write_zc() */
+static err_t netconn_write_data(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, struct tcp_zc *zc, size_t *bytes_written)
 {
 	struct api_msg msg;
 	err_t err;
@@ -629,6 +617,11 @@ err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t siz
 	msg.msg.msg.w.dataptr = dataptr;
 	msg.msg.msg.w.apiflags = apiflags;
 	msg.msg.msg.w.len = size;
+#if LWIP_TCP_ZEROCOPY
+	msg.msg.msg.w.zc = zc;
+#else
+	LWIP_UNUSED_ARG(zc);
+#endif							/* LWIP_TCP_ZEROCOPY */
 #if LWIP_SO_SNDTIMEO
 	if (conn->send_timeout != 0) {
 		/* get the time we started, which is later compared to
@@ -661,6 +654,45 @@ err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t siz
 	return err;
 }
 
+/**
+ * Send data over a TCP netconn.
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags combination of following flags :
+ * - NETCONN_COPY: data will be copied into memory belonging to the stack
+ * - NETCONN_MORE: for TCP connection, PSH flag will be set on last segment sent
+ * - NETCONN_DONTBLOCK: only write the data if all dat can be written at once
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @return ERR_OK if data was sent, any other err_t on error
+ */
+err_t netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, size_t *bytes_written)
+{
+	return netconn_write_data(conn, dataptr, size, apiflags, NULL, bytes_written);
+}
+
+#if LWIP_TCP_ZEROCOPY
+/**
+ * Send data over a TCP netconn without copying it. The data is referenced
+ * by the segments queued on the connection and must stay valid until the
+ * completion function of 'zc' is called (see tcp_write_zc()).
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags NETCONN_MORE and/or NETCONN_DONTBLOCK (NETCONN_COPY is ignored)
+ * @param zc descriptor initialized with tcp_zc_init()
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @return ERR_OK if data was sent, any other err_t on error
+ */
+err_t netconn_write_zc(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags, struct tcp_zc *zc, size_t *bytes_written)
+{
+	LWIP_ERROR("netconn_write_zc: invalid zc", (zc != NULL), return ERR_ARG;);
+	return netconn_write_data(conn, dataptr, size, apiflags & ~NETCONN_COPY, zc, bytes_written);
+}
+#endif							/* LWIP_TCP_ZEROCOPY */
+
 /**
  * Close ot shutdown a TCP netconn (doesn't delete it).
  *
@@ -1260,7 +1260,14 @@ static err_t do_writemore(struct netconn *conn)
 			}
 		}
 		LWIP_ASSERT("do_writemore: invalid length!", ((conn->write_offset + len) <= conn->current_msg->msg.w.len));
-		err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+#if LWIP_TCP_ZEROCOPY
+		if (conn->current_msg->msg.w.zc != NULL) {
+			err = tcp_write_zc(conn->pcb.tcp, dataptr, len, apiflags, conn->current_msg->msg.w.zc);
+		} else
+#endif							/* LWIP_TCP_ZEROCOPY */
+		{
+			err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+		}
 		/* if OK or memory error, check available space */
 		if ((err == ERR_OK) || (err == ERR_MEM)) {
 err_mem:
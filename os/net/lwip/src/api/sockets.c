@@ -96,6 +96,7 @@
 
 #include <string.h>
 #include <poll.h>
+#include <tinyara/fs/fs.h>
 #include <time.h>
 
 #define NUM_SOCKETS MEMP_NUM_NETCONN
@@ -116,8 +117,8 @@ struct lwip_select_cb {
 	/** semaphore to wake up a task waiting for select */
 	sys_sem_t sem;
 #else
-	/** Pointer to semaphore used post output event */
-	sys_sem_t *poll_sem;
+	/** poll descriptor to notify of output events */
+	struct pollfd *fds;
 	/** Pointer to event-set of requested poll events */
 	pollevent_t events;
 	/** socket descriptor value */
@@ -149,8 +150,16 @@ struct lwip_setgetsockopt_data {
 	err_t err;
 };
 
+#if LWIP_SELECT
 /** The global list of tasks waiting for select */
 static struct lwip_select_cb *select_cb_list;
+
+/** A select call waits on a set of sockets, so all of them share a list */
+#define SELECT_CB_LIST(sock) select_cb_list
+#else
+/** A poll or epoll waiter watches one socket, which keeps its own list */
+#define SELECT_CB_LIST(sock) ((sock)->select_cb)
+#endif
 /** This counter is increased from lwip_select when the list is chagned
     and checked in event_callback to see if it has changed. */
 static volatile int select_cb_ctr;
@@ -352,6 +361,7 @@ int alloc_socket(struct netconn *newconn, int accepted)
 				list->sl_sockets[i].errevent = 0;
 				list->sl_sockets[i].err = 0;
 				list->sl_sockets[i].select_waiting = 0;
+				list->sl_sockets[i].select_cb = NULL;
 				_net_semgive(list);
 
 				return i + LWIP_SOCKET_OFFSET;
@@ -554,6 +564,10 @@ int lwip_close(int s)
 int lwip_sock_close(struct socket *sock)
 {
 	int is_tcp = 0;
+#if !LWIP_SELECT && defined(CONFIG_FS_EPOLL)
+	/* Unregister the socket from epoll before its select_cb goes away */
+	epoll_detach(sock);
+#endif
 	if (sock->conn != NULL) {
 		is_tcp = netconn_type(sock->conn) == NETCONN_TCP;
 	} else {
@@ -866,6 +880,127 @@ int lwip_send(int s, const void *data, size_t size, int flags)
 	return (err == ERR_OK ? (int)written : -1);
 }
 
+#if LWIP_TCP_ZEROCOPY
+/**
+ * Send data over a TCP socket without copying it. The segments queued on
+ * the connection reference 'data', which must stay untouched until the
+ * completion function of 'zc' has been called. The caller initializes
+ * 'zc' with tcp_zc_init() and hands over its reference: the completion
+ * function is called exactly once, also when this function fails, from
+ * the tcpip thread (or this thread), so it must not block.
+ *
+ * @return the number of bytes queued or -1 with errno set
+ */
+int lwip_send_ref(int s, const void *data, size_t size, int flags, struct tcp_zc *zc)
+{
+	struct socket *sock;
+	err_t err;
+	u8_t write_flags;
+	size_t written;
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_ref(%d, data=%p, size=%" SZT_F ", flags=0x%x)\n", s, data, size, flags));
+
+	sock = get_socket(s);
+	if (!sock) {
+		tcp_zc_release(zc);
+		return -1;
+	}
+
+	if (sock->conn->type != NETCONN_TCP) {
+		tcp_zc_release(zc);
+		sock_set_errno(sock, EOPNOTSUPP);
+		return -1;
+	}
+
+	write_flags = ((flags & MSG_MORE) ? NETCONN_MORE : 0) | ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+	written = 0;
+	err = netconn_write_zc(sock->conn, data, size, write_flags, zc, &written);
+	/* every queued segment holds its own reference */
+	tcp_zc_release(zc);
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_ref(%d) err=%d written=%" SZT_F "\n", s, err, written));
+	sock_set_errno(sock, err_to_errno(err));
+	return (err == ERR_OK ? (int)written : -1);
+}
+
+/**
+ * Receive data from a TCP socket without copying it. On success '*loan' is
+ * the received pbuf chain, which the caller reads in place and returns with
+ * lwip_recv_loan_free(). The receive window is only opened again when the
+ * loan is returned, so loans should not be held for long.
+ *
+ * @return the number of bytes in the chain, 0 if the connection was closed
+ *         or -1 with errno set
+ */
+int lwip_recv_loan(int s, struct pbuf **loan, int flags)
+{
+	struct socket *sock;
+	struct pbuf *p;
+	u16_t off;
+	err_t err;
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_loan(%d, 0x%x)\n", s, flags));
+	sock = get_socket(s);
+	if (!sock) {
+		return -1;
+	}
+	if (netconn_type(sock->conn) != NETCONN_TCP) {
+		sock_set_errno(sock, EOPNOTSUPP);
+		return -1;
+	}
+
+	if (sock->lastdata) {
+		/* data left from the last recv operation: drop what was consumed */
+		p = (struct pbuf *)sock->lastdata;
+		off = sock->lastoffset;
+		sock->lastdata = NULL;
+		sock->lastoffset = 0;
+		while (off >= p->len) {
+			struct pbuf *next = p->next;
+			LWIP_ASSERT("lastoffset < tot_len", next != NULL);
+			off -= p->len;
+			pbuf_ref(next);
+			pbuf_free(p);
+			p = next;
+		}
+		pbuf_header(p, -(s16_t) off);
+	} else {
+		if (((flags & MSG_DONTWAIT) || netconn_is_nonblocking(sock->conn)) && (sock->rcvevent <= 0)) {
+			LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_loan(%d): returning EWOULDBLOCK\n", s));
+			sock_set_errno(sock, EWOULDBLOCK);
+			return -1;
+		}
+
+		err = netconn_recv_tcp_pbuf(sock->conn, &p);
+		if (err != ERR_OK) {
+			LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_loan(%d): error is \"%s\"!\n", s, lwip_strerr(err)));
+			sock_set_errno(sock, err_to_errno(err));
+			return (err == ERR_CLSD) ? 0 : -1;
+		}
+		LWIP_ASSERT("p != NULL", p != NULL);
+	}
+
+	*loan = p;
+	sock_set_errno(sock, 0);
+	return p->tot_len;
+}
+
+/**
+ * Return a pbuf chain received with lwip_recv_loan() and open the receive
+ * window by its length.
+ */
+void lwip_recv_loan_free(int s, struct pbuf *loan)
+{
+	struct socket *sock;
+
+	sock = get_socket(s);
+	if (sock != NULL && sock->conn != NULL) {
+		netconn_recved(sock->conn, loan->tot_len);
+	}
+	pbuf_free(loan);
+}
+#endif							/* LWIP_TCP_ZEROCOPY */
+
 int lwip_sendto(int s, const void *data, size_t size, int flags, const struct sockaddr *to, socklen_t tolen)
 {
 	struct socket *sock;
@@ -873,9 +1008,7 @@ int lwip_sendto(int s, const void *data, size_t size, int flags, const struct so
 	u16_t short_size;
 	const struct sockaddr_in *to_in;
 	u16_t remote_port;
-#if !LWIP_TCPIP_CORE_LOCKING
 	struct netbuf buf;
-#endif
 
 	sock = get_socket(s);
 	if (!sock) {
@@ -897,73 +1030,8 @@ int lwip_sendto(int s, const void *data, size_t size, int flags, const struct so
 	LWIP_ERROR("lwip_sendto: invalid address", (((to == NULL) && (tolen == 0)) || ((tolen == sizeof(struct sockaddr_in)) && ((to->sa_family) == AF_INET) && ((((mem_ptr_t) to) % 4) == 0))), sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
 	to_in = (const struct sockaddr_in *)(void *)to;
 
-#if LWIP_TCPIP_CORE_LOCKING
-	/* Should only be consider like a sample or a simple way to experiment this option (no check of "to" field...) */
-	{
-		struct pbuf *p;
-		ip_addr_t *remote_addr;
-
-#if LWIP_NETIF_TX_SINGLE_PBUF
-		p = pbuf_alloc(PBUF_TRANSPORT, short_size, PBUF_RAM);
-		if (p != NULL) {
-#if LWIP_CHECKSUM_ON_COPY
-			u16_t chksum = 0;
-			if (sock->conn->type != NETCONN_RAW) {
-				chksum = LWIP_CHKSUM_COPY(p->payload, data, short_size);
-			} else
-#endif							/* LWIP_CHECKSUM_ON_COPY */
-				MEMCPY(p->payload, data, size);
-#else							/* LWIP_NETIF_TX_SINGLE_PBUF */
-		p = pbuf_alloc(PBUF_TRANSPORT, short_size, PBUF_REF);
-		if (p != NULL) {
-			p->payload = (void *)data;
-#endif							/* LWIP_NETIF_TX_SINGLE_PBUF */
-
-			if (to_in != NULL) {
-				inet_addr_to_ipaddr_p(remote_addr, &to_in->sin_addr);
-				remote_port = ntohs(to_in->sin_port);
-			} else {
-				remote_addr = &sock->conn->pcb.ip->remote_ip;
-#if LWIP_UDP
-				if (NETCONNTYPE_GROUP(sock->conn->type) == NETCONN_UDP) {
-					remote_port = sock->conn->pcb.udp->remote_port;
-				} else
-#endif							/* LWIP_UDP */
-				{
-					remote_port = 0;
-				}
-			}
-
-			LOCK_TCPIP_CORE();
-			if (netconn_type(sock->conn) == NETCONN_RAW) {
-#if LWIP_RAW
-				err = sock->conn->last_err = raw_sendto(sock->conn->pcb.raw, p, remote_addr);
-#else							/* LWIP_RAW */
-				err = ERR_ARG;
-#endif							/* LWIP_RAW */
-			}
-#if LWIP_UDP && LWIP_RAW
-			else
-#endif							/* LWIP_UDP && LWIP_RAW */
-			{
-#if LWIP_UDP
-#if LWIP_CHECKSUM_ON_COPY && LWIP_NETIF_TX_SINGLE_PBUF
-				err = sock->conn->last_err = udp_sendto_chksum(sock->conn->pcb.udp, p, remote_addr, remote_port, 1, chksum);
-#else							/* LWIP_CHECKSUM_ON_COPY && LWIP_NETIF_TX_SINGLE_PBUF */
-				err = sock->conn->last_err = udp_sendto(sock->conn->pcb.udp, p, remote_addr, remote_port);
-#endif							/* LWIP_CHECKSUM_ON_COPY && LWIP_NETIF_TX_SINGLE_PBUF */
-#else							/* LWIP_UDP */
-				err = ERR_ARG;
-#endif							/* LWIP_UDP */
-			}
-			UNLOCK_TCPIP_CORE();
-
-			pbuf_free(p);
-		} else {
-			err = ERR_MEM;
-		}
-	}
-#else							/* LWIP_TCPIP_CORE_LOCKING */
+	/* with LWIP_TCPIP_CORE_LOCKING, netconn_send() runs do_send() directly
+	   in this thread, so there is no need to bypass the netconn layer */
 	/* initialize a buffer */
 	buf.p = buf.ptr = NULL;
 #if LWIP_CHECKSUM_ON_COPY
@@ -1001,6 +1069,7 @@ int lwip_sendto(int s, const void *data, size_t size, int flags, const struct so
 		}
 	}
 #else							/* LWIP_NETIF_TX_SINGLE_PBUF */
+	/* No copy here, udp_sendto() sums the data where it is */
 	err = netbuf_ref(&buf, data, short_size);
 #endif							/* LWIP_NETIF_TX_SINGLE_PBUF */
 	if (err == ERR_OK) {
@@ -1010,7 +1079,6 @@ int lwip_sendto(int s, const void *data, size_t size, int flags, const struct so
 
 	/* deallocated the buffer */
 	netbuf_free(&buf);
-#endif							/* LWIP_TCPIP_CORE_LOCKING */
 	sock_set_errno(sock, err_to_errno(err));
 	return (err == ERR_OK ? short_size : -1);
 }
@@ -1422,10 +1490,17 @@ static int lwip_poll_setup(int fd, struct socket * sock, struct pollfd * fds)
 	nready = lwip_poll_scan(fd, sock, fds);
 	LWIP_DEBUGF(POLL_DEBUG, ("first nready=%d\n", nready));
 
-	/* Check if any requested events are already in effect */
-	if (nready > 0 && fds->revents != 0) {
+	/* Check if any requested events are already in effect.  An epoll
+	 * descriptor stays registered after it has been reported, so it needs
+	 * its select_cb even then to hear about the later events.
+	 */
+	if (nready > 0 && fds->revents != 0
+#ifdef CONFIG_FS_EPOLL
+		&& fds->cb == NULL
+#endif
+	   ) {
 		/* Yes.. then signal the poll logic */
-		sys_sem_signal(fds->sem);
+		poll_notify(fds);
 		return 0;
 	}
 
@@ -1443,21 +1518,21 @@ static int lwip_poll_setup(int fd, struct socket * sock, struct pollfd * fds)
 	select_cb->next = NULL;
 	select_cb->prev = NULL;
 	select_cb->sem_signalled = 0;
-	select_cb->poll_sem = fds->sem;
+	select_cb->fds = fds;
 	select_cb->events = fds->events;
 	select_cb->sfd = fd;
 
-	/* Protect the select_cb_list */
+	/* Protect the select_cb list of the socket */
 	SYS_ARCH_PROTECT(lev);
 
 	/* Put this select_cb on top of list */
-	select_cb->next = select_cb_list;
-	if (select_cb_list != NULL) {
-		select_cb_list->prev = select_cb;
+	select_cb->next = sock->select_cb;
+	if (sock->select_cb != NULL) {
+		sock->select_cb->prev = select_cb;
 	}
 
 	fds->scb = (void *)select_cb;
-	select_cb_list = select_cb;
+	sock->select_cb = select_cb;
 
 	/* Increasing this counter tells event_callback that the list has changed. */
 	select_cb_ctr++;
@@ -1477,7 +1552,7 @@ static int lwip_poll_setup(int fd, struct socket * sock, struct pollfd * fds)
 	if (nready > 0 && fds->revents != 0) {
 		/* Yes.. then signal the poll logic */
 
-		sys_sem_signal(fds->sem);
+		poll_notify(fds);
 	}
 
 	return 0;
@@ -1491,24 +1566,29 @@ static int lwip_poll_teardown(int fd, struct socket * sock, struct pollfd * fds)
 	select_cb = (struct lwip_select_cb *)fds->scb;
 
 	SYS_ARCH_PROTECT(lev);
-	if (sock->select_waiting > 0) {
-		sock->select_waiting--;
-	}
 
-	/* Take select_cb_list off the list */
+	/* Take select_cb off the list of the socket.  Setup does not register
+	 * a select_cb (nor count the socket as waited on) when the socket was
+	 * already ready.
+	 */
 	if (select_cb) {
+		if (sock->select_waiting > 0) {
+			sock->select_waiting--;
+		}
+
 		if (select_cb->next != NULL) {
 			select_cb->next->prev = select_cb->prev;
 		}
-		if (select_cb_list == select_cb) {
+		if (sock->select_cb == select_cb) {
 			LWIP_ASSERT("select_cb.prev == NULL", select_cb->prev == NULL);
-			select_cb_list = select_cb->next;
+			sock->select_cb = select_cb->next;
 		} else {
 			LWIP_ASSERT("select_cb.prev != NULL", select_cb->prev != NULL);
 			select_cb->prev->next = select_cb->next;
 		}
 
 		mem_free((void *)select_cb);
+		fds->scb = NULL;
 		/* Increasing this counter tells event_callback that the list has changed. */
 		select_cb_ctr++;
 	}
@@ -1540,9 +1620,6 @@ static int lwip_poll_teardown(int fd, struct socket * sock, struct pollfd * fds)
 
 int lwip_poll(int fd, struct pollfd * fds, bool setup)
 {
-
-	int ret = 0;
-
 	struct socket *sock = NULL;
 
 	/* First get the socket's status (protected)... */
@@ -1552,6 +1629,23 @@ int lwip_poll(int fd, struct pollfd * fds, bool setup)
 		return -EBADF;
 	}
 
+	return lwip_sock_poll(fd, sock, fds, setup);
+}
+
+/****************************************************************************
+ * Function: lwip_sock_poll
+ *
+ * Description:
+ *   Same as lwip_poll(), for a socket that is already looked up.  Used by
+ *   epoll, which may tear down the poll from a task that does not own the
+ *   socket.
+ *
+ ****************************************************************************/
+
+int lwip_sock_poll(int fd, struct socket * sock, struct pollfd * fds, bool setup)
+{
+	int ret = 0;
+
 	/* Check if we are setting up or tearing down the poll */
 
 	if (setup) {
@@ -1580,6 +1674,9 @@ static void event_callback(struct netconn * conn, enum netconn_evt evt, u16_t le
 	struct socket *sock;
 	struct lwip_select_cb *scb;
 	int last_select_cb_ctr;
+#if !LWIP_SELECT
+	pollevent_t revents;
+#endif
 	SYS_ARCH_DECL_PROTECT(lev);
 
 	LWIP_UNUSED_ARG(len);
@@ -1640,32 +1737,47 @@ static void event_callback(struct netconn * conn, enum netconn_evt evt, u16_t le
 	}
 
 	if (sock->select_waiting == 0) {
-		/* none is waiting for this socket, no need to check select_cb_list */
+		/* none is waiting for this socket, no need to check the select_cbs */
 		SYS_ARCH_UNPROTECT(lev);
 		return;
 	}
 
 	/* Now decide if anyone is waiting for this socket */
-	/* NOTE: This code goes through the select_cb_list list multiple times
+	/* NOTE: This code goes through the select_cb list multiple times
 	   ONLY IF a select was actually waiting. We go through the list the number
-	   of waiting select calls + 1. This list is expected to be small. */
+	   of waiting select calls + 1. With poll, the list only holds the waiters
+	   of this socket. */
 
 	/* At this point, SYS_ARCH is still protected! */
 again:
-	for (scb = select_cb_list; scb != NULL; scb = scb->next) {
+	for (scb = SELECT_CB_LIST(sock); scb != NULL; scb = scb->next) {
 
 		/* remember the state of select_cb_list to detect changes */
 		last_select_cb_ctr = select_cb_ctr;
+#if !LWIP_SELECT && defined(CONFIG_FS_EPOLL)
+		/* epoll_wait() clears revents when it consumes the events of a
+		 * descriptor, which stays registered: signal it again from now on.
+		 */
+		if (scb->sem_signalled && scb->fds->cb != NULL && scb->fds->revents == 0) {
+			scb->sem_signalled = 0;
+		}
+#endif
 		if (scb->sem_signalled == 0) {
 			/* semaphore not signalled yet */
 			int do_signal = 0;
 			int check_set = 0;
+#if !LWIP_SELECT
+			revents = 0;
+#endif
 			/* Test this select call for our socket */
 			if (sock->rcvevent > 0) {
 #if LWIP_SELECT
 				check_set = scb->readset && FD_ISSET(s, scb->readset);
 #else
 				check_set = (scb->sfd == s) && (scb->events & POLLIN);
+				if (check_set) {
+					revents |= POLLIN;
+				}
 #endif
 				if (check_set) {
 					do_signal = 1;
@@ -1676,6 +1788,9 @@ again:
 				check_set = scb->writeset && FD_ISSET(s, scb->writeset);
 #else
 				check_set = (scb->sfd == s) && (scb->events & POLLOUT);
+				if (check_set) {
+					revents |= POLLOUT;
+				}
 #endif
 				if (!do_signal && check_set) {
 					do_signal = 1;
@@ -1686,6 +1801,9 @@ again:
 				check_set = scb->exceptset && FD_ISSET(s, scb->exceptset);
 #else
 				check_set = (scb->sfd == s) && (scb->events & POLLERR);
+				if (check_set) {
+					revents |= POLLERR;
+				}
 #endif
 				if (!do_signal && check_set) {
 					do_signal = 1;
@@ -1698,7 +1816,8 @@ again:
 #if LWIP_SELECT
 				sys_sem_signal(&scb->sem);
 #else
-				sys_sem_signal(scb->poll_sem);
+				scb->fds->revents |= revents;
+				poll_notify(scb->fds);
 #endif
 			}
 		}
@@ -1707,7 +1826,7 @@ again:
 		/* this makes sure interrupt protection time is short */
 		SYS_ARCH_PROTECT(lev);
 		if (last_select_cb_ctr != select_cb_ctr) {
-			/* someone has changed select_cb_list, restart at the beginning */
+			/* someone has changed a select_cb list, restart at the beginning */
 			goto again;
 		}
 	}
@@ -78,6 +78,82 @@ static sys_mbox_t mbox;
 sys_mutex_t lock_tcpip_core;
 #endif							/* LWIP_TCPIP_CORE_LOCKING */
 
+/**
+ * Process one message of the tcpip_thread mailbox. A NULL message is
+ * reported and ignored.
+ * Called with the core lock held.
+ *
+ * @param msg the message to process
+ */
+static void tcpip_thread_handle_msg(struct tcpip_msg *msg)
+{
+	if (msg == NULL) {
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: NULL\n"));
+		LWIP_ASSERT("tcpip_thread: invalid message", 0);
+		return;
+	}
+
+	switch (msg->type) {
+#if LWIP_NETCONN
+	case TCPIP_MSG_API:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: API message %p\n", (void *)msg));
+		msg->msg.apimsg->function(&(msg->msg.apimsg->msg));
+		break;
+#endif							/* LWIP_NETCONN */
+
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+	case TCPIP_MSG_INPKT:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET %p\n", (void *)msg));
+#if LWIP_ETHERNET
+		if (msg->msg.inp.netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
+			ethernet_input(msg->msg.inp.p, msg->msg.inp.netif);
+		} else
+#endif							/* LWIP_ETHERNET */
+		{
+			ip_input(msg->msg.inp.p, msg->msg.inp.netif);
+		}
+		memp_free(MEMP_TCPIP_MSG_INPKT, msg);
+		break;
+#endif							/* LWIP_TCPIP_CORE_LOCKING_INPUT */
+
+#if LWIP_NETIF_API
+	case TCPIP_MSG_NETIFAPI:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: Netif API message %p\n", (void *)msg));
+		msg->msg.netifapimsg->function(&(msg->msg.netifapimsg->msg));
+		break;
+#endif							/* LWIP_NETIF_API */
+
+#if LWIP_TCPIP_TIMEOUT
+	case TCPIP_MSG_TIMEOUT:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: TIMEOUT %p\n", (void *)msg));
+		sys_timeout(msg->msg.tmo.msecs, msg->msg.tmo.h, msg->msg.tmo.arg);
+		memp_free(MEMP_TCPIP_MSG_API, msg);
+		break;
+	case TCPIP_MSG_UNTIMEOUT:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: UNTIMEOUT %p\n", (void *)msg));
+		sys_untimeout(msg->msg.tmo.h, msg->msg.tmo.arg);
+		memp_free(MEMP_TCPIP_MSG_API, msg);
+		break;
+#endif							/* LWIP_TCPIP_TIMEOUT */
+
+	case TCPIP_MSG_CALLBACK:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK %p\n", (void *)msg));
+		msg->msg.cb.function(msg->msg.cb.ctx);
+		memp_free(MEMP_TCPIP_MSG_API, msg);
+		break;
+
+	case TCPIP_MSG_CALLBACK_STATIC:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK_STATIC %p\n", (void *)msg));
+		msg->msg.cb.function(msg->msg.cb.ctx);
+		break;
+
+	default:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: %d\n", msg->type));
+		LWIP_ASSERT("tcpip_thread: invalid message", 0);
+		break;
+	}
+}
+
 /**
  * The main lwIP thread. This thread has exclusive access to lwIP core functions
  * (unless access to them is not locked). Other threads communicate with this
@@ -92,6 +168,9 @@ static void tcpip_thread(void *arg)
 {
 
 	struct tcpip_msg *msg = NULL;
+	void *batch[TCPIP_MBOX_BATCH];
+	u32_t nbatch;
+	u32_t i;
 	LWIP_DEBUGF(TCPIP_DEBUG, ("NULL == msg %d \n", NULL == msg));
 	LWIP_UNUSED_ARG(arg);
 	//LWIP_DEBUGF(TCPIP_DEBUG,("Entry \n"));
@@ -101,77 +180,21 @@ static void tcpip_thread(void *arg)
 
 	LOCK_TCPIP_CORE();
 	while (1) {					/* MAIN Loop */
-		UNLOCK_TCPIP_CORE();
 		LWIP_TCPIP_THREAD_ALIVE();
-		/* wait for a message, timeouts are processed while waiting */
+		/* wait for a message, timeouts are processed while waiting (the
+		   core lock is only released for the wait itself) */
 		sys_timeouts_mbox_fetch(&mbox, (void **)&msg);
 
-		LOCK_TCPIP_CORE();
-
-		if (msg == NULL) {
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: NULL\n"));
-			LWIP_ASSERT("tcpip_thread: invalid message", 0);
-			continue;
-		}
-
-		switch (msg->type) {
-#if LWIP_NETCONN
-		case TCPIP_MSG_API:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: API message %p\n", (void *)msg));
-			msg->msg.apimsg->function(&(msg->msg.apimsg->msg));
-			break;
-#endif							/* LWIP_NETCONN */
-
-#if !LWIP_TCPIP_CORE_LOCKING_INPUT
-		case TCPIP_MSG_INPKT:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET %p\n", (void *)msg));
-#if LWIP_ETHERNET
-			if (msg->msg.inp.netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
-				ethernet_input(msg->msg.inp.p, msg->msg.inp.netif);
-			} else
-#endif							/* LWIP_ETHERNET */
-			{
-				ip_input(msg->msg.inp.p, msg->msg.inp.netif);
-			}
-			memp_free(MEMP_TCPIP_MSG_INPKT, msg);
-			break;
-#endif							/* LWIP_TCPIP_CORE_LOCKING_INPUT */
-
-#if LWIP_NETIF_API
-		case TCPIP_MSG_NETIFAPI:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: Netif API message %p\n", (void *)msg));
-			msg->msg.netifapimsg->function(&(msg->msg.netifapimsg->msg));
-			break;
-#endif							/* LWIP_NETIF_API */
-
-#if LWIP_TCPIP_TIMEOUT
-		case TCPIP_MSG_TIMEOUT:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: TIMEOUT %p\n", (void *)msg));
-			sys_timeout(msg->msg.tmo.msecs, msg->msg.tmo.h, msg->msg.tmo.arg);
-			memp_free(MEMP_TCPIP_MSG_API, msg);
-			break;
-		case TCPIP_MSG_UNTIMEOUT:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: UNTIMEOUT %p\n", (void *)msg));
-			sys_untimeout(msg->msg.tmo.h, msg->msg.tmo.arg);
-			memp_free(MEMP_TCPIP_MSG_API, msg);
-			break;
-#endif							/* LWIP_TCPIP_TIMEOUT */
+		tcpip_thread_handle_msg(msg);
 
-		case TCPIP_MSG_CALLBACK:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK %p\n", (void *)msg));
-			msg->msg.cb.function(msg->msg.cb.ctx);
-			memp_free(MEMP_TCPIP_MSG_API, msg);
-			break;
-
-		case TCPIP_MSG_CALLBACK_STATIC:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK_STATIC %p\n", (void *)msg));
-			msg->msg.cb.function(msg->msg.cb.ctx);
-			break;
-
-		default:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: %d\n", msg->type));
-			LWIP_ASSERT("tcpip_thread: invalid message", 0);
-			break;
+		/* Process the messages that were posted meanwhile without going
+		 * through the mailbox wait again.  The batch is bounded so that
+		 * timeouts are still checked regularly.
+		 */
+		nbatch = sys_arch_mbox_tryfetch_n(&mbox, batch, TCPIP_MBOX_BATCH);
+		for (i = 0; i < nbatch; i++) {
+			msg = (struct tcpip_msg *)batch[i];
+			tcpip_thread_handle_msg(msg);
 		}
 	}
 }
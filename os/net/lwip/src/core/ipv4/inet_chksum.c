@@ -69,13 +69,13 @@
  * #define LWIP_CHKSUM <your_checksum_routine>
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3 or 4.
  */
 
 #ifndef LWIP_CHKSUM
 #define LWIP_CHKSUM lwip_standard_chksum
 #ifndef LWIP_CHKSUM_ALGORITHM
-#define LWIP_CHKSUM_ALGORITHM 2
+#define LWIP_CHKSUM_ALGORITHM 4
 #endif
 #endif
 /* If none set: */
@@ -83,6 +83,104 @@
 #define LWIP_CHKSUM_ALGORITHM 0
 #endif
 
+/* ARMv7 cores (Cortex-M3/M4, Cortex-R) use an add-with-carry chain for
+ * the word loops of algorithm #4 and of lwip_chksum_copy() #2.
+ */
+#if defined(__GNUC__) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7R__))
+#define LWIP_CHKSUM_ARMV7 1
+#else
+#define LWIP_CHKSUM_ARMV7 0
+#endif
+
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2)
+/** Number of bytes handled by one iteration of the word loops */
+#define CHKSUM_BLOCK_SIZE 32
+
+#if LWIP_CHKSUM_ARMV7
+/**
+ * Add nblocks blocks of 8 words to a 32-bit ones' complement sum.
+ *
+ * @param pl word aligned start of the data
+ * @param nblocks number of 32 byte blocks to add (> 0)
+ * @param sum initial sum
+ * @return 32-bit ones' complement sum (fold it to get the 16-bit sum)
+ */
+static u32_t lwip_chksum_words(const u32_t *pl, u32_t nblocks, u32_t sum)
+{
+	u32_t a, b, c, d;
+
+	__asm__ __volatile__(
+		"1:\n\t"
+		"ldr	%[a], [%[p]], #4\n\t"
+		"ldr	%[b], [%[p]], #4\n\t"
+		"ldr	%[c], [%[p]], #4\n\t"
+		"ldr	%[d], [%[p]], #4\n\t"
+		"adds	%[s], %[s], %[a]\n\t"
+		"adcs	%[s], %[s], %[b]\n\t"
+		"adcs	%[s], %[s], %[c]\n\t"
+		"adcs	%[s], %[s], %[d]\n\t"
+		"ldr	%[a], [%[p]], #4\n\t"
+		"ldr	%[b], [%[p]], #4\n\t"
+		"ldr	%[c], [%[p]], #4\n\t"
+		"ldr	%[d], [%[p]], #4\n\t"
+		"adcs	%[s], %[s], %[a]\n\t"
+		"adcs	%[s], %[s], %[b]\n\t"
+		"adcs	%[s], %[s], %[c]\n\t"
+		"adcs	%[s], %[s], %[d]\n\t"
+		"adc	%[s], %[s], #0\n\t"
+		"subs	%[n], %[n], #1\n\t"
+		"bne	1b\n\t"
+		: [p] "+r"(pl), [n] "+r"(nblocks), [s] "+r"(sum),
+		  [a] "=&r"(a), [b] "=&r"(b), [c] "=&r"(c), [d] "=&r"(d)
+		:
+		: "cc", "memory");
+
+	return sum;
+}
+#else							/* LWIP_CHKSUM_ARMV7 */
+/** Add one word to sum, counting the carry out in carry */
+#define CHKSUM_ADD_WORD(sum, carry, w) \
+	do { \
+		u32_t _w = (w); \
+		(sum) += _w; \
+		(carry) += ((sum) < _w); \
+	} while (0)
+
+/**
+ * Add nblocks blocks of 8 words to a 32-bit ones' complement sum.
+ * The carries are counted separately and added back once at the end.
+ *
+ * @param pl word aligned start of the data
+ * @param nblocks number of 32 byte blocks to add (> 0)
+ * @param sum initial sum
+ * @return 32-bit ones' complement sum (fold it to get the 16-bit sum)
+ */
+static u32_t lwip_chksum_words(const u32_t *pl, u32_t nblocks, u32_t sum)
+{
+	u32_t carry = 0;
+
+	while (nblocks-- > 0) {
+		CHKSUM_ADD_WORD(sum, carry, pl[0]);
+		CHKSUM_ADD_WORD(sum, carry, pl[1]);
+		CHKSUM_ADD_WORD(sum, carry, pl[2]);
+		CHKSUM_ADD_WORD(sum, carry, pl[3]);
+		CHKSUM_ADD_WORD(sum, carry, pl[4]);
+		CHKSUM_ADD_WORD(sum, carry, pl[5]);
+		CHKSUM_ADD_WORD(sum, carry, pl[6]);
+		CHKSUM_ADD_WORD(sum, carry, pl[7]);
+		pl += 8;
+	}
+
+	/* end-around carry */
+	sum += carry;
+	if (sum < carry) {
+		sum++;
+	}
+	return sum;
+}
+#endif							/* LWIP_CHKSUM_ARMV7 */
+#endif							/* (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
+
 #if (LWIP_CHKSUM_ALGORITHM == 1)	/* Version #1 */
 /**
  * lwip checksum
@@ -270,6 +368,75 @@ static u16_t lwip_standard_chksum(void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 4)	/* Alternative version #4 */
+/**
+ * Checksum 32 bits at a time. After aligning to a word boundary the data
+ * is added in blocks of 8 words with a 32-bit accumulator (see
+ * lwip_chksum_words()), the tail is handled like in version #3.
+ *
+ * @arg start of buffer to be checksummed. May be an odd byte address.
+ * @len number of bytes in the buffer to be checksummed.
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+static u16_t lwip_standard_chksum(void *dataptr, int len)
+{
+	u8_t *pb = (u8_t *) dataptr;
+	u16_t *ps, t = 0;
+	u32_t *pl;
+	u32_t sum = 0;
+	/* starts at odd byte address? */
+	int odd = ((mem_ptr_t) pb & 1);
+
+	if (odd && len > 0) {
+		((u8_t *)&t)[1] = *pb++;
+		len--;
+	}
+
+	ps = (u16_t *)(void *)pb;
+
+	if (((mem_ptr_t) ps & 3) && len > 1) {
+		sum += *ps++;
+		len -= 2;
+	}
+
+	pl = (u32_t *)(void *)ps;
+
+	if (len >= CHKSUM_BLOCK_SIZE) {
+		sum = lwip_chksum_words(pl, (u32_t) len / CHKSUM_BLOCK_SIZE, sum);
+		pl += (len / CHKSUM_BLOCK_SIZE) * (CHKSUM_BLOCK_SIZE / 4);
+		len %= CHKSUM_BLOCK_SIZE;
+		/* make room in upper bits */
+		sum = FOLD_U32T(sum);
+	}
+
+	ps = (u16_t *) pl;
+
+	/* 16-bit aligned words remaining? */
+	while (len > 1) {
+		sum += *ps++;
+		len -= 2;
+	}
+
+	/* dangling tail byte remaining? */
+	if (len > 0) {				/* include odd byte */
+		((u8_t *)&t)[0] = *(u8_t *) ps;
+	}
+
+	sum += t;					/* add end bytes */
+
+	/* Fold 32-bit sum to 16 bits
+	   calling this twice is propably faster than if statements... */
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+
+	return (u16_t) sum;
+}
+#endif
+
 /* inet_chksum_pseudo:
  *
  * Calculates the pseudo Internet checksum used by TCP and UDP for a pbuf chain.
@@ -451,3 +618,151 @@ u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len)
 	return LWIP_CHKSUM(dst, len);
 }
 #endif							/* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2)	/* Version #2 */
+/**
+ * Copy nblocks blocks of 8 words and add them to a 32-bit ones' complement
+ * sum in the same pass.
+ *
+ * @param dl word aligned destination
+ * @param sl word aligned source
+ * @param nblocks number of 32 byte blocks to copy (> 0)
+ * @param sum initial sum
+ * @return 32-bit ones' complement sum (fold it to get the 16-bit sum)
+ */
+#if LWIP_CHKSUM_ARMV7
+static u32_t lwip_chksum_copy_words(u32_t *dl, const u32_t *sl, u32_t nblocks, u32_t sum)
+{
+	u32_t a, b, c, d;
+
+	__asm__ __volatile__(
+		"1:\n\t"
+		"ldr	%[a], [%[sp]], #4\n\t"
+		"ldr	%[b], [%[sp]], #4\n\t"
+		"ldr	%[c], [%[sp]], #4\n\t"
+		"ldr	%[d], [%[sp]], #4\n\t"
+		"str	%[a], [%[dp]], #4\n\t"
+		"str	%[b], [%[dp]], #4\n\t"
+		"str	%[c], [%[dp]], #4\n\t"
+		"str	%[d], [%[dp]], #4\n\t"
+		"adds	%[s], %[s], %[a]\n\t"
+		"adcs	%[s], %[s], %[b]\n\t"
+		"adcs	%[s], %[s], %[c]\n\t"
+		"adcs	%[s], %[s], %[d]\n\t"
+		"ldr	%[a], [%[sp]], #4\n\t"
+		"ldr	%[b], [%[sp]], #4\n\t"
+		"ldr	%[c], [%[sp]], #4\n\t"
+		"ldr	%[d], [%[sp]], #4\n\t"
+		"str	%[a], [%[dp]], #4\n\t"
+		"str	%[b], [%[dp]], #4\n\t"
+		"str	%[c], [%[dp]], #4\n\t"
+		"str	%[d], [%[dp]], #4\n\t"
+		"adcs	%[s], %[s], %[a]\n\t"
+		"adcs	%[s], %[s], %[b]\n\t"
+		"adcs	%[s], %[s], %[c]\n\t"
+		"adcs	%[s], %[s], %[d]\n\t"
+		"adc	%[s], %[s], #0\n\t"
+		"subs	%[n], %[n], #1\n\t"
+		"bne	1b\n\t"
+		: [dp] "+r"(dl), [sp] "+r"(sl), [n] "+r"(nblocks), [s] "+r"(sum),
+		  [a] "=&r"(a), [b] "=&r"(b), [c] "=&r"(c), [d] "=&r"(d)
+		:
+		: "cc", "memory");
+
+	return sum;
+}
+#else							/* LWIP_CHKSUM_ARMV7 */
+static u32_t lwip_chksum_copy_words(u32_t *dl, const u32_t *sl, u32_t nblocks, u32_t sum)
+{
+	u32_t carry = 0;
+	int i;
+
+	while (nblocks-- > 0) {
+		for (i = 0; i < 8; i++) {
+			dl[i] = sl[i];
+			CHKSUM_ADD_WORD(sum, carry, dl[i]);
+		}
+		dl += 8;
+		sl += 8;
+	}
+
+	/* end-around carry */
+	sum += carry;
+	if (sum < carry) {
+		sum++;
+	}
+	return sum;
+}
+#endif							/* LWIP_CHKSUM_ARMV7 */
+
+/** Copy and checksum in one pass.
+ * The word loop needs source and destination at the same offset from a
+ * word boundary; otherwise MEMCPY is followed by LWIP_CHKSUM on the copy,
+ * which is then still in cache on most targets.
+ */
+u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+	u8_t *db = (u8_t *) dst;
+	const u8_t *sb = (const u8_t *)src;
+	u16_t t = 0;
+	u32_t sum = 0;
+	int left = len;
+	int odd;
+
+	if (((((mem_ptr_t) db ^ (mem_ptr_t) sb) & 3) != 0) || (len < CHKSUM_BLOCK_SIZE)) {
+		MEMCPY(dst, src, len);
+		return LWIP_CHKSUM(dst, len);
+	}
+
+	/* starts at odd byte address? */
+	odd = ((mem_ptr_t) db & 1);
+	if (odd) {
+		((u8_t *)&t)[1] = *sb;
+		*db++ = *sb++;
+		left--;
+	}
+
+	if ((mem_ptr_t) db & 2) {
+		*(u16_t *)(void *)db = *(const u16_t *)(const void *)sb;
+		sum += *(u16_t *)(void *)db;
+		db += 2;
+		sb += 2;
+		left -= 2;
+	}
+
+	if (left >= CHKSUM_BLOCK_SIZE) {
+		sum = lwip_chksum_copy_words((u32_t *)(void *)db, (const u32_t *)(const void *)sb, (u32_t) left / CHKSUM_BLOCK_SIZE, sum);
+		db += (left / CHKSUM_BLOCK_SIZE) * CHKSUM_BLOCK_SIZE;
+		sb += (left / CHKSUM_BLOCK_SIZE) * CHKSUM_BLOCK_SIZE;
+		left %= CHKSUM_BLOCK_SIZE;
+		/* make room in upper bits */
+		sum = FOLD_U32T(sum);
+	}
+
+	/* 16-bit aligned words remaining? */
+	while (left > 1) {
+		*(u16_t *)(void *)db = *(const u16_t *)(const void *)sb;
+		sum += *(u16_t *)(void *)db;
+		db += 2;
+		sb += 2;
+		left -= 2;
+	}
+
+	/* dangling tail byte remaining? */
+	if (left > 0) {
+		((u8_t *)&t)[0] = *sb;
+		*db = *sb;
+	}
+
+	sum += t;
+
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+
+	return (u16_t) sum;
+}
+#endif							/* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
@@ -187,7 +187,7 @@ static err_t tcp_close_shutdown(struct tcp_pcb *pcb, u8_t rst_on_unacked_data)
 	err_t err;
 
 	if (rst_on_unacked_data && ((pcb->state == ESTABLISHED) || (pcb->state == CLOSE_WAIT))) {
-		if ((pcb->refused_data != NULL) || (pcb->rcv_wnd != TCP_WND)) {
+		if ((pcb->refused_data != NULL) || (pcb->rcv_wnd != TCP_WND_MAX(pcb))) {
 			/* Not all data received by application, send RST to tell the remote
 			   side about this. */
 			LWIP_ASSERT("pcb->flags & TF_RXCLOSED", pcb->flags & TF_RXCLOSED);
@@ -596,8 +596,10 @@ u32_t tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb)
 		} else {
 			/* keep the right edge of window constant */
 			u32_t new_rcv_ann_wnd = pcb->rcv_ann_right_edge - pcb->rcv_nxt;
+#if !LWIP_WND_SCALE
 			LWIP_ASSERT("new_rcv_ann_wnd <= 0xffff", new_rcv_ann_wnd <= 0xffff);
-			pcb->rcv_ann_wnd = (u16_t) new_rcv_ann_wnd;
+#endif							/* !LWIP_WND_SCALE */
+			pcb->rcv_ann_wnd = (tcpwnd_size_t) new_rcv_ann_wnd;
 		}
 		return 0;
 	}
@@ -617,11 +619,11 @@ void tcp_recved(struct tcp_pcb *pcb, u16_t len)
 
 	/* pcb->state LISTEN not allowed here */
 	LWIP_ASSERT("don't call tcp_recved for listen-pcbs", pcb->state != LISTEN);
-	LWIP_ASSERT("tcp_recved: len would wrap rcv_wnd\n", len <= 0xffff - pcb->rcv_wnd);
+	LWIP_ASSERT("tcp_recved: len would wrap rcv_wnd\n", (tcpwnd_size_t)(pcb->rcv_wnd + len) >= pcb->rcv_wnd);
 
 	pcb->rcv_wnd += len;
-	if (pcb->rcv_wnd > TCP_WND) {
-		pcb->rcv_wnd = TCP_WND;
+	if (pcb->rcv_wnd > TCP_WND_MAX(pcb)) {
+		pcb->rcv_wnd = TCP_WND_MAX(pcb);
 	}
 
 	wnd_inflation = tcp_update_rcv_ann_wnd(pcb);
@@ -635,7 +637,7 @@ void tcp_recved(struct tcp_pcb *pcb, u16_t len)
 		tcp_output(pcb);
 	}
 
-	LWIP_DEBUGF(TCP_DEBUG, ("tcp_recved: recveived %" U16_F " bytes, wnd %" U16_F " (%" U16_F ").\n", len, pcb->rcv_wnd, TCP_WND - pcb->rcv_wnd));
+	LWIP_DEBUGF(TCP_DEBUG, ("tcp_recved: recveived %" U16_F " bytes, wnd %" TCPWNDSIZE_F " (%" TCPWNDSIZE_F ").\n", len, pcb->rcv_wnd, (tcpwnd_size_t)(TCP_WND_MAX(pcb) - pcb->rcv_wnd)));
 }
 
 /**
@@ -737,10 +739,11 @@ err_t tcp_connect(struct tcp_pcb *pcb, ip_addr_t *ipaddr, u16_t port, tcp_connec
 	pcb->snd_nxt = iss;
 	pcb->lastack = iss - 1;
 	pcb->snd_lbb = iss - 1;
-	pcb->rcv_wnd = TCP_WND;
-	pcb->rcv_ann_wnd = TCP_WND;
+	/* the window is scaled only once the SYN-ACK carried the option */
+	pcb->rcv_wnd = TCPWND_MIN16(TCP_WND);
+	pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
 	pcb->rcv_ann_right_edge = pcb->rcv_nxt;
-	pcb->snd_wnd = TCP_WND;
+	pcb->snd_wnd = TCPWND_MIN16(TCP_WND);
 	/* As initial send MSS, we use TCP_MSS but limit it to 536.
 	   The send MSS is updated when an MSS option is received. */
 	pcb->mss = (TCP_MSS > 536) ? 536 : TCP_MSS;
@@ -781,7 +784,7 @@ err_t tcp_connect(struct tcp_pcb *pcb, ip_addr_t *ipaddr, u16_t port, tcp_connec
 void tcp_slowtmr(void)
 {
 	struct tcp_pcb *pcb, *prev;
-	u16_t eff_wnd;
+	tcpwnd_size_t eff_wnd;
 	u8_t pcb_remove;			/* flag if a PCB should be removed */
 	u8_t pcb_reset;				/* flag if a RST should be sent when removing */
 	err_t err;
@@ -857,7 +860,7 @@ tcp_slowtmr_start:
 						pcb->ssthresh = (pcb->mss << 1);
 					}
 					pcb->cwnd = pcb->mss;
-					LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %" U16_F " ssthresh %" U16_F "\n", pcb->cwnd, pcb->ssthresh));
+					LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %" TCPWNDSIZE_F " ssthresh %" TCPWNDSIZE_F "\n", pcb->cwnd, pcb->ssthresh));
 
 					/* The following needs to be called AFTER cwnd is set to one
 					   mss - STJ */
@@ -1068,7 +1071,7 @@ err_t tcp_process_refused_data(struct tcp_pcb *pcb)
 		if (refused_flags & PBUF_FLAG_TCP_FIN) {
 			/* correct rcv_wnd as the application won't call tcp_recved()
 			   for the FIN's seqno */
-			if (pcb->rcv_wnd != TCP_WND) {
+			if (pcb->rcv_wnd != TCP_WND_MAX(pcb)) {
 				pcb->rcv_wnd++;
 			}
 			TCP_EVENT_CLOSED(pcb, err);
@@ -1265,8 +1268,8 @@ struct tcp_pcb *tcp_alloc(u8_t prio)
 		pcb->prio = prio;
 		pcb->snd_buf = TCP_SND_BUF;
 		pcb->snd_queuelen = 0;
-		pcb->rcv_wnd = TCP_WND;
-		pcb->rcv_ann_wnd = TCP_WND;
+		pcb->rcv_wnd = TCPWND_MIN16(TCP_WND);
+		pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
 		pcb->tos = 0;
 		pcb->ttl = TCP_TTL;
 		/* As initial send MSS, we use TCP_MSS but limit it to 536.
@@ -86,12 +86,31 @@ static u16_t tcplen;
 static u8_t recv_flags;
 static struct pbuf *recv_data;
 
+#if LWIP_TCP_SACK
+/* SACK blocks of the incoming segment (host byte order), set by
+   tcp_parseopt(). At most 4 blocks fit into a TCP header. */
+static struct tcp_sack_block {
+	u32_t left;
+	u32_t right;
+} sack_blocks[4];
+static u8_t sack_num;
+
+/* An ACK that leaves data sent before SACK loss recovery started
+   outstanding does not end the recovery */
+#define TCP_SACK_PARTIAL_ACK(pcb) (((pcb)->flags & TF_SACK) && TCP_SEQ_LT(ackno, (pcb)->recover))
+#else							/* LWIP_TCP_SACK */
+#define TCP_SACK_PARTIAL_ACK(pcb) 0
+#endif							/* LWIP_TCP_SACK */
+
 struct tcp_pcb *tcp_input_pcb;
 
 /* Forward declarations. */
 static err_t tcp_process(struct tcp_pcb *pcb);
 static void tcp_receive(struct tcp_pcb *pcb);
 static void tcp_parseopt(struct tcp_pcb *pcb);
+#if LWIP_TCP_SACK
+static void tcp_sack_input(struct tcp_pcb *pcb, u8_t recovering);
+#endif
 
 static err_t tcp_listen_input(struct tcp_pcb_listen *pcb);
 static err_t tcp_timewait_input(struct tcp_pcb *pcb);
@@ -372,7 +391,7 @@ void tcp_input(struct pbuf *p, struct netif *inp)
 					} else {
 						/* correct rcv_wnd as the application won't call tcp_recved()
 						   for the FIN's seqno */
-						if (pcb->rcv_wnd != TCP_WND) {
+						if (pcb->rcv_wnd != TCP_WND_MAX(pcb)) {
 							pcb->rcv_wnd++;
 						}
 						TCP_EVENT_CLOSED(pcb, err);
@@ -675,7 +694,7 @@ static err_t tcp_process(struct tcp_pcb *pcb)
 		if (flags & TCP_ACK) {
 			/* expected ACK number? */
 			if (TCP_SEQ_BETWEEN(ackno, pcb->lastack + 1, pcb->snd_nxt)) {
-				u16_t old_cwnd;
+				tcpwnd_size_t old_cwnd;
 				pcb->state = ESTABLISHED;
 				LWIP_DEBUGF(TCP_DEBUG, ("TCP connection established %" U16_F " -> %" U16_F ".\n", inseg.tcphdr->src, inseg.tcphdr->dest));
 #if LWIP_CALLBACK_API
@@ -839,6 +858,9 @@ static void tcp_receive(struct tcp_pcb *pcb)
 	u32_t right_wnd_edge;
 	u16_t new_tot_len;
 	int found_dupack = 0;
+#if LWIP_TCP_SACK
+	u8_t recovering = (pcb->flags & TF_INFR) != 0;
+#endif
 #if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
 	u32_t ooseq_blen;
 	u16_t ooseq_qlen;
@@ -850,12 +872,12 @@ static void tcp_receive(struct tcp_pcb *pcb)
 		right_wnd_edge = pcb->snd_wnd + pcb->snd_wl2;
 
 		/* Update window. */
-		if (TCP_SEQ_LT(pcb->snd_wl1, seqno) || (pcb->snd_wl1 == seqno && TCP_SEQ_LT(pcb->snd_wl2, ackno)) || (pcb->snd_wl2 == ackno && tcphdr->wnd > pcb->snd_wnd)) {
-			pcb->snd_wnd = tcphdr->wnd;
+		if (TCP_SEQ_LT(pcb->snd_wl1, seqno) || (pcb->snd_wl1 == seqno && TCP_SEQ_LT(pcb->snd_wl2, ackno)) || (pcb->snd_wl2 == ackno && SND_WND_SCALE(pcb, tcphdr->wnd) > pcb->snd_wnd)) {
+			pcb->snd_wnd = SND_WND_SCALE(pcb, tcphdr->wnd);
 			/* keep track of the biggest window announced by the remote host to calculate
 			   the maximum segment size */
-			if (pcb->snd_wnd_max < tcphdr->wnd) {
-				pcb->snd_wnd_max = tcphdr->wnd;
+			if (pcb->snd_wnd_max < pcb->snd_wnd) {
+				pcb->snd_wnd_max = pcb->snd_wnd;
 			}
 			pcb->snd_wl1 = seqno;
 			pcb->snd_wl2 = ackno;
@@ -869,10 +891,10 @@ static void tcp_receive(struct tcp_pcb *pcb)
 				/* stop persist timer */
 				pcb->persist_backoff = 0;
 			}
-			LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_receive: window update %" U16_F "\n", pcb->snd_wnd));
+			LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_receive: window update %" TCPWNDSIZE_F "\n", pcb->snd_wnd));
 #if TCP_WND_DEBUG
 		} else {
-			if (pcb->snd_wnd != tcphdr->wnd) {
+			if (pcb->snd_wnd != SND_WND_SCALE(pcb, tcphdr->wnd)) {
 				LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_receive: no window update lastack %" U32_F " ackno %" U32_F " wl1 %" U32_F " seqno %" U32_F " wl2 %" U32_F "\n", pcb->lastack, ackno, pcb->snd_wl1, seqno, pcb->snd_wl2));
 			}
 #endif							/* TCP_WND_DEBUG */
@@ -916,7 +938,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
 							if (pcb->dupacks > 3) {
 								/* Inflate the congestion window, but not if it means that
 								   the value overflows. */
-								if ((u16_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
+								if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
 									pcb->cwnd += pcb->mss;
 								}
 							} else if (pcb->dupacks == 3) {
@@ -937,8 +959,9 @@ static void tcp_receive(struct tcp_pcb *pcb)
 
 			/* Reset the "IN Fast Retransmit" flag, since we are no longer
 			   in fast retransmit. Also reset the congestion window to the
-			   slow start threshold. */
-			if (pcb->flags & TF_INFR) {
+			   slow start threshold. With SACK, recovery goes on until all
+			   data outstanding when it started has been acknowledged. */
+			if ((pcb->flags & TF_INFR) && !TCP_SACK_PARTIAL_ACK(pcb)) {
 				pcb->flags &= ~TF_INFR;
 				pcb->cwnd = pcb->ssthresh;
 			}
@@ -959,19 +982,19 @@ static void tcp_receive(struct tcp_pcb *pcb)
 			pcb->lastack = ackno;
 
 			/* Update the congestion control variables (cwnd and
-			   ssthresh). */
-			if (pcb->state >= ESTABLISHED) {
+			   ssthresh). Partial ACKs during recovery don't open cwnd. */
+			if (pcb->state >= ESTABLISHED && !(pcb->flags & TF_INFR)) {
 				if (pcb->cwnd < pcb->ssthresh) {
-					if ((u16_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
+					if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
 						pcb->cwnd += pcb->mss;
 					}
-					LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: slow start cwnd %" U16_F "\n", pcb->cwnd));
+					LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: slow start cwnd %" TCPWNDSIZE_F "\n", pcb->cwnd));
 				} else {
-					u16_t new_cwnd = (pcb->cwnd + pcb->mss * pcb->mss / pcb->cwnd);
+					tcpwnd_size_t new_cwnd = (pcb->cwnd + pcb->mss * pcb->mss / pcb->cwnd);
 					if (new_cwnd > pcb->cwnd) {
 						pcb->cwnd = new_cwnd;
 					}
-					LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: congestion avoidance cwnd %" U16_F "\n", pcb->cwnd));
+					LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_receive: congestion avoidance cwnd %" TCPWNDSIZE_F "\n", pcb->cwnd));
 				}
 			}
 			LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_receive: ACK for %" U32_F ", unacked->seqno %" U32_F ":%" U32_F "\n", ackno, pcb->unacked != NULL ? ntohl(pcb->unacked->tcphdr->seqno) : 0, pcb->unacked != NULL ? ntohl(pcb->unacked->tcphdr->seqno) + TCP_TCPLEN(pcb->unacked) : 0));
@@ -1045,6 +1068,12 @@ static void tcp_receive(struct tcp_pcb *pcb)
 		}
 		/* End of ACK for new data processing. */
 
+#if LWIP_TCP_SACK
+		if (pcb->flags & TF_SACK) {
+			tcp_sack_input(pcb, recovering);
+		}
+#endif							/* LWIP_TCP_SACK */
+
 		LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: pcb->rttest %" U32_F " rtseq %" U32_F " ackno %" U32_F "\n", pcb->rttest, pcb->rtseq, ackno));
 
 		/* RTT estimation calculations. This is done by checking if the
@@ -1185,7 +1214,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
 						TCPH_FLAGS_SET(inseg.tcphdr, TCPH_FLAGS(inseg.tcphdr) & ~TCP_FIN);
 					}
 					/* Adjust length of segment to fit in the window. */
-					inseg.len = pcb->rcv_wnd;
+					inseg.len = (u16_t)pcb->rcv_wnd;
 					if (TCPH_FLAGS(inseg.tcphdr) & TCP_SYN) {
 						inseg.len -= 1;
 					}
@@ -1305,12 +1334,25 @@ static void tcp_receive(struct tcp_pcb *pcb)
 #endif							/* TCP_QUEUE_OOSEQ */
 
 				/* Acknowledge the segment(s). */
-				tcp_ack(pcb);
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+				if ((pcb->flags & TF_SACK) && pcb->ooseq != NULL) {
+					/* a hole has been (partially) filled: tell the sender
+					   right away which data is still missing */
+					tcp_ack_now(pcb);
+				} else
+#endif							/* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
+				{
+					tcp_ack(pcb);
+				}
 
 			} else {
-				/* We get here if the incoming segment is out-of-sequence. */
-				tcp_send_empty_ack(pcb);
+				/* We get here if the incoming segment is out-of-sequence.
+				   It is queued first so that the duplicate ACK sent below
+				   can report it in a SACK block. */
 #if TCP_QUEUE_OOSEQ
+#if LWIP_TCP_SACK
+				pcb->rcv_sack_last = seqno;
+#endif
 				/* We queue the segment on the ->ooseq queue. */
 				if (pcb->ooseq == NULL) {
 					pcb->ooseq = tcp_seg_copy(&inseg);
@@ -1451,6 +1493,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
 				}
 #endif							/* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
 #endif							/* TCP_QUEUE_OOSEQ */
+				tcp_send_empty_ack(pcb);
 			}
 		} else {
 			/* The incoming segment is not withing the window. */
@@ -1467,11 +1510,64 @@ static void tcp_receive(struct tcp_pcb *pcb)
 	}
 }
 
+#if LWIP_TCP_SACK
+/**
+ * Marks the segments on the unacked queue that are covered by the SACK
+ * blocks of the incoming ACK and drives SACK based loss recovery (a
+ * simplified RFC 6675): recovery starts when three segments above the
+ * first unacknowledged one have been SACKed (or on the third duplicate
+ * ACK), and every ACK received during recovery retransmits the next
+ * hole, i.e. the first segment that is neither SACKed nor retransmitted
+ * yet and has SACKed data above it.
+ *
+ * Called from tcp_receive().
+ *
+ * @param pcb the tcp_pcb for which an ACK arrived
+ * @param recovering 1 if the pcb already was in recovery before this ACK
+ */
+static void tcp_sack_input(struct tcp_pcb *pcb, u8_t recovering)
+{
+	struct tcp_seg *seg;
+	struct tcp_seg *candidate = NULL;
+	struct tcp_seg *hole = NULL;
+	u32_t left, right;
+	u8_t i, sacked = 0;
+
+	for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+		left = ntohl(seg->tcphdr->seqno);
+		right = left + TCP_TCPLEN(seg);
+		for (i = 0; i < sack_num && !(seg->flags & TF_SEG_SACKED); i++) {
+			if (TCP_SEQ_LEQ(sack_blocks[i].left, left) && TCP_SEQ_LEQ(right, sack_blocks[i].right)) {
+				seg->flags |= TF_SEG_SACKED;
+			}
+		}
+		if (seg->flags & TF_SEG_SACKED) {
+			sacked++;
+			if (hole == NULL) {
+				hole = candidate;
+			}
+		} else if (candidate == NULL && !(seg->flags & TF_SEG_RETRANSMITTED)) {
+			candidate = seg;
+		}
+	}
+
+	if (!(pcb->flags & TF_INFR)) {
+		if (sacked >= 3) {
+			LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_sack_input: %" U16_F " segments SACKed, fast retransmit\n", (u16_t) sacked));
+			tcp_rexmit_fast(pcb);
+		}
+	} else if (recovering && hole != NULL) {
+		LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_sack_input: retransmitting hole at %" U32_F "\n", ntohl(hole->tcphdr->seqno)));
+		tcp_rexmit_seg(pcb, hole);
+	}
+}
+#endif							/* LWIP_TCP_SACK */
+
 /**
  * Parses the options contained in the incoming segment.
  *
  * Called from tcp_listen_input() and tcp_process().
- * Currently, only the MSS option is supported!
+ * Supported are MSS, window scale, SACK permitted, SACK and timestamps.
  *
  * @param pcb the tcp_pcb for which a segment arrived
  */
@@ -1483,6 +1579,12 @@ static void tcp_parseopt(struct tcp_pcb *pcb)
 #if LWIP_TCP_TIMESTAMPS
 	u32_t tsval;
 #endif
+#if LWIP_TCP_SACK
+	u32_t left, right;
+	u16_t b;
+
+	sack_num = 0;
+#endif
 
 	opts = (u8_t *) tcphdr + TCP_HLEN;
 
@@ -1515,6 +1617,65 @@ static void tcp_parseopt(struct tcp_pcb *pcb)
 				/* Advance to next option */
 				c += 0x04;
 				break;
+#if LWIP_WND_SCALE
+			case 0x03:
+				LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: WND_SCALE\n"));
+				if (opts[c + 1] != 0x03 || c + 0x03 > max_c) {
+					/* Bad length */
+					LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+					return;
+				}
+				/* Only valid on SYNs; ignore it on a retransmitted SYN */
+				if ((flags & TCP_SYN) && !(pcb->flags & TF_WND_SCALE)) {
+					pcb->snd_scale = LWIP_MIN(opts[c + 2], 14);
+					pcb->rcv_scale = TCP_RCV_SCALE;
+					pcb->flags |= TF_WND_SCALE;
+					/* window scaling is enabled, we can use the full receive window */
+					LWIP_ASSERT("window not at default value", pcb->rcv_wnd == TCPWND_MIN16(TCP_WND));
+					pcb->rcv_wnd = TCP_WND;
+					pcb->rcv_ann_wnd = TCP_WND;
+				}
+				/* Advance to next option */
+				c += 0x03;
+				break;
+#endif							/* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK
+			case 0x04:
+				LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK_PERM\n"));
+				if (opts[c + 1] != 0x02 || c + 0x02 > max_c) {
+					/* Bad length */
+					LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+					return;
+				}
+				if (flags & TCP_SYN) {
+					pcb->flags |= TF_SACK;
+				}
+				/* Advance to next option */
+				c += 0x02;
+				break;
+			case 0x05:
+				LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+				if (opts[c + 1] < 0x0A || ((opts[c + 1] - 2) & 7) != 0 || c + opts[c + 1] > max_c) {
+					/* Bad length */
+					LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+					return;
+				}
+				if ((pcb->flags & TF_SACK) && (flags & TCP_ACK)) {
+					for (b = c + 2; b < c + opts[c + 1] && sack_num < 4; b += 8) {
+						left = ((u32_t) opts[b] << 24) | ((u32_t) opts[b + 1] << 16) | ((u32_t) opts[b + 2] << 8) | opts[b + 3];
+						right = ((u32_t) opts[b + 4] << 24) | ((u32_t) opts[b + 5] << 16) | ((u32_t) opts[b + 6] << 8) | opts[b + 7];
+						/* only use blocks above the cumulative ACK that cover data sent */
+						if (TCP_SEQ_LT(ackno, left) && TCP_SEQ_LT(left, right) && TCP_SEQ_LEQ(right, pcb->snd_nxt)) {
+							sack_blocks[sack_num].left = left;
+							sack_blocks[sack_num].right = right;
+							sack_num++;
+						}
+					}
+				}
+				/* Advance to next option */
+				c += opts[c + 1];
+				break;
+#endif							/* LWIP_TCP_SACK */
 #if LWIP_TCP_TIMESTAMPS
 			case 0x08:
 				LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: TS\n"));
@@ -68,7 +68,7 @@
 #include <net/lwip/ipv4/inet_chksum.h>
 #include <net/lwip/stats.h>
 #include <net/lwip/snmp.h>
-#if LWIP_TCP_TIMESTAMPS
+#if LWIP_TCP_TIMESTAMPS || LWIP_TCP_ZEROCOPY
 #include <net/lwip/sys.h>
 #endif
 
@@ -95,6 +95,7 @@
 #endif
 
 /* Forward declarations.*/
+struct tcp_zc;
 static void tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb);
 
 /** Allocate a pbuf and create a tcphdr at p->payload, used for output
@@ -119,7 +120,7 @@ static struct pbuf *tcp_output_alloc_header(struct tcp_pcb *pcb, u16_t optlen, u
 		tcphdr->seqno = seqno_be;
 		tcphdr->ackno = htonl(pcb->rcv_nxt);
 		TCPH_HDRLEN_FLAGS_SET(tcphdr, (5 + optlen / 4), TCP_ACK);
-		tcphdr->wnd = htons(pcb->rcv_ann_wnd);
+		tcphdr->wnd = htons(TCPWND_MIN16(RCV_WND_SCALE(pcb, pcb->rcv_ann_wnd)));
 		tcphdr->chksum = 0;
 		tcphdr->urgp = 0;
 
@@ -327,6 +328,104 @@ static err_t tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
 	return ERR_OK;
 }
 
+#if LWIP_TCP_ZEROCOPY
+/**
+ * Initialize a zero-copy descriptor for tcp_write_zc(). The caller holds a
+ * reference until it calls tcp_zc_release() after its last tcp_write_zc()
+ * with this descriptor, so 'done' is not called while it is still writing.
+ *
+ * @param zc the descriptor to initialize
+ * @param done function to call when the stack has released the data
+ * @param arg argument passed to 'done'
+ */
+void tcp_zc_init(struct tcp_zc *zc, tcp_zc_fn done, void *arg)
+{
+	zc->done = done;
+	zc->arg = arg;
+	zc->ref = 1;
+}
+
+/**
+ * Drop a reference to a zero-copy descriptor and call its 'done' function
+ * if it was the last one.
+ *
+ * @param zc the descriptor to release
+ */
+void tcp_zc_release(struct tcp_zc *zc)
+{
+	u16_t ref;
+	SYS_ARCH_DECL_PROTECT(old_level);
+
+	SYS_ARCH_PROTECT(old_level);
+	LWIP_ASSERT("tcp_zc_release: zc->ref > 0", zc->ref > 0);
+	ref = --zc->ref;
+	SYS_ARCH_UNPROTECT(old_level);
+	if (ref == 0 && zc->done != NULL) {
+		zc->done(zc->arg);
+	}
+}
+
+/** pbuf_free() callback of pbufs allocated by tcp_pbuf_ref() */
+static void tcp_zc_pbuf_free(struct pbuf *p)
+{
+	struct tcp_zc_pbuf *zp = (struct tcp_zc_pbuf *)p;
+	struct tcp_zc *zc = zp->zc;
+
+	memp_free(MEMP_TCP_ZC_PBUF, zp);
+	tcp_zc_release(zc);
+}
+#endif							/* LWIP_TCP_ZEROCOPY */
+
+/**
+ * Allocate a PBUF_RAW pbuf referencing data that is not copied.
+ *
+ * @param data the data to reference
+ * @param len length of the data
+ * @param zc zero-copy descriptor the pbuf holds a reference to, or NULL if
+ *        the data stays valid until it has been ACKed anyway
+ * @return the pbuf or NULL if out of memory
+ */
+static struct pbuf *tcp_pbuf_ref(const u8_t *data, u16_t len, struct tcp_zc *zc)
+{
+	struct pbuf *p;
+
+#if LWIP_TCP_ZEROCOPY
+	if (zc != NULL) {
+		struct tcp_zc_pbuf *zp;
+		SYS_ARCH_DECL_PROTECT(old_level);
+
+		zp = (struct tcp_zc_pbuf *)memp_malloc(MEMP_TCP_ZC_PBUF);
+		if (zp == NULL) {
+			return NULL;
+		}
+		zp->pc.custom_free_function = tcp_zc_pbuf_free;
+		zp->zc = zc;
+		p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &zp->pc, (void *)data, len);
+		LWIP_ASSERT("tcp_pbuf_ref: custom pbuf", p != NULL);
+
+		SYS_ARCH_PROTECT(old_level);
+		LWIP_ASSERT("tcp_pbuf_ref: zc->ref overflow", zc->ref < 0xffff);
+		zc->ref++;
+		SYS_ARCH_UNPROTECT(old_level);
+		return p;
+	}
+#else
+	LWIP_UNUSED_ARG(zc);
+#endif							/* LWIP_TCP_ZEROCOPY */
+
+	/* Since the referenced data is available at least until it is sent out
+	 * on the link (as it has to be ACKed by the remote party) we can safely
+	 * use PBUF_ROM instead of PBUF_REF here.
+	 */
+	p = pbuf_alloc(PBUF_RAW, len, PBUF_ROM);
+	if (p != NULL) {
+		p->payload = (u8_t *) data;
+	}
+	return p;
+}
+
+static err_t tcp_write_data(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, struct tcp_zc *zc);
+
 /**
  * Write data for sending (but does not send it immediately).
  *
@@ -344,6 +443,35 @@ static err_t tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
  * @return ERR_OK if enqueued, another err_t on error
  */
 err_t tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+{
+	return tcp_write_data(pcb, arg, len, apiflags, NULL);
+}
+
+#if LWIP_TCP_ZEROCOPY
+/**
+ * Write data for sending without copying it, like tcp_write() without
+ * TCP_WRITE_FLAG_COPY. Every pbuf referencing the data holds a reference
+ * to 'zc', so its 'done' function is called once all of the data has been
+ * ACKed (or dropped because the connection was aborted) and the caller
+ * has called tcp_zc_release(). The same descriptor may be used for several
+ * writes.
+ *
+ * @param pcb Protocol control block for the TCP connection to enqueue data for.
+ * @param arg Pointer to the data to be enqueued for sending.
+ * @param len Data length in bytes
+ * @param apiflags TCP_WRITE_FLAG_MORE or 0 (TCP_WRITE_FLAG_COPY is ignored)
+ * @param zc descriptor initialized with tcp_zc_init()
+ * @return ERR_OK if enqueued, another err_t on error
+ */
+err_t tcp_write_zc(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, struct tcp_zc *zc)
+{
+	LWIP_ERROR("tcp_write_zc: zc == NULL (programmer violates API)", zc != NULL, return ERR_ARG;);
+	return tcp_write_data(pcb, arg, len, apiflags & ~TCP_WRITE_FLAG_COPY, zc);
+}
+#endif							/* LWIP_TCP_ZEROCOPY */
+
+/** Common part of tcp_write() and tcp_write_zc() */
+static err_t tcp_write_data(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, struct tcp_zc *zc)
 {
 	struct pbuf *concat_p = NULL;
 	struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
@@ -473,7 +601,7 @@ err_t tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 #endif							/* TCP_CHECKSUM_ON_COPY */
 			} else {
 				/* Data is not copied */
-				if ((concat_p = pbuf_alloc(PBUF_RAW, seglen, PBUF_ROM)) == NULL) {
+				if ((concat_p = tcp_pbuf_ref((u8_t *) arg + pos, seglen, zc)) == NULL) {
 					LWIP_DEBUGF(TCP_OUTPUT_DEBUG | 2, ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
 					goto memerr;
 				}
@@ -482,8 +610,6 @@ err_t tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 				tcp_seg_add_chksum(~inet_chksum((u8_t *) arg + pos, seglen), seglen, &concat_chksum, &concat_chksum_swapped);
 				concat_chksummed += seglen;
 #endif							/* TCP_CHECKSUM_ON_COPY */
-				/* reference the non-volatile payload data */
-				concat_p->payload = (u8_t *) arg + pos;
 			}
 
 			pos += seglen;
@@ -521,16 +647,12 @@ err_t tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 			LWIP_ASSERT("tcp_write: check that first pbuf can hold the complete seglen", (p->len >= seglen));
 			TCP_DATA_COPY2((char *)p->payload + optlen, (u8_t *) arg + pos, seglen, &chksum, &chksum_swapped);
 		} else {
-			/* Copy is not set: First allocate a pbuf for holding the data.
-			 * Since the referenced data is available at least until it is
-			 * sent out on the link (as it has to be ACKed by the remote
-			 * party) we can safely use PBUF_ROM instead of PBUF_REF here.
-			 */
+			/* Copy is not set: First allocate a pbuf referencing the data. */
 			struct pbuf *p2;
 #if TCP_OVERSIZE
 			LWIP_ASSERT("oversize == 0", oversize == 0);
 #endif							/* TCP_OVERSIZE */
-			if ((p2 = pbuf_alloc(PBUF_TRANSPORT, seglen, PBUF_ROM)) == NULL) {
+			if ((p2 = tcp_pbuf_ref((u8_t *) arg + pos, seglen, zc)) == NULL) {
 				LWIP_DEBUGF(TCP_OUTPUT_DEBUG | 2, ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
 				goto memerr;
 			}
@@ -538,8 +660,6 @@ err_t tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 			/* calculate the checksum of nocopy-data */
 			chksum = ~inet_chksum((u8_t *) arg + pos, seglen);
 #endif							/* TCP_CHECKSUM_ON_COPY */
-			/* reference the non-volatile payload data */
-			p2->payload = (u8_t *) arg + pos;
 
 			/* Second, allocate a pbuf for the headers. */
 			if ((p = pbuf_alloc(PBUF_TRANSPORT, optlen, PBUF_RAM)) == NULL) {
@@ -712,6 +832,17 @@ err_t tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
 
 	if (flags & TCP_SYN) {
 		optflags = TF_SEG_OPTS_MSS;
+#if LWIP_WND_SCALE
+		/* A SYN-ACK may only carry the option if the SYN did */
+		if (!(flags & TCP_ACK) || (pcb->flags & TF_WND_SCALE)) {
+			optflags |= TF_SEG_OPTS_WND_SCALE;
+		}
+#endif							/* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK
+		if (!(flags & TCP_ACK) || (pcb->flags & TF_SACK)) {
+			optflags |= TF_SEG_OPTS_SACK_PERM;
+		}
+#endif							/* LWIP_TCP_SACK */
 	}
 #if LWIP_TCP_TIMESTAMPS
 	if ((pcb->flags & TF_TIMESTAMP)) {
@@ -797,6 +928,55 @@ static void tcp_build_timestamp_option(struct tcp_pcb *pcb, u32_t *opts)
 }
 #endif
 
+#if LWIP_TCP_SACK
+/**
+ * Collect the runs of contiguous data on the ooseq queue as SACK blocks
+ * (RFC 2018). The block holding the most recently received segment is
+ * reported first, the others follow in sequence number order.
+ *
+ * @param pcb tcp_pcb for which to report received data
+ * @param blocks receives left and right edge pairs (host byte order)
+ * @param max maximum number of blocks to store in blocks
+ * @return number of blocks stored
+ */
+static u8_t tcp_sack_blocks(struct tcp_pcb *pcb, u32_t *blocks, u8_t max)
+{
+	u8_t num = 0;
+#if TCP_QUEUE_OOSEQ
+	struct tcp_seg *seg = pcb->ooseq;
+	u32_t left, right;
+	u8_t i;
+
+	while (seg != NULL) {
+		left = seg->tcphdr->seqno;
+		right = left + TCP_TCPLEN(seg);
+		for (seg = seg->next; seg != NULL && seg->tcphdr->seqno == right; seg = seg->next) {
+			right += TCP_TCPLEN(seg);
+		}
+		if (TCP_SEQ_GEQ(pcb->rcv_sack_last, left) && TCP_SEQ_LT(pcb->rcv_sack_last, right)) {
+			/* most recent block goes first, drop the last one if full */
+			i = (num < max) ? num++ : num - 1;
+			for (; i > 0; i--) {
+				blocks[2 * i] = blocks[2 * i - 2];
+				blocks[2 * i + 1] = blocks[2 * i - 1];
+			}
+			blocks[0] = left;
+			blocks[1] = right;
+		} else if (num < max) {
+			blocks[2 * num] = left;
+			blocks[2 * num + 1] = right;
+			num++;
+		}
+	}
+#else							/* TCP_QUEUE_OOSEQ */
+	LWIP_UNUSED_ARG(pcb);
+	LWIP_UNUSED_ARG(blocks);
+	LWIP_UNUSED_ARG(max);
+#endif							/* TCP_QUEUE_OOSEQ */
+	return num;
+}
+#endif							/* LWIP_TCP_SACK */
+
 /** Send an ACK without data.
  *
  * @param pcb Protocol control block for the TCP connection to send the ACK
@@ -805,13 +985,27 @@ err_t tcp_send_empty_ack(struct tcp_pcb *pcb)
 {
 	struct pbuf *p;
 	struct tcp_hdr *tcphdr;
+	u32_t *opts;
 	u8_t optlen = 0;
+#if LWIP_TCP_SACK
+	u32_t sacks[2 * LWIP_TCP_MAX_SACK_NUM];
+	u8_t num_sacks = 0;
+#endif
 
 #if LWIP_TCP_TIMESTAMPS
 	if (pcb->flags & TF_TIMESTAMP) {
 		optlen = LWIP_TCP_OPT_LENGTH(TF_SEG_OPTS_TS);
 	}
 #endif
+#if LWIP_TCP_SACK
+	if (pcb->flags & TF_SACK) {
+		/* as many blocks as fit into the 40 bytes of TCP options */
+		num_sacks = tcp_sack_blocks(pcb, sacks, LWIP_MIN(LWIP_TCP_MAX_SACK_NUM, (40 - 4 - optlen) / 8));
+		if (num_sacks > 0) {
+			optlen += LWIP_TCP_SACK_OPT_LENGTH(num_sacks);
+		}
+	}
+#endif
 
 	p = tcp_output_alloc_header(pcb, optlen, 0, htonl(pcb->snd_nxt));
 	if (p == NULL) {
@@ -824,13 +1018,26 @@ err_t tcp_send_empty_ack(struct tcp_pcb *pcb)
 	pcb->flags &= ~(TF_ACK_DELAY | TF_ACK_NOW);
 
 	/* NB. MSS option is only sent on SYNs, so ignore it here */
+	opts = (u32_t *)(void *)(tcphdr + 1);
 #if LWIP_TCP_TIMESTAMPS
 	pcb->ts_lastacksent = pcb->rcv_nxt;
 
 	if (pcb->flags & TF_TIMESTAMP) {
-		tcp_build_timestamp_option(pcb, (u32_t *)(tcphdr + 1));
+		tcp_build_timestamp_option(pcb, opts);
+		opts += 3;
 	}
 #endif
+#if LWIP_TCP_SACK
+	if (num_sacks > 0) {
+		u8_t i;
+		/* 2 NOPs for alignment, kind 5, length */
+		*opts++ = htonl(0x01010500 | (LWIP_TCP_SACK_OPT_LENGTH(num_sacks) - 2));
+		for (i = 0; i < 2 * num_sacks; i++) {
+			*opts++ = htonl(sacks[i]);
+		}
+	}
+#endif
+	LWIP_UNUSED_ARG(opts);
 
 #if CHECKSUM_GEN_TCP
 	tcphdr->chksum = inet_chksum_pseudo(p, &(pcb->local_ip), &(pcb->remote_ip), IP_PROTO_TCP, p->tot_len);
@@ -897,9 +1104,9 @@ err_t tcp_output(struct tcp_pcb *pcb)
 #endif							/* TCP_OUTPUT_DEBUG */
 #if TCP_CWND_DEBUG
 	if (seg == NULL) {
-		LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %" U16_F ", cwnd %" U16_F ", wnd %" U32_F ", seg == NULL, ack %" U32_F "\n", pcb->snd_wnd, pcb->cwnd, wnd, pcb->lastack));
+		LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %" TCPWNDSIZE_F ", cwnd %" TCPWNDSIZE_F ", wnd %" U32_F ", seg == NULL, ack %" U32_F "\n", pcb->snd_wnd, pcb->cwnd, wnd, pcb->lastack));
 	} else {
-		LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %" U16_F ", cwnd %" U16_F ", wnd %" U32_F ", effwnd %" U32_F ", seq %" U32_F ", ack %" U32_F "\n", pcb->snd_wnd, pcb->cwnd, wnd, ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len, ntohl(seg->tcphdr->seqno), pcb->lastack));
+		LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %" TCPWNDSIZE_F ", cwnd %" TCPWNDSIZE_F ", wnd %" U32_F ", effwnd %" U32_F ", seq %" U32_F ", ack %" U32_F "\n", pcb->snd_wnd, pcb->cwnd, wnd, ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len, ntohl(seg->tcphdr->seqno), pcb->lastack));
 	}
 #endif							/* TCP_CWND_DEBUG */
 	/* data available and window allows it to be sent? */
@@ -916,7 +1123,7 @@ err_t tcp_output(struct tcp_pcb *pcb)
 			break;
 		}
 #if TCP_CWND_DEBUG
-		LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %" U16_F ", cwnd %" U16_F ", wnd %" U32_F ", effwnd %" U32_F ", seq %" U32_F ", ack %" U32_F ", i %" S16_F "\n", pcb->snd_wnd, pcb->cwnd, wnd, ntohl(seg->tcphdr->seqno) + seg->len - pcb->lastack, ntohl(seg->tcphdr->seqno), pcb->lastack, i));
+		LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %" TCPWNDSIZE_F ", cwnd %" TCPWNDSIZE_F ", wnd %" U32_F ", effwnd %" U32_F ", seq %" U32_F ", ack %" U32_F ", i %" S16_F "\n", pcb->snd_wnd, pcb->cwnd, wnd, ntohl(seg->tcphdr->seqno) + seg->len - pcb->lastack, ntohl(seg->tcphdr->seqno), pcb->lastack, i));
 		++i;
 #endif							/* TCP_CWND_DEBUG */
 
@@ -994,8 +1201,13 @@ static void tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
 	   wnd fields remain. */
 	seg->tcphdr->ackno = htonl(pcb->rcv_nxt);
 
-	/* advertise our receive window size in this TCP segment */
-	seg->tcphdr->wnd = htons(pcb->rcv_ann_wnd);
+	if (TCPH_FLAGS(seg->tcphdr) & TCP_SYN) {
+		/* the window of a SYN is never scaled (RFC 7323) */
+		seg->tcphdr->wnd = htons(TCPWND_MIN16(pcb->rcv_ann_wnd));
+	} else {
+		/* advertise our receive window size in this TCP segment */
+		seg->tcphdr->wnd = htons(TCPWND_MIN16(RCV_WND_SCALE(pcb, pcb->rcv_ann_wnd)));
+	}
 
 	pcb->rcv_ann_right_edge = pcb->rcv_nxt + pcb->rcv_ann_wnd;
 
@@ -1012,6 +1224,20 @@ static void tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
 		*opts = TCP_BUILD_MSS_OPTION(mss);
 		opts += 1;
 	}
+#if LWIP_WND_SCALE
+	if (seg->flags & TF_SEG_OPTS_WND_SCALE) {
+		/* NOP for alignment, kind 3, length 3, shift count */
+		*opts = PP_HTONL(0x01030300 | TCP_RCV_SCALE);
+		opts += 1;
+	}
+#endif							/* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK
+	if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
+		/* 2 NOPs for alignment, kind 4, length 2 */
+		*opts = PP_HTONL(0x01010402);
+		opts += 1;
+	}
+#endif							/* LWIP_TCP_SACK */
 #if LWIP_TCP_TIMESTAMPS
 	pcb->ts_lastacksent = pcb->rcv_nxt;
 
@@ -1132,7 +1358,7 @@ void tcp_rst(u32_t seqno, u32_t ackno, ip_addr_t *local_ip, ip_addr_t *remote_ip
 	tcphdr->seqno = htonl(seqno);
 	tcphdr->ackno = htonl(ackno);
 	TCPH_HDRLEN_FLAGS_SET(tcphdr, TCP_HLEN / 4, TCP_RST | TCP_ACK);
-	tcphdr->wnd = PP_HTONS(TCP_WND);
+	tcphdr->wnd = PP_HTONS(TCPWND_MIN16(TCP_WND));
 	tcphdr->chksum = 0;
 	tcphdr->urgp = 0;
 
@@ -1162,6 +1388,17 @@ void tcp_rexmit_rto(struct tcp_pcb *pcb)
 		return;
 	}
 
+#if LWIP_TCP_SACK
+	/* The receiver may have discarded SACKed data (RFC 2018), so the
+	   timeout ends SACK recovery and everything is sent again */
+	for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+		seg->flags &= ~(TF_SEG_SACKED | TF_SEG_RETRANSMITTED);
+	}
+	if (pcb->flags & TF_SACK) {
+		pcb->flags &= ~TF_INFR;
+	}
+#endif							/* LWIP_TCP_SACK */
+
 	/* Move all unacked segments to the head of the unsent queue */
 	for (seg = pcb->unacked; seg->next != NULL; seg = seg->next) ;
 	/* concatenate unsent queue after unacked queue */
@@ -1202,6 +1439,9 @@ void tcp_rexmit(struct tcp_pcb *pcb)
 	/* Keep the unsent queue sorted. */
 	seg = pcb->unacked;
 	pcb->unacked = seg->next;
+#if LWIP_TCP_SACK
+	seg->flags |= TF_SEG_RETRANSMITTED;
+#endif
 
 	cur_seg = &(pcb->unsent);
 	while (*cur_seg && TCP_SEQ_LT(ntohl((*cur_seg)->tcphdr->seqno), ntohl(seg->tcphdr->seqno))) {
@@ -1227,6 +1467,40 @@ void tcp_rexmit(struct tcp_pcb *pcb)
 	   and thus tcp_output directly returns. */
 }
 
+/**
+ * Retransmit one segment of the unacked queue right away
+ *
+ * Called by tcp_receive() to repair a hole reported by SACK blocks.
+ * Unlike tcp_rexmit(), the segment stays on the unacked queue and is
+ * not subject to the window check of tcp_output(), so holes far from
+ * the left edge of the window are repaired in the same round trip.
+ *
+ * A segment whose pbuf is still referenced by the netif (e.g. queued
+ * for transmission by the driver) is skipped: tcp_output_segment()
+ * rewrites its header in place, which would corrupt the copy in flight.
+ * The hole is then repaired by a later SACK or by the retransmission
+ * timer.
+ *
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param seg the segment on pcb->unacked to retransmit
+ */
+void tcp_rexmit_seg(struct tcp_pcb *pcb, struct tcp_seg *seg)
+{
+	if (seg->p->ref != 1) {
+		LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_rexmit_seg: segment %" U32_F " still in flight\n", ntohl(seg->tcphdr->seqno)));
+		return;
+	}
+
+#if LWIP_TCP_SACK
+	seg->flags |= TF_SEG_RETRANSMITTED;
+#endif
+	snmp_inc_tcpretranssegs();
+	tcp_output_segment(seg, pcb);
+
+	/* Don't take any rtt measurements after retransmitting. */
+	pcb->rttest = 0;
+}
+
 /**
  * Handle retransmission after three dupacks received
  *
@@ -1238,6 +1512,10 @@ void tcp_rexmit_fast(struct tcp_pcb *pcb)
 		/* This is fast retransmit. Retransmit the first unacked segment. */
 		LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_receive: dupacks %" U16_F " (%" U32_F "), fast retransmit %" U32_F "\n", (u16_t) pcb->dupacks, pcb->lastack, ntohl(pcb->unacked->tcphdr->seqno)));
 		tcp_rexmit(pcb);
+#if LWIP_TCP_SACK
+		/* recovery ends when everything sent so far is acknowledged */
+		pcb->recover = pcb->snd_nxt;
+#endif
 
 		/* Set ssthresh to half of the minimum of the current
 		 * cwnd and the advertised window */
@@ -1249,7 +1527,7 @@ void tcp_rexmit_fast(struct tcp_pcb *pcb)
 
 		/* The minimum value for ssthresh should be 2 MSS */
 		if (pcb->ssthresh < 2 * pcb->mss) {
-			LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_receive: The minimum value for ssthresh %" U16_F " should be min 2 mss %" U16_F "...\n", pcb->ssthresh, 2 * pcb->mss));
+			LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_receive: The minimum value for ssthresh %" TCPWNDSIZE_F " should be min 2 mss %" U16_F "...\n", pcb->ssthresh, 2 * pcb->mss));
 			pcb->ssthresh = 2 * pcb->mss;
 		}
 
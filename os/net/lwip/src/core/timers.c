@@ -77,9 +77,13 @@
 
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
-#if NO_SYS
+#if NO_SYS || LWIP_TCPIP_CORE_LOCKING
 static systime_t timeouts_last_time;
-#endif							/* NO_SYS */
+#endif							/* NO_SYS || LWIP_TCPIP_CORE_LOCKING */
+#if !NO_SYS && LWIP_TCPIP_CORE_LOCKING
+/** set while tcpip_thread waits for a message with the core unlocked */
+static u8_t timeouts_waiting;
+#endif							/* !NO_SYS && LWIP_TCPIP_CORE_LOCKING */
 
 #if LWIP_TCP
 /** global variable that shows if the tcp timer is currently scheduled or not */
@@ -230,12 +234,49 @@ void sys_timeouts_init(void)
 	sys_timeout(IGMP_TMR_INTERVAL, igmp_timer, NULL);
 #endif							/* LWIP_IGMP */
 
-#if NO_SYS
-	/* Initialise timestamp for sys_check_timeouts */
+#if NO_SYS || LWIP_TCPIP_CORE_LOCKING
+	/* Initialise timestamp for sys_check_timeouts/sys_timeouts_update */
 	timeouts_last_time = sys_now();
 #endif
 }
 
+#if !NO_SYS && LWIP_TCPIP_CORE_LOCKING
+/**
+ * Charge the time elapsed since the last update to the timeout list.
+ * Expired timeouts are left at the head of the list with a time of 0.
+ *
+ * With core locking, threads other than tcpip_thread add timeouts while
+ * tcpip_thread waits for a message, so the elapsed time has to be applied
+ * before a new timeout is inserted relative to the ones already queued.
+ */
+static void sys_timeouts_update(void)
+{
+	struct sys_timeo *t;
+	systime_t now;
+	u32_t diff;
+
+	now = sys_now();
+	/* this cares for wraparounds */
+	diff = (u32_t)(now - timeouts_last_time);
+	timeouts_last_time = now;
+
+	for (t = next_timeout; (t != NULL) && (diff > 0); t = t->next) {
+		if (t->time >= diff) {
+			t->time -= diff;
+			break;
+		}
+		diff -= t->time;
+		t->time = 0;
+	}
+}
+
+/** Callback posted to tcpip_thread to make it recompute its wait time */
+static void sys_timeouts_wakeup(void *arg)
+{
+	LWIP_UNUSED_ARG(arg);
+}
+#endif							/* !NO_SYS && LWIP_TCPIP_CORE_LOCKING */
+
 /**
  * Create a one-shot timer (aka timeout). Timeouts are processed in the
  * following cases:
@@ -268,6 +309,17 @@ void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 	LWIP_DEBUGF(TIMERS_DEBUG, ("sys_timeout: %p msecs=%" U32_F " handler=%s arg=%p\n", (void *)timeout, msecs, handler_name, (void *)arg));
 #endif							/* LWIP_DEBUG_TIMERNAMES */
 
+#if !NO_SYS && LWIP_TCPIP_CORE_LOCKING
+	sys_timeouts_update();
+	if ((next_timeout == NULL) || (next_timeout->time > msecs)) {
+		if (timeouts_waiting) {
+			/* tcpip_thread sleeps longer than this timeout: wake it up */
+			timeouts_waiting = 0;
+			tcpip_callback_with_block(sys_timeouts_wakeup, NULL, 0);
+		}
+	}
+#endif							/* !NO_SYS && LWIP_TCPIP_CORE_LOCKING */
+
 	if (next_timeout == NULL) {
 		next_timeout = timeout;
 		return;
@@ -390,6 +442,66 @@ void sys_restart_timeouts(void)
 	timeouts_last_time = sys_now();
 }
 
+#elif LWIP_TCPIP_CORE_LOCKING
+
+/**
+ * Wait (forever) for a message to arrive in an mbox.
+ * While waiting, timeouts are processed.
+ *
+ * Must be called with the core locked: timeout handlers run with the lock
+ * held and it is only released while waiting for the mbox.  Other threads
+ * may change the timeout list meanwhile, so the elapsed time is taken from
+ * sys_now() instead of from the wait.
+ *
+ * @param mbox the mbox to fetch the message from
+ * @param msg the place to store the message
+ */
+void sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
+{
+	u32_t time_needed;
+	u32_t sleeptime;
+	struct sys_timeo *tmptimeout;
+	sys_timeout_handler handler;
+	void *arg;
+
+	while (1) {
+		sys_timeouts_update();
+		tmptimeout = next_timeout;
+		if ((tmptimeout != NULL) && (tmptimeout->time == 0)) {
+			next_timeout = tmptimeout->next;
+			handler = tmptimeout->h;
+			arg = tmptimeout->arg;
+#if LWIP_DEBUG_TIMERNAMES
+			if (handler != NULL) {
+				LWIP_DEBUGF(TIMERS_DEBUG, ("stmf calling h=%s arg=%p\n", tmptimeout->handler_name, arg));
+			}
+#endif							/* LWIP_DEBUG_TIMERNAMES */
+			memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
+			if (handler != NULL) {
+				handler(arg);
+			}
+			LWIP_TCPIP_THREAD_ALIVE();
+			continue;
+		}
+
+		/* 0 waits forever if there is no timeout at all */
+		sleeptime = (tmptimeout != NULL) ? tmptimeout->time : 0;
+
+		timeouts_waiting = 1;
+		UNLOCK_TCPIP_CORE();
+		time_needed = sys_arch_mbox_fetch(mbox, msg, sleeptime);
+		LOCK_TCPIP_CORE();
+		timeouts_waiting = 0;
+
+		if (time_needed != SYS_ARCH_TIMEOUT) {
+			/* a message was received, the time waited is charged on the
+			   next call */
+			return;
+		}
+		/* the head may have changed while waiting: recheck it */
+	}
+}
+
 #else							/* NO_SYS */
 
 /**
@@ -432,11 +544,7 @@ again:
 #endif							/* LWIP_DEBUG_TIMERNAMES */
 			memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
 			if (handler != NULL) {
-				/* For LWIP_TCPIP_CORE_LOCKING, lock the core before calling the
-				   timeout handler function. */
-				LOCK_TCPIP_CORE();
 				handler(arg);
-				UNLOCK_TCPIP_CORE();
 			}
 			LWIP_TCPIP_THREAD_ALIVE();
 
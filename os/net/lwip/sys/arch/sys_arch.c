@@ -30,6 +30,8 @@
 #include <tinyara/arch.h>
 #include <tinyara/kthread.h>
 #include <sys/types.h>
+#include <stdbool.h>
+#include <arch/irq.h>
 
 /* lwIP includes. */
 #include <net/lwip/stats.h>
@@ -50,6 +52,56 @@
 
 static u16_t s_nextthread = 0;
 
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_full / sys_mbox_put / sys_mbox_get
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Ring helpers, called with interrupts disabled.  A message is queued
+ *      or dequeued without touching a semaphore unless a task is blocked
+ *      waiting for it, in which case that one task is woken up.
+ *---------------------------------------------------------------------------*/
+#define sys_mbox_empty(mbox) ((mbox)->front == (mbox)->rear)
+
+static inline bool sys_mbox_full(sys_mbox_t *mbox)
+{
+	u32_t next = mbox->rear + 1;
+
+	if (next == mbox->queue_size) {
+		next = 0;
+	}
+
+	return next == mbox->front;
+}
+
+static inline void sys_mbox_put(sys_mbox_t *mbox, void *msg)
+{
+	mbox->msgs[mbox->rear] = msg;
+	if (++mbox->rear == mbox->queue_size) {
+		mbox->rear = 0;
+	}
+
+	if (mbox->wait_fetch > 0) {
+		mbox->wait_fetch--;
+		sem_post(&mbox->not_empty);
+	}
+}
+
+static inline void *sys_mbox_get(sys_mbox_t *mbox)
+{
+	void *msg = mbox->msgs[mbox->front];
+
+	if (++mbox->front == mbox->queue_size) {
+		mbox->front = 0;
+	}
+
+	if (mbox->wait_send > 0) {
+		mbox->wait_send--;
+		sem_post(&mbox->not_full);
+	}
+
+	return msg;
+}
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
  *---------------------------------------------------------------------------*
@@ -65,14 +117,22 @@ err_t sys_mbox_new(sys_mbox_t *mbox, int queue_sz)
 {
 
 	err_t err = ERR_OK;
+
 	mbox->is_valid = 1;
 	mbox->id = lwip_stats.sys.mbox.used + 1;
-	mbox->queue_size = queue_sz;
+
+	/* One slot of the ring is always left empty */
+	if (queue_sz <= 0 || queue_sz >= SYS_MBOX_MAXSIZE) {
+		mbox->queue_size = SYS_MBOX_MAXSIZE;
+	} else {
+		mbox->queue_size = queue_sz + 1;
+	}
+
 	mbox->wait_send = 0;
 	mbox->wait_fetch = 0;
 	mbox->front = mbox->rear = 0;
-	sys_sem_new(&(mbox->mail), 0);
-	sys_sem_new(&(mbox->mutex), 1);
+	sys_sem_new(&(mbox->not_empty), 0);
+	sys_sem_new(&(mbox->not_full), 0);
 
 #if SYS_STATS
 	SYS_STATS_INC_USED(mbox);
@@ -103,8 +163,8 @@ void sys_mbox_free(sys_mbox_t *mbox)
 		mbox->queue_size = 0;
 		mbox->wait_send = 0;
 		mbox->wait_fetch = 0;
-		sys_sem_free(&(mbox->mail));
-		sys_sem_free(&(mbox->mutex));
+		sys_sem_free(&(mbox->not_empty));
+		sys_sem_free(&(mbox->not_full));
 
 		LWIP_DEBUGF(SYSARCH_DEBUG, ("Succesfully deleted MBOX with id %d", mbox->id));
 #if SYS_STATS
@@ -126,41 +186,24 @@ void sys_mbox_free(sys_mbox_t *mbox)
  *---------------------------------------------------------------------------*/
 void sys_mbox_post(sys_mbox_t *mbox, void *msg)
 {
-	u8_t first_msg = 0;
-	u32_t tmp = 0;
-	sys_arch_sem_wait(&(mbox->mutex), 0);
+	irqstate_t flags;
 
 	LWIP_DEBUGF(SYSARCH_DEBUG, ("mbox %p msg %p\n", (void *)mbox, (void *)msg));
-	/* Wait while the queue is full */
-	tmp = (mbox->rear + 1) % mbox->queue_size;
-	if (tmp == mbox->front) {
+
+	flags = irqsave();
+
+	/* Wait while the queue is full.  The fetcher that makes room counts
+	   us out of wait_send when it wakes us up. */
+	while (sys_mbox_full(mbox)) {
 		LWIP_DEBUGF(SYSARCH_DEBUG, ("Queue Full, Wait until gets free\n"));
-	}
-	while (tmp == mbox->front) {
 		mbox->wait_send++;
-		sys_sem_signal(&(mbox->mutex));
-		sys_arch_sem_wait(&(mbox->mail), 0);
-		sys_arch_sem_wait(&(mbox->mutex), 0);
-		mbox->wait_send--;
-	}
-
-	mbox->msgs[mbox->rear] = msg;
-	LWIP_DEBUGF(SYSARCH_DEBUG, ("Post SUCCESS\n"));
-	if (mbox->rear == mbox->front) {
-		first_msg = 1;
-	} else {
-		first_msg = 0;
+		sys_arch_sem_wait(&(mbox->not_full), 0);
 	}
 
-	mbox->rear = tmp;
+	sys_mbox_put(mbox, msg);
+	irqrestore(flags);
 
-	/* If msg was posted to an empty queue, Release semaphore for
-	   some fetch api blocked on this sem due to Empty queue. */
-	if (first_msg && mbox->wait_fetch) {
-		sys_sem_signal(&(mbox->mail));
-	}
-
-	sys_sem_signal(&(mbox->mutex));
+	LWIP_DEBUGF(SYSARCH_DEBUG, ("Post SUCCESS\n"));
 	return;
 }
 
@@ -169,7 +212,7 @@ void sys_mbox_post(sys_mbox_t *mbox, void *msg)
  *---------------------------------------------------------------------------*
  * Description:
  *      Try to post the "msg" to the mailbox.  Returns immediately with
- *      error if cannot.
+ *      error if cannot.  May be called from an interrupt handler.
  * Inputs:
  *      sys_mbox_t mbox         -- Handle of mailbox
  *      void *msg               -- Pointer to data to post
@@ -180,38 +223,19 @@ void sys_mbox_post(sys_mbox_t *mbox, void *msg)
 err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg)
 {
 	err_t err = ERR_OK;
-	u8_t first_msg = 0;
-	u32_t tmp = 0;
-	sys_arch_sem_wait(&(mbox->mutex), 0);
+	irqstate_t flags;
 
 	LWIP_DEBUGF(SYSARCH_DEBUG, ("mbox %p msg %p\n", (void *)mbox, (void *)msg));
-	/* Check if the queue is full */
-	tmp = (mbox->rear + 1) % mbox->queue_size;
-	if (tmp == mbox->front) {
+
+	flags = irqsave();
+	if (sys_mbox_full(mbox)) {
 		LWIP_DEBUGF(SYSARCH_DEBUG, ("Queue Full, returning error\n"));
 		err = ERR_MEM;
-		goto errout_with_mutex;
-	}
-
-	mbox->msgs[mbox->rear] = msg;
-	LWIP_DEBUGF(SYSARCH_DEBUG, ("Post SUCCESS\n"));
-	if (mbox->rear == mbox->front) {
-		first_msg = 1;
 	} else {
-		first_msg = 0;
+		sys_mbox_put(mbox, msg);
 	}
 
-	mbox->rear = tmp;
-
-	/* If msg was posted to an empty queue, Release semaphore for
-	   some fetch api blocked on this sem due to Empty queue. */
-	if (first_msg && mbox->wait_fetch) {
-		sys_sem_signal(&(mbox->mail));
-	}
-
-errout_with_mutex:
-	sys_sem_signal(&(mbox->mutex));
-
+	irqrestore(flags);
 	return err;
 }
 
@@ -242,53 +266,50 @@ errout_with_mutex:
  *---------------------------------------------------------------------------*/
 u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
 {
+	systime_t start = clock_systimer();
 	u32_t time = 0;
+	u32_t wait = 0;
+	irqstate_t flags;
+	void *m;
 
-	/* The mutex lock is quick so we don't bother with the timeout
-	   stuff here. */
-	sys_arch_sem_wait(&(mbox->mutex), 0);
+	flags = irqsave();
 
 	/* wait while the queue is empty */
-	while (mbox->front == mbox->rear) {
-		mbox->wait_fetch++;
-		sys_sem_signal(&(mbox->mutex));
-
+	while (sys_mbox_empty(mbox)) {
 		/* We block while waiting for a mail to arrive in the mailbox. We
 		   must be prepared to timeout. */
 		if (timeout != 0) {
-			time = sys_arch_sem_wait(&(mbox->mail), timeout);
+			time = TICK2MSEC(clock_systimer() - start);
+			if (time >= timeout) {
+				irqrestore(flags);
+				return SYS_ARCH_TIMEOUT;
+			}
 
-			if (time == SYS_ARCH_TIMEOUT) {
-				sys_arch_sem_wait(&(mbox->mutex), 0);
+			wait = timeout - time;
+		}
+
+		mbox->wait_fetch++;
+		if (sys_arch_sem_wait(&(mbox->not_empty), wait) == SYS_ARCH_TIMEOUT) {
+			/* A poster may have counted us out of wait_fetch just as the
+			   wait timed out.  Its wakeup is then still pending. */
+			if (sem_trywait(&(mbox->not_empty)) != OK) {
 				mbox->wait_fetch--;
-				sys_sem_signal(&(mbox->mutex));
-				return SYS_ARCH_TIMEOUT;
 			}
-		} else {
-			sys_arch_sem_wait(&(mbox->mail), 0);
 		}
 
-		sys_arch_sem_wait(&(mbox->mutex), 0);
-		mbox->wait_fetch--;
+		time = TICK2MSEC(clock_systimer() - start);
 	}
 
+	m = sys_mbox_get(mbox);
+	irqrestore(flags);
+
 	if (msg != NULL) {
-		*msg = mbox->msgs[mbox->front];
+		*msg = m;
 		LWIP_DEBUGF(SYSARCH_DEBUG, (" mbox %p msg %p\n", (void *)mbox, *msg));
 	} else {
 		LWIP_DEBUGF(SYSARCH_DEBUG, (" mbox %p, null msg\n", (void *)mbox));
 	}
 
-	mbox->front = (mbox->front + 1) % mbox->queue_size;
-
-	/* We just fetched a msg, Release semaphore for
-	   some post api blocked on this sem due to queue full. */
-	if (mbox->wait_send) {
-		sys_sem_signal(&(mbox->mail));
-	}
-
-	sys_sem_signal(&(mbox->mutex));
-
 	return time;
 }
 
@@ -308,36 +329,60 @@ u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
  *---------------------------------------------------------------------------*/
 u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
 {
-	u32_t err = ERR_OK;
-	/* The mutex lock is quick so we don't bother with the timeout
-	   stuff here. */
-	sys_arch_sem_wait(&(mbox->mutex), 0);
+	irqstate_t flags;
+	void *m;
+
+	flags = irqsave();
 
 	/* check if the queue is empty */
-	if (mbox->front == mbox->rear) {
+	if (sys_mbox_empty(mbox)) {
+		irqrestore(flags);
 		LWIP_DEBUGF(SYSARCH_DEBUG, ("SYS_MBOX_EMPTY , returning\n"));
-		err = SYS_MBOX_EMPTY;
-		goto errout_with_mutex;
+		return SYS_MBOX_EMPTY;
 	}
 
+	m = sys_mbox_get(mbox);
+	irqrestore(flags);
+
 	if (msg != NULL) {
+		*msg = m;
 		LWIP_DEBUGF(SYSARCH_DEBUG, ("mbox %p msg %p\n", (void *)mbox, *msg));
-		*msg = mbox->msgs[mbox->front];
 	} else {
 		LWIP_DEBUGF(SYSARCH_DEBUG, ("mbox %p, null msg\n", (void *)mbox));
 	}
 
-	mbox->front = (mbox->front + 1) % mbox->queue_size;
+	return ERR_OK;
+}
 
-	/* We just fetched a msg, Release semaphore for
-	   some post api blocked on this sem due to queue full. */
-	if (mbox->wait_send) {
-		sys_sem_signal(&(mbox->mail));
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_tryfetch_n
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Fetch up to "max" messages that are already in the mailbox, without
+ *      blocking.  Lets a consumer that was woken up for one message drain
+ *      the messages that arrived meanwhile in a single pass.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msgs             -- Array receiving the messages
+ *      u32_t max               -- Number of entries in msgs
+ * Outputs:
+ *      u32_t                   -- Number of messages fetched, 0 if the
+ *                                  mailbox was empty.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_tryfetch_n(sys_mbox_t *mbox, void **msgs, u32_t max)
+{
+	irqstate_t flags;
+	u32_t n = 0;
+
+	flags = irqsave();
+	while (n < max && !sys_mbox_empty(mbox)) {
+		msgs[n++] = sys_mbox_get(mbox);
 	}
 
-errout_with_mutex:
-	sys_sem_signal(&(mbox->mutex));
-	return err;
+	irqrestore(flags);
+
+	LWIP_DEBUGF(SYSARCH_DEBUG, ("mbox %p fetched %u msgs\n", (void *)mbox, n));
+	return n;
 }
 
 /*---------------------------------------------------------------------------*
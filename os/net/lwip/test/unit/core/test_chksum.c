@@ -0,0 +1,272 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "test_chksum.h"
+
+#include <net/lwip/ipv4/inet_chksum.h>
+#include <net/lwip/pbuf.h>
+#include <net/lwip/def.h>
+#include <net/lwip/sys.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define CHKSUM_BUF_SIZE     2048
+#define CHKSUM_PERF_LEN     1460
+#define CHKSUM_PERF_LOOPS   20000
+
+static u8_t src_buf[CHKSUM_BUF_SIZE + 8];
+static u8_t dst_buf[CHKSUM_BUF_SIZE + 8];
+static u32_t rand_state;
+
+/* Helper functions */
+
+static u8_t test_rand(void)
+{
+	rand_state = rand_state * 1103515245UL + 12345UL;
+	return (u8_t)(rand_state >> 16);
+}
+
+static void fill_buf(u8_t *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		buf[i] = test_rand();
+	}
+}
+
+/** RFC 1071 reference: sum the data as big endian 16-bit words, one octet
+ * at a time, and return the non-inverted sum like LWIP_CHKSUM does. */
+static u16_t ref_chksum(const u8_t *data, int len)
+{
+	u32_t acc = 0;
+
+	while (len > 1) {
+		acc += ((u32_t)data[0] << 8) | data[1];
+		data += 2;
+		len -= 2;
+	}
+	if (len > 0) {
+		acc += (u32_t)data[0] << 8;
+	}
+	while (acc >> 16) {
+		acc = (acc & 0xffffUL) + (acc >> 16);
+	}
+	return lwip_htons((u16_t)acc);
+}
+
+/** The former default algorithm (#2): two bytes at a time */
+static u16_t ref_chksum_halfword(void *dataptr, int len)
+{
+	u8_t *pb = (u8_t *)dataptr;
+	u16_t *ps, t = 0;
+	u32_t sum = 0;
+	int odd = ((mem_ptr_t)pb & 1);
+
+	if (odd && len > 0) {
+		((u8_t *)&t)[1] = *pb++;
+		len--;
+	}
+	ps = (u16_t *)(void *)pb;
+	while (len > 1) {
+		sum += *ps++;
+		len -= 2;
+	}
+	if (len > 0) {
+		((u8_t *)&t)[0] = *(u8_t *)ps;
+	}
+	sum += t;
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+	return (u16_t)sum;
+}
+
+/* Setups/teardown functions */
+
+static void chksum_setup(void)
+{
+	rand_state = 1;
+}
+
+static void chksum_teardown(void)
+{
+}
+
+/* Test functions */
+
+/** inet_chksum() matches the reference for every alignment and length */
+START_TEST(test_chksum_alignment)
+{
+	int off, len;
+	LWIP_UNUSED_ARG(_i);
+
+	fill_buf(src_buf, sizeof(src_buf));
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len <= 300; len++) {
+			fail_unless((u16_t)~inet_chksum(src_buf + off, len) == ref_chksum(src_buf + off, len));
+		}
+		len = CHKSUM_BUF_SIZE - off;
+		fail_unless((u16_t)~inet_chksum(src_buf + off, len) == ref_chksum(src_buf + off, len));
+	}
+}
+
+END_TEST
+/** Carries are not lost when every word overflows the accumulator */
+START_TEST(test_chksum_carry)
+{
+	int off;
+	LWIP_UNUSED_ARG(_i);
+
+	memset(src_buf, 0xff, sizeof(src_buf));
+	for (off = 0; off < 4; off++) {
+		fail_unless((u16_t)~inet_chksum(src_buf + off, CHKSUM_BUF_SIZE) == ref_chksum(src_buf + off, CHKSUM_BUF_SIZE));
+		fail_unless((u16_t)~inet_chksum(src_buf + off, CHKSUM_BUF_SIZE - 1) == ref_chksum(src_buf + off, CHKSUM_BUF_SIZE - 1));
+	}
+
+	memset(src_buf, 0xff, sizeof(src_buf));
+	src_buf[CHKSUM_BUF_SIZE / 2] = 0xfe;
+	fail_unless((u16_t)~inet_chksum(src_buf, CHKSUM_BUF_SIZE) == ref_chksum(src_buf, CHKSUM_BUF_SIZE));
+}
+
+END_TEST
+/** inet_chksum_pbuf() over a chain of odd sized pbufs matches the reference
+ * over the concatenated data */
+START_TEST(test_chksum_pbuf_chain)
+{
+	struct pbuf *p, *q;
+	u16_t lens[] = { 1, 33, 64, 255, 2, 7, 600 };
+	u16_t total = 0;
+	size_t i;
+	LWIP_UNUSED_ARG(_i);
+
+	fill_buf(src_buf, sizeof(src_buf));
+	p = NULL;
+	for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+		q = pbuf_alloc(PBUF_RAW, lens[i], PBUF_RAM);
+		EXPECT_RET(q != NULL);
+		memcpy(q->payload, src_buf + total, lens[i]);
+		total += lens[i];
+		if (p == NULL) {
+			p = q;
+		} else {
+			pbuf_cat(p, q);
+		}
+	}
+
+	fail_unless((u16_t)~inet_chksum_pbuf(p) == ref_chksum(src_buf, total));
+	pbuf_free(p);
+}
+
+END_TEST
+#if LWIP_CHECKSUM_ON_COPY
+/** LWIP_CHKSUM_COPY copies exactly len bytes and returns the checksum of the
+ * copied data for any source and destination alignment */
+START_TEST(test_chksum_copy)
+{
+	int soff, doff, len;
+	u16_t chksum;
+	LWIP_UNUSED_ARG(_i);
+
+	fill_buf(src_buf, sizeof(src_buf));
+	for (soff = 0; soff < 4; soff++) {
+		for (doff = 0; doff < 4; doff++) {
+			for (len = 0; len <= CHKSUM_BUF_SIZE; len += (len < 160) ? 1 : 97) {
+				memset(dst_buf, 0xa5, sizeof(dst_buf));
+				chksum = LWIP_CHKSUM_COPY(dst_buf + doff, src_buf + soff, (u16_t)len);
+				fail_unless(chksum == ref_chksum(src_buf + soff, len));
+				fail_unless(memcmp(dst_buf + doff, src_buf + soff, len) == 0);
+				/* nothing written around the destination */
+				fail_unless(doff == 0 || dst_buf[doff - 1] == 0xa5);
+				fail_unless(dst_buf[doff + len] == 0xa5);
+			}
+		}
+	}
+}
+
+END_TEST
+#endif							/* LWIP_CHECKSUM_ON_COPY */
+/** Compare the throughput with the former default algorithm */
+START_TEST(test_chksum_throughput)
+{
+	systime_t start;
+	u32_t ref_ms, ms;
+	u32_t acc = 0;
+	int i;
+	LWIP_UNUSED_ARG(_i);
+
+	fill_buf(src_buf, sizeof(src_buf));
+	fail_unless(ref_chksum_halfword(src_buf, CHKSUM_PERF_LEN) == (u16_t)~inet_chksum(src_buf, CHKSUM_PERF_LEN));
+
+	memset(src_buf, 0, 8);
+	start = sys_now();
+	for (i = 0; i < CHKSUM_PERF_LOOPS; i++) {
+		src_buf[i & 7] = (u8_t)i;
+		acc += ref_chksum_halfword(src_buf, CHKSUM_PERF_LEN);
+	}
+	ref_ms = (u32_t)(sys_now() - start);
+
+	memset(src_buf, 0, 8);
+	start = sys_now();
+	for (i = 0; i < CHKSUM_PERF_LOOPS; i++) {
+		src_buf[i & 7] = (u8_t)i;
+		acc -= (u16_t)~inet_chksum(src_buf, CHKSUM_PERF_LEN);
+	}
+	ms = (u32_t)(sys_now() - start);
+
+	/* both loops summed the same data */
+	fail_unless(acc == 0);
+	printf("chksum: %d x %d bytes: halfword %u ms, inet_chksum %u ms\n", CHKSUM_PERF_LOOPS, CHKSUM_PERF_LEN, (unsigned)ref_ms, (unsigned)ms);
+
+#if LWIP_CHECKSUM_ON_COPY
+	start = sys_now();
+	for (i = 0; i < CHKSUM_PERF_LOOPS; i++) {
+		MEMCPY(dst_buf, src_buf, CHKSUM_PERF_LEN);
+		acc += ref_chksum_halfword(dst_buf, CHKSUM_PERF_LEN);
+	}
+	ref_ms = (u32_t)(sys_now() - start);
+
+	start = sys_now();
+	for (i = 0; i < CHKSUM_PERF_LOOPS; i++) {
+		acc -= LWIP_CHKSUM_COPY(dst_buf, src_buf, CHKSUM_PERF_LEN);
+	}
+	ms = (u32_t)(sys_now() - start);
+
+	fail_unless(acc == 0);
+	printf("chksum: %d x %d bytes: copy then halfword %u ms, LWIP_CHKSUM_COPY %u ms\n", CHKSUM_PERF_LOOPS, CHKSUM_PERF_LEN, (unsigned)ref_ms, (unsigned)ms);
+#endif							/* LWIP_CHECKSUM_ON_COPY */
+}
+
+END_TEST
+/** Create the suite including all tests for this module */
+Suite *chksum_suite(void)
+{
+	TFun tests[] = {
+		test_chksum_alignment,
+		test_chksum_carry,
+		test_chksum_pbuf_chain,
+#if LWIP_CHECKSUM_ON_COPY
+		test_chksum_copy,
+#endif
+		test_chksum_throughput
+	};
+	return create_suite("CHKSUM", tests, sizeof(tests) / sizeof(TFun), chksum_setup, chksum_teardown);
+}
@@ -62,6 +62,17 @@
 #define TCP_SND_BUF                     (12 * TCP_MSS)
 #define TCP_WND                         (10 * TCP_MSS)
 
+/* Exercise the fused copy and checksum path in the tcp and chksum tests */
+#define LWIP_CHECKSUM_ON_COPY           1
+
+/* Exercise window scaling and selective acknowledgments in the tcp tests */
+#define LWIP_WND_SCALE                  1
+#define TCP_RCV_SCALE                   2
+#define LWIP_TCP_SACK                   1
+
+/* Exercise zero-copy writes with completion notification in the tcp tests */
+#define LWIP_TCP_ZEROCOPY               1
+
 /* Minimal changes to opt.h required for etharp unit tests: */
 #define ETHARP_SUPPORT_STATIC_ENTRIES   1
 
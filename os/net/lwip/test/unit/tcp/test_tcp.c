@@ -661,6 +661,89 @@ END_TEST START_TEST(test_tcp_tx_full_window_lost_from_unacked)
 	test_tcp_tx_full_window_lost(0);
 }
 
+END_TEST
+
+static void test_tcp_zc_done(void *arg)
+{
+	(*(int *)arg)++;
+}
+
+/** Write data with tcp_write_zc() and check that the completion function is
+ * called exactly once, after all of the data has been ACKed, and that it is
+ * also called when the connection is aborted with data still queued */
+START_TEST(test_tcp_write_zc)
+{
+	struct netif netif;
+	struct test_tcp_txcounters txcounters;
+	struct test_tcp_counters counters;
+	struct tcp_pcb *pcb;
+	struct tcp_zc zc;
+	struct pbuf *p;
+	static u8_t data[3 * TCP_MSS];
+	ip_addr_t remote_ip, local_ip, netmask;
+	u16_t remote_port = 0x100, local_port = 0x101;
+	int done = 0;
+	err_t err;
+	LWIP_UNUSED_ARG(_i);
+
+	/* initialize local vars */
+	IP4_ADDR(&local_ip, 192, 168, 1, 1);
+	IP4_ADDR(&remote_ip, 192, 168, 1, 2);
+	IP4_ADDR(&netmask, 255, 255, 255, 0);
+	test_tcp_init_netif(&netif, &txcounters, &local_ip, &netmask);
+	memset(&counters, 0, sizeof(counters));
+
+	/* create and initialize the pcb */
+	pcb = test_tcp_new_counters_pcb(&counters);
+	EXPECT_RET(pcb != NULL);
+	tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+	pcb->mss = TCP_MSS;
+	/* disable initial congestion window (we don't send a SYN here...) */
+	pcb->cwnd = pcb->snd_wnd;
+
+	/* two writes referencing the data, the first spanning two segments */
+	tcp_zc_init(&zc, test_tcp_zc_done, &done);
+	err = tcp_write_zc(pcb, data, 2 * TCP_MSS, TCP_WRITE_FLAG_COPY, &zc);
+	EXPECT_RET(err == ERR_OK);
+	err = tcp_write_zc(pcb, data + 2 * TCP_MSS, TCP_MSS, 0, &zc);
+	EXPECT_RET(err == ERR_OK);
+	EXPECT(lwip_stats.memp[MEMP_TCP_ZC_PBUF].used == 3);
+	tcp_zc_release(&zc);
+	EXPECT(done == 0);
+	err = tcp_output(pcb);
+	EXPECT_RET(err == ERR_OK);
+	EXPECT(txcounters.num_tx_calls == 3);
+
+	/* ACK of the first two segments does not complete the write */
+	p = tcp_create_rx_segment(pcb, NULL, 0, 0, 2 * TCP_MSS, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	EXPECT(done == 0);
+	EXPECT(lwip_stats.memp[MEMP_TCP_ZC_PBUF].used == 1);
+	/* ACK of the rest does */
+	p = tcp_create_rx_segment(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	EXPECT(pcb->unacked == NULL);
+	EXPECT(done == 1);
+	EXPECT(lwip_stats.memp[MEMP_TCP_ZC_PBUF].used == 0);
+
+	/* data still queued when the connection is aborted */
+	done = 0;
+	tcp_zc_init(&zc, test_tcp_zc_done, &done);
+	err = tcp_write_zc(pcb, data, TCP_MSS, 0, &zc);
+	EXPECT_RET(err == ERR_OK);
+	tcp_zc_release(&zc);
+	EXPECT(done == 0);
+
+	/* make sure the pcb is freed */
+	EXPECT_RET(lwip_stats.memp[MEMP_TCP_PCB].used == 1);
+	tcp_abort(pcb);
+	EXPECT_RET(lwip_stats.memp[MEMP_TCP_PCB].used == 0);
+	EXPECT(done == 1);
+	EXPECT(lwip_stats.memp[MEMP_TCP_ZC_PBUF].used == 0);
+}
+
 END_TEST
 /** Create the suite including all tests for this module */
 Suite *tcp_suite(void)
@@ -672,7 +755,8 @@ Suite *tcp_suite(void)
 		test_tcp_fast_rexmit_wraparound,
 		test_tcp_rto_rexmit_wraparound,
 		test_tcp_tx_full_window_lost_from_unacked,
-		test_tcp_tx_full_window_lost_from_unsent
+		test_tcp_tx_full_window_lost_from_unsent,
+		test_tcp_write_zc
 	};
 	return create_suite("TCP", tests, sizeof(tests) / sizeof(TFun), tcp_setup, tcp_teardown);
 }
@@ -0,0 +1,573 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "test_tcp_sack.h"
+
+#include <net/lwip/tcp_impl.h>
+#include <net/lwip/stats.h>
+#include <net/lwip/ipv4/ip.h>
+#include "tcp_helper.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !LWIP_STATS || !TCP_STATS || !MEMP_STATS
+#error "This tests needs TCP- and MEMP-statistics enabled"
+#endif
+#if !LWIP_TCP_SACK || !LWIP_WND_SCALE
+#error "This tests needs LWIP_TCP_SACK and LWIP_WND_SCALE enabled"
+#endif
+
+/* number of full sized segments sent by the loss recovery tests */
+#define SACK_NSEG       10
+/* segment length used by the receiver tests */
+#define SACK_RX_LEN     100
+#define SACK_TXQ_SIZE   64
+
+/** Header of a segment sent by the stack, captured by the netif output hook */
+struct test_tcp_sack_tx {
+	u32_t seqno;
+	u32_t ackno;
+	u16_t wnd;
+	u16_t datalen;
+	u8_t flags;
+	u8_t optlen;
+	u8_t opts[40];
+};
+
+static struct test_tcp_sack_tx txq[SACK_TXQ_SIZE];
+static int txq_head;
+static int txq_tail;
+static u8_t test_tcp_timer;
+/* pbufs the netif output hook keeps referenced, as a driver queue would */
+static struct pbuf *held[SACK_TXQ_SIZE];
+static int nheld;
+static u8_t hold_tx;
+static u8_t tx_data[SACK_NSEG * TCP_MSS];
+
+/* Helper functions */
+
+static u32_t get_be32(const u8_t *b)
+{
+	return ((u32_t) b[0] << 24) | ((u32_t) b[1] << 16) | ((u32_t) b[2] << 8) | b[3];
+}
+
+static void put_be32(u8_t *b, u32_t v)
+{
+	b[0] = (u8_t)(v >> 24);
+	b[1] = (u8_t)(v >> 16);
+	b[2] = (u8_t)(v >> 8);
+	b[3] = (u8_t) v;
+}
+
+/* our own version of tcp_tmr so we can reset fast/slow timer state */
+static void test_tcp_tmr(void)
+{
+	tcp_fasttmr();
+	if (++test_tcp_timer & 1) {
+		tcp_slowtmr();
+	}
+}
+
+/** netif output function queueing the TCP header of each segment sent */
+static err_t test_tcp_sack_output(struct netif *netif, struct pbuf *p, ip_addr_t *ipaddr)
+{
+	u8_t hdr[IP_HLEN + 60];
+	struct test_tcp_sack_tx *tx;
+	u16_t len;
+	u8_t hdrlen;
+	LWIP_UNUSED_ARG(netif);
+	LWIP_UNUSED_ARG(ipaddr);
+
+	EXPECT_RETX(txq_tail - txq_head < SACK_TXQ_SIZE, ERR_OK);
+	len = LWIP_MIN(p->tot_len, sizeof(hdr));
+	EXPECT_RETX(pbuf_copy_partial(p, hdr, len, 0) == len, ERR_OK);
+	hdrlen = (u8_t)((hdr[IP_HLEN + 12] >> 4) * 4);
+	EXPECT_RETX(hdrlen >= TCP_HLEN && IP_HLEN + hdrlen <= len, ERR_OK);
+
+	tx = &txq[txq_tail++ % SACK_TXQ_SIZE];
+	tx->seqno = get_be32(&hdr[IP_HLEN + 4]);
+	tx->ackno = get_be32(&hdr[IP_HLEN + 8]);
+	tx->flags = hdr[IP_HLEN + 13] & TCP_FLAGS;
+	tx->wnd = (u16_t)((hdr[IP_HLEN + 14] << 8) | hdr[IP_HLEN + 15]);
+	tx->optlen = (u8_t)(hdrlen - TCP_HLEN);
+	memcpy(tx->opts, &hdr[IP_HLEN + TCP_HLEN], tx->optlen);
+	tx->datalen = (u16_t)(p->tot_len - IP_HLEN - hdrlen);
+
+	if (hold_tx && nheld < SACK_TXQ_SIZE) {
+		pbuf_ref(p);
+		held[nheld++] = p;
+	}
+	return ERR_OK;
+}
+
+static void release_held(void)
+{
+	while (nheld > 0) {
+		pbuf_free(held[--nheld]);
+	}
+}
+
+static struct test_tcp_sack_tx *txq_pop(void)
+{
+	if (txq_head == txq_tail) {
+		return NULL;
+	}
+	return &txq[txq_head++ % SACK_TXQ_SIZE];
+}
+
+static void test_tcp_sack_init_netif(struct netif *netif, struct test_tcp_txcounters *txcounters)
+{
+	ip_addr_t netmask, local_ip;
+	IP4_ADDR(&local_ip, 192, 168, 1, 1);
+	IP4_ADDR(&netmask, 255, 255, 255, 0);
+	test_tcp_init_netif(netif, txcounters, &local_ip, &netmask);
+	netif->output = test_tcp_sack_output;
+}
+
+/** Find the SACK option of a captured segment and return its blocks */
+static u8_t test_tcp_sack_get_blocks(const struct test_tcp_sack_tx *tx, u32_t *blocks)
+{
+	u8_t i = 0;
+	u8_t n;
+
+	while (i < tx->optlen) {
+		if (tx->opts[i] == 0) {
+			break;
+		} else if (tx->opts[i] == 1) {
+			i++;
+			continue;
+		} else if (i + 1 >= tx->optlen || tx->opts[i + 1] < 2) {
+			break;
+		}
+		if (tx->opts[i] == 5) {
+			for (n = 0; n < (tx->opts[i + 1] - 2) / 8; n++) {
+				blocks[2 * n] = get_be32(&tx->opts[i + 2 + 8 * n]);
+				blocks[2 * n + 1] = get_be32(&tx->opts[i + 6 + 8 * n]);
+			}
+			return n;
+		}
+		i += tx->opts[i + 1];
+	}
+	return 0;
+}
+
+static err_t test_tcp_sack_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+	struct tcp_pcb **accepted = (struct tcp_pcb **)arg;
+	LWIP_UNUSED_ARG(err);
+	*accepted = newpcb;
+	return ERR_OK;
+}
+
+/* Setups/teardown functions */
+
+static void tcp_sack_setup(void)
+{
+	txq_head = txq_tail = 0;
+	test_tcp_timer = 0;
+	hold_tx = 0;
+	tcp_remove_all();
+}
+
+static void tcp_sack_teardown(void)
+{
+	release_held();
+	netif_list = NULL;
+	tcp_remove_all();
+}
+
+/* Test functions */
+
+/** Negotiate window scaling and SACK on a passive open, check that the
+ * SYN window is never scaled and that later windows are */
+START_TEST(test_tcp_sack_negotiate)
+{
+	struct test_tcp_txcounters txcounters;
+	struct tcp_pcb *pcb, *lpcb, *npcb;
+	struct tcp_pcb *accepted = NULL;
+	struct test_tcp_sack_tx *tx;
+	struct pbuf *p;
+	struct netif netif;
+	ip_addr_t remote_ip, local_ip;
+	u16_t remote_port = 0x100, local_port = 0x101;
+	err_t err;
+	/* MSS 536, NOP + window scale 7, NOP + NOP + SACK permitted */
+	const u8_t syn_opts[] = { 2, 4, 0x02, 0x18, 1, 3, 3, 7, 1, 1, 4, 2 };
+	LWIP_UNUSED_ARG(_i);
+
+	IP4_ADDR(&local_ip, 192, 168, 1, 1);
+	IP4_ADDR(&remote_ip, 192, 168, 1, 2);
+	test_tcp_sack_init_netif(&netif, &txcounters);
+
+	pcb = tcp_new();
+	EXPECT_RET(pcb != NULL);
+	err = tcp_bind(pcb, &local_ip, local_port);
+	EXPECT_RET(err == ERR_OK);
+	lpcb = tcp_listen(pcb);
+	EXPECT_RET(lpcb != NULL);
+	tcp_arg(lpcb, &accepted);
+	tcp_accept(lpcb, test_tcp_sack_accept);
+
+	/* SYN with both options */
+	p = tcp_create_segment_opt(&remote_ip, &local_ip, remote_port, local_port, NULL, 0, 1000, 0, TCP_SYN, 0x1000, syn_opts, sizeof(syn_opts));
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	npcb = tcp_active_pcbs;
+	EXPECT_RET(npcb != NULL && npcb->state == SYN_RCVD);
+	EXPECT((npcb->flags & (TF_WND_SCALE | TF_SACK)) == (TF_WND_SCALE | TF_SACK));
+	EXPECT(npcb->snd_scale == 7);
+	EXPECT(npcb->rcv_scale == TCP_RCV_SCALE);
+	EXPECT(npcb->rcv_wnd == TCP_WND);
+	EXPECT(npcb->snd_wnd == 0x1000);
+
+	/* SYN|ACK: MSS, window scale and SACK permitted, unscaled window */
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	EXPECT(tx->flags == (TCP_SYN | TCP_ACK));
+	EXPECT(tx->wnd == TCPWND_MIN16(TCP_WND));
+	EXPECT_RET(tx->optlen == 12);
+	EXPECT(tx->opts[0] == 2 && tx->opts[1] == 4);
+	EXPECT(tx->opts[4] == 1 && tx->opts[5] == 3 && tx->opts[6] == 3 && tx->opts[7] == TCP_RCV_SCALE);
+	EXPECT(tx->opts[8] == 1 && tx->opts[9] == 1 && tx->opts[10] == 4 && tx->opts[11] == 2);
+	EXPECT(txq_pop() == NULL);
+
+	/* the handshake ACK carries the first scaled window */
+	p = tcp_create_segment(&remote_ip, &local_ip, remote_port, local_port, NULL, 0, 1001, npcb->snd_nxt, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	EXPECT_RET(accepted == npcb && npcb->state == ESTABLISHED);
+	EXPECT(npcb->snd_wnd == ((tcpwnd_size_t) TCP_WND << 7));
+
+	/* windows we send from now on are scaled down */
+	tcp_ack_now(npcb);
+	tcp_output(npcb);
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	EXPECT(tx->flags == TCP_ACK);
+	EXPECT(tx->optlen == 0);
+	EXPECT(tx->wnd == (u16_t)(npcb->rcv_ann_wnd >> TCP_RCV_SCALE));
+
+	tcp_abort(npcb);
+	txq_head = txq_tail = 0;
+
+	/* a SYN without options disables both */
+	p = tcp_create_segment(&remote_ip, &local_ip, remote_port + 1, local_port, NULL, 0, 2000, 0, TCP_SYN);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	npcb = tcp_active_pcbs;
+	EXPECT_RET(npcb != NULL && npcb->state == SYN_RCVD);
+	EXPECT((npcb->flags & (TF_WND_SCALE | TF_SACK)) == 0);
+	EXPECT(npcb->rcv_wnd == TCPWND_MIN16(TCP_WND));
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	EXPECT(tx->flags == (TCP_SYN | TCP_ACK));
+	/* MSS only */
+	EXPECT(tx->optlen == 4);
+
+	tcp_abort(npcb);
+	err = tcp_close(lpcb);
+	EXPECT(err == ERR_OK);
+}
+
+END_TEST
+/** Receive out-of-sequence segments and check the SACK blocks reported,
+ * most recently changed block first */
+START_TEST(test_tcp_sack_ooseq_blocks)
+{
+	struct test_tcp_counters counters;
+	struct test_tcp_txcounters txcounters;
+	struct tcp_pcb *pcb;
+	struct test_tcp_sack_tx *tx;
+	struct pbuf *p;
+	struct netif netif;
+	ip_addr_t remote_ip, local_ip;
+	u16_t remote_port = 0x100, local_port = 0x101;
+	u32_t blocks[2 * LWIP_TCP_MAX_SACK_NUM];
+	u32_t rcv_nxt;
+	u8_t nblocks;
+	u32_t i;
+	LWIP_UNUSED_ARG(_i);
+
+	for (i = 0; i < 5 * SACK_RX_LEN; i++) {
+		tx_data[i] = (u8_t) i;
+	}
+	IP4_ADDR(&local_ip, 192, 168, 1, 1);
+	IP4_ADDR(&remote_ip, 192, 168, 1, 2);
+	test_tcp_sack_init_netif(&netif, &txcounters);
+	memset(&counters, 0, sizeof(counters));
+	counters.expected_data = (char *)tx_data;
+	counters.expected_data_len = 5 * SACK_RX_LEN;
+
+	pcb = test_tcp_new_counters_pcb(&counters);
+	EXPECT_RET(pcb != NULL);
+	tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+	pcb->flags |= TF_SACK;
+	rcv_nxt = pcb->rcv_nxt;
+
+	/* segment 2: duplicate ACK with one block */
+	p = tcp_create_rx_segment(pcb, &tx_data[2 * SACK_RX_LEN], SACK_RX_LEN, 2 * SACK_RX_LEN, 0, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	EXPECT(tx->ackno == rcv_nxt);
+	nblocks = test_tcp_sack_get_blocks(tx, blocks);
+	EXPECT_RET(nblocks == 1);
+	EXPECT(blocks[0] == rcv_nxt + 2 * SACK_RX_LEN && blocks[1] == rcv_nxt + 3 * SACK_RX_LEN);
+
+	/* segment 4: the new block is reported first */
+	p = tcp_create_rx_segment(pcb, &tx_data[4 * SACK_RX_LEN], SACK_RX_LEN, 4 * SACK_RX_LEN, 0, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	nblocks = test_tcp_sack_get_blocks(tx, blocks);
+	EXPECT_RET(nblocks == 2);
+	EXPECT(blocks[0] == rcv_nxt + 4 * SACK_RX_LEN && blocks[1] == rcv_nxt + 5 * SACK_RX_LEN);
+	EXPECT(blocks[2] == rcv_nxt + 2 * SACK_RX_LEN && blocks[3] == rcv_nxt + 3 * SACK_RX_LEN);
+
+	/* segment 3 joins both blocks */
+	p = tcp_create_rx_segment(pcb, &tx_data[3 * SACK_RX_LEN], SACK_RX_LEN, 3 * SACK_RX_LEN, 0, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	nblocks = test_tcp_sack_get_blocks(tx, blocks);
+	EXPECT_RET(nblocks == 1);
+	EXPECT(blocks[0] == rcv_nxt + 2 * SACK_RX_LEN && blocks[1] == rcv_nxt + 5 * SACK_RX_LEN);
+
+	/* segment 0 is in sequence but the hole remains: ACKed at once */
+	p = tcp_create_rx_segment(pcb, &tx_data[0], SACK_RX_LEN, 0, 0, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	EXPECT(tx->ackno == rcv_nxt + SACK_RX_LEN);
+	nblocks = test_tcp_sack_get_blocks(tx, blocks);
+	EXPECT_RET(nblocks == 1);
+	EXPECT(blocks[0] == rcv_nxt + 2 * SACK_RX_LEN && blocks[1] == rcv_nxt + 5 * SACK_RX_LEN);
+
+	/* segment 1 (at rcv_nxt now) fills the hole, nothing left to report */
+	p = tcp_create_rx_segment(pcb, &tx_data[SACK_RX_LEN], SACK_RX_LEN, 0, 0, TCP_ACK);
+	EXPECT_RET(p != NULL);
+	test_tcp_input(p, &netif);
+	EXPECT(counters.recved_bytes == 5 * SACK_RX_LEN);
+	EXPECT(pcb->ooseq == NULL);
+	tcp_ack_now(pcb);
+	tcp_output(pcb);
+	tx = txq_pop();
+	EXPECT_RET(tx != NULL);
+	EXPECT(tx->ackno == rcv_nxt + 5 * SACK_RX_LEN);
+	EXPECT(tx->optlen == 0);
+
+	tcp_abort(pcb);
+}
+
+END_TEST
+/** Send SACK_NSEG segments, lose three of them once and let a receiver
+ * model ACK everything else.  Returns the number of retransmitted segments
+ * and the number of timer ticks needed until everything is ACKed. */
+static void test_tcp_sack_recover(u8_t use_sack, u32_t *rexmits, u32_t *ticks)
+{
+	struct test_tcp_counters counters;
+	struct test_tcp_txcounters txcounters;
+	struct tcp_pcb *pcb;
+	struct test_tcp_sack_tx *tx;
+	struct pbuf *p;
+	struct netif netif;
+	ip_addr_t remote_ip, local_ip;
+	u16_t remote_port = 0x100, local_port = 0x101;
+	u8_t sent[SACK_NSEG], received[SACK_NSEG];
+	u8_t opts[4 + 8 * 3];
+	u32_t iss;
+	err_t err;
+	int idx, cum, i, n;
+
+	*rexmits = 0;
+	*ticks = 0;
+	memset(sent, 0, sizeof(sent));
+	memset(received, 0, sizeof(received));
+	IP4_ADDR(&local_ip, 192, 168, 1, 1);
+	IP4_ADDR(&remote_ip, 192, 168, 1, 2);
+	test_tcp_sack_init_netif(&netif, &txcounters);
+	memset(&counters, 0, sizeof(counters));
+
+	pcb = test_tcp_new_counters_pcb(&counters);
+	EXPECT_RET(pcb != NULL);
+	tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+	if (use_sack) {
+		pcb->flags |= TF_SACK;
+	}
+	pcb->mss = TCP_MSS;
+	pcb->cwnd = SACK_NSEG * TCP_MSS;
+	pcb->ssthresh = SACK_NSEG * TCP_MSS;
+	iss = pcb->snd_nxt;
+
+	err = tcp_write(pcb, tx_data, sizeof(tx_data), TCP_WRITE_FLAG_COPY);
+	EXPECT_RET(err == ERR_OK);
+	err = tcp_output(pcb);
+	EXPECT_RET(err == ERR_OK);
+
+	while (pcb->unacked != NULL || pcb->unsent != NULL) {
+		tx = txq_pop();
+		if (tx == NULL) {
+			/* nothing in flight: wait for the retransmission timer */
+			EXPECT_RET(*ticks < 100);
+			test_tcp_tmr();
+			(*ticks)++;
+			continue;
+		}
+		if (tx->datalen == 0) {
+			continue;
+		}
+		idx = (int)((tx->seqno - iss) / TCP_MSS);
+		EXPECT_RET(idx >= 0 && idx < SACK_NSEG && tx->seqno == iss + (u32_t) idx * TCP_MSS);
+		if (sent[idx]++) {
+			(*rexmits)++;
+		} else if (idx == 1 || idx == 4 || idx == 7) {
+			/* lost on first transmission */
+			continue;
+		}
+		received[idx] = 1;
+
+		/* cumulative ACK plus the blocks above it, the one just
+		   received first */
+		for (cum = 0; cum < SACK_NSEG && received[cum]; cum++) ;
+		n = 0;
+		if (use_sack) {
+			opts[0] = 1;
+			opts[1] = 1;
+			opts[2] = 5;
+			for (i = SACK_NSEG - 1; i > cum && n < 3;) {
+				int left, right;
+				if (!received[i]) {
+					i--;
+					continue;
+				}
+				right = i + 1;
+				while (i > cum && received[i - 1]) {
+					i--;
+				}
+				left = i;
+				i--;
+				if (idx >= left && idx < right && n > 0) {
+					/* move the block to the front */
+					memmove(&opts[4 + 8], &opts[4], 8 * n);
+					put_be32(&opts[4], iss + (u32_t) left * TCP_MSS);
+					put_be32(&opts[8], iss + (u32_t) right * TCP_MSS);
+				} else {
+					put_be32(&opts[4 + 8 * n], iss + (u32_t) left * TCP_MSS);
+					put_be32(&opts[8 + 8 * n], iss + (u32_t) right * TCP_MSS);
+				}
+				n++;
+			}
+			opts[3] = (u8_t)(2 + 8 * n);
+		}
+		p = tcp_create_segment_opt(&remote_ip, &local_ip, remote_port, local_port, NULL, 0, pcb->rcv_nxt, iss + (u32_t) cum * TCP_MSS, TCP_ACK, TCP_WND, opts, (u8_t)(n > 0 ? 4 + 8 * n : 0));
+		EXPECT_RET(p != NULL);
+		test_tcp_input(p, &netif);
+	}
+	for (i = 0; i < SACK_NSEG; i++) {
+		EXPECT(received[i]);
+	}
+
+	tcp_abort(pcb);
+}
+
+/** Recover three losses in one window with SACK: each lost segment is
+ * retransmitted once and no retransmission timeout is needed */
+START_TEST(test_tcp_sack_loss_recovery)
+{
+	u32_t rexmits, ticks;
+	u32_t rexmits_nosack, ticks_nosack;
+	LWIP_UNUSED_ARG(_i);
+
+	test_tcp_sack_recover(1, &rexmits, &ticks);
+	EXPECT(rexmits == 3);
+	EXPECT(ticks == 0);
+
+	txq_head = txq_tail = 0;
+	test_tcp_sack_recover(0, &rexmits_nosack, &ticks_nosack);
+	EXPECT(ticks_nosack > 0);
+	EXPECT(rexmits_nosack >= rexmits);
+
+	printf("tcp sack: %d segments, 3 lost: SACK %u rexmits %u ticks, without SACK %u rexmits %u ticks\n", SACK_NSEG, (unsigned)rexmits, (unsigned)ticks, (unsigned)rexmits_nosack, (unsigned)ticks_nosack);
+}
+
+END_TEST
+/** A hole whose segment is still referenced by the netif is not
+ * retransmitted in place; it is once the netif has released it */
+START_TEST(test_tcp_sack_rexmit_busy)
+{
+	struct netif netif;
+	struct test_tcp_txcounters txcounters;
+	struct test_tcp_counters counters;
+	struct tcp_pcb *pcb;
+	struct test_tcp_sack_tx *tx;
+	ip_addr_t remote_ip, local_ip;
+	u16_t remote_port = 0x100, local_port = 0x101;
+	u32_t seqno;
+	LWIP_UNUSED_ARG(_i);
+
+	IP4_ADDR(&local_ip, 192, 168, 1, 1);
+	IP4_ADDR(&remote_ip, 192, 168, 1, 2);
+	test_tcp_sack_init_netif(&netif, &txcounters);
+	memset(&counters, 0, sizeof(counters));
+
+	pcb = test_tcp_new_counters_pcb(&counters);
+	EXPECT_RET(pcb != NULL);
+	tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+	pcb->flags |= TF_SACK;
+	pcb->mss = TCP_MSS;
+	pcb->cwnd = 2 * TCP_MSS;
+
+	hold_tx = 1;
+	EXPECT_RET(tcp_write(pcb, tx_data, 2 * TCP_MSS, TCP_WRITE_FLAG_COPY) == ERR_OK);
+	EXPECT_RET(tcp_output(pcb) == ERR_OK);
+	EXPECT_RET(pcb->unacked != NULL);
+	while (txq_pop() != NULL) ;
+	seqno = ntohl(pcb->unacked->tcphdr->seqno);
+
+	tcp_rexmit_seg(pcb, pcb->unacked);
+	EXPECT(txq_pop() == NULL);
+	EXPECT(!(pcb->unacked->flags & TF_SEG_RETRANSMITTED));
+
+	hold_tx = 0;
+	release_held();
+	tcp_rexmit_seg(pcb, pcb->unacked);
+	tx = txq_pop();
+	EXPECT(tx != NULL && tx->seqno == seqno && tx->datalen == TCP_MSS);
+	EXPECT(pcb->unacked->flags & TF_SEG_RETRANSMITTED);
+
+	tcp_abort(pcb);
+}
+
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *tcp_sack_suite(void)
+{
+	TFun tests[] = {
+		test_tcp_sack_negotiate,
+		test_tcp_sack_ooseq_blocks,
+		test_tcp_sack_loss_recovery,
+		test_tcp_sack_rexmit_busy
+	};
+	return create_suite("TCP_SACK", tests, sizeof(tests) / sizeof(TFun), tcp_sack_setup, tcp_sack_teardown);
+}
@@ -223,6 +223,13 @@ SYSCALL_LOOKUP(sched_getstreams,        0, STUB_sched_getstreams)
 SYSCALL_LOOKUP(sendfile,                4, STUB_fs_sendifile)
 #  endif
 
+#  ifdef CONFIG_FS_EPOLL
+SYSCALL_LOOKUP(epoll_create,            1, STUB_epoll_create)
+SYSCALL_LOOKUP(epoll_ctl,               4, STUB_epoll_ctl)
+SYSCALL_LOOKUP(epoll_wait,              4, STUB_epoll_wait)
+SYSCALL_LOOKUP(epoll_close,             1, STUB_epoll_close)
+#  endif
+
 #  if !defined(CONFIG_DISABLE_MOUNTPOINT)
 SYSCALL_LOOKUP(fsync,                   1, STUB_fsync)
 SYSCALL_LOOKUP(mkdir,                   2, STUB_mkdir)
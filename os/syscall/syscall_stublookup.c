@@ -235,6 +235,13 @@ uintptr_t STUB_sched_getstreams(int nbr);
 
 ssize_t sendfile(int outfd, int infd, FAR off_t *offset, size_t count);
 
+uintptr_t STUB_epoll_create(int nbr, uintptr_t parm1);
+uintptr_t STUB_epoll_ctl(int nbr, uintptr_t parm1, uintptr_t parm2,
+						 uintptr_t parm3, uintptr_t parm4);
+uintptr_t STUB_epoll_wait(int nbr, uintptr_t parm1, uintptr_t parm2,
+						  uintptr_t parm3, uintptr_t parm4);
+uintptr_t STUB_epoll_close(int nbr, uintptr_t parm1);
+
 uintptr_t STUB_fsync(int nbr, uintptr_t parm1);
 uintptr_t STUB_mkdir(int nbr, uintptr_t parm1, uintptr_t parm2);
 uintptr_t STUB_mount(int nbr, uintptr_t parm1, uintptr_t parm2,
@@ -0,0 +1,278 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * tools/heapbench/heapbench.c
+ *
+ * Host-side stress benchmark for the os/mm/mm_heap allocator.  The heap
+ * sources are compiled for the host twice, once with the size ordered
+ * nodelist and once with CONFIG_MM_TLSF, and this driver runs the same
+ * pseudo-random allocation pattern against each build, reporting the mean
+ * and worst-case latency of mm_malloc(), mm_free() and mm_realloc().
+ *
+ * The pattern keeps a fixed number of live allocations with a size mix
+ * weighted towards small network-style buffers, which fragments the heap
+ * into many free chunks over time.  Every block is filled with a pattern
+ * that is verified before it is freed so that heap corruption is caught.
+ *
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <tinyara/mm/mm.h>
+
+#define HEAPBENCH_HEAPSIZE   (4 * 1024 * 1024)
+#define HEAPBENCH_SLOTS      4096
+#define HEAPBENCH_ITERATIONS 2000000
+
+#ifdef CONFIG_MM_TLSF
+#define HEAPBENCH_NAME "tlsf"
+#else
+#define HEAPBENCH_NAME "list"
+#endif
+
+struct heapbench_stat_s {
+	uint64_t count;
+	uint64_t total;
+	uint64_t max;
+};
+
+struct heapbench_slot_s {
+	unsigned char *mem;
+	size_t size;
+};
+
+static struct mm_heap_s g_heap;
+static struct heapbench_slot_s g_slot[HEAPBENCH_SLOTS];
+static uint32_t g_seed = 0x12345678;
+
+/* The benchmark is single threaded, so the heap semaphore is not needed */
+
+void mm_takesemaphore(FAR struct mm_heap_s *heap)
+{
+}
+
+void mm_givesemaphore(FAR struct mm_heap_s *heap)
+{
+}
+
+void mm_seminitialize(FAR struct mm_heap_s *heap)
+{
+}
+
+static uint32_t heapbench_rand(void)
+{
+	/* xorshift32 so that both builds see exactly the same sequence */
+
+	g_seed ^= g_seed << 13;
+	g_seed ^= g_seed >> 17;
+	g_seed ^= g_seed << 5;
+	return g_seed;
+}
+
+static size_t heapbench_size(void)
+{
+	uint32_t r = heapbench_rand() % 100;
+
+	if (r < 70) {
+		return 8 + heapbench_rand() % 248;		/* Small: 8..255 */
+	} else if (r < 95) {
+		return 256 + heapbench_rand() % 1536;	/* Packet sized */
+	} else {
+		return 2048 + heapbench_rand() % 14336;	/* Large buffers */
+	}
+}
+
+static uint64_t heapbench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void heapbench_record(struct heapbench_stat_s *stat, uint64_t elapsed)
+{
+	stat->count++;
+	stat->total += elapsed;
+	if (elapsed > stat->max) {
+		stat->max = elapsed;
+	}
+}
+
+static void heapbench_print(const char *op, struct heapbench_stat_s *stat)
+{
+	printf("%s %-7s count=%-9llu mean=%6.1f ns  max=%8llu ns\n", HEAPBENCH_NAME, op,
+		   (unsigned long long)stat->count,
+		   stat->count ? (double)stat->total / stat->count : 0.0,
+		   (unsigned long long)stat->max);
+}
+
+static void heapbench_fill(struct heapbench_slot_s *slot, unsigned char *mem, size_t size)
+{
+	size_t i;
+
+	slot->mem = mem;
+	slot->size = size;
+	for (i = 0; i < size; i++) {
+		mem[i] = (unsigned char)((uintptr_t)mem + i);
+	}
+}
+
+static int heapbench_check(struct heapbench_slot_s *slot)
+{
+	size_t i;
+
+	for (i = 0; i < slot->size; i++) {
+		if (slot->mem[i] != (unsigned char)((uintptr_t)slot->mem + i)) {
+			fprintf(stderr, "corruption at %p+%zu\n", slot->mem, i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct heapbench_stat_s mstat;
+	struct heapbench_stat_s fstat;
+	struct heapbench_stat_s rstat;
+	struct heapbench_slot_s *slot;
+	unsigned char *mem;
+	void *heapmem;
+	uint64_t start;
+	uint64_t elapsed;
+	unsigned long failures = 0;
+	long iterations = HEAPBENCH_ITERATIONS;
+	long i;
+	size_t size;
+	size_t j;
+
+	if (argc > 1) {
+		iterations = atol(argv[1]);
+	}
+
+	heapmem = malloc(HEAPBENCH_HEAPSIZE);
+	if (heapmem == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	/* Touch the whole heap first so that page faults do not show up as
+	 * allocator latency.
+	 */
+
+	memset(heapmem, 0, HEAPBENCH_HEAPSIZE);
+	mm_initialize(&g_heap, heapmem, HEAPBENCH_HEAPSIZE);
+	memset(&mstat, 0, sizeof(mstat));
+	memset(&fstat, 0, sizeof(fstat));
+	memset(&rstat, 0, sizeof(rstat));
+
+	for (i = 0; i < iterations; i++) {
+		slot = &g_slot[heapbench_rand() % HEAPBENCH_SLOTS];
+
+		if (slot->mem != NULL) {
+			if (heapbench_check(slot) < 0) {
+				return EXIT_FAILURE;
+			}
+
+			if ((heapbench_rand() & 3) == 0) {
+				/* Resize one in four live blocks instead of freeing it */
+
+				size = heapbench_size();
+				start = heapbench_now();
+				mem = mm_realloc(&g_heap, slot->mem, size);
+				elapsed = heapbench_now() - start;
+				heapbench_record(&rstat, elapsed);
+
+				if (mem == NULL) {
+					failures++;
+					continue;
+				}
+
+				if (size < slot->size) {
+					slot->size = size;
+				}
+
+				/* The preserved part must have moved with the block */
+
+				for (j = 0; j < slot->size; j++) {
+					if (mem[j] != (unsigned char)((uintptr_t)slot->mem + j)) {
+						fprintf(stderr, "realloc lost data at %p+%zu\n", mem, j);
+						return EXIT_FAILURE;
+					}
+				}
+
+				heapbench_fill(slot, mem, size);
+				continue;
+			}
+
+			start = heapbench_now();
+			mm_free(&g_heap, slot->mem);
+			elapsed = heapbench_now() - start;
+			heapbench_record(&fstat, elapsed);
+			slot->mem = NULL;
+			continue;
+		}
+
+		slot->size = heapbench_size();
+		start = heapbench_now();
+		slot->mem = mm_malloc(&g_heap, slot->size);
+		elapsed = heapbench_now() - start;
+		heapbench_record(&mstat, elapsed);
+
+		if (slot->mem == NULL) {
+			failures++;
+			continue;
+		}
+
+		heapbench_fill(slot, slot->mem, slot->size);
+	}
+
+	for (i = 0; i < HEAPBENCH_SLOTS; i++) {
+		if (g_slot[i].mem != NULL) {
+			if (heapbench_check(&g_slot[i]) < 0) {
+				return EXIT_FAILURE;
+			}
+
+			mm_free(&g_heap, g_slot[i].mem);
+		}
+	}
+
+	heapbench_print("malloc", &mstat);
+	heapbench_print("free", &fstat);
+	heapbench_print("realloc", &rstat);
+	printf("%s failed allocations: %lu\n", HEAPBENCH_NAME, failures);
+
+	/* Everything has been freed, so the heap must have coalesced back into
+	 * a single chunk that satisfies the largest possible request.
+	 */
+
+	heapmem = mm_malloc(&g_heap, HEAPBENCH_HEAPSIZE - 4 * MM_MIN_CHUNK);
+	if (heapmem == NULL) {
+		fprintf(stderr, "%s: heap did not coalesce\n", HEAPBENCH_NAME);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,10 @@
+/* Host assert.h wrapper providing the TinyAra DEBUGASSERT() macro */
+
+#ifndef __TOOLS_HEAPBENCH_INCLUDE_ASSERT_H
+#define __TOOLS_HEAPBENCH_INCLUDE_ASSERT_H
+
+#include_next <assert.h>
+
+#define DEBUGASSERT(f) assert(f)
+
+#endif
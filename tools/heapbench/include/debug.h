@@ -0,0 +1,11 @@
+/* Host debug.h stub:  The heap debug output is compiled out */
+
+#ifndef __TOOLS_HEAPBENCH_INCLUDE_DEBUG_H
+#define __TOOLS_HEAPBENCH_INCLUDE_DEBUG_H
+
+#define mdbg(...)
+#define mvdbg(...)
+#define mlldbg(...)
+#define mllvdbg(...)
+
+#endif
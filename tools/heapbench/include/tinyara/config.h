@@ -0,0 +1,13 @@
+/* Minimal host configuration for building os/mm/mm_heap in tools/heapbench */
+
+#ifndef __TOOLS_HEAPBENCH_INCLUDE_TINYARA_CONFIG_H
+#define __TOOLS_HEAPBENCH_INCLUDE_TINYARA_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FAR
+#define CONFIG_MM_REGIONS 1
+#define CONFIG_HAVE_LONG_LONG 1
+
+#endif
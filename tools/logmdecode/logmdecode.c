@@ -0,0 +1,424 @@
+/****************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * tools/logmdecode/logmdecode.c
+ *
+ * Host-side decoder for the console output of logm with
+ * CONFIG_LOGM_BINARY_RAW.  Each binary record carries the address of its
+ * format string, so the firmware ELF image is needed to look the format
+ * strings up.  Console output between records is copied through unchanged.
+ *
+ *   logmdecode <tinyara ELF> [capture file]
+ *
+ * The capture is read from stdin if no file is given.  A 32-bit little
+ * endian target is assumed.  The record layout must match os/logm/logm.h.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LOGM_BIN_MAGIC  0xa5
+#define LOGM_BIN_SYNC0  'L'
+#define LOGM_BIN_SYNC1  'G'
+#define LOGM_BIN_HDRLEN 16
+
+#define SHT_NOBITS      8
+#define SHF_ALLOC       2
+
+enum logm_argtype_e {
+	LOGM_ARG_NONE,
+	LOGM_ARG_INT32,
+	LOGM_ARG_INT64,
+	LOGM_ARG_PTR,
+	LOGM_ARG_DOUBLE,
+	LOGM_ARG_STRING,
+	LOGM_ARG_COUNT
+};
+
+struct elf_section_s {
+	uint32_t addr;
+	uint32_t size;
+	uint32_t offset;
+};
+
+static uint8_t *g_elf;
+static long g_elfsize;
+static struct elf_section_s *g_sections;
+static int g_nsections;
+
+static uint32_t get16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int elf_load(const char *path)
+{
+	FILE *fp;
+	uint32_t shoff;
+	uint32_t shentsize;
+	const uint8_t *sh;
+	int i;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	g_elfsize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	g_elf = malloc(g_elfsize);
+	if (g_elf == NULL || fread(g_elf, 1, g_elfsize, fp) != (size_t)g_elfsize) {
+		fprintf(stderr, "%s: read failed\n", path);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	if (g_elfsize < 52 || memcmp(g_elf, "\177ELF", 4) != 0 || g_elf[4] != 1 || g_elf[5] != 1) {
+		fprintf(stderr, "%s: not a 32-bit little endian ELF file\n", path);
+		return -1;
+	}
+
+	shoff = get32(&g_elf[32]);
+	shentsize = get16(&g_elf[46]);
+	g_nsections = get16(&g_elf[48]);
+	g_sections = calloc(g_nsections, sizeof(struct elf_section_s));
+	if (g_sections == NULL || shoff + (uint64_t)shentsize * g_nsections > (uint64_t)g_elfsize) {
+		fprintf(stderr, "%s: bad section headers\n", path);
+		return -1;
+	}
+
+	/* Keep the allocated sections that have contents in the file */
+
+	for (i = 0; i < g_nsections; i++) {
+		sh = &g_elf[shoff + i * shentsize];
+		if ((get32(&sh[8]) & SHF_ALLOC) != 0 && get32(&sh[4]) != SHT_NOBITS) {
+			g_sections[i].addr = get32(&sh[12]);
+			g_sections[i].offset = get32(&sh[16]);
+			g_sections[i].size = get32(&sh[20]);
+		}
+	}
+
+	return 0;
+}
+
+/* Return the NUL terminated string at a target address, or NULL */
+
+static const char *elf_string(uint32_t addr)
+{
+	const struct elf_section_s *s;
+	uint32_t off;
+	int i;
+
+	for (i = 0; i < g_nsections; i++) {
+		s = &g_sections[i];
+		if (s->size != 0 && addr >= s->addr && addr - s->addr < s->size) {
+			off = s->offset + (addr - s->addr);
+			if (off >= g_elfsize || memchr(&g_elf[off], '\0', s->size - (addr - s->addr)) == NULL) {
+				return NULL;
+			}
+
+			return (const char *)&g_elf[off];
+		}
+	}
+
+	return NULL;
+}
+
+/* Parse the conversion specification starting at the '%' in fmt.  Builds
+ * the equivalent host specification in spec, with '*' kept and the length
+ * modifier replaced to match the size of the target argument.
+ */
+
+static const char *parse_spec(const char *fmt, char *spec, size_t size, int *type, int *nstar)
+{
+	char *out = spec;
+	int lng = 0;
+	char conv;
+
+	*out++ = *fmt++;
+	*nstar = 0;
+
+	while (*fmt != '\0' && strchr("-+ #0123456789.*", *fmt) != NULL) {
+		if (*fmt == '*') {
+			(*nstar)++;
+		}
+		if (out < spec + size - 4) {
+			*out++ = *fmt;
+		}
+		fmt++;
+	}
+
+	while (*fmt != '\0' && strchr("hljztLq", *fmt) != NULL) {
+		if (*fmt == 'l') {
+			lng++;
+		} else if (*fmt == 'j') {
+			lng = 2;
+		}
+		fmt++;
+	}
+
+	conv = *fmt;
+	switch (conv) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'c':
+		/* long, size_t and ptrdiff_t are 32 bits wide on the target */
+
+		*type = lng >= 2 ? LOGM_ARG_INT64 : LOGM_ARG_INT32;
+		if (lng >= 2) {
+			*out++ = 'l';
+			*out++ = 'l';
+		}
+		break;
+	case 'p':
+		*type = LOGM_ARG_PTR;
+		break;
+	case 's':
+		*type = LOGM_ARG_STRING;
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		*type = LOGM_ARG_DOUBLE;
+		break;
+	case 'n':
+		*type = LOGM_ARG_COUNT;
+		break;
+	default:
+		*type = LOGM_ARG_NONE;
+		break;
+	}
+
+	if (conv == '\0') {
+		*out = '\0';
+		return fmt;
+	}
+
+	*out++ = conv;
+	*out = '\0';
+	return fmt + 1;
+}
+
+static bool get_arg(const uint8_t **ptr, const uint8_t *end, void *val, size_t size)
+{
+	if ((size_t)(end - *ptr) < size) {
+		return false;
+	}
+
+	memcpy(val, *ptr, size);
+	*ptr += (size + 3) & ~3;
+	return true;
+}
+
+static void decode_record(const uint8_t *rec, uint32_t len)
+{
+	const uint8_t *ptr = rec + LOGM_BIN_HDRLEN;
+	const uint8_t *end = rec + len;
+	const char *fmt;
+	char spec[32];
+	char str[1024];
+	int32_t star[2];
+	int type;
+	int nstar;
+	int i;
+
+	printf("[%10u] %3u %u: ", get32(&rec[8]), get32(&rec[12]), (get32(&rec[0]) >> 16) & 0xff);
+
+	fmt = elf_string(get32(&rec[4]));
+	if (fmt == NULL) {
+		printf("<unknown format 0x%08x>\n", get32(&rec[4]));
+		return;
+	}
+
+	while (*fmt != '\0') {
+		if (*fmt != '%') {
+			putchar(*fmt++);
+			continue;
+		}
+
+		fmt = parse_spec(fmt, spec, sizeof(spec), &type, &nstar);
+		for (i = 0; i < nstar; i++) {
+			if (!get_arg(&ptr, end, &star[i], sizeof(int32_t))) {
+				goto truncated;
+			}
+		}
+
+		switch (type) {
+		case LOGM_ARG_NONE:
+			printf(spec, 0);
+			continue;
+
+		case LOGM_ARG_INT32:
+		case LOGM_ARG_PTR: {
+			uint32_t val;
+			if (!get_arg(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			if (type == LOGM_ARG_PTR) {
+				printf("0x%x", val);
+			} else if (nstar == 2) {
+				printf(spec, star[0], star[1], val);
+			} else if (nstar == 1) {
+				printf(spec, star[0], val);
+			} else {
+				printf(spec, val);
+			}
+		}
+		break;
+
+		case LOGM_ARG_INT64: {
+			uint64_t val;
+			if (!get_arg(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			if (nstar == 2) {
+				printf(spec, star[0], star[1], (long long)val);
+			} else if (nstar == 1) {
+				printf(spec, star[0], (long long)val);
+			} else {
+				printf(spec, (long long)val);
+			}
+		}
+		break;
+
+		case LOGM_ARG_DOUBLE: {
+			double val;
+			if (!get_arg(&ptr, end, &val, sizeof(val))) {
+				goto truncated;
+			}
+			if (nstar == 2) {
+				printf(spec, star[0], star[1], val);
+			} else if (nstar == 1) {
+				printf(spec, star[0], val);
+			} else {
+				printf(spec, val);
+			}
+		}
+		break;
+
+		case LOGM_ARG_STRING: {
+			uint32_t slen;
+			if (!get_arg(&ptr, end, &slen, sizeof(slen)) || slen > (uint32_t)(end - ptr) || slen >= sizeof(str)) {
+				goto truncated;
+			}
+			memcpy(str, ptr, slen);
+			str[slen] = '\0';
+			ptr += (slen + 3) & ~3;
+			if (nstar == 2) {
+				printf(spec, star[0], star[1], str);
+			} else if (nstar == 1) {
+				printf(spec, star[0], str);
+			} else {
+				printf(spec, str);
+			}
+		}
+		break;
+
+		default:
+			break;
+		}
+	}
+
+	return;
+
+truncated:
+	printf("...\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t rec[0x10000];
+	FILE *in = stdin;
+	uint32_t len;
+	int ch;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: %s <tinyara ELF> [capture file]\n", argv[0]);
+		return 1;
+	}
+
+	if (elf_load(argv[1]) < 0) {
+		return 1;
+	}
+
+	if (argc == 3) {
+		in = fopen(argv[2], "rb");
+		if (in == NULL) {
+			perror(argv[2]);
+			return 1;
+		}
+	}
+
+	while ((ch = getc(in)) != EOF) {
+		if (ch != LOGM_BIN_SYNC0) {
+			putchar(ch);
+			continue;
+		}
+
+		ch = getc(in);
+		if (ch != LOGM_BIN_SYNC1) {
+			putchar(LOGM_BIN_SYNC0);
+			if (ch != EOF) {
+				ungetc(ch, in);
+			}
+			continue;
+		}
+
+		/* Check the record word before trusting the sync bytes */
+
+		if (fread(rec, 1, 4, in) != 4) {
+			break;
+		}
+
+		len = get32(rec) & 0xffff;
+		if ((get32(rec) >> 24) != LOGM_BIN_MAGIC || len < LOGM_BIN_HDRLEN || (len & 3) != 0) {
+			printf("%c%c", LOGM_BIN_SYNC0, LOGM_BIN_SYNC1);
+			fwrite(rec, 1, 4, stdout);
+			continue;
+		}
+
+		if (fread(rec + 4, 1, len - 4, in) != len - 4) {
+			break;
+		}
+
+		decode_record(rec, len);
+	}
+
+	return 0;
+}